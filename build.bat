@@ -8,16 +8,18 @@ if %errorlevel% neq 0 (call setup.bat)
 
 SET TITLE=fleuret
 SET DEBUG=1
+SET BENCHMARK=0
+SET PROFILE=0
 SET IFLAGS=/Iinclude
 SET CFLAGS=/Fe%TITLE% /nologo /W4 /wd4152 /wd4029 /D_CRT_SECURE_NO_WARNINGS /GR /EHa /Oi /fp:fast /FC /INCREMENTAL:NO
-SET LIBS=/link user32.lib gdi32.lib winmm.lib shell32.lib kernel32.lib
+SET LIBS=/link user32.lib gdi32.lib winmm.lib shell32.lib kernel32.lib psapi.lib
 
 if "%DEBUG%" == "1" (
-  cl %IFLAGS% src/main.c /Od /MTd /Zi /Fm /DDEBUG=1 %CFLAGS% %LIBS% > output
+  cl %IFLAGS% src/main.c /Od /MTd /Zi /Fm /DDEBUG=1 /DBENCHMARK=%BENCHMARK% /DPROFILE=%PROFILE% %CFLAGS% %LIBS% > output
   type output
   del /F output > nul
 ) else (
-  cl %IFLAGS% src/main.c /Ox /MT /DDEBUG=0 %CFLAGS% %LIBS% > output
+  cl %IFLAGS% src/main.c /Ox /MT /DDEBUG=0 /DBENCHMARK=%BENCHMARK% /DPROFILE=%PROFILE% %CFLAGS% %LIBS% > output
   type output
   del /F output > nul
 )
@@ -1,16 +1,24 @@
 #define KB 1024LL
-#define MB KB*1000
-#define GB MB*1000
+#define MB (KB*1000)
+#define GB (MB*1000)
 
 #ifndef DEFAULT_ALIGNMENT
 #define DEFAULT_ALIGNMENT (2 * sizeof(void *))
 #endif
 
+#define ARENA_COMMIT_SIZE (64 * 1024) // Virtual arenas commit in steps of this many bytes.
+#define ARENA_DEFAULT_RESERVE (64 * GB)
+#define SCRATCH_ARENA_COUNT 2
+#define SCRATCH_ARENA_RESERVE (8 * GB)
+
 typedef struct Arena {
   size_t cur;
   size_t prev;
-  size_t capacity;
+  size_t capacity; // Reserved bytes for virtual arenas.
   uc *data;
+  size_t committed; // Equal to capacity for arenas over a caller buffer.
+  size_t highWater; // Bytes past this were never handed out, in a virtual arena they are still zero.
+  i32 isVirtual;
 } Arena;
 
 typedef struct TmpArena {
@@ -35,46 +43,99 @@ uintptr_t AlignForward(uintptr_t ptr, size_t align)
   return p;
 }
 
-void *AllocAlign(Arena *arena, size_t size, size_t align)
+// Commits up to end rounded to ARENA_COMMIT_SIZE, returns 0 when the system refuses.
+i32 CommitArena(Arena *arena, size_t end)
+{
+  if (!arena->isVirtual) return 0;
+  size_t committed = AlignForward(end, ARENA_COMMIT_SIZE);
+  if (committed > arena->capacity) committed = arena->capacity;
+  if (!PlatformCommit(&arena->data[arena->committed], committed - arena->committed)) return 0;
+  arena->committed = committed;
+  return 1;
+}
+
+void *AllocAlignWith(Arena *arena, size_t size, size_t align, i32 zero)
 {
   uintptr_t curr_ptr = (uintptr_t)arena->data + (uintptr_t)arena->cur;
   uintptr_t offset = AlignForward(curr_ptr, align);
   offset -= (uintptr_t)arena->data;
 
-  if (offset + size <= arena->capacity)
-  {
-    void *ptr = &arena->data[offset];
-    arena->prev = offset;
-    arena->cur = offset + size;
-    memset(ptr, 0, size);
-    return ptr;
-  }
-  else
+  if (offset + size > arena->capacity) return NULL;
+  if (offset + size > arena->committed && !CommitArena(arena, offset + size)) return NULL;
+
+  void *ptr = &arena->data[offset];
+  arena->prev = offset;
+  arena->cur = offset + size;
+
+  // Only bytes below the high water mark can hold old allocations.
+  if (zero && offset < arena->highWater)
   {
-    return NULL;
+    memset(ptr, 0, (offset + size < arena->highWater ? offset + size : arena->highWater) - offset);
   }
+  if (arena->cur > arena->highWater) arena->highWater = arena->cur;
+  return ptr;
+}
+
+void *AllocAlign(Arena *arena, size_t size, size_t align)
+{
+  return AllocAlignWith(arena, size, align, 1);
 }
 
 void *Alloc(Arena *arena, size_t size) 
 {
-  return AllocAlign(arena, size, DEFAULT_ALIGNMENT);
+  return AllocAlignWith(arena, size, DEFAULT_ALIGNMENT, 1);
+}
+
+// For buffers the caller overwrites entirely, e.g. arrays decoded straight from the font.
+void *AllocNoZero(Arena *arena, size_t size)
+{
+  return AllocAlignWith(arena, size, DEFAULT_ALIGNMENT, 0);
 }
 
+// The buffer may hold anything, every zeroed allocation from it is cleared.
 void InitArena(Arena *arena, void *backBuffer, size_t backBufferLength)
 {
+  memset(arena, 0, sizeof(Arena));
   arena->data = (uc *)backBuffer;
   arena->capacity = backBufferLength;
-  arena->cur = 0;
-  arena->prev = 0;
+  arena->committed = backBufferLength;
+  arena->highWater = backBufferLength;
 }
 
+// Reserves reserveSize bytes of address space, pages are committed as allocations reach them.
+i32 InitVirtualArena(Arena *arena, size_t reserveSize)
+{
+  memset(arena, 0, sizeof(Arena));
+  arena->data = (uc *)PlatformReserve(reserveSize);
+  if (!arena->data) return 0;
+  arena->capacity = reserveSize;
+  arena->isVirtual = 1;
+  return 1;
+}
+
+// Empties the arena, virtual arenas also give their pages back.
 void DestroyArena(Arena *arena)
 {
-  memset(arena->data, 0, arena->capacity);
+  if (arena->isVirtual)
+  {
+    PlatformDecommit(arena->data, arena->committed);
+    arena->committed = 0;
+    arena->highWater = 0;
+  }
+  else
+  {
+    memset(arena->data, 0, arena->capacity);
+  }
   arena->cur = 0;
   arena->prev = 0;
 }
 
+void ReleaseArena(Arena *arena)
+{
+  if (arena->isVirtual) PlatformFree(arena->data, arena->capacity);
+  memset(arena, 0, sizeof(Arena));
+}
+
 void TmpArenaPush(TmpArena *tmp, Arena *src)
 {
   tmp->arena = src;
@@ -87,3 +148,29 @@ void TmpArenaPop(TmpArena *tmp)
   tmp->arena->prev = tmp->prev;
   tmp->arena->cur = tmp->cur;
 }
+
+THREAD_LOCAL Arena scratchArenas[SCRATCH_ARENA_COUNT];
+
+// Per-thread scratch for work that does not outlive the call or the frame, used through TmpArena.
+// conflict is the arena the caller returns results in, the scratch arena is never that one, so a function
+// handed a scratch arena as output can still use scratch space of its own.
+Arena *GetScratchArena(Arena *conflict)
+{
+  for (i32 i = 0; i < SCRATCH_ARENA_COUNT; ++i)
+  {
+    Arena *scratch = &scratchArenas[i];
+    if (scratch == conflict) continue;
+    if (!scratch->data && !InitVirtualArena(scratch, SCRATCH_ARENA_RESERVE)) return NULL;
+    return scratch;
+  }
+  return NULL;
+}
+
+// Threads that used scratch arenas call this before exiting, the reservations are not freed otherwise.
+void ReleaseScratchArenas(void)
+{
+  for (i32 i = 0; i < SCRATCH_ARENA_COUNT; ++i)
+  {
+    if (scratchArenas[i].data) ReleaseArena(&scratchArenas[i]);
+  }
+}
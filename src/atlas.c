@@ -0,0 +1,391 @@
+// CPU-side glyph cache. Bitmaps are rasterized on miss and packed into fixed-size atlas pages with a
+// skyline packer. A skyline cannot free single rectangles, so eviction empties the least recently used
+// page as a whole and drops every entry that lived in it.
+
+#define GLYPH_CACHE_MAX_FONTS 16
+#define GLYPH_CACHE_PADDING 1 // Empty pixels kept right and below each glyph so sampling does not bleed.
+
+typedef struct {
+  u16 x;
+  u16 y;
+  u16 width;
+} SkylineNode;
+
+typedef struct {
+  u8 *pixels; // pageWidth * pageHeight coverage values.
+  SkylineNode *nodes; // Top edge of the packed area, sorted by x and covering the page width.
+  i32 nodeCount;
+  i32 entryCount;
+  u64 lastUse;
+} AtlasPage;
+
+typedef struct {
+  u64 key; // 0 marks an empty slot, see GlyphCacheKey.
+  u16 page;
+  u16 x;
+  u16 y;
+  u16 width;
+  u16 height;
+  i16 left;
+  i16 top;
+} GlyphCacheEntry;
+
+typedef struct {
+  GlyphData *glyphData;
+  GlyphOutline *outline;
+  OutlineCache *outlineCache; // Optional, misses then unpack outlines drawn at other sizes instead of decoding them.
+  f32 unitsPerEm;
+} GlyphCacheFont;
+
+typedef struct {
+  i32 pageWidth;
+  i32 pageHeight;
+  i32 pageCount;
+  AtlasPage *pages;
+
+  u32 entryCapacity; // Power of two, the table is open addressed with linear probing.
+  i32 entryCount;
+  GlyphCacheEntry *entries;
+
+  i32 fontCount;
+  GlyphCacheFont fonts[GLYPH_CACHE_MAX_FONTS];
+
+  Rasterizer *rasterizer;
+  u8 *scratchPixels;
+  u64 tick;
+
+  u64 hits;
+  u64 misses;
+  u64 evictions; // Entries dropped with their page.
+  u64 pageEvictions;
+} GlyphCache;
+
+u64 GlyphCacheKey(i32 fontId, u16 glyphId, u16 pixelSize)
+{
+  // fontId is stored plus one so that no valid key is 0.
+  return ((u64)(fontId + 1) << 32) | ((u64)pixelSize << 16) | glyphId;
+}
+
+u32 GlyphCacheSlot(GlyphCache *cache, u64 key)
+{
+  return (u32)((key * 0x9E3779B97F4A7C15ull) >> 32) & (cache->entryCapacity - 1);
+}
+
+void ResetAtlasPage(GlyphCache *cache, AtlasPage *page)
+{
+  memset(page->pixels, 0, (size_t)cache->pageWidth * cache->pageHeight);
+  page->nodes[0].x = 0;
+  page->nodes[0].y = 0;
+  page->nodes[0].width = (u16)cache->pageWidth;
+  page->nodeCount = 1;
+  page->entryCount = 0;
+  page->lastUse = 0;
+}
+
+// entryCapacity is rounded up to a power of two. Returns NULL when a page does not fit in u16 coordinates.
+GlyphCache *CreateGlyphCache(Arena *arena, i32 pageWidth, i32 pageHeight, i32 pageCount, u32 entryCapacity)
+{
+  if (pageWidth <= 0 || pageHeight <= 0 || pageWidth > 0xFFFF || pageHeight > 0xFFFF || pageCount <= 0 || pageCount > 0xFFFF)
+  {
+    fprintf(stderr, "Invalid glyph cache page layout %dx%d x%d\n", pageWidth, pageHeight, pageCount);
+    return NULL;
+  }
+
+  GlyphCache *cache = (GlyphCache *)Alloc(arena, sizeof(GlyphCache));
+  cache->pageWidth = pageWidth;
+  cache->pageHeight = pageHeight;
+  cache->pageCount = pageCount;
+  cache->pages = (AtlasPage *)Alloc(arena, pageCount * sizeof(AtlasPage));
+  for (i32 i = 0; i < pageCount; ++i)
+  {
+    AtlasPage *page = &cache->pages[i];
+    page->pixels = (u8 *)Alloc(arena, (size_t)pageWidth * pageHeight);
+    page->nodes = (SkylineNode *)Alloc(arena, (pageWidth + 1) * sizeof(SkylineNode));
+    ResetAtlasPage(cache, page);
+  }
+
+  cache->entryCapacity = 16;
+  while (cache->entryCapacity < entryCapacity) cache->entryCapacity <<= 1;
+  cache->entries = (GlyphCacheEntry *)Alloc(arena, cache->entryCapacity * sizeof(GlyphCacheEntry));
+
+  cache->rasterizer = AllocRasterizer(arena, pageWidth, pageHeight);
+  cache->scratchPixels = (u8 *)Alloc(arena, (size_t)pageWidth * pageHeight + SIMD_PADDING);
+  return cache;
+}
+
+// Returns the font id used in lookups, or -1 when the cache is full.
+i32 AddGlyphCacheFont(GlyphCache *cache, Arena *arena, GlyphData *glyphData)
+{
+  if (cache->fontCount == GLYPH_CACHE_MAX_FONTS)
+  {
+    fprintf(stderr, "Glyph cache supports at most %d fonts\n", GLYPH_CACHE_MAX_FONTS);
+    return -1;
+  }
+
+  GlyphCacheFont *font = &cache->fonts[cache->fontCount];
+  font->glyphData = glyphData;
+  font->outline = AllocGlyphOutline(arena, glyphData);
+  font->unitsPerEm = (f32)glyphData->fontHeader->unitsPerEm;
+  return cache->fontCount++;
+}
+
+GlyphCacheEntry *FindGlyphCacheEntry(GlyphCache *cache, u64 key)
+{
+  u32 mask = cache->entryCapacity - 1;
+  for (u32 slot = GlyphCacheSlot(cache, key); cache->entries[slot].key; slot = (slot + 1) & mask)
+  {
+    if (cache->entries[slot].key == key) return &cache->entries[slot];
+  }
+  return NULL;
+}
+
+GlyphCacheEntry *InsertGlyphCacheEntry(GlyphCache *cache, GlyphCacheEntry *entry)
+{
+  u32 mask = cache->entryCapacity - 1;
+  u32 slot = GlyphCacheSlot(cache, entry->key);
+  while (cache->entries[slot].key) slot = (slot + 1) & mask;
+  cache->entries[slot] = *entry;
+  ++cache->entryCount;
+  return &cache->entries[slot];
+}
+
+// Lowest position for a width x height rectangle, ties go to the narrowest node. Returns the node index or -1.
+i32 FindSkylinePosition(GlyphCache *cache, AtlasPage *page, i32 width, i32 height, i32 *bestX, i32 *bestY)
+{
+  i32 bestIndex = -1;
+  i32 bestTop = cache->pageHeight + 1;
+  i32 bestWidth = cache->pageWidth + 1;
+  for (i32 i = 0; i < page->nodeCount; ++i)
+  {
+    i32 x = page->nodes[i].x;
+    if (x + width > cache->pageWidth) break;
+
+    // The rectangle rests on the highest node it spans.
+    i32 y = 0;
+    i32 remaining = width;
+    for (i32 j = i; remaining > 0; ++j)
+    {
+      if (page->nodes[j].y > y) y = page->nodes[j].y;
+      remaining -= page->nodes[j].width;
+    }
+    if (y + height > cache->pageHeight) continue;
+
+    if (y < bestTop || (y == bestTop && page->nodes[i].width < bestWidth))
+    {
+      bestIndex = i;
+      bestTop = y;
+      bestWidth = page->nodes[i].width;
+      *bestX = x;
+      *bestY = y;
+    }
+  }
+  return bestIndex;
+}
+
+void AddSkylineLevel(AtlasPage *page, i32 index, i32 x, i32 y, i32 width, i32 height)
+{
+  memmove(&page->nodes[index + 1], &page->nodes[index], (page->nodeCount - index) * sizeof(SkylineNode));
+  ++page->nodeCount;
+  page->nodes[index].x = (u16)x;
+  page->nodes[index].y = (u16)(y + height);
+  page->nodes[index].width = (u16)width;
+
+  // Trim or drop the nodes now hidden under the new one.
+  i32 right = x + width;
+  i32 next = index + 1;
+  while (next < page->nodeCount && page->nodes[next].x < right)
+  {
+    SkylineNode *node = &page->nodes[next];
+    i32 nodeRight = node->x + node->width;
+    if (nodeRight <= right)
+    {
+      memmove(node, node + 1, (page->nodeCount - next - 1) * sizeof(SkylineNode));
+      --page->nodeCount;
+    }
+    else
+    {
+      node->width = (u16)(nodeRight - right);
+      node->x = (u16)right;
+      break;
+    }
+  }
+
+  // Merge neighbours that ended up at the same height.
+  for (i32 i = 0; i + 1 < page->nodeCount;)
+  {
+    if (page->nodes[i].y == page->nodes[i + 1].y)
+    {
+      page->nodes[i].width += page->nodes[i + 1].width;
+      memmove(&page->nodes[i + 1], &page->nodes[i + 2], (page->nodeCount - i - 2) * sizeof(SkylineNode));
+      --page->nodeCount;
+    }
+    else
+    {
+      ++i;
+    }
+  }
+}
+
+// Empties the least recently used page holding entries, or the first page when none does, and rebuilds the
+// table without its entries. Empty glyphs are dropped as well, they own no pixels and are cheap to look up
+// again.
+AtlasPage *EvictGlyphCachePage(GlyphCache *cache)
+{
+  i32 victim = -1;
+  for (i32 i = 0; i < cache->pageCount; ++i)
+  {
+    if (cache->pages[i].entryCount && (victim < 0 || cache->pages[i].lastUse < cache->pages[victim].lastUse)) victim = i;
+  }
+  if (victim < 0) victim = 0;
+
+  TmpArena scratch;
+  TmpArenaPush(&scratch, GetScratchArena(NULL));
+  GlyphCacheEntry *kept = (GlyphCacheEntry *)AllocNoZero(scratch.arena, cache->entryCount * sizeof(GlyphCacheEntry));
+  i32 keptCount = 0;
+  for (u32 slot = 0; slot < cache->entryCapacity; ++slot)
+  {
+    GlyphCacheEntry *entry = &cache->entries[slot];
+    if (!entry->key) continue;
+    if (entry->page == victim || !entry->width) ++cache->evictions;
+    else kept[keptCount++] = *entry;
+  }
+
+  memset(cache->entries, 0, cache->entryCapacity * sizeof(GlyphCacheEntry));
+  cache->entryCount = 0;
+  for (i32 i = 0; i < keptCount; ++i) InsertGlyphCacheEntry(cache, &kept[i]);
+  TmpArenaPop(&scratch);
+
+  AtlasPage *page = &cache->pages[victim];
+  ResetAtlasPage(cache, page);
+  ++cache->pageEvictions;
+  return page;
+}
+
+// Places a bitmap in the first page with room, evicting pages until one fits.
+// Returns the page index or -1 when the bitmap is larger than a page.
+i32 PackGlyphBitmap(GlyphCache *cache, GlyphBitmap *bitmap, u16 *x, u16 *y)
+{
+  i32 width = bitmap->width + GLYPH_CACHE_PADDING;
+  i32 height = bitmap->height + GLYPH_CACHE_PADDING;
+  if (width > cache->pageWidth || height > cache->pageHeight) return -1;
+
+  AtlasPage *page = NULL;
+  i32 index = -1, packedX = 0, packedY = 0;
+  for (i32 i = 0; i < cache->pageCount && index < 0; ++i)
+  {
+    page = &cache->pages[i];
+    index = FindSkylinePosition(cache, page, width, height, &packedX, &packedY);
+  }
+  if (index < 0)
+  {
+    page = EvictGlyphCachePage(cache);
+    index = FindSkylinePosition(cache, page, width, height, &packedX, &packedY);
+  }
+
+  AddSkylineLevel(page, index, packedX, packedY, width, height);
+  for (i32 row = 0; row < bitmap->height; ++row)
+  {
+    memcpy(&page->pixels[(packedY + row) * cache->pageWidth + packedX], &bitmap->pixels[row * bitmap->width], bitmap->width);
+  }
+  ++page->entryCount;
+  *x = (u16)packedX;
+  *y = (u16)packedY;
+  return (i32)(page - cache->pages);
+}
+
+// Packs a rasterized bitmap and records it under key. Returns NULL when it does not fit in a page.
+GlyphCacheEntry *AddCachedGlyphBitmap(GlyphCache *cache, u64 key, GlyphBitmap *bitmap)
+{
+  // Keep the table at most 3/4 full, evicting pages frees their slots. Any entry lives in a page or is an
+  // empty glyph, so an eviction always frees one, stopping when it does not only guards against a hang.
+  while (cache->entryCount >= (i32)(cache->entryCapacity / 4 * 3))
+  {
+    i32 entryCount = cache->entryCount;
+    EvictGlyphCachePage(cache);
+    if (cache->entryCount == entryCount) break;
+  }
+
+  GlyphCacheEntry newEntry = {0};
+  newEntry.key = key;
+  newEntry.width = (u16)bitmap->width;
+  newEntry.height = (u16)bitmap->height;
+  newEntry.left = (i16)bitmap->left;
+  newEntry.top = (i16)bitmap->top;
+  if (bitmap->width && bitmap->height)
+  {
+    i32 page = PackGlyphBitmap(cache, bitmap, &newEntry.x, &newEntry.y);
+    if (page < 0) return NULL;
+    newEntry.page = (u16)page;
+    cache->pages[page].lastUse = cache->tick;
+  }
+
+  return InsertGlyphCacheEntry(cache, &newEntry);
+}
+
+// Returns the cached glyph, rasterizing and packing it on a miss. Empty glyphs get an entry with a zero
+// size. Returns NULL when the glyph cannot be decoded or does not fit in a page. The entry is only valid
+// until the next lookup, which may evict it.
+GlyphCacheEntry *GetCachedGlyph(GlyphCache *cache, i32 fontId, u16 glyphId, u16 pixelSize)
+{
+  u64 key = GlyphCacheKey(fontId, glyphId, pixelSize);
+  ++cache->tick;
+
+  GlyphCacheEntry *entry = FindGlyphCacheEntry(cache, key);
+  if (entry)
+  {
+    ++cache->hits;
+    if (entry->width) cache->pages[entry->page].lastUse = cache->tick;
+    return entry;
+  }
+  ++cache->misses;
+
+  if (fontId < 0 || fontId >= cache->fontCount) return NULL;
+  GlyphCacheFont *font = &cache->fonts[fontId];
+  i32 decoded = font->outlineCache ? GetCachedGlyphOutline(font->outlineCache, glyphId, font->outline) : DecodeGlyphOutline(font->glyphData, glyphId, font->outline);
+  if (!decoded) return NULL;
+
+  f32 scale = (f32)pixelSize / font->unitsPerEm;
+  GlyphBitmap bitmap;
+  GetGlyphBitmapBounds(font->outline, scale, &bitmap);
+  bitmap.pixels = cache->scratchPixels;
+  if (bitmap.width > cache->pageWidth || bitmap.height > cache->pageHeight) return NULL;
+  if (!RasterizeGlyphOutline(cache->rasterizer, font->outline, scale, &bitmap)) return NULL;
+
+  return AddCachedGlyphBitmap(cache, key, &bitmap);
+}
+
+// Rasterizes every glyph of a font at the given sizes on all workers, then packs the bitmaps on the
+// calling thread. Packing stays serial since the skyline and the table are not shared safely.
+// Returns the number of glyphs that could not be cached.
+i32 WarmGlyphCache(GlyphCache *cache, JobSystem *system, Arena *arena, i32 fontId, u16 *pixelSizes, i32 sizeCount)
+{
+  if (fontId < 0 || fontId >= cache->fontCount) return 0;
+  GlyphData *glyphData = cache->fonts[fontId].glyphData;
+
+  TmpArena tmp;
+  TmpArenaPush(&tmp, arena);
+  TmpArena *workerTmps = (TmpArena *)Alloc(arena, system->workerCount * sizeof(TmpArena));
+  for (i32 i = 0; i < system->workerCount; ++i) TmpArenaPush(&workerTmps[i], &system->workers[i].arena);
+
+  i32 count = sizeCount * glyphData->numGlyphs;
+  GlyphBitmap *bitmaps = (GlyphBitmap *)Alloc(arena, count * sizeof(GlyphBitmap));
+  i32 failures = PrerasterizeGlyphs(system, arena, glyphData, pixelSizes, sizeCount, bitmaps);
+
+  PROFILE_BEGIN(PackGlyphBitmaps);
+  for (i32 i = 0; i < count; ++i)
+  {
+    u16 glyphId = (u16)(i % glyphData->numGlyphs);
+    u64 key = GlyphCacheKey(fontId, glyphId, pixelSizes[i / glyphData->numGlyphs]);
+    if (!bitmaps[i].pixels || FindGlyphCacheEntry(cache, key)) continue;
+    ++cache->tick;
+    if (!AddCachedGlyphBitmap(cache, key, &bitmaps[i])) ++failures;
+  }
+  PROFILE_END(PackGlyphBitmaps);
+  PROFILE_COUNTER("glyph cache", "hits", cache->hits);
+  PROFILE_COUNTER("glyph cache", "misses", cache->misses);
+  PROFILE_COUNTER("glyph cache", "evictions", cache->evictions);
+
+  for (i32 i = 0; i < system->workerCount; ++i) TmpArenaPop(&workerTmps[i]);
+  TmpArenaPop(&tmp);
+  return failures;
+}
@@ -0,0 +1,2651 @@
+// Built instead of the regular entry point when BENCHMARK=1, run from the repository root.
+// Usage: fleuret [benchmark name]
+
+#define BENCHMARK_FONT_PATH "fonts/NotoSans.ttf"
+#define BENCHMARK_TRACE_PATH "fleuret-benchmark.trace.json"
+#define BENCHMARK_CFF_FONT_PATH "fonts/NotoSansCFF.otf" // NotoSans with subroutinized, counter-clockwise CFF outlines.
+#define BENCHMARK_VARIABLE_FONT_PATH "fonts/NotoSansVF.ttf" // Latin NotoSans with wght and wdth axes.
+#define BENCHMARK_WOFF_FONT_PATH "fonts/NotoSans.woff" // NotoSans compressed with zlib.
+
+char *bundledFontPaths[] = { "fonts/NotoSans.ttf", "fonts/BitstreamVeraSansMonoRoman.ttf" };
+#define BUNDLED_FONT_COUNT (i32)(sizeof(bundledFontPaths) / sizeof(bundledFontPaths[0]))
+
+typedef struct {
+  char *name;
+  void (*run)(Arena *arena);
+} Benchmark;
+
+u32 RandomU32(u32 *state)
+{
+  u32 x = *state;
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  *state = x;
+  return x;
+}
+
+void BenchmarkFontLoading(Arena *arena)
+{
+  i32 iterations = 2000;
+  i32 residentFonts = 200;
+
+  // Copy path: read the whole file into the arena then decode the directory and the cmap header.
+  f64 start = GetWallClockSeconds();
+  for (i32 i = 0; i < iterations; ++i)
+  {
+    TmpArena tmp;
+    TmpArenaPush(&tmp, arena);
+    size_t fileSize = 0;
+    char *buffer = ReadWholeFile(arena, BENCHMARK_FONT_PATH, &fileSize);
+    TableDirectory *directory = ReadTableDirectory(arena, MakeFontView(buffer, fileSize));
+    for (i32 j = 0; j < directory->numTables; ++j)
+    {
+      if (directory->tableRecords[j].tag.value == READ_BIG_ENDIAN_U32("cmap"))
+      {
+        ReadCodepointMapTableHeader(arena, FontSubView(MakeFontView(buffer, fileSize), directory->tableRecords[j].offset, directory->tableRecords[j].length));
+      }
+    }
+    TmpArenaPop(&tmp);
+  }
+  f64 copySeconds = GetWallClockSeconds() - start;
+
+  // Mapped path: map the file, decode the directory and read the cmap header through a view.
+  u32 checksum = 0;
+  start = GetWallClockSeconds();
+  for (i32 i = 0; i < iterations; ++i)
+  {
+    TmpArena tmp;
+    TmpArenaPush(&tmp, arena);
+    Font font;
+    LoadFont(arena, BENCHMARK_FONT_PATH, &font);
+    FontView cmap = GetTableView(&font, READ_BIG_ENDIAN_U32("cmap"));
+    checksum += ViewU16(cmap, 2);
+    UnloadFont(&font);
+    TmpArenaPop(&tmp);
+  }
+  f64 mapSeconds = GetWallClockSeconds() - start;
+
+  printf("copy:   %10.0f fonts/s\n", iterations / copySeconds);
+  printf("mapped: %10.0f fonts/s (%.1fx)\n", iterations / mapSeconds, copySeconds / mapSeconds);
+
+  // Resident memory while keeping many fonts loaded at once, the mapped path goes first since arena pages stay resident.
+  Font *fonts = (Font *)Alloc(arena, residentFonts * sizeof(Font));
+  size_t residentBefore = GetResidentBytes();
+  for (i32 i = 0; i < residentFonts; ++i)
+  {
+    LoadFont(arena, BENCHMARK_FONT_PATH, &fonts[i]);
+    FontView cmap = GetTableView(&fonts[i], READ_BIG_ENDIAN_U32("cmap"));
+    checksum += ViewU16(cmap, 2);
+  }
+  size_t mapResident = GetResidentBytes() - residentBefore;
+  for (i32 i = 0; i < residentFonts; ++i)
+  {
+    UnloadFont(&fonts[i]);
+  }
+
+  residentBefore = GetResidentBytes();
+  for (i32 i = 0; i < residentFonts; ++i)
+  {
+    size_t fileSize = 0;
+    char *buffer = ReadWholeFile(arena, BENCHMARK_FONT_PATH, &fileSize);
+    ReadTableDirectory(arena, MakeFontView(buffer, fileSize));
+  }
+  size_t copyResident = GetResidentBytes() - residentBefore;
+
+  printf("RSS with %d fonts loaded: copy %.2f MB, mapped %.2f MB (checksum %u)\n",
+         residentFonts, copyResident / (f64)MB, mapResident / (f64)MB, checksum);
+}
+
+void BenchmarkCodepointLookup(Arena *arena)
+{
+  i32 streamLength = 1 << 20;
+  i32 passes = 16;
+
+  Font font;
+  if (!LoadFont(arena, BENCHMARK_FONT_PATH, &font)) return;
+
+  CodepointMap searchMap;
+  LoadCodepointMap(arena, &font, &searchMap, 0);
+
+  f64 start = GetWallClockSeconds();
+  CodepointMap tableMap;
+  LoadCodepointMap(arena, &font, &tableMap, CODEPOINT_MAP_BMP_TABLE);
+  printf("BMP table built in %.3f ms\n", (GetWallClockSeconds() - start) * 1000.0);
+
+  for (u32 codepoint = 0; codepoint < BMP_GLYPH_TABLE_SIZE; ++codepoint)
+  {
+    if (GlyphIndexFromCodepoint(&searchMap, codepoint) != GlyphIndexFromCodepoint(&tableMap, codepoint))
+    {
+      fprintf(stderr, "Lookup mismatch for U+%04X\n", codepoint);
+      return;
+    }
+  }
+
+  u32 *randomStream = (u32 *)Alloc(arena, streamLength * sizeof(u32));
+  u32 *latinStream = (u32 *)Alloc(arena, streamLength * sizeof(u32));
+  u32 seed = 0x9E3779B9;
+  for (i32 i = 0; i < streamLength; ++i)
+  {
+    randomStream[i] = RandomU32(&seed) & 0xFFFF;
+
+    u32 roll = RandomU32(&seed) % 100;
+    if (roll < 90) latinStream[i] = 0x20 + RandomU32(&seed) % 95;
+    else if (roll < 98) latinStream[i] = 0xA0 + RandomU32(&seed) % 0x1B0;
+    else latinStream[i] = RandomU32(&seed) & 0xFFFF;
+  }
+
+  char *streamNames[] = { "random", "latin" };
+  u32 *streams[] = { randomStream, latinStream };
+  CodepointMap *maps[] = { &searchMap, &tableMap };
+  char *mapNames[] = { "binary search", "BMP table" };
+  u32 checksum = 0;
+  for (i32 s = 0; s < 2; ++s)
+  {
+    for (i32 m = 0; m < 2; ++m)
+    {
+      start = GetWallClockSeconds();
+      for (i32 pass = 0; pass < passes; ++pass)
+      {
+        for (i32 i = 0; i < streamLength; ++i)
+        {
+          checksum += GlyphIndexFromCodepoint(maps[m], streams[s][i]);
+        }
+      }
+      f64 seconds = GetWallClockSeconds() - start;
+      printf("%-6s %-13s: %8.1f M lookups/s\n", streamNames[s], mapNames[m], (f64)streamLength * passes / seconds / 1e6);
+    }
+  }
+  printf("(checksum %u)\n", checksum);
+
+  UnloadFont(&font);
+}
+
+void BenchmarkBatchLookup(Arena *arena)
+{
+  i32 streamLength = 1 << 20;
+  i32 passes = 8;
+
+  Font font;
+  if (!LoadFont(arena, BENCHMARK_FONT_PATH, &font)) return;
+
+  CodepointMap searchMap, tableMap;
+  LoadCodepointMap(arena, &font, &searchMap, 0);
+  LoadCodepointMap(arena, &font, &tableMap, CODEPOINT_MAP_BMP_TABLE);
+
+  u32 *codepoints = (u32 *)Alloc(arena, streamLength * sizeof(u32));
+  u8 *utf8 = (u8 *)Alloc(arena, streamLength * 4);
+  u16 *expected = (u16 *)Alloc(arena, streamLength * sizeof(u16));
+  u16 *glyphIds = (u16 *)Alloc(arena, streamLength * sizeof(u16));
+
+  // Latin-heavy text with some BMP noise and a few supplementary plane codepoints.
+  u32 seed = 0x2545F491;
+  i32 utf8Length = 0;
+  for (i32 i = 0; i < streamLength; ++i)
+  {
+    u32 roll = RandomU32(&seed) % 100;
+    u32 codepoint = roll < 85 ? 0x20 + RandomU32(&seed) % 95 : roll < 99 ? 0xA0 + RandomU32(&seed) % 0x2000 : 0x1F600 + roll;
+    if (codepoint >= 0xD800 && codepoint <= 0xDFFF) codepoint = 0x20;
+    codepoints[i] = codepoint;
+
+    if (codepoint < 0x80) utf8[utf8Length++] = (u8)codepoint;
+    else if (codepoint < 0x800)
+    {
+      utf8[utf8Length++] = (u8)(0xC0 | (codepoint >> 6));
+      utf8[utf8Length++] = (u8)(0x80 | (codepoint & 0x3F));
+    }
+    else if (codepoint < 0x10000)
+    {
+      utf8[utf8Length++] = (u8)(0xE0 | (codepoint >> 12));
+      utf8[utf8Length++] = (u8)(0x80 | ((codepoint >> 6) & 0x3F));
+      utf8[utf8Length++] = (u8)(0x80 | (codepoint & 0x3F));
+    }
+    else
+    {
+      utf8[utf8Length++] = (u8)(0xF0 | (codepoint >> 18));
+      utf8[utf8Length++] = (u8)(0x80 | ((codepoint >> 12) & 0x3F));
+      utf8[utf8Length++] = (u8)(0x80 | ((codepoint >> 6) & 0x3F));
+      utf8[utf8Length++] = (u8)(0x80 | (codepoint & 0x3F));
+    }
+  }
+
+  CpuFeatures *features = GetCpuFeatures();
+  CodepointMap *maps[] = { &searchMap, &tableMap };
+  char *mapNames[] = { "search", "table" };
+  for (i32 m = 0; m < 2; ++m)
+  {
+    CodepointMap *map = maps[m];
+    f64 start = GetWallClockSeconds();
+    for (i32 pass = 0; pass < passes; ++pass)
+    {
+      for (i32 i = 0; i < streamLength; ++i)
+      {
+        expected[i] = GlyphIndexFromCodepoint(map, codepoints[i]);
+      }
+    }
+    f64 scalarSeconds = GetWallClockSeconds() - start;
+    printf("%-6s per codepoint: %6.3f codepoints/ns\n", mapNames[m], (f64)streamLength * passes / scalarSeconds * 1e-9);
+
+#if SIMD_X86
+    void (*paths[])(CodepointMap *, u32 *, i32, u16 *) = { GlyphIndicesFromCodepointsSse2, GlyphIndicesFromCodepointsAvx2 };
+    char *pathNames[] = { "SSE2", "AVX2" };
+    i32 supported[] = { features->hasSse2, features->hasAvx2 };
+    for (i32 p = 0; p < 2; ++p)
+    {
+      if (!supported[p]) continue;
+      start = GetWallClockSeconds();
+      for (i32 pass = 0; pass < passes; ++pass)
+      {
+        paths[p](map, codepoints, streamLength, glyphIds);
+      }
+      f64 seconds = GetWallClockSeconds() - start;
+      i32 matches = memcmp(glyphIds, expected, streamLength * sizeof(u16)) == 0;
+      printf("%-6s %-13s: %6.3f codepoints/ns (%.2fx)%s\n", mapNames[m], pathNames[p],
+             (f64)streamLength * passes / seconds * 1e-9, scalarSeconds / seconds, matches ? "" : " MISMATCH");
+    }
+#else
+    (void)features;
+#endif
+
+    start = GetWallClockSeconds();
+    i32 glyphCount = 0;
+    for (i32 pass = 0; pass < passes; ++pass)
+    {
+      glyphCount = GlyphIndicesFromUtf8(map, utf8, utf8Length, glyphIds);
+    }
+    f64 seconds = GetWallClockSeconds() - start;
+    i32 matches = glyphCount == streamLength && memcmp(glyphIds, expected, streamLength * sizeof(u16)) == 0;
+    printf("%-6s %-13s: %6.3f codepoints/ns%s\n", mapNames[m], "UTF-8", (f64)streamLength * passes / seconds * 1e-9, matches ? "" : " MISMATCH");
+  }
+
+  UnloadFont(&font);
+}
+
+void BenchmarkByteSwap(Arena *arena)
+{
+  char *tableNames[] = { "cmap", "loca", "hmtx", "glyf" };
+  char *pathNames[] = { "scalar", "SSSE3", "AVX2" };
+  void (*u16Paths[])(u16 *, u8 *, i32) = {
+    ReadBigEndianU16ArrayScalar,
+#if SIMD_X86
+    ReadBigEndianU16ArraySsse3, ReadBigEndianU16ArrayAvx2,
+#endif
+  };
+  CpuFeatures *features = GetCpuFeatures();
+  i32 supported[] = { 1, features->hasSsse3, features->hasAvx2 };
+  i32 pathCount = (i32)(sizeof(u16Paths) / sizeof(u16Paths[0]));
+
+  for (i32 f = 0; f < BUNDLED_FONT_COUNT; ++f)
+  {
+    Font font;
+    if (!LoadFont(arena, bundledFontPaths[f], &font)) continue;
+    printf("%s\n", bundledFontPaths[f]);
+
+    // Raw decode throughput over whole tables, as u16 arrays.
+    for (i32 t = 0; t < 4; ++t)
+    {
+      FontView table = GetTableView(&font, READ_BIG_ENDIAN_U32(tableNames[t]));
+      i32 count = (i32)(table.length / 2);
+      u16 *destination = (u16 *)Alloc(arena, count * sizeof(u16));
+      i32 iterations = 1 + (64 * (i32)MB) / (table.length + 1);
+
+      printf("  %s %7u bytes:", tableNames[t], table.length);
+      for (i32 p = 0; p < pathCount; ++p)
+      {
+        if (!supported[p]) continue;
+        f64 start = GetWallClockSeconds();
+        for (i32 i = 0; i < iterations; ++i)
+        {
+          u16Paths[p](destination, table.data, count);
+        }
+        f64 seconds = GetWallClockSeconds() - start;
+        printf(" %s %6.2f GB/s", pathNames[p], (f64)count * 2 * iterations / seconds * 1e-9);
+      }
+      printf("\n");
+    }
+
+    // Directory and cmap parse time with the bulk decoder forced to scalar, then with the dispatched path.
+    CpuFeatures savedFeatures = cpuFeatures;
+    i32 iterations = 20000;
+    f64 parseSeconds[2];
+    for (i32 pass = 0; pass < 2; ++pass)
+    {
+      if (pass == 0) cpuFeatures.hasSsse3 = cpuFeatures.hasAvx2 = 0;
+      else cpuFeatures = savedFeatures;
+
+      f64 start = GetWallClockSeconds();
+      for (i32 i = 0; i < iterations; ++i)
+      {
+        TmpArena tmp;
+        TmpArenaPush(&tmp, arena);
+        CodepointMap codepointMap;
+        ReadTableDirectory(arena, font.view);
+        LoadCodepointMap(arena, &font, &codepointMap, 0);
+        TmpArenaPop(&tmp);
+      }
+      parseSeconds[pass] = GetWallClockSeconds() - start;
+    }
+    printf("  parse directory+cmap: before %.2f us, after %.2f us (%.2fx)\n",
+           parseSeconds[0] / iterations * 1e6, parseSeconds[1] / iterations * 1e6, parseSeconds[0] / parseSeconds[1]);
+
+    UnloadFont(&font);
+  }
+}
+
+void MeasureCodepointMap(Arena *arena, char *name, CodepointMapSubtable *subtable)
+{
+  i32 streamLength = 1 << 20;
+  i32 passes = 8;
+
+  CodepointMap searchMap = { subtable, NULL, NULL };
+  CodepointMap pageMap = { subtable, NULL, NULL };
+  f64 start = GetWallClockSeconds();
+  pageMap.pageTable = BuildCodepointPageTable(arena, subtable);
+  f64 buildSeconds = GetWallClockSeconds() - start;
+
+  size_t subtableBytes = 0;
+  i32 rangeCount = GetSubtableRangeCount(subtable);
+  u32 coveredCodepoints = 0;
+  for (i32 i = 0; i < rangeCount; ++i)
+  {
+    CodepointRange range = GetSubtableRange(subtable, i);
+    if (range.first <= range.last) coveredCodepoints += range.last - range.first + 1;
+  }
+  if (subtable->format == 12 || subtable->format == 13) subtableBytes = subtable->value.format12->numGroups * sizeof(SequentialMapGroup);
+  else if (subtable->format == 4) subtableBytes = (size_t)subtable->value.format4->length;
+
+  printf("%s: format %d, %d ranges, %u codepoints\n", name, subtable->format, rangeCount, coveredCodepoints);
+  printf("  memory: subtable %.1f KB, page table %.1f KB (%d pages, built in %.2f ms), BMP table alone %.1f KB\n",
+         subtableBytes / (f64)KB, GetCodepointPageTableSize(pageMap.pageTable) / (f64)KB, pageMap.pageTable->pageCount,
+         buildSeconds * 1000.0, BMP_GLYPH_TABLE_SIZE * sizeof(u16) / (f64)KB);
+
+  // Covered codepoints drawn from the ranges, and uniform codepoints over all 17 planes.
+  u32 *coveredStream = (u32 *)Alloc(arena, streamLength * sizeof(u32));
+  u32 *uniformStream = (u32 *)Alloc(arena, streamLength * sizeof(u32));
+  u32 seed = 0x1B873593;
+  for (i32 i = 0; i < streamLength; ++i)
+  {
+    CodepointRange range = GetSubtableRange(subtable, RandomU32(&seed) % rangeCount);
+    coveredStream[i] = range.first + RandomU32(&seed) % (range.last - range.first + 1);
+    uniformStream[i] = RandomU32(&seed) % 0x110000;
+  }
+
+  char *streamNames[] = { "covered", "uniform" };
+  u32 *streams[] = { coveredStream, uniformStream };
+  CodepointMap *maps[] = { &searchMap, &pageMap };
+  char *mapNames[] = { "binary search", "page table" };
+  u32 checksums[2] = {0};
+  for (i32 s = 0; s < 2; ++s)
+  {
+    for (i32 m = 0; m < 2; ++m)
+    {
+      start = GetWallClockSeconds();
+      for (i32 pass = 0; pass < passes; ++pass)
+      {
+        for (i32 i = 0; i < streamLength; ++i)
+        {
+          checksums[m] += GlyphIndexFromCodepoint(maps[m], streams[s][i]);
+        }
+      }
+      f64 seconds = GetWallClockSeconds() - start;
+      printf("  %-7s %-13s: %6.2f ns/lookup\n", streamNames[s], mapNames[m], seconds / ((f64)streamLength * passes) * 1e9);
+    }
+  }
+  if (checksums[0] != checksums[1]) printf("  MISMATCH\n");
+}
+
+void BenchmarkSupplementaryPlanes(Arena *arena)
+{
+  Font font;
+  if (!LoadFont(arena, BENCHMARK_FONT_PATH, &font)) return;
+
+  CodepointMap codepointMap;
+  LoadCodepointMap(arena, &font, &codepointMap, 0);
+  MeasureCodepointMap(arena, BENCHMARK_FONT_PATH, codepointMap.subtable);
+  UnloadFont(&font);
+
+  // Synthetic pan-Unicode font: every 256 codepoint block of planes 0 to 3 and 14 is partially covered.
+  u32 planes[] = { 0, 1, 2, 3, 14 };
+  u32 maxGroups = 5 * 256 * 3;
+  CodepointMapSubtable *subtable = (CodepointMapSubtable *)Alloc(arena, sizeof(CodepointMapSubtable));
+  CodepointMapFormat12 *format12 = (CodepointMapFormat12 *)Alloc(arena, sizeof(CodepointMapFormat12));
+  format12->groups = (SequentialMapGroup *)Alloc(arena, maxGroups * sizeof(SequentialMapGroup));
+  subtable->format = 12;
+  subtable->value.format12 = format12;
+
+  u32 seed = 0xCC9E2D51;
+  u32 glyphId = 1;
+  for (i32 p = 0; p < 5; ++p)
+  {
+    for (u32 block = 0; block < 256; ++block)
+    {
+      u32 blockStart = (planes[p] << 16) | (block << 8);
+      u32 groupCount = 1 + RandomU32(&seed) % 3;
+      for (u32 g = 0; g < groupCount; ++g)
+      {
+        u32 first = blockStart + g * 85 + RandomU32(&seed) % 16;
+        u32 last = first + 16 + RandomU32(&seed) % 64;
+        if (glyphId + (last - first) > 0xFFFF) glyphId = 1;
+        SequentialMapGroup *group = &format12->groups[format12->numGroups++];
+        group->startCharCode = first;
+        group->endCharCode = last;
+        group->startGlyphID = glyphId;
+        glyphId += last - first + 1;
+      }
+    }
+  }
+  format12->length = 16 + format12->numGroups * sizeof(SequentialMapGroup);
+  MeasureCodepointMap(arena, "synthetic full coverage", subtable);
+}
+
+void BenchmarkOutlineDecoding(Arena *arena)
+{
+  i32 passes = 50;
+
+  Font font;
+  if (!LoadFont(arena, BENCHMARK_FONT_PATH, &font)) return;
+
+  f64 start = GetWallClockSeconds();
+  GlyphData glyphData;
+  if (!LoadGlyphData(arena, &font, &glyphData)) return;
+  GlyphOutline *outline = AllocGlyphOutline(arena, &glyphData);
+  printf("head/maxp/loca parsed in %.1f us, outline buffer sized for %d points and %d contours\n",
+         (GetWallClockSeconds() - start) * 1e6, outline->pointCapacity, outline->contourCapacity);
+
+  i32 composites = 0;
+  i32 failures = 0;
+  i64 points = 0;
+  for (u16 glyphId = 0; glyphId < glyphData.numGlyphs; ++glyphId)
+  {
+    FontView glyph = GetGlyphView(&glyphData, glyphId);
+    if (glyph.length && ViewI16(glyph, 0) < 0) ++composites;
+    if (!DecodeGlyphOutline(&glyphData, glyphId, outline)) ++failures;
+    points += outline->pointCount;
+  }
+
+  start = GetWallClockSeconds();
+  for (i32 pass = 0; pass < passes; ++pass)
+  {
+    for (u16 glyphId = 0; glyphId < glyphData.numGlyphs; ++glyphId)
+    {
+      DecodeGlyphOutline(&glyphData, glyphId, outline);
+    }
+  }
+  f64 seconds = GetWallClockSeconds() - start;
+
+  printf("%d glyphs (%d composites, %d failed), %lld points\n", glyphData.numGlyphs, composites, failures, (long long)points);
+  printf("decode: %.2f M glyphs/s, %.1f M points/s\n",
+         (f64)glyphData.numGlyphs * passes / seconds * 1e-6, (f64)points * passes / seconds * 1e-6);
+
+  UnloadFont(&font);
+}
+
+typedef void AccumulateCoverageFunction(f32 *accumulation, u8 *pixels, i32 count);
+
+// Mirrors RasterizeGlyphOutline with a fixed accumulation pass so both variants can be timed.
+void RasterizeGlyphWith(Rasterizer *rasterizer, GlyphOutline *outline, f32 scale, GlyphBitmap *bitmap,
+                        AccumulateCoverageFunction *accumulate)
+{
+  i32 area = bitmap->width * bitmap->height;
+  if (!area) return;
+  rasterizer->scale = scale;
+  rasterizer->offsetX = (f32)bitmap->left;
+  rasterizer->offsetY = (f32)bitmap->top;
+  RasterizeContours(rasterizer, outline, bitmap->width, bitmap->height);
+  accumulate(rasterizer->accumulation, bitmap->pixels, area);
+  memset(&rasterizer->accumulation[area], 0, 4 * sizeof(f32));
+}
+
+void BenchmarkRasterization(Arena *arena)
+{
+  i32 pixelSizes[] = { 16, 32, 64 };
+  i32 passes = 5;
+
+  Font font;
+  if (!LoadFont(arena, BENCHMARK_FONT_PATH, &font)) return;
+  GlyphData glyphData;
+  if (!LoadGlyphData(arena, &font, &glyphData)) return;
+  GlyphOutline *decoded = AllocGlyphOutline(arena, &glyphData);
+
+  // Outlines are decoded once up front so only rasterization is timed.
+  GlyphOutline *outlines = (GlyphOutline *)Alloc(arena, glyphData.numGlyphs * sizeof(GlyphOutline));
+  f32 maxExtent = 0;
+  for (u16 glyphId = 0; glyphId < glyphData.numGlyphs; ++glyphId)
+  {
+    DecodeGlyphOutline(&glyphData, glyphId, decoded);
+    GlyphOutline *outline = &outlines[glyphId];
+    *outline = *decoded;
+    outline->x = (f32 *)Alloc(arena, decoded->pointCount * sizeof(f32));
+    outline->y = (f32 *)Alloc(arena, decoded->pointCount * sizeof(f32));
+    outline->onCurve = (u8 *)Alloc(arena, decoded->pointCount);
+    outline->contourEnds = (u16 *)Alloc(arena, decoded->contourCount * sizeof(u16));
+    memcpy(outline->x, decoded->x, decoded->pointCount * sizeof(f32));
+    memcpy(outline->y, decoded->y, decoded->pointCount * sizeof(f32));
+    memcpy(outline->onCurve, decoded->onCurve, decoded->pointCount);
+    memcpy(outline->contourEnds, decoded->contourEnds, decoded->contourCount * sizeof(u16));
+    for (i32 i = 0; i < decoded->pointCount; ++i)
+    {
+      if (fabsf(decoded->x[i]) > maxExtent) maxExtent = fabsf(decoded->x[i]);
+      if (fabsf(decoded->y[i]) > maxExtent) maxExtent = fabsf(decoded->y[i]);
+    }
+  }
+
+  f32 unitsPerEm = (f32)glyphData.fontHeader->unitsPerEm;
+  i32 maxSide = 2 * (i32)ceilf(maxExtent * pixelSizes[2] / unitsPerEm) + 2;
+  Rasterizer *rasterizer = AllocRasterizer(arena, maxSide, maxSide);
+  u8 *scalarPixels = (u8 *)Alloc(arena, maxSide * maxSide);
+  u8 *simdPixels = (u8 *)Alloc(arena, maxSide * maxSide);
+
+  for (i32 size = 0; size < (i32)(sizeof(pixelSizes) / sizeof(pixelSizes[0])); ++size)
+  {
+    f32 scale = (f32)pixelSizes[size] / unitsPerEm;
+
+    i64 pixels = 0;
+    i32 mismatches = 0;
+    for (u16 glyphId = 0; glyphId < glyphData.numGlyphs; ++glyphId)
+    {
+      GlyphBitmap scalarBitmap, simdBitmap;
+      GetGlyphBitmapBounds(&outlines[glyphId], scale, &scalarBitmap);
+      simdBitmap = scalarBitmap;
+      scalarBitmap.pixels = scalarPixels;
+      simdBitmap.pixels = simdPixels;
+      RasterizeGlyphWith(rasterizer, &outlines[glyphId], scale, &scalarBitmap, AccumulateCoverageScalar);
+      RasterizeGlyphOutline(rasterizer, &outlines[glyphId], scale, &simdBitmap);
+      i32 area = scalarBitmap.width * scalarBitmap.height;
+      for (i32 i = 0; i < area; ++i)
+      {
+        if (abs((i32)scalarPixels[i] - (i32)simdPixels[i]) > 1) { ++mismatches; break; }
+      }
+      pixels += area;
+    }
+
+    f64 seconds[2];
+    for (i32 variant = 0; variant < 2; ++variant)
+    {
+      AccumulateCoverageFunction *accumulate = variant ? AccumulateCoverage : AccumulateCoverageScalar;
+      f64 start = GetWallClockSeconds();
+      for (i32 pass = 0; pass < passes; ++pass)
+      {
+        for (u16 glyphId = 0; glyphId < glyphData.numGlyphs; ++glyphId)
+        {
+          GlyphBitmap bitmap;
+          GetGlyphBitmapBounds(&outlines[glyphId], scale, &bitmap);
+          bitmap.pixels = simdPixels;
+          RasterizeGlyphWith(rasterizer, &outlines[glyphId], scale, &bitmap, accumulate);
+        }
+      }
+      seconds[variant] = GetWallClockSeconds() - start;
+    }
+
+    // The accumulation pass alone, over a buffer as large as all glyph bitmaps of this size.
+    f64 accumulateSeconds[2];
+    for (i32 variant = 0; variant < 2; ++variant)
+    {
+      AccumulateCoverageFunction *accumulate = variant ? AccumulateCoverage : AccumulateCoverageScalar;
+      f64 start = GetWallClockSeconds();
+      for (i32 pass = 0; pass < passes; ++pass)
+      {
+        for (u16 glyphId = 0; glyphId < glyphData.numGlyphs; ++glyphId)
+        {
+          GlyphBitmap bitmap;
+          GetGlyphBitmapBounds(&outlines[glyphId], scale, &bitmap);
+          accumulate(rasterizer->accumulation, simdPixels, bitmap.width * bitmap.height);
+        }
+      }
+      accumulateSeconds[variant] = GetWallClockSeconds() - start;
+    }
+
+    f64 glyphCount = (f64)glyphData.numGlyphs * passes;
+    f64 pixelCount = (f64)pixels * passes;
+    printf("%2d px: %lld pixels per pass, %d glyphs differ between variants\n", pixelSizes[size], (long long)pixels, mismatches);
+    printf("  scalar: %.0f K glyphs/s, %.2f ns/pixel (accumulate %.2f ns/pixel)\n",
+           glyphCount / seconds[0] * 1e-3, seconds[0] / pixelCount * 1e9, accumulateSeconds[0] / pixelCount * 1e9);
+    printf("  simd:   %.0f K glyphs/s, %.2f ns/pixel (accumulate %.2f ns/pixel)\n",
+           glyphCount / seconds[1] * 1e-3, seconds[1] / pixelCount * 1e9, accumulateSeconds[1] / pixelCount * 1e9);
+  }
+
+  UnloadFont(&font);
+}
+
+// A recorded UI session: mostly body text at a few sizes with headings, plus a long tail of rarely seen
+// glyphs that forces evictions once the atlas is small enough.
+char *glyphCacheTraceText =
+  "The quick brown fox jumps over the lazy dog. Pack my box with five dozen liquor jugs! "
+  "Sphinx of black quartz, judge my vow; How vexingly quick daft zebras jump (1234567890). "
+  "Font rendering caches rasterized glyphs so that repeated frames only pay for new text.";
+
+void ReplayGlyphCacheTrace(GlyphCache *cache, i32 fontId, u16 *traceGlyphs, u16 *traceSizes, i32 traceLength, char *label)
+{
+  f64 start = GetWallClockSeconds();
+  for (i32 i = 0; i < traceLength; ++i)
+  {
+    GetCachedGlyph(cache, fontId, traceGlyphs[i], traceSizes[i]);
+  }
+  f64 seconds = GetWallClockSeconds() - start;
+
+  u64 lookups = cache->hits + cache->misses;
+  printf("%-18s hit rate %.2f%% (%llu hits, %llu misses), %llu entries evicted in %llu page evictions, %.0f ns/lookup\n",
+         label, 100.0 * cache->hits / lookups, (unsigned long long)cache->hits, (unsigned long long)cache->misses,
+         (unsigned long long)cache->evictions, (unsigned long long)cache->pageEvictions, seconds / traceLength * 1e9);
+}
+
+void BenchmarkGlyphCache(Arena *arena)
+{
+  i32 frames = 200;
+  u16 sizes[] = { 14, 14, 14, 14, 16, 16, 20, 32 };
+
+  Font font;
+  if (!LoadFont(arena, BENCHMARK_FONT_PATH, &font)) return;
+  GlyphData glyphData;
+  if (!LoadGlyphData(arena, &font, &glyphData)) return;
+  CodepointMap codepointMap;
+  if (!LoadCodepointMap(arena, &font, &codepointMap, 0)) return;
+
+  // Every frame redraws the text at a rotating size and adds a few glyphs from the long tail.
+  i32 textLength = (i32)strlen(glyphCacheTraceText);
+  i32 tailPerFrame = 8;
+  i32 traceLength = frames * (textLength + tailPerFrame);
+  u16 *traceGlyphs = (u16 *)Alloc(arena, traceLength * sizeof(u16));
+  u16 *traceSizes = (u16 *)Alloc(arena, traceLength * sizeof(u16));
+  u32 random = 0x2545F491;
+  i32 count = 0;
+  for (i32 frame = 0; frame < frames; ++frame)
+  {
+    u16 size = sizes[RandomU32(&random) % (sizeof(sizes) / sizeof(sizes[0]))];
+    for (i32 i = 0; i < textLength; ++i)
+    {
+      traceGlyphs[count] = GlyphIndexFromCodepoint(&codepointMap, (u8)glyphCacheTraceText[i]);
+      traceSizes[count++] = size;
+    }
+    for (i32 i = 0; i < tailPerFrame; ++i)
+    {
+      traceGlyphs[count] = (u16)(RandomU32(&random) % glyphData.numGlyphs);
+      traceSizes[count++] = sizes[RandomU32(&random) % (sizeof(sizes) / sizeof(sizes[0]))];
+    }
+  }
+
+  // The last configuration misses as often as the one before, but unpacks outlines seen at other sizes.
+  // A 16 entry table fills long before two large pages do, entries are then evicted to free slots.
+  struct { i32 pageSize; i32 pageCount; u32 entryCapacity; i32 outlines; char *label; } configurations[] = {
+    { 1024, 4, 8192, 0, "4 x 1024^2 pages" },
+    { 256, 4, 8192, 0, "4 x 256^2 pages" },
+    { 128, 2, 8192, 0, "2 x 128^2 pages" },
+    { 128, 2, 8192, 1, "... + outlines" },
+    { 512, 2, 16, 0, "2 x 512^2 16 slots" },
+  };
+  for (i32 c = 0; c < (i32)(sizeof(configurations) / sizeof(configurations[0])); ++c)
+  {
+    TmpArena tmp;
+    TmpArenaPush(&tmp, arena);
+    GlyphCache *cache = CreateGlyphCache(arena, configurations[c].pageSize, configurations[c].pageSize, configurations[c].pageCount, configurations[c].entryCapacity);
+    i32 fontId = AddGlyphCacheFont(cache, arena, &glyphData);
+    if (configurations[c].outlines) cache->fonts[fontId].outlineCache = CreateOutlineCache(arena, &glyphData, 1 * MB);
+    ReplayGlyphCacheTrace(cache, fontId, traceGlyphs, traceSizes, traceLength, configurations[c].label);
+
+    // Once warm, a hit is a hash probe.
+    u64 misses = cache->misses;
+    f64 start = GetWallClockSeconds();
+    for (i32 i = 0; i < textLength; ++i) GetCachedGlyph(cache, fontId, traceGlyphs[i], traceSizes[0]);
+    f64 warmStart = GetWallClockSeconds();
+    for (i32 pass = 0; pass < 1000; ++pass)
+    {
+      for (i32 i = 0; i < textLength; ++i) GetCachedGlyph(cache, fontId, traceGlyphs[i], traceSizes[0]);
+    }
+    f64 end = GetWallClockSeconds();
+    printf("%-18s warm-up %.1f us (%llu misses), hit latency %.1f ns/lookup\n", "",
+           (warmStart - start) * 1e6, (unsigned long long)(cache->misses - misses), (end - warmStart) / (1000.0 * textLength) * 1e9);
+    TmpArenaPop(&tmp);
+  }
+
+  UnloadFont(&font);
+}
+
+void BenchmarkParallelRasterization(Arena *arena)
+{
+  u16 pixelSizes[] = { 16, 24, 32, 48 };
+  i32 sizeCount = (i32)(sizeof(pixelSizes) / sizeof(pixelSizes[0]));
+  i32 threadCounts[] = { 1, 2, 4, 8, 16 };
+
+  Font font;
+  if (!LoadFont(arena, BENCHMARK_FONT_PATH, &font)) return;
+  GlyphData glyphData;
+  if (!LoadGlyphData(arena, &font, &glyphData)) return;
+  printf("%d processors, %d glyphs at %d sizes\n", GetProcessorCount(), glyphData.numGlyphs, sizeCount);
+
+  i32 count = glyphData.numGlyphs * sizeCount;
+  f64 singleThreadSeconds = 0;
+  for (i32 t = 0; t < (i32)(sizeof(threadCounts) / sizeof(threadCounts[0])); ++t)
+  {
+    TmpArena tmp;
+    TmpArenaPush(&tmp, arena);
+    JobSystem *system = CreateJobSystem(arena, threadCounts[t], 256 * MB);
+    if (!system) return;
+    GlyphBitmap *bitmaps = (GlyphBitmap *)Alloc(arena, count * sizeof(GlyphBitmap));
+
+    // First run faults in the worker arenas, the second one is timed.
+    PrerasterizeGlyphs(system, arena, &glyphData, pixelSizes, sizeCount, bitmaps);
+    for (i32 i = 0; i < system->workerCount; ++i)
+    {
+      system->workers[i].arena.cur = 0;
+      system->workers[i].itemsRun = 0;
+      system->workers[i].steals = 0;
+    }
+
+    f64 start = GetWallClockSeconds();
+    i32 failures = PrerasterizeGlyphs(system, arena, &glyphData, pixelSizes, sizeCount, bitmaps);
+    f64 seconds = GetWallClockSeconds() - start;
+    if (t == 0) singleThreadSeconds = seconds;
+
+    i64 steals = 0, minItems = count, maxItems = 0;
+    for (i32 i = 0; i < system->workerCount; ++i)
+    {
+      JobWorker *worker = &system->workers[i];
+      steals += worker->steals;
+      if (worker->itemsRun < minItems) minItems = worker->itemsRun;
+      if (worker->itemsRun > maxItems) maxItems = worker->itemsRun;
+    }
+    printf("%2d threads: %.0f K glyphs/s, speedup %.2fx, %d failed, %lld steals, %lld-%lld glyphs per worker\n",
+           threadCounts[t], count / seconds * 1e-3, singleThreadSeconds / seconds, failures,
+           (long long)steals, (long long)minItems, (long long)maxItems);
+
+    // Warming an atlas adds the serial packing on top.
+    GlyphCache *cache = CreateGlyphCache(arena, 1024, 1024, 8, 32768);
+    i32 fontId = AddGlyphCacheFont(cache, arena, &glyphData);
+    start = GetWallClockSeconds();
+    i32 uncached = WarmGlyphCache(cache, system, arena, fontId, pixelSizes, sizeCount);
+    printf("            warm atlas in %.1f ms, %d entries, %d not cached, %llu page evictions\n",
+           (GetWallClockSeconds() - start) * 1e3, cache->entryCount, uncached, (unsigned long long)cache->pageEvictions);
+
+    DestroyJobSystem(system);
+    TmpArenaPop(&tmp);
+  }
+
+  UnloadFont(&font);
+}
+
+// Reverses the direction of every contour, keeping its first point first.
+void ReverseOutlineContours(GlyphOutline *outline)
+{
+  i32 contourStart = 0;
+  for (i32 contour = 0; contour < outline->contourCount; ++contour)
+  {
+    i32 contourEnd = outline->contourEnds[contour];
+    for (i32 low = contourStart + 1, high = contourEnd; low < high; ++low, --high)
+    {
+      f32 x = outline->x[low], y = outline->y[low];
+      u8 onCurve = outline->onCurve[low];
+      outline->x[low] = outline->x[high]; outline->y[low] = outline->y[high]; outline->onCurve[low] = outline->onCurve[high];
+      outline->x[high] = x; outline->y[high] = y; outline->onCurve[high] = onCurve;
+    }
+    contourStart = contourEnd + 1;
+  }
+}
+
+// Pixels whose channels differ, the others fell back to the true distance.
+i32 CountMultiChannelPixels(GlyphBitmap *bitmap)
+{
+  i32 count = 0;
+  for (i32 i = 0; i < bitmap->width * bitmap->height; ++i)
+  {
+    u8 *pixel = &bitmap->pixels[i * 3];
+    count += pixel[0] != pixel[1] || pixel[1] != pixel[2];
+  }
+  return count;
+}
+
+void BenchmarkDistanceFields(Arena *arena)
+{
+  i32 fieldPixelSize = 32;
+  i32 spread = 4;
+  u16 coverageSizes[] = { 12, 14, 16, 18, 20, 24, 28, 32, 40, 48, 64 };
+  i32 coverageSizeCount = (i32)(sizeof(coverageSizes) / sizeof(coverageSizes[0]));
+
+  Font font;
+  if (!LoadFont(arena, BENCHMARK_FONT_PATH, &font)) return;
+  GlyphData glyphData;
+  if (!LoadGlyphData(arena, &font, &glyphData)) return;
+  GlyphOutline *outline = AllocGlyphOutline(arena, &glyphData);
+  f32 unitsPerEm = (f32)glyphData.fontHeader->unitsPerEm;
+  f32 scale = (f32)fieldPixelSize / unitsPerEm;
+
+  i32 maxWidth = 1024;
+  DistanceFieldGenerator *generator = AllocDistanceFieldGenerator(arena, outline->pointCapacity, outline->contourCapacity, maxWidth);
+  u8 *pixels = (u8 *)Alloc(arena, maxWidth * maxWidth * 3);
+  u8 *simdPixels = (u8 *)Alloc(arena, maxWidth * maxWidth * 3);
+
+  // Both variants solve for the exact closest point, their fields must match byte for byte.
+  DistanceFieldMode modes[] = { DISTANCE_FIELD_SINGLE, DISTANCE_FIELD_MULTI };
+  for (i32 m = 0; m < 2; ++m)
+  {
+    i32 mismatches = 0;
+    i64 mismatchBytes = 0;
+    for (u16 glyphId = 0; glyphId < glyphData.numGlyphs; ++glyphId)
+    {
+      DecodeGlyphOutline(&glyphData, glyphId, outline);
+      GlyphBitmap scalarBitmap, simdBitmap;
+      GetDistanceFieldBounds(outline, scale, spread, &scalarBitmap);
+      simdBitmap = scalarBitmap;
+      scalarBitmap.pixels = pixels;
+      simdBitmap.pixels = simdPixels;
+      if (!GenerateDistanceFieldWith(generator, outline, scale, spread, modes[m], &scalarBitmap, 0) ||
+          !GenerateDistanceFieldWith(generator, outline, scale, spread, modes[m], &simdBitmap, 1)) continue;
+      i32 differing = 0;
+      for (i32 i = 0; i < scalarBitmap.width * scalarBitmap.height * (i32)modes[m]; ++i) differing += pixels[i] != simdPixels[i];
+      mismatches += differing > 0;
+      mismatchBytes += differing;
+    }
+    printf("%s: %d glyphs differ between variants (%lld bytes)\n", m ? "msdf" : "sdf", mismatches, (long long)mismatchBytes);
+  }
+
+  // Reversed contours must keep their multi-channel pixels, otherwise every pixel falls back to the true
+  // distance. Edge colors are assigned along the walk, so a handful of pixels may still land differently.
+  // The CFF font has counter-clockwise outer contours, the glyf one clockwise ones.
+  char *orientationPaths[] = { BENCHMARK_FONT_PATH, BENCHMARK_CFF_FONT_PATH };
+  for (i32 f = 0; f < 2; ++f)
+  {
+    Font orientationFont;
+    if (!LoadFont(arena, orientationPaths[f], &orientationFont)) continue;
+    GlyphData orientationData;
+    CodepointMap codepointMap;
+    if (!LoadGlyphData(arena, &orientationFont, &orientationData) || !LoadCodepointMap(arena, &orientationFont, &codepointMap, 0))
+    {
+      UnloadFont(&orientationFont);
+      continue;
+    }
+    GlyphOutline *letterOutline = AllocGlyphOutline(arena, &orientationData);
+    DistanceFieldGenerator *letterGenerator = AllocDistanceFieldGenerator(arena, letterOutline->pointCapacity,
+                                                                          letterOutline->contourCapacity, maxWidth);
+    f32 letterScale = (f32)fieldPixelSize / orientationData.fontHeader->unitsPerEm;
+    printf("msdf %s, multi-channel pixels as decoded and reversed:", orientationPaths[f]);
+    i32 mismatches = 0;
+    char *letters = "HEMTLkx";
+    for (char *letter = letters; *letter; ++letter)
+    {
+      u16 glyphId = GlyphIndexFromCodepoint(&codepointMap, (u32)*letter);
+      i32 counts[2];
+      for (i32 reversed = 0; reversed < 2; ++reversed)
+      {
+        DecodeGlyphOutline(&orientationData, glyphId, letterOutline);
+        if (reversed) ReverseOutlineContours(letterOutline);
+        GlyphBitmap bitmap;
+        GetDistanceFieldBounds(letterOutline, letterScale, spread, &bitmap);
+        bitmap.pixels = pixels;
+        GenerateDistanceField(letterGenerator, letterOutline, letterScale, spread, DISTANCE_FIELD_MULTI, &bitmap);
+        counts[reversed] = CountMultiChannelPixels(&bitmap);
+      }
+      printf(" %c %d/%d", *letter, counts[0], counts[1]);
+      mismatches += counts[0] == 0 || abs(counts[0] - counts[1]) * 100 > counts[0];
+    }
+    printf(", %d mismatches\n", mismatches);
+    UnloadFont(&orientationFont);
+  }
+
+  struct { DistanceFieldMode mode; i32 vectorized; char *label; } variants[] = {
+    { DISTANCE_FIELD_SINGLE, 0, "sdf scalar" },
+    { DISTANCE_FIELD_SINGLE, 1, "sdf avx2" },
+    { DISTANCE_FIELD_MULTI, 0, "msdf scalar" },
+    { DISTANCE_FIELD_MULTI, 1, "msdf avx2" },
+  };
+  i64 fieldPixels = 0;
+  for (i32 v = 0; v < (i32)(sizeof(variants) / sizeof(variants[0])); ++v)
+  {
+    i32 failures = 0;
+    fieldPixels = 0;
+    f64 seconds = 0;
+    for (u16 glyphId = 0; glyphId < glyphData.numGlyphs; ++glyphId)
+    {
+      DecodeGlyphOutline(&glyphData, glyphId, outline);
+      GlyphBitmap bitmap;
+      GetDistanceFieldBounds(outline, scale, spread, &bitmap);
+      bitmap.pixels = pixels;
+      f64 start = GetWallClockSeconds();
+      if (!GenerateDistanceFieldWith(generator, outline, scale, spread, variants[v].mode, &bitmap, variants[v].vectorized)) ++failures;
+      seconds += GetWallClockSeconds() - start;
+      fieldPixels += bitmap.width * bitmap.height;
+    }
+    printf("%-12s %.1f us/glyph, %.1f ns/pixel, %d failed\n", variants[v].label,
+           seconds / glyphData.numGlyphs * 1e6, seconds / fieldPixels * 1e9, failures);
+  }
+
+  // A distance field is rendered once and scaled, coverage bitmaps are rasterized at every size used.
+  i64 coverageBytes = 0;
+  for (i32 size = 0; size < coverageSizeCount; ++size)
+  {
+    f32 coverageScale = (f32)coverageSizes[size] / unitsPerEm;
+    for (u16 glyphId = 0; glyphId < glyphData.numGlyphs; ++glyphId)
+    {
+      DecodeGlyphOutline(&glyphData, glyphId, outline);
+      GlyphBitmap bitmap;
+      GetGlyphBitmapBounds(outline, coverageScale, &bitmap);
+      coverageBytes += bitmap.width * bitmap.height;
+    }
+  }
+  printf("coverage at %d sizes: %.2f MB, sdf at %d px: %.2f MB (%.1fx less), msdf: %.2f MB (%.1fx less)\n",
+         coverageSizeCount, (f64)coverageBytes / MB, fieldPixelSize, (f64)fieldPixels / MB, (f64)coverageBytes / fieldPixels,
+         (f64)fieldPixels * 3 / MB, (f64)coverageBytes / (fieldPixels * 3));
+
+  UnloadFont(&font);
+}
+
+// Writes a collection of faceCount copies of a font. Every face gets its own head like real collections,
+// all other tables are stored once and shared by every directory.
+i32 WriteSyntheticCollection(Arena *arena, Font *font, i32 faceCount, char *filePath)
+{
+  TableDirectory *directory = font->directory;
+  i32 numTables = directory->numTables;
+  u32 headerSize = 12 + faceCount * 4;
+  u32 directorySize = 12 + numTables * 16;
+  u32 size = headerSize + faceCount * directorySize;
+  for (i32 i = 0; i < numTables; ++i) size += (directory->tableRecords[i].length + 3) & ~3u;
+  FontView head = GetTableView(font, READ_BIG_ENDIAN_U32("head"));
+  size += faceCount * ((head.length + 3) & ~3u);
+
+  TmpArena tmp;
+  TmpArenaPush(&tmp, arena);
+  u8 *data = (u8 *)Alloc(arena, size);
+  WriteBigEndianU32(data, READ_BIG_ENDIAN_U32("ttcf"));
+  WriteBigEndianU16(&data[4], 1);
+  WriteBigEndianU32(&data[8], (u32)faceCount);
+
+  u32 tableOffset = headerSize + faceCount * directorySize;
+  u32 *sharedOffsets = (u32 *)Alloc(arena, numTables * sizeof(u32));
+  for (i32 i = 0; i < numTables; ++i)
+  {
+    TableRecord *record = &directory->tableRecords[i];
+    sharedOffsets[i] = tableOffset;
+    memcpy(&data[tableOffset], &font->view.data[record->offset], record->length);
+    tableOffset += (record->length + 3) & ~3u;
+  }
+
+  for (i32 face = 0; face < faceCount; ++face)
+  {
+    u32 directoryOffset = headerSize + face * directorySize;
+    WriteBigEndianU32(&data[12 + face * 4], directoryOffset);
+    memcpy(&data[directoryOffset], font->view.data, 12);
+    u32 headOffset = tableOffset;
+    memcpy(&data[headOffset], head.data, head.length);
+    tableOffset += (head.length + 3) & ~3u;
+
+    for (i32 i = 0; i < numTables; ++i)
+    {
+      TableRecord *record = &directory->tableRecords[i];
+      u8 *entry = &data[directoryOffset + 12 + i * 16];
+      WriteBigEndianU32(entry, record->tag.value);
+      WriteBigEndianU32(entry + 4, record->checksum);
+      WriteBigEndianU32(entry + 8, record->tag.value == READ_BIG_ENDIAN_U32("head") ? headOffset : sharedOffsets[i]);
+      WriteBigEndianU32(entry + 12, record->length);
+    }
+  }
+
+  FILE *file = fopen(filePath, "wb");
+  i32 success = file && fwrite(data, size, 1, file) == 1;
+  if (file) fclose(file);
+  TmpArenaPop(&tmp);
+  return success;
+}
+
+void BenchmarkCollectionLoading(Arena *arena)
+{
+  i32 faceCount = 8;
+  i32 passes = 50;
+  char *collectionPath = "fonts/benchmark_collection.ttc";
+
+  Font font;
+  if (!LoadFont(arena, BENCHMARK_FONT_PATH, &font)) return;
+  i32 written = WriteSyntheticCollection(arena, &font, faceCount, collectionPath);
+  UnloadFont(&font);
+  if (!written)
+  {
+    fprintf(stderr, "Failed to write %s\n", collectionPath);
+    return;
+  }
+
+  // Each face opened as its own font, with its own mapping and decoded tables.
+  size_t separateBytes = 0;
+  f64 start = GetWallClockSeconds();
+  for (i32 pass = 0; pass < passes; ++pass)
+  {
+    TmpArena tmp;
+    TmpArenaPush(&tmp, arena);
+    size_t used = arena->cur;
+    Font *fonts = (Font *)Alloc(arena, faceCount * sizeof(Font));
+    for (i32 i = 0; i < faceCount; ++i)
+    {
+      GlyphData glyphData;
+      CodepointMap codepointMap;
+      LoadFont(arena, BENCHMARK_FONT_PATH, &fonts[i]);
+      LoadGlyphData(arena, &fonts[i], &glyphData);
+      LoadCodepointMap(arena, &fonts[i], &codepointMap, CODEPOINT_MAP_BMP_TABLE);
+    }
+    separateBytes = arena->cur - used;
+    for (i32 i = 0; i < faceCount; ++i) UnloadFont(&fonts[i]);
+    TmpArenaPop(&tmp);
+  }
+  f64 separateSeconds = (GetWallClockSeconds() - start) / passes;
+
+  size_t collectionBytes = 0;
+  i32 sharedHits = 0, sharedTables = 0;
+  start = GetWallClockSeconds();
+  for (i32 pass = 0; pass < passes; ++pass)
+  {
+    TmpArena tmp;
+    TmpArenaPush(&tmp, arena);
+    size_t used = arena->cur;
+    FontCollection *collection = (FontCollection *)Alloc(arena, sizeof(FontCollection));
+    if (!LoadFontCollection(arena, collectionPath, collection)) break;
+    for (i32 i = 0; i < collection->faceCount; ++i)
+    {
+      GlyphData glyphData;
+      CodepointMap codepointMap;
+      LoadFaceGlyphData(arena, collection, i, &glyphData);
+      LoadFaceCodepointMap(arena, collection, i, &codepointMap, CODEPOINT_MAP_BMP_TABLE);
+    }
+    collectionBytes = arena->cur - used;
+    sharedHits = collection->sharedTableHits;
+    sharedTables = collection->sharedTableCount;
+    UnloadFontCollection(collection);
+    TmpArenaPop(&tmp);
+  }
+  f64 collectionSeconds = (GetWallClockSeconds() - start) / passes;
+  remove(collectionPath);
+
+  printf("%d faces as separate fonts: %.1f us, %.1f KB decoded\n", faceCount, separateSeconds * 1e6, (f64)separateBytes / KB);
+  printf("%d faces from one collection: %.1f us, %.1f KB decoded, %d tables decoded, %d shared\n",
+         faceCount, collectionSeconds * 1e6, (f64)collectionBytes / KB, sharedTables, sharedHits);
+}
+
+// The lookup every caller did before the table index, kept for comparison.
+FontView FindTableLinear(Font *font, u32 tag)
+{
+  FontView tableView = {0};
+  TableDirectory *directory = font->directory;
+  for (i32 i = 0; i < directory->numTables; ++i)
+  {
+    TableRecord *tableRecord = &directory->tableRecords[i];
+    if (tableRecord->tag.value == tag)
+    {
+      tableView = FontSubView(font->view, tableRecord->offset, tableRecord->length);
+      break;
+    }
+  }
+  return tableView;
+}
+
+void BenchmarkTableLookup(Arena *arena)
+{
+  i32 loads = 2000;
+  i32 lookups = 1 << 22;
+
+  u32 tags[FONT_TABLE_COUNT];
+  for (i32 i = 0; i < FONT_TABLE_COUNT; ++i) tags[i] = READ_BIG_ENDIAN_U32(fontTableTags[i]);
+
+  for (i32 f = 0; f < BUNDLED_FONT_COUNT; ++f)
+  {
+    Font font;
+    if (!LoadFont(arena, bundledFontPaths[f], &font)) continue;
+    printf("%s (%d tables)\n", bundledFontPaths[f], font.directory->numTables);
+
+    // Load plus resolving every standard table once, as a loader touching head, hhea, hmtx, glyf, loca, kern, GPOS... would.
+    u32 checksum = 0;
+    f64 linearLoadSeconds = 0, indexedLoadSeconds = 0;
+    for (i32 i = 0; i < loads; ++i)
+    {
+      TmpArena tmp;
+      TmpArenaPush(&tmp, arena);
+      Font loaded;
+      f64 start = GetWallClockSeconds();
+      LoadFont(arena, bundledFontPaths[f], &loaded);
+      for (i32 t = 0; t < FONT_TABLE_COUNT; ++t) checksum += FindTableLinear(&loaded, tags[t]).length;
+      linearLoadSeconds += GetWallClockSeconds() - start;
+      UnloadFont(&loaded);
+
+      start = GetWallClockSeconds();
+      LoadFont(arena, bundledFontPaths[f], &loaded);
+      for (i32 t = 0; t < FONT_TABLE_COUNT; ++t) checksum += GetFontTable(&loaded, (FontTable)t).length;
+      indexedLoadSeconds += GetWallClockSeconds() - start;
+      UnloadFont(&loaded);
+      TmpArenaPop(&tmp);
+    }
+    printf("  load + resolve %d tables: linear %.2f us, indexed %.2f us\n",
+           FONT_TABLE_COUNT, linearLoadSeconds / loads * 1e6, indexedLoadSeconds / loads * 1e6);
+
+    // Repeated lookups in the hot path, tags cycle through present and missing tables.
+    f64 start = GetWallClockSeconds();
+    for (i32 i = 0; i < lookups; ++i) checksum += FindTableLinear(&font, tags[i % FONT_TABLE_COUNT]).length;
+    f64 linearSeconds = GetWallClockSeconds() - start;
+
+    start = GetWallClockSeconds();
+    for (i32 i = 0; i < lookups; ++i) checksum += GetTableView(&font, tags[i % FONT_TABLE_COUNT]).length;
+    f64 binarySeconds = GetWallClockSeconds() - start;
+
+    start = GetWallClockSeconds();
+    for (i32 i = 0; i < lookups; ++i) checksum += GetFontTable(&font, (FontTable)(i % FONT_TABLE_COUNT)).length;
+    f64 indexedSeconds = GetWallClockSeconds() - start;
+
+    printf("  lookup: linear %.2f ns, binary search %.2f ns, indexed %.2f ns (checksum %u)\n",
+           linearSeconds / lookups * 1e9, binarySeconds / lookups * 1e9, indexedSeconds / lookups * 1e9, checksum);
+    UnloadFont(&font);
+  }
+}
+
+// Builds an in-memory font of tableCount tables of tableSize random bytes plus a copy of head,
+// with valid checksums and checksumAdjustment.
+i32 BuildSyntheticFont(Arena *arena, FontView head, i32 tableCount, u32 tableSize, Font *font)
+{
+  memset(font, 0, sizeof(Font));
+  i32 numTables = tableCount + 1;
+  u32 headSize = (head.length + 3) & ~3u;
+  u32 directorySize = 12 + numTables * 16;
+  u64 size = (u64)directorySize + headSize + (u64)tableCount * tableSize;
+  if (size > UINT32_MAX) return 0;
+  u8 *data = (u8 *)Alloc(arena, size);
+  if (!data) return 0;
+
+  i32 searchRange = 1;
+  while (searchRange * 2 <= numTables) searchRange *= 2;
+  WriteBigEndianU32(data, TRUETYPE);
+  WriteBigEndianU16(&data[4], (u16)numTables);
+  WriteBigEndianU16(&data[6], (u16)(searchRange * 16));
+  WriteBigEndianU16(&data[8], (u16)log2(searchRange));
+  WriteBigEndianU16(&data[10], (u16)(numTables * 16 - searchRange * 16));
+
+  // Tags 'z000'... sort after 'head' in the directory.
+  u32 headOffset = directorySize;
+  memcpy(&data[headOffset], head.data, head.length);
+  WriteBigEndianU32(&data[headOffset + 8], 0);
+  u32 random = 0x12345678;
+  for (i32 t = 0; t < tableCount; ++t)
+  {
+    u32 offset = headOffset + headSize + t * tableSize;
+    u32 *words = (u32 *)&data[offset];
+    for (u32 i = 0; i < tableSize / 4; ++i) words[i] = RandomU32(&random);
+    u8 *record = &data[12 + (t + 1) * 16];
+    char tag[5];
+    snprintf(tag, sizeof(tag), "z%03d", t % 1000);
+    WriteBigEndianU32(record, READ_BIG_ENDIAN_U32(tag));
+    WriteBigEndianU32(record + 4, ComputeTableChecksum(MakeFontView(&data[offset], tableSize)));
+    WriteBigEndianU32(record + 8, offset);
+    WriteBigEndianU32(record + 12, tableSize);
+  }
+  u8 *headRecord = &data[12];
+  WriteBigEndianU32(headRecord, READ_BIG_ENDIAN_U32("head"));
+  WriteBigEndianU32(headRecord + 4, ComputeTableChecksum(MakeFontView(&data[headOffset], head.length)));
+  WriteBigEndianU32(headRecord + 8, headOffset);
+  WriteBigEndianU32(headRecord + 12, head.length);
+  WriteBigEndianU32(&data[headOffset + 8], 0xB1B0AFBA - ComputeTableChecksum(MakeFontView(data, (u32)size)));
+
+  return LoadFontFromMemory(arena, data, size, font);
+}
+
+typedef u32 SumBigEndianU32Function(u8 *data, i32 count);
+
+void BenchmarkChecksumVerification(Arena *arena)
+{
+  char *pathNames[] = { "scalar", "ssse3", "avx2" };
+  SumBigEndianU32Function *paths[] = {
+    SumBigEndianU32Scalar,
+#if SIMD_X86
+    SumBigEndianU32Ssse3, SumBigEndianU32Avx2,
+#endif
+  };
+  i32 pathCount = (i32)(sizeof(paths) / sizeof(paths[0]));
+  CpuFeatures *features = GetCpuFeatures();
+  i32 supported[] = { 1, features->hasSsse3, features->hasAvx2 };
+
+  FontView head = {0};
+  for (i32 f = 0; f < BUNDLED_FONT_COUNT; ++f)
+  {
+    Font font;
+    if (!LoadFont(arena, bundledFontPaths[f], &font)) continue;
+    FontChecksumReport report;
+    i32 valid = VerifyFontChecksums(arena, &font, NULL, &report);
+    i32 iterations = 1 + (256 * (i32)MB) / (i32)font.view.length;
+    f64 start = GetWallClockSeconds();
+    for (i32 i = 0; i < iterations; ++i)
+    {
+      TmpArena tmp;
+      TmpArenaPush(&tmp, arena);
+      VerifyFontChecksums(arena, &font, NULL, &report);
+      TmpArenaPop(&tmp);
+    }
+    f64 seconds = GetWallClockSeconds() - start;
+    printf("%s: %s, %d/%d tables bad, adjustment %08X/%08X, %.2f GB/s\n",
+           bundledFontPaths[f], valid ? "valid" : "INVALID", report.failedTables, report.tableCount,
+           report.computedAdjustment, report.storedAdjustment, font.view.length * (f64)iterations / seconds * 1e-9);
+
+    if (f == 0)
+    {
+      // head is copied before unloading, the synthetic font outlives the mapping.
+      FontView fontHead = GetFontTable(&font, FONT_TABLE_HEAD);
+      head = MakeFontView(Alloc(arena, fontHead.length), fontHead.length);
+      memcpy(head.data, fontHead.data, fontHead.length);
+    }
+    UnloadFont(&font);
+  }
+  if (!head.length) return;
+
+  Font synthetic;
+  if (!BuildSyntheticFont(arena, head, 48, 8 * (u32)MB, &synthetic)) return;
+  f64 gigabytes = synthetic.view.length * 1e-9;
+
+  for (i32 p = 0; p < pathCount; ++p)
+  {
+    if (!supported[p]) continue;
+    f64 start = GetWallClockSeconds();
+    u32 sum = paths[p](synthetic.view.data, (i32)(synthetic.view.length / 4));
+    f64 seconds = GetWallClockSeconds() - start;
+    printf("synthetic %.0f MB sum %-6s: %6.2f GB/s (%08X)\n", gigabytes * 1e3, pathNames[p], gigabytes / seconds, sum);
+  }
+
+  i32 workerCounts[] = { 1, 2, 4, GetProcessorCount() };
+  for (i32 w = 0; w < 4; ++w)
+  {
+    JobSystem *system = CreateJobSystem(arena, workerCounts[w], 1 * MB);
+    if (!system) continue;
+    FontChecksumReport report;
+    f64 start = GetWallClockSeconds();
+    i32 valid = VerifyFontChecksums(arena, &synthetic, system, &report);
+    f64 seconds = GetWallClockSeconds() - start;
+    printf("synthetic verify, %2d workers: %6.2f GB/s, %s\n", workerCounts[w], gigabytes / seconds, valid ? "valid" : "INVALID");
+    DestroyJobSystem(system);
+  }
+}
+
+// The parsers as they were before FontCursor, trusting every count and offset. Kept for comparison only.
+TableDirectory *ReadTableDirectoryUnchecked(Arena *arena, char *buffer)
+{
+  char *pBuffer = buffer;
+  
+  TableDirectory *fontDirectory = (TableDirectory  *)Alloc(arena, sizeof(TableDirectory));
+  fontDirectory->scalableFontType = READ_BIG_ENDIAN_U32_MOVE(pBuffer);
+  
+  fontDirectory->numTables = READ_BIG_ENDIAN_U16_MOVE(pBuffer);
+  u16 numTables = fontDirectory->numTables;
+  
+  fontDirectory->searchRange = READ_BIG_ENDIAN_U16_MOVE(pBuffer);
+  u16 searchRange = fontDirectory->searchRange;
+  
+  if (fontDirectory->searchRange != (u16)pow(2, floor(log2(numTables))) * 16)
+  {
+    return NULL;
+  }
+  
+  fontDirectory->entrySelector = READ_BIG_ENDIAN_U16_MOVE(pBuffer);
+  if (fontDirectory->entrySelector != (u16)log2(searchRange / 16))
+  {
+    return NULL;
+  }
+  
+  fontDirectory->rangeShift = READ_BIG_ENDIAN_U16_MOVE(pBuffer);
+  if (fontDirectory->rangeShift != (u16)numTables * 16 - searchRange)
+  {
+    return NULL;
+  }
+
+  // TableRecord is four u32s, same as the file layout.
+  fontDirectory->tableRecords = (TableRecord *)Alloc(arena, numTables * sizeof(TableRecord));
+  ReadBigEndianU32Array((u32 *)fontDirectory->tableRecords, (u8 *)pBuffer, numTables * 4);
+  PTR_MOVE(pBuffer, numTables * sizeof(TableRecord));
+
+  buffer = pBuffer;
+  return fontDirectory;
+}
+
+CodepointMapTableHeader *ReadCodepointMapTableHeaderUnchecked(Arena *arena, char *buffer)
+{
+  char *pBuffer = buffer;
+  
+  CodepointMapTableHeader *codepointMapTable = (CodepointMapTableHeader *)Alloc(arena, sizeof(CodepointMapTableHeader));
+  codepointMapTable->version = READ_BIG_ENDIAN_U16_MOVE(pBuffer);
+  codepointMapTable->numTables = READ_BIG_ENDIAN_U16_MOVE(pBuffer);
+
+  i32 numTables = codepointMapTable->numTables;
+  codepointMapTable->encodingRecords = (EncodingRecord *)Alloc(arena, numTables * sizeof(EncodingRecord));
+  for (i32 i = 0; i < numTables; ++i)
+  {
+    EncodingRecord *encodingRecord = &codepointMapTable->encodingRecords[i];
+    encodingRecord->platformID.value = READ_BIG_ENDIAN_U16_MOVE(pBuffer);
+    encodingRecord->platformSpecificID.value = READ_BIG_ENDIAN_U16_MOVE(pBuffer);
+    encodingRecord->offset = READ_BIG_ENDIAN_U32_MOVE(pBuffer);
+  }
+
+  buffer = pBuffer;
+  return codepointMapTable;
+}
+
+CodepointMapSubtable *ReadCodepointMapSubtableUnchecked(Arena *arena, char *buffer)
+{
+  char *pBuffer = buffer;
+  CodepointMapSubtable *codepointMapSubtable;
+  
+  u16 format = READ_BIG_ENDIAN_U16_MOVE(pBuffer);
+  switch (format)
+  {
+    case 0: {
+      codepointMapSubtable = (CodepointMapSubtable *)Alloc(arena, sizeof(CodepointMapSubtable));
+      codepointMapSubtable->format = format;
+      codepointMapSubtable->value.format0 = (CodepointMapFormat0 *)Alloc(arena, sizeof(CodepointMapFormat0));
+      
+      CodepointMapFormat0 *format0 = codepointMapSubtable->value.format0;
+      format0->length = READ_BIG_ENDIAN_U16_MOVE(pBuffer);
+      format0->language = READ_BIG_ENDIAN_U16_MOVE(pBuffer);
+      memcpy(format0->glyphIdArray, pBuffer, 256); PTR_MOVE(pBuffer, 256);
+    } break;
+    
+    case 4: {
+      codepointMapSubtable = (CodepointMapSubtable *)Alloc(arena, sizeof(CodepointMapSubtable));
+      codepointMapSubtable->format = format;
+      codepointMapSubtable->value.format4 = (CodepointMapFormat4 *)Alloc(arena, sizeof(CodepointMapFormat4));
+      
+      CodepointMapFormat4 *format4 = codepointMapSubtable->value.format4;
+      format4->length = READ_BIG_ENDIAN_U16_MOVE(pBuffer);
+      format4->language = READ_BIG_ENDIAN_U16_MOVE(pBuffer);
+      format4->segCountX2 = READ_BIG_ENDIAN_U16_MOVE(pBuffer);
+  
+      u16 segCount = format4->segCountX2 / 2;
+      format4->searchRange = (u16)powf(2, floorf(log2f(segCount))) * 2;
+      u16 searchRange = format4->searchRange;
+      format4->entrySelector = (u16)log2f(searchRange / 2);
+      format4->rangeShift = (segCount * 2) - searchRange;
+      PTR_MOVE(pBuffer, 6);
+  
+      // 14 bytes of header, 4 segment arrays and the reservedPad come before glyphIdArray.
+      i32 glyphIdCount = ((i32)format4->length - 16 - segCount * 8) / 2;
+      if (glyphIdCount < 0) glyphIdCount = 0;
+      format4->endCode = (u16 *)Alloc(arena, (segCount * 4 + glyphIdCount) * sizeof(u16) + SIMD_PADDING);
+      format4->startCode = format4->endCode + segCount;
+      format4->idDelta = format4->startCode + segCount;
+      format4->idRangeOffset = format4->idDelta + segCount;
+      format4->glyphIdArray = format4->idRangeOffset + segCount;
+
+      // startCode, idDelta, idRangeOffset and glyphIdArray follow each other after reservedPad.
+      ReadBigEndianU16Array(format4->endCode, (u8 *)pBuffer, segCount);
+      PTR_MOVE(pBuffer, format4->segCountX2 + 2);
+      ReadBigEndianU16Array(format4->startCode, (u8 *)pBuffer, segCount * 3 + glyphIdCount);
+      PTR_MOVE(pBuffer, format4->segCountX2 * 3 + glyphIdCount * 2);
+    } break;
+
+    case 12: case 13: {
+      codepointMapSubtable = (CodepointMapSubtable *)Alloc(arena, sizeof(CodepointMapSubtable));
+      codepointMapSubtable->format = format;
+      codepointMapSubtable->value.format12 = (CodepointMapFormat12 *)Alloc(arena, sizeof(CodepointMapFormat12));
+
+      CodepointMapFormat12 *format12 = codepointMapSubtable->value.format12;
+      format12->reserved = READ_BIG_ENDIAN_U16_MOVE(pBuffer);
+      format12->length = READ_BIG_ENDIAN_U32_MOVE(pBuffer);
+      format12->language = READ_BIG_ENDIAN_U32_MOVE(pBuffer);
+      format12->numGroups = READ_BIG_ENDIAN_U32_MOVE(pBuffer);
+
+      // Never trust numGroups beyond what the subtable length can hold.
+      u32 maxGroups = format12->length >= 16 ? (format12->length - 16) / sizeof(SequentialMapGroup) : 0;
+      if (format12->numGroups > maxGroups) format12->numGroups = maxGroups;
+
+      // SequentialMapGroup is three u32s, same as the file layout.
+      format12->groups = (SequentialMapGroup *)Alloc(arena, format12->numGroups * sizeof(SequentialMapGroup));
+      ReadBigEndianU32Array((u32 *)format12->groups, (u8 *)pBuffer, format12->numGroups * 3);
+      PTR_MOVE(pBuffer, format12->numGroups * sizeof(SequentialMapGroup));
+    } break;
+    
+    default: {
+      fprintf(stderr, "Failed to read the codepoint map subtable\n,");
+      return NULL;
+    } break;
+  }
+  
+  return codepointMapSubtable;
+}
+
+void BenchmarkHardenedParsing(Arena *arena)
+{
+  i32 iterations = 200000;
+
+  for (i32 f = 0; f < BUNDLED_FONT_COUNT; ++f)
+  {
+    Font font;
+    if (!LoadFont(arena, bundledFontPaths[f], &font)) continue;
+    FontView cmap = GetFontTable(&font, FONT_TABLE_CMAP);
+
+    // Same subtable LoadCodepointMap would pick.
+    CodepointMap codepointMap;
+    if (!LoadCodepointMap(arena, &font, &codepointMap, 0)) continue;
+    u32 subtableOffset = 0;
+    for (u16 i = 0; i < ViewU16(cmap, 2); ++i)
+    {
+      u32 offset = ViewU32(cmap, 4 + i * 8 + 4);
+      if (ViewU16(cmap, offset) == codepointMap.subtable->format) subtableOffset = offset;
+    }
+    FontView subtable = FontSubView(cmap, subtableOffset, cmap.length - subtableOffset);
+
+    // Alternating the two parsers per round keeps frequency changes and cache state even between them.
+    f64 seconds[2] = {0};
+    u32 checksum = 0;
+    for (i32 round = 0; round < 20; ++round)
+    {
+      for (i32 hardened = 0; hardened < 2; ++hardened)
+      {
+        f64 start = GetWallClockSeconds();
+        for (i32 i = 0; i < iterations / 20; ++i)
+        {
+          TmpArena tmp;
+          TmpArenaPush(&tmp, arena);
+          if (hardened)
+          {
+            checksum += ReadTableDirectory(arena, font.view)->numTables;
+            checksum += ReadCodepointMapTableHeader(arena, cmap)->numTables;
+            checksum += ReadCodepointMapSubtable(arena, subtable)->format;
+          }
+          else
+          {
+            checksum += ReadTableDirectoryUnchecked(arena, (char *)font.view.data)->numTables;
+            checksum += ReadCodepointMapTableHeaderUnchecked(arena, (char *)cmap.data)->numTables;
+            checksum += ReadCodepointMapSubtableUnchecked(arena, (char *)subtable.data)->format;
+          }
+          TmpArenaPop(&tmp);
+        }
+        seconds[hardened] += GetWallClockSeconds() - start;
+      }
+    }
+
+    printf("%s: directory + cmap header + format %d subtable: unchecked %.3f us, hardened %.3f us (%+.1f%%, checksum %u)\n",
+           bundledFontPaths[f], codepointMap.subtable->format, seconds[0] / iterations * 1e6, seconds[1] / iterations * 1e6,
+           (seconds[1] / seconds[0] - 1.0) * 100.0, checksum);
+    UnloadFont(&font);
+  }
+}
+
+typedef struct {
+  f64 smallSeconds;
+  f64 bufferSeconds;
+  size_t residentBytes;
+} ArenaBenchmarkResult;
+
+// Frames of small allocations reset with TmpArena, then decode-sized buffers that are overwritten right away.
+ArenaBenchmarkResult RunArenaWorkload(Arena *arena, i32 zero, i32 frames, i32 allocationsPerFrame, i32 bufferCount, size_t bufferSize, u8 *source)
+{
+  ArenaBenchmarkResult result = {0};
+  u32 random = 0x2545F491;
+  size_t residentBefore = GetResidentBytes();
+
+  f64 start = GetWallClockSeconds();
+  for (i32 frame = 0; frame < frames; ++frame)
+  {
+    TmpArena tmp;
+    TmpArenaPush(&tmp, arena);
+    for (i32 i = 0; i < allocationsPerFrame; ++i)
+    {
+      size_t size = 16 + (RandomU32(&random) & 240);
+      u8 *memory = (u8 *)AllocAlignWith(arena, size, DEFAULT_ALIGNMENT, zero);
+      memory[0] = (u8)i;
+    }
+    TmpArenaPop(&tmp);
+  }
+  result.smallSeconds = GetWallClockSeconds() - start;
+
+  start = GetWallClockSeconds();
+  for (i32 i = 0; i < bufferCount; ++i)
+  {
+    u32 *buffer = (u32 *)AllocAlignWith(arena, bufferSize, DEFAULT_ALIGNMENT, zero);
+    ReadBigEndianU32Array(buffer, source, (i32)(bufferSize / 4));
+  }
+  result.bufferSeconds = GetWallClockSeconds() - start;
+  result.residentBytes = GetResidentBytes() - residentBefore;
+  return result;
+}
+
+void BenchmarkArenas(Arena *arena)
+{
+  i32 frames = 2000;
+  i32 allocationsPerFrame = 4096;
+  i32 bufferCount = 512;
+  size_t bufferSize = 256 * KB;
+  size_t fixedSize = 1 * GB;
+  u8 *source = (u8 *)Alloc(arena, bufferSize);
+  memset(source, 0x5A, bufferSize);
+
+  char *names[] = { "fixed, zeroed (previous)", "virtual, zeroed", "virtual, no zero" };
+  for (i32 kind = 0; kind < 3; ++kind)
+  {
+    Arena tested;
+    void *buffer = NULL;
+    if (kind == 0)
+    {
+      buffer = PlatformAllocate(fixedSize);
+      if (!buffer) continue;
+      InitArena(&tested, buffer, fixedSize);
+    }
+    else if (!InitVirtualArena(&tested, ARENA_DEFAULT_RESERVE)) continue;
+
+    ArenaBenchmarkResult result = RunArenaWorkload(&tested, kind < 2, frames, allocationsPerFrame, bufferCount, bufferSize, source);
+    f64 smallCount = (f64)frames * allocationsPerFrame;
+    printf("%-25s small: %6.1f M allocs/s, %3d KB buffers: %6.2f GB/s, RSS +%.1f MB, committed %.1f MB of %.1f GB reserved\n",
+           names[kind], smallCount / result.smallSeconds * 1e-6, (i32)(bufferSize / KB),
+           (f64)bufferCount * bufferSize / result.bufferSeconds * 1e-9, (f64)result.residentBytes / MB,
+           (f64)tested.committed / MB, (f64)tested.capacity / GB);
+
+    if (kind == 0) PlatformFree(buffer, fixedSize);
+    else ReleaseArena(&tested);
+  }
+
+  // Scratch arenas are per thread and stay committed between frames.
+  i32 scopes = 1 << 22;
+  u32 checksum = 0;
+  f64 start = GetWallClockSeconds();
+  for (i32 i = 0; i < scopes; ++i)
+  {
+    TmpArena scratch;
+    TmpArenaPush(&scratch, GetScratchArena(arena));
+    u32 *values = (u32 *)AllocNoZero(scratch.arena, 64 * sizeof(u32));
+    values[0] = (u32)i;
+    checksum += values[0];
+    TmpArenaPop(&scratch);
+  }
+  f64 seconds = GetWallClockSeconds() - start;
+  printf("scratch scope (get + push + alloc + pop): %.2f ns (checksum %u)\n", seconds / scopes * 1e9, checksum);
+}
+
+// Coverage index of a glyph by binary search, -1 when not covered.
+i32 FindCoverageIndex(FontView coverage, u16 glyph)
+{
+  u16 format = ViewU16(coverage, 0);
+  i32 low = 0, high = (i32)ViewU16(coverage, 2) - 1;
+  while (low <= high)
+  {
+    i32 middle = (low + high) / 2;
+    u16 start = ViewU16(coverage, 4 + middle * (format == 1 ? 2 : 6));
+    u16 end = format == 1 ? start : ViewU16(coverage, 6 + middle * 6);
+    if (glyph < start) high = middle - 1;
+    else if (glyph > end) low = middle + 1;
+    else return format == 1 ? middle : ViewU16(coverage, 8 + middle * 6) + glyph - start;
+  }
+  return -1;
+}
+
+u16 FindGlyphClass(FontView classDef, u16 glyph)
+{
+  u16 format = ViewU16(classDef, 0);
+  if (format == 1)
+  {
+    u16 startGlyph = ViewU16(classDef, 2);
+    return glyph >= startGlyph && glyph - startGlyph < ViewU16(classDef, 4) ? ViewU16(classDef, 6 + (glyph - startGlyph) * 2) : 0;
+  }
+  i32 low = 0, high = format == 2 ? (i32)ViewU16(classDef, 2) - 1 : -1;
+  while (low <= high)
+  {
+    i32 middle = (low + high) / 2;
+    if (glyph < ViewU16(classDef, 4 + middle * 6)) high = middle - 1;
+    else if (glyph > ViewU16(classDef, 6 + middle * 6)) low = middle + 1;
+    else return ViewU16(classDef, 8 + middle * 6);
+  }
+  return 0;
+}
+
+// Walks the GPOS lookups for every pair like an interpreter without a compiled table would,
+// used as the baseline and to cross-check the compiled table.
+i32 GetKerningUncompiled(FontView gpos, u8 *isKerning, u16 left, u16 right)
+{
+  u16 lookupListOffset = ViewU16(gpos, 8);
+  FontView lookupList = FontSubView(gpos, lookupListOffset, gpos.length - lookupListOffset);
+  i32 value = 0;
+  for (u16 i = 0; i < ViewU16(lookupList, 0); ++i)
+  {
+    if (!isKerning[i]) continue;
+    u16 lookupOffset = ViewU16(lookupList, 2 + i * 2);
+    FontView lookup = FontSubView(lookupList, lookupOffset, lookupList.length - lookupOffset);
+    for (u16 j = 0; j < ViewU16(lookup, 4); ++j)
+    {
+      FontView subtable = GetPairPosSubtable(lookup, j);
+      u16 format = ViewU16(subtable, 0);
+      u16 coverageOffset = ViewU16(subtable, 2);
+      i32 coverageIndex = FindCoverageIndex(FontSubView(subtable, coverageOffset, subtable.length - coverageOffset), left);
+      if (coverageIndex < 0) continue;
+      u16 valueFormat1 = ViewU16(subtable, 4), valueFormat2 = ViewU16(subtable, 6);
+      i32 xAdvanceOffset = GetXAdvanceOffset(valueFormat1);
+      i32 valuesSize = (CountValueRecordFields(valueFormat1) + CountValueRecordFields(valueFormat2)) * 2;
+      if (format == 1)
+      {
+        if (coverageIndex >= ViewU16(subtable, 8)) continue;
+        u16 pairSetOffset = ViewU16(subtable, 10 + coverageIndex * 2);
+        i32 low = 0, high = (i32)ViewU16(subtable, pairSetOffset) - 1, found = 0;
+        while (low <= high && !found)
+        {
+          i32 middle = (low + high) / 2;
+          u32 record = pairSetOffset + 2 + middle * (2 + valuesSize);
+          u16 second = ViewU16(subtable, record);
+          if (right < second) high = middle - 1;
+          else if (right > second) low = middle + 1;
+          else
+          {
+            if (xAdvanceOffset >= 0) value += ViewI16(subtable, record + 2 + xAdvanceOffset);
+            found = 1;
+          }
+        }
+        if (found) break;
+      }
+      else if (format == 2)
+      {
+        u16 class1 = FindGlyphClass(FontSubView(subtable, ViewU16(subtable, 8), subtable.length - ViewU16(subtable, 8)), left);
+        u16 class2 = FindGlyphClass(FontSubView(subtable, ViewU16(subtable, 10), subtable.length - ViewU16(subtable, 10)), right);
+        u16 class1Count = ViewU16(subtable, 12), class2Count = ViewU16(subtable, 14);
+        if (class1 >= class1Count || class2 >= class2Count) continue;
+        if (xAdvanceOffset >= 0) value += ViewI16(subtable, 16 + (class1 * class2Count + class2) * valuesSize + xAdvanceOffset);
+        break;
+      }
+    }
+  }
+  return value;
+}
+
+void BenchmarkKerning(Arena *arena)
+{
+  i32 loads = 200;
+  i32 lookups = 1 << 22;
+  i32 paragraphLength = 1 << 20;
+  i32 passes = 16;
+
+  // Words of Latin letters with punctuation, the pairs a paragraph of prose goes through.
+  u8 *paragraph = (u8 *)Alloc(arena, paragraphLength);
+  char *letters = "etaoinshrdlucmfwypvbgkqjxzETAOINSHRDLUCMFWYPVBGKQJXZ";
+  u32 seed = 0x2545F491;
+  for (i32 i = 0; i < paragraphLength;)
+  {
+    i32 wordLength = 1 + RandomU32(&seed) % 9;
+    for (i32 j = 0; j < wordLength && i < paragraphLength; ++j) paragraph[i++] = letters[RandomU32(&seed) % (j ? 26 : 52)];
+    if (i < paragraphLength && RandomU32(&seed) % 8 == 0) paragraph[i++] = ",.;'\"-"[RandomU32(&seed) % 6];
+    if (i < paragraphLength) paragraph[i++] = ' ';
+  }
+
+  for (i32 f = 0; f < BUNDLED_FONT_COUNT; ++f)
+  {
+    Font font;
+    if (!LoadFont(arena, bundledFontPaths[f], &font)) continue;
+    CodepointMap codepointMap;
+    HorizontalMetrics metrics;
+    KerningTable kerning;
+    if (!LoadCodepointMap(arena, &font, &codepointMap, CODEPOINT_MAP_BMP_TABLE) || !LoadHorizontalMetrics(arena, &font, &metrics)) continue;
+
+    size_t used = arena->cur;
+    f64 start = GetWallClockSeconds();
+    i32 hasKerning = LoadKerningTable(arena, &font, &kerning);
+    f64 compileSeconds = GetWallClockSeconds() - start;
+    used = arena->cur - used;
+    for (i32 i = 1; i < loads; ++i)
+    {
+      TmpArena tmp;
+      TmpArenaPush(&tmp, arena);
+      KerningTable reloaded;
+      start = GetWallClockSeconds();
+      LoadKerningTable(arena, &font, &reloaded);
+      compileSeconds += GetWallClockSeconds() - start;
+      TmpArenaPop(&tmp);
+    }
+    printf("%s: %d pairs, %d class subtables, compiled in %.1f us into %.1f KB\n", bundledFontPaths[f],
+           kerning.pairCount, kerning.classTableCount, compileSeconds / loads * 1e6, (f64)used / KB);
+
+    u16 *glyphIds = (u16 *)Alloc(arena, (paragraphLength + 16) * sizeof(u16));
+    i32 *advances = (i32 *)Alloc(arena, paragraphLength * sizeof(i32));
+    i32 glyphCount = GlyphIndicesFromUtf8(&codepointMap, paragraph, paragraphLength, glyphIds);
+
+    // Per-pair latency over the pairs of the paragraph, checked against the uncompiled walk when GPOS has one.
+    FontView gpos = GetFontTable(&font, FONT_TABLE_GPOS);
+    u16 lookupCount = ViewU16(gpos, 8) < gpos.length ? ViewU16(FontSubView(gpos, ViewU16(gpos, 8), gpos.length - ViewU16(gpos, 8)), 0) : 0;
+    u8 *isKerning = (u8 *)Alloc(arena, lookupCount + 1);
+    i32 gposKerning = gpos.length && FindKerningLookups(gpos, isKerning, lookupCount);
+    i64 checksum = 0;
+    start = GetWallClockSeconds();
+    for (i32 i = 0; i < lookups; ++i)
+    {
+      i32 at = i % (glyphCount - 1);
+      checksum += GetKerning(&kerning, glyphIds[at], glyphIds[at + 1]);
+    }
+    f64 compiledSeconds = GetWallClockSeconds() - start;
+    printf("  pair lookup: compiled %.2f ns", compiledSeconds / lookups * 1e9);
+    if (gposKerning)
+    {
+      i32 checked = lookups / 64, mismatches = 0, kerned = 0;
+      start = GetWallClockSeconds();
+      for (i32 i = 0; i < checked; ++i)
+      {
+        i32 at = i % (glyphCount - 1);
+        i32 expected = GetKerningUncompiled(gpos, isKerning, glyphIds[at], glyphIds[at + 1]);
+        mismatches += expected != GetKerning(&kerning, glyphIds[at], glyphIds[at + 1]);
+        kerned += expected != 0;
+      }
+      f64 uncompiledSeconds = GetWallClockSeconds() - start;
+      printf(", uncompiled GPOS walk %.2f ns (%d of %d pairs kerned, %d mismatches)",
+             uncompiledSeconds / checked * 1e9, kerned, checked, mismatches);
+    }
+    printf(" (checksum %lld)\n", (long long)checksum);
+
+    // Layout of the whole paragraph: UTF-8 to glyphs, then advances with and without kerning.
+    f64 cmapSeconds = 0, advanceSeconds = 0, kernedSeconds = 0;
+    i64 width = 0, kernedWidth = 0;
+    for (i32 pass = 0; pass < passes; ++pass)
+    {
+      start = GetWallClockSeconds();
+      glyphCount = GlyphIndicesFromUtf8(&codepointMap, paragraph, paragraphLength, glyphIds);
+      cmapSeconds += GetWallClockSeconds() - start;
+      start = GetWallClockSeconds();
+      width = GetGlyphRunAdvances(&metrics, NULL, glyphIds, glyphCount, advances);
+      advanceSeconds += GetWallClockSeconds() - start;
+      start = GetWallClockSeconds();
+      kernedWidth = GetGlyphRunAdvances(&metrics, hasKerning ? &kerning : NULL, glyphIds, glyphCount, advances);
+      kernedSeconds += GetWallClockSeconds() - start;
+    }
+    printf("  1 MB paragraph: cmap %.2f ms, advances %.2f ms, advances + kerning %.2f ms (%.2f ns/glyph), width %lld -> %lld units\n",
+           cmapSeconds / passes * 1e3, advanceSeconds / passes * 1e3, kernedSeconds / passes * 1e3,
+           kernedSeconds / passes / glyphCount * 1e9, (long long)width, (long long)kernedWidth);
+    UnloadFont(&font);
+  }
+}
+
+// Log lines built from a Zipf-like vocabulary with numbers in between, the kind of text where words
+// repeat across lines but whole lines rarely do.
+i32 BuildLogCorpus(u8 *corpus, i32 capacity, u32 *seed)
+{
+  char *levels[] = { "INFO", "WARN", "DEBUG", "ERROR" };
+  char vocabulary[1024][12];
+  for (i32 i = 0; i < 1024; ++i)
+  {
+    i32 length = 2 + RandomU32(seed) % 9;
+    for (i32 j = 0; j < length; ++j) vocabulary[i][j] = "etaoinshrdlucmfwypvbgkqjxz"[RandomU32(seed) % 26];
+    vocabulary[i][length] = 0;
+  }
+
+  i32 length = 0;
+  while (length + 256 < capacity)
+  {
+    length += sprintf((char *)&corpus[length], "[%s] %02u:%02u:%02u", levels[RandomU32(seed) % 4], RandomU32(seed) % 24, RandomU32(seed) % 60, RandomU32(seed) % 60);
+    i32 wordCount = 4 + RandomU32(seed) % 12;
+    for (i32 i = 0; i < wordCount; ++i)
+    {
+      u32 rank = RandomU32(seed) % 1024;
+      rank = rank * rank / 1024;
+      if (RandomU32(seed) % 6 == 0) length += sprintf((char *)&corpus[length], " %u", RandomU32(seed) % 10000);
+      else length += sprintf((char *)&corpus[length], " %s", vocabulary[rank]);
+    }
+    corpus[length++] = '\n';
+  }
+  return length;
+}
+
+void BenchmarkTextLayout(Arena *arena)
+{
+  i32 corpusCapacity = 4 << 20;
+  i32 passes = 4;
+  f32 pixelSize = 16.0f;
+  f32 lineWidth = 480.0f;
+
+  Font font;
+  TextFont textFont;
+  if (!LoadFont(arena, BENCHMARK_FONT_PATH, &font) || !LoadTextFont(arena, &font, &textFont)) return;
+
+  u32 seed = 0x2545F491;
+  u8 *corpus = (u8 *)Alloc(arena, corpusCapacity);
+  i32 corpusLength = BuildLogCorpus(corpus, corpusCapacity, &seed);
+
+  // Short labels laid out one call each, as a UI redrawing the same strings every frame.
+  i32 labelCount = 2000;
+  u8 **labels = (u8 **)Alloc(arena, labelCount * sizeof(u8 *));
+  i32 *labelLengths = (i32 *)Alloc(arena, labelCount * sizeof(i32));
+  char *labelWords[] = { "Open", "Save", "Cancel", "File", "Edit", "View", "Settings", "Export", "Import", "Recent", "Window", "Help" };
+  for (i32 i = 0; i < labelCount; ++i)
+  {
+    labels[i] = (u8 *)Alloc(arena, 64);
+    labelLengths[i] = sprintf((char *)labels[i], "%s %s %d", labelWords[RandomU32(&seed) % 12], labelWords[RandomU32(&seed) % 12], i % 50);
+  }
+
+  RunCache *caches[] = { NULL, CreateRunCache(arena, 1 << 16, 8 * MB), CreateRunCache(arena, 1 << 16, 8 * MB) };
+  char *names[] = { "uncached", "cached" };
+  for (i32 c = 0; c < 2; ++c)
+  {
+    RunCache *cache = caches[c];
+    f64 seconds[2] = {0};
+    i64 glyphs[2] = {0};
+    i32 lineCount = 0;
+    for (i32 pass = 0; pass < passes; ++pass)
+    {
+      TmpArena tmp;
+      TmpArenaPush(&tmp, arena);
+      f64 start = GetWallClockSeconds();
+      TextLayout *layout = LayoutText(arena, &textFont, cache, corpus, corpusLength, pixelSize, lineWidth);
+      seconds[pass > 0] += GetWallClockSeconds() - start;
+      glyphs[pass > 0] += layout->glyphCount;
+      lineCount = layout->lineCount;
+      TmpArenaPop(&tmp);
+    }
+    printf("corpus %-8s %.1f MB, %d lines: cold %6.1f M glyphs/s, warm %6.1f M glyphs/s", names[c], (f64)corpusLength / MB, lineCount,
+           glyphs[0] / seconds[0] * 1e-6, glyphs[1] / seconds[1] * 1e-6);
+    if (cache) printf(" (%llu hits, %llu misses, %llu rotations)", (unsigned long long)cache->hits, (unsigned long long)cache->misses, (unsigned long long)cache->rotations);
+    printf("\n");
+  }
+
+  for (i32 c = 0; c < 2; ++c)
+  {
+    RunCache *cache = caches[c ? 2 : 0];
+    f64 seconds[2] = {0};
+    i64 glyphs[2] = {0};
+    for (i32 pass = 0; pass < passes; ++pass)
+    {
+      f64 start = GetWallClockSeconds();
+      for (i32 i = 0; i < labelCount; ++i)
+      {
+        TmpArena tmp;
+        TmpArenaPush(&tmp, arena);
+        glyphs[pass > 0] += LayoutText(arena, &textFont, cache, labels[i], labelLengths[i], pixelSize, lineWidth)->glyphCount;
+        TmpArenaPop(&tmp);
+      }
+      seconds[pass > 0] += GetWallClockSeconds() - start;
+    }
+    printf("labels %-8s %d strings: cold %6.1f M glyphs/s, warm %6.1f M glyphs/s, %.2f us per label warm\n", names[c], labelCount,
+           glyphs[0] / seconds[0] * 1e-6, glyphs[1] / seconds[1] * 1e-6, seconds[1] / (labelCount * (passes - 1)) * 1e6);
+  }
+  UnloadFont(&font);
+}
+
+#define BENCHMARK_CACHE_PATH "fleuret-benchmark.fontcache"
+
+// Opens the font one way and looks up a first glyph, what an application does before drawing anything.
+// mode 0 parses the font, 1 goes through the cache.
+u16 OpenAndLookUpFirstGlyph(Arena *arena, i32 mode)
+{
+  u16 advance = 0;
+  if (mode == 0)
+  {
+    Font font;
+    TextFont textFont;
+    GlyphData glyphData;
+    if (LoadFont(arena, BENCHMARK_FONT_PATH, &font))
+    {
+      if (LoadTextFont(arena, &font, &textFont) && LoadGlyphData(arena, &font, &glyphData))
+      {
+        advance = GetAdvanceWidth(&textFont.metrics, GlyphIndexFromCodepoint(&textFont.codepointMap, 'A'));
+      }
+      UnloadFont(&font);
+    }
+  }
+  else
+  {
+    CachedFont cached;
+    if (OpenCachedFont(arena, BENCHMARK_FONT_PATH, BENCHMARK_CACHE_PATH, &cached))
+    {
+      advance = GetAdvanceWidth(&cached.textFont.metrics, GlyphIndexFromCodepoint(&cached.textFont.codepointMap, 'A'));
+      UnloadCachedFont(&cached);
+    }
+  }
+  return advance;
+}
+
+void BenchmarkFontCache(Arena *arena)
+{
+  remove(BENCHMARK_CACHE_PATH);
+  Font font;
+  TextFont textFont;
+  GlyphData glyphData;
+  CachedFont cached;
+  if (!LoadFont(arena, BENCHMARK_FONT_PATH, &font) || !LoadTextFont(arena, &font, &textFont) || !LoadGlyphData(arena, &font, &glyphData)) return;
+
+  f64 start = GetWallClockSeconds();
+  if (!OpenCachedFont(arena, BENCHMARK_FONT_PATH, BENCHMARK_CACHE_PATH, &cached) || !cached.cacheFile.data)
+  {
+    remove(BENCHMARK_CACHE_PATH);
+    return;
+  }
+  f64 buildSeconds = GetWallClockSeconds() - start;
+
+  // The cached state must answer exactly like the parsed one.
+  i32 mismatches = 0;
+  for (u32 codepoint = 0; codepoint < 0x110000; ++codepoint)
+  {
+    mismatches += GlyphIndexFromCodepoint(&cached.textFont.codepointMap, codepoint) != GlyphIndexFromCodepoint(&textFont.codepointMap, codepoint);
+  }
+  u16 numGlyphs = textFont.metrics.numGlyphs;
+  for (u32 glyph = 0; glyph <= numGlyphs; ++glyph)
+  {
+    mismatches += glyph < numGlyphs && GetAdvanceWidth(&cached.textFont.metrics, (u16)glyph) != GetAdvanceWidth(&textFont.metrics, (u16)glyph);
+    mismatches += cached.glyphData.glyphOffsets[glyph] != glyphData.glyphOffsets[glyph];
+  }
+  u32 seed = 0x9E3779B9;
+  for (i32 i = 0; i < 1 << 20; ++i)
+  {
+    u16 left = (u16)(RandomU32(&seed) % numGlyphs), right = (u16)(RandomU32(&seed) % numGlyphs);
+    mismatches += GetKerning(&cached.textFont.kerning, left, right) != GetKerning(&textFont.kerning, left, right);
+  }
+  printf("cache %.1f KB built and written in %.2f ms, %d mismatches against the parsed font\n",
+         (f64)cached.cacheFile.size / KB, buildSeconds * 1e3, mismatches);
+  UnloadCachedFont(&cached);
+
+  // A cache built from another font is stale for this one.
+  Font otherFont;
+  if (LoadFont(arena, bundledFontPaths[1], &otherFont))
+  {
+    i32 written = WriteFontCache(arena, &otherFont, BENCHMARK_CACHE_PATH);
+    memset(&cached, 0, sizeof(CachedFont));
+    cached.font = font;
+    i32 stale = written && !LoadFontCache(arena, &cached, BENCHMARK_CACHE_PATH);
+    printf("cache of %s rejected for %s: %s\n", bundledFontPaths[1], BENCHMARK_FONT_PATH, stale ? "yes" : "NO");
+    UnloadFont(&otherFont);
+  }
+  UnloadFont(&font);
+
+  // Cold runs drop the font and the cache from the OS file cache first, when the platform allows it.
+  char *names[] = { "parse", "cache rebuild", "cache" };
+  i32 canEvict = PlatformEvictFileCache(BENCHMARK_FONT_PATH);
+  for (i32 m = 0; m < 3; ++m)
+  {
+    f64 seconds[2] = {0};
+    i32 runs[2] = { canEvict ? 20 : 0, 200 };
+    for (i32 cold = 1; cold >= 0; --cold)
+    {
+      for (i32 i = 0; i < runs[cold]; ++i)
+      {
+        if (m == 1) remove(BENCHMARK_CACHE_PATH);
+        if (cold)
+        {
+          PlatformEvictFileCache(BENCHMARK_FONT_PATH);
+          PlatformEvictFileCache(BENCHMARK_CACHE_PATH);
+        }
+        TmpArena tmp;
+        TmpArenaPush(&tmp, arena);
+        start = GetWallClockSeconds();
+        if (!OpenAndLookUpFirstGlyph(arena, m > 0)) fprintf(stderr, "First lookup failed\n");
+        seconds[cold] += GetWallClockSeconds() - start;
+        TmpArenaPop(&tmp);
+      }
+    }
+    printf("%-14s first glyph lookup: warm %8.1f us", names[m], seconds[0] / runs[0] * 1e6);
+    if (canEvict) printf(", cold %8.1f us", seconds[1] / runs[1] * 1e6);
+    printf("\n");
+  }
+  remove(BENCHMARK_CACHE_PATH);
+}
+
+// Glyphs per second through DecodeGlyphOutline for the glyf font and its CFF copy, then through the
+// rasterizer so the cost of flattening cubics shows next to the quadratics.
+void BenchmarkCompactOutlines(Arena *arena)
+{
+  char *paths[] = { BENCHMARK_FONT_PATH, BENCHMARK_CFF_FONT_PATH };
+  i32 passes = 20;
+  f32 pixelSize = 32;
+  for (i32 f = 0; f < 2; ++f)
+  {
+    Font font;
+    if (!LoadFont(arena, paths[f], &font)) return;
+
+    f64 start = GetWallClockSeconds();
+    GlyphData glyphData;
+    if (!LoadGlyphData(arena, &font, &glyphData)) return;
+    f64 loadSeconds = GetWallClockSeconds() - start;
+    GlyphOutline *outline = AllocGlyphOutline(arena, &glyphData);
+
+    i32 failures = 0;
+    i64 points = 0;
+    for (u16 glyphId = 0; glyphId < glyphData.numGlyphs; ++glyphId)
+    {
+      if (!DecodeGlyphOutline(&glyphData, glyphId, outline)) ++failures;
+      points += outline->pointCount;
+    }
+
+    start = GetWallClockSeconds();
+    for (i32 pass = 0; pass < passes; ++pass)
+    {
+      for (u16 glyphId = 0; glyphId < glyphData.numGlyphs; ++glyphId)
+      {
+        DecodeGlyphOutline(&glyphData, glyphId, outline);
+      }
+    }
+    f64 decodeSeconds = GetWallClockSeconds() - start;
+
+    f32 scale = pixelSize / glyphData.fontHeader->unitsPerEm;
+    i32 maxSide = 4 * (i32)pixelSize;
+    Rasterizer *rasterizer = AllocRasterizer(arena, maxSide, maxSide);
+    u8 *pixels = (u8 *)Alloc(arena, maxSide * maxSide);
+    i32 rasterized = 0;
+    start = GetWallClockSeconds();
+    for (i32 pass = 0; pass < passes; ++pass)
+    {
+      for (u16 glyphId = 0; glyphId < glyphData.numGlyphs; ++glyphId)
+      {
+        DecodeGlyphOutline(&glyphData, glyphId, outline);
+        GlyphBitmap bitmap;
+        GetGlyphBitmapBounds(outline, scale, &bitmap);
+        bitmap.pixels = pixels;
+        rasterized += RasterizeGlyphOutline(rasterizer, outline, scale, &bitmap);
+      }
+    }
+    f64 rasterSeconds = GetWallClockSeconds() - start;
+
+    printf("%-24s %s loaded in %6.1f us, %d glyphs (%d failed), %lld points\n", paths[f],
+           glyphData.compactFont ? "CFF " : "glyf", loadSeconds * 1e6, glyphData.numGlyphs, failures, (long long)points);
+    printf("%-24s decode %6.2f M glyphs/s, decode + raster at %.0f px %6.3f M glyphs/s (%d skipped)\n", "",
+           (f64)glyphData.numGlyphs * passes / decodeSeconds * 1e-6, pixelSize,
+           (f64)glyphData.numGlyphs * passes / rasterSeconds * 1e-6, glyphData.numGlyphs * passes - rasterized);
+    UnloadFont(&font);
+  }
+}
+
+// Opens the font, builds everything layout and rasterization need and decodes a few hundred glyphs.
+i32 RunParsePipeline(Arena *arena)
+{
+  Font font;
+  if (!LoadFont(arena, BENCHMARK_FONT_PATH, &font)) return 0;
+  TextFont textFont;
+  GlyphData glyphData;
+  i32 success = LoadTextFont(arena, &font, &textFont) && LoadGlyphData(arena, &font, &glyphData);
+  if (success)
+  {
+    u8 text[] = "Sphinx of black quartz, judge my vow.";
+    LayoutText(arena, &textFont, NULL, text, (i32)sizeof(text) - 1, 16.0f, 120.0f);
+    GlyphOutline *outline = AllocGlyphOutline(arena, &glyphData);
+    for (u16 glyphId = 0; glyphId < 256 && glyphId < glyphData.numGlyphs; ++glyphId)
+    {
+      success &= DecodeGlyphOutline(&glyphData, glyphId, outline);
+    }
+  }
+  UnloadFont(&font);
+  return success;
+}
+
+// Pass times of a PROFILE=0 and a PROFILE=1 build give the cost of the instrumentation. The instrumented
+// build also times a bare scope and writes the passes as a trace.
+void BenchmarkProfiling(Arena *arena)
+{
+  i32 passes = 200;
+#if PROFILE
+  // The first round only commits the event pages.
+  i32 scopes = 1 << 19;
+  BeginProfiling(arena, scopes);
+  f64 start = 0;
+  for (i32 round = 0; round < 2; ++round)
+  {
+    ResetProfiling();
+    start = GetWallClockSeconds();
+    for (i32 i = 0; i < scopes; ++i)
+    {
+      PROFILE_BEGIN(EmptyScope);
+      PROFILE_END(EmptyScope);
+    }
+  }
+  printf("empty scope: %.1f ns\n", (GetWallClockSeconds() - start) / scopes * 1e9);
+  BeginProfiling(arena, PROFILE_DEFAULT_EVENTS);
+  PROFILE_THREAD_NAME("benchmark");
+#endif
+
+  i32 failures = 0;
+  f64 seconds = 0;
+  for (i32 pass = 0; pass < passes; ++pass)
+  {
+    TmpArena tmp;
+    TmpArenaPush(&tmp, arena);
+    f64 passStart = GetWallClockSeconds();
+    failures += !RunParsePipeline(arena);
+    seconds += GetWallClockSeconds() - passStart;
+    TmpArenaPop(&tmp);
+  }
+#if PROFILE
+  char *build = "instrumented";
+#else
+  char *build = "PROFILE=0, scopes compiled out";
+#endif
+  printf("parse pipeline: %.1f us per pass, %d failed (%s)\n", seconds / passes * 1e6, failures, build);
+
+#if PROFILE
+  PROFILE_ARENA("benchmark arena", arena);
+  i64 events = profiler.reserved < profiler.capacity ? profiler.reserved : profiler.capacity;
+  if (WriteProfileTrace(BENCHMARK_TRACE_PATH)) printf("trace of up to %lld events written to %s\n", (long long)events, BENCHMARK_TRACE_PATH);
+#endif
+}
+
+i32 EncodeUtf8(u32 codepoint, u8 *text)
+{
+  if (codepoint < 0x80)
+  {
+    text[0] = (u8)codepoint;
+    return 1;
+  }
+  if (codepoint < 0x800)
+  {
+    text[0] = (u8)(0xC0 | (codepoint >> 6));
+    text[1] = (u8)(0x80 | (codepoint & 0x3F));
+    return 2;
+  }
+  if (codepoint < 0x10000)
+  {
+    text[0] = (u8)(0xE0 | (codepoint >> 12));
+    text[1] = (u8)(0x80 | ((codepoint >> 6) & 0x3F));
+    text[2] = (u8)(0x80 | (codepoint & 0x3F));
+    return 3;
+  }
+  text[0] = (u8)(0xF0 | (codepoint >> 18));
+  text[1] = (u8)(0x80 | ((codepoint >> 12) & 0x3F));
+  text[2] = (u8)(0x80 | ((codepoint >> 6) & 0x3F));
+  text[3] = (u8)(0x80 | (codepoint & 0x3F));
+  return 4;
+}
+
+// Synthetic script font: ASCII punctuation and digits plus most of a 768 codepoint block, every third font
+// also covers the start of the next block so chain order matters.
+CodepointMap *BuildScriptFontMap(Arena *arena, u32 blockStart, u32 *seed)
+{
+  CodepointMapSubtable *subtable = (CodepointMapSubtable *)Alloc(arena, sizeof(CodepointMapSubtable));
+  CodepointMapFormat12 *format12 = (CodepointMapFormat12 *)Alloc(arena, sizeof(CodepointMapFormat12));
+  format12->groups = (SequentialMapGroup *)Alloc(arena, 8 * sizeof(SequentialMapGroup));
+  subtable->format = 12;
+  subtable->value.format12 = format12;
+
+  u32 glyphId = 1;
+  u32 firsts[] = { 0x20, 0x30, blockStart, blockStart + 0x100 + RandomU32(seed) % 64, blockStart + 0x300 };
+  u32 lasts[] = { 0x2F, 0x40, blockStart + 0xFF, blockStart + 0x2FF, blockStart + 0x37F };
+  i32 groupCount = RandomU32(seed) % 3 ? 4 : 5;
+  for (i32 g = 0; g < groupCount; ++g)
+  {
+    SequentialMapGroup *group = &format12->groups[format12->numGroups++];
+    group->startCharCode = firsts[g];
+    group->endCharCode = lasts[g];
+    group->startGlyphID = glyphId;
+    glyphId += lasts[g] - firsts[g] + 1;
+  }
+  format12->length = 16 + format12->numGroups * sizeof(SequentialMapGroup);
+
+  CodepointMap *map = (CodepointMap *)Alloc(arena, sizeof(CodepointMap));
+  map->subtable = subtable;
+  map->pageTable = BuildCodepointPageTable(arena, subtable);
+  return map;
+}
+
+// First font of the chain with a glyph, asking every cmap in turn.
+u8 FindFallbackFontNaive(CodepointMap **fonts, i32 fontCount, u32 codepoint)
+{
+  for (i32 font = 0; font < fontCount; ++font)
+  {
+    if (GlyphIndexFromCodepoint(fonts[font], codepoint)) return (u8)font;
+  }
+  return FALLBACK_NO_FONT;
+}
+
+void BenchmarkFallbackResolution(Arena *arena)
+{
+  i32 maxFonts = 100;
+  i32 streamLength = 1 << 20;
+  i32 passes = 8;
+
+  // NotoSans and the Vera mono font first, as a UI font and its fallback, then script fonts.
+  Font fonts[2];
+  CodepointMap **maps = (CodepointMap **)Alloc(arena, maxFonts * sizeof(CodepointMap *));
+  for (i32 i = 0; i < 2; ++i)
+  {
+    maps[i] = (CodepointMap *)Alloc(arena, sizeof(CodepointMap));
+    if (!LoadFont(arena, bundledFontPaths[i], &fonts[i]) || !LoadCodepointMap(arena, &fonts[i], maps[i], CODEPOINT_MAP_PAGE_TABLE)) return;
+  }
+  u32 seed = 0x9E3779B9;
+  for (i32 i = 2; i < maxFonts; ++i)
+  {
+    maps[i] = BuildScriptFontMap(arena, 0x3000 + (u32)(i - 2) * 0x300, &seed);
+  }
+
+  // Words of one script separated by spaces, mostly Latin, some codepoints no font covers.
+  u32 *codepoints = (u32 *)Alloc(arena, streamLength * sizeof(u32));
+  u8 *utf8 = (u8 *)Alloc(arena, streamLength * 4);
+  i32 utf8Length = 0;
+  for (i32 i = 0; i < streamLength;)
+  {
+    u32 roll = RandomU32(&seed) % 100;
+    u32 script = roll < 50 ? 0 : 1 + RandomU32(&seed) % (maxFonts - 2);
+    i32 wordLength = 2 + RandomU32(&seed) % 8;
+    for (i32 c = 0; c < wordLength && i < streamLength; ++c)
+    {
+      u32 codepoint = !script ? 'a' + RandomU32(&seed) % 26 : 0x3000 + (script - 1) * 0x300 + RandomU32(&seed) % 0x300;
+      if (RandomU32(&seed) % 200 == 0) codepoint = 0x10FF00 + RandomU32(&seed) % 256;
+      codepoints[i++] = codepoint;
+      utf8Length += EncodeUtf8(codepoint, &utf8[utf8Length]);
+    }
+    if (i < streamLength)
+    {
+      codepoints[i++] = ' ';
+      utf8[utf8Length++] = ' ';
+    }
+  }
+
+  u8 *expected = (u8 *)Alloc(arena, streamLength);
+  u8 *resolved = (u8 *)Alloc(arena, streamLength);
+  i32 maxRuns = streamLength;
+  FallbackRun *runs = (FallbackRun *)Alloc(arena, maxRuns * sizeof(FallbackRun));
+  i32 chainLengths[] = { 1, 10, 100 };
+  for (i32 c = 0; c < 3; ++c)
+  {
+    i32 fontCount = chainLengths[c];
+    f64 start = GetWallClockSeconds();
+    FallbackIndex *index = BuildFallbackIndex(arena, maps, fontCount);
+    f64 buildSeconds = GetWallClockSeconds() - start;
+    if (!index) return;
+
+    start = GetWallClockSeconds();
+    for (i32 pass = 0; pass < passes; ++pass)
+    {
+      for (i32 i = 0; i < streamLength; ++i)
+      {
+        expected[i] = FindFallbackFontNaive(maps, fontCount, codepoints[i]);
+      }
+    }
+    f64 naiveSeconds = GetWallClockSeconds() - start;
+
+    start = GetWallClockSeconds();
+    for (i32 pass = 0; pass < passes; ++pass)
+    {
+      for (i32 i = 0; i < streamLength; ++i)
+      {
+        resolved[i] = FindFallbackFont(index, codepoints[i]);
+      }
+    }
+    f64 indexSeconds = GetWallClockSeconds() - start;
+    i32 matches = memcmp(expected, resolved, streamLength) == 0;
+
+    i32 runCount = 0;
+    start = GetWallClockSeconds();
+    for (i32 pass = 0; pass < passes; ++pass)
+    {
+      runCount = SplitFallbackRuns(index, utf8, utf8Length, runs, maxRuns);
+    }
+    f64 splitSeconds = GetWallClockSeconds() - start;
+    i32 covered = runCount > 0 && runs[runCount - 1].offset + runs[runCount - 1].length == utf8Length;
+
+    f64 lookups = (f64)streamLength * passes;
+    printf("%3d fonts: index %.1f KB built in %.2f ms, per-font cmaps %6.2f ns/codepoint, index %5.2f ns/codepoint (%.1fx)%s\n",
+           fontCount, GetFallbackIndexSize(index) / 1024.0, buildSeconds * 1e3, naiveSeconds / lookups * 1e9,
+           indexSeconds / lookups * 1e9, naiveSeconds / indexSeconds, matches ? "" : " MISMATCH");
+    printf("           runs: %d over %.1f MB, %.0f MB/s%s\n", runCount, (f64)utf8Length / MB,
+           (f64)utf8Length * passes / splitSeconds / MB, covered ? "" : " INCOMPLETE");
+  }
+
+  UnloadFont(&fonts[0]);
+  UnloadFont(&fonts[1]);
+}
+
+// Appends the codepoints of [first, last] to codepoints.
+i32 AppendCodepointRange(u32 *codepoints, i32 count, u32 first, u32 last)
+{
+  for (u32 codepoint = first; codepoint <= last; ++codepoint) codepoints[count++] = codepoint;
+  return count;
+}
+
+void BenchmarkSubsetting(Arena *arena)
+{
+  Font font;
+  FontSubsetter subsetter;
+  f64 start = GetWallClockSeconds();
+  if (!LoadFont(arena, BENCHMARK_FONT_PATH, &font) || !LoadFontSubsetter(arena, &font, &subsetter)) return;
+  printf("subsetter loaded in %.1f us, source font %.1f KB\n", (GetWallClockSeconds() - start) * 1e6, font.view.length / 1024.0);
+
+  // A label, a Latin page, the European scripts and every codepoint the font maps.
+  u32 *codepoints = (u32 *)Alloc(arena, 0x10000 * sizeof(u32));
+  i32 requestEnds[4];
+  i32 count = 0;
+  char *label = "Save as...";
+  for (char *c = label; *c; ++c) codepoints[count++] = (u8)*c;
+  requestEnds[0] = count;
+  count = AppendCodepointRange(codepoints, count, 0x20, 0x7E);
+  count = AppendCodepointRange(codepoints, count, 0xA0, 0xFF);
+  requestEnds[1] = count;
+  count = AppendCodepointRange(codepoints, count, 0x100, 0x24F);
+  count = AppendCodepointRange(codepoints, count, 0x370, 0x4FF);
+  requestEnds[2] = count;
+  count = AppendCodepointRange(codepoints, count, 0x500, 0xFFFF);
+  requestEnds[3] = count;
+  char *requestNames[] = { "label", "latin page", "european", "whole font" };
+
+  for (i32 r = 0; r < 4; ++r)
+  {
+    // The later requests extend the earlier ones, so they start at the same place.
+    i32 codepointCount = requestEnds[r];
+    i32 iterations = r < 3 ? 2000 : 50;
+    u32 subsetSize = 0;
+    u16 glyphCount = 0;
+    start = GetWallClockSeconds();
+    for (i32 i = 0; i < iterations; ++i)
+    {
+      TmpArena tmp;
+      TmpArenaPush(&tmp, arena);
+      u8 *subsetData = SubsetFont(arena, &subsetter, codepoints, codepointCount, &subsetSize);
+      Font subset;
+      if (!i && subsetData && LoadFontFromMemory(arena, subsetData, subsetSize, &subset)) glyphCount = ViewU16(GetFontTable(&subset, FONT_TABLE_MAXP), 4);
+      TmpArenaPop(&tmp);
+    }
+    f64 seconds = GetWallClockSeconds() - start;
+    printf("%-11s %5d codepoints -> %4d glyphs, %7.1f KB (%5.2f%% of the font), %8.1f us per subset\n", requestNames[r], codepointCount,
+           glyphCount, subsetSize / 1024.0, 100.0 * subsetSize / font.view.length, seconds / iterations * 1e6);
+  }
+
+  // Cold: nothing parsed ahead of the request.
+  i32 iterations = 200;
+  start = GetWallClockSeconds();
+  for (i32 i = 0; i < iterations; ++i)
+  {
+    TmpArena tmp;
+    TmpArenaPush(&tmp, arena);
+    Font coldFont;
+    FontSubsetter coldSubsetter;
+    u32 subsetSize = 0;
+    if (LoadFont(arena, BENCHMARK_FONT_PATH, &coldFont))
+    {
+      if (LoadFontSubsetter(arena, &coldFont, &coldSubsetter)) SubsetFont(arena, &coldSubsetter, codepoints, requestEnds[0], &subsetSize);
+      UnloadFont(&coldFont);
+    }
+    TmpArenaPop(&tmp);
+  }
+  printf("label cold, font opened and parsed per request: %.1f us\n", (GetWallClockSeconds() - start) / iterations * 1e6);
+
+  UnloadFont(&font);
+}
+
+// Seconds per glyph to decode every glyph of the font passes times, through the cache when there is one.
+f64 MeasureInstancing(GlyphData *glyphData, VariationInstance *instance, InstanceCache *cache, GlyphOutline *outline, i32 passes)
+{
+  f64 start = GetWallClockSeconds();
+  for (i32 pass = 0; pass < passes; ++pass)
+  {
+    for (u16 glyphId = 0; glyphId < glyphData->numGlyphs; ++glyphId)
+    {
+      if (cache) DecodeCachedGlyphOutline(cache, glyphData, instance, glyphId, outline);
+      else DecodeInstancedGlyphOutline(glyphData, instance, glyphId, outline);
+    }
+  }
+  return (GetWallClockSeconds() - start) / ((f64)passes * glyphData->numGlyphs);
+}
+
+void BenchmarkVariations(Arena *arena)
+{
+  Font font;
+  GlyphData glyphData;
+  FontVariations fontVariations;
+  if (!LoadFont(arena, BENCHMARK_VARIABLE_FONT_PATH, &font)) return;
+  f64 start = GetWallClockSeconds();
+  if (!LoadGlyphData(arena, &font, &glyphData) || !LoadFontVariations(arena, &font, &fontVariations)) return;
+  VariationInstance *instance = CreateVariationInstance(arena, &glyphData);
+  if (!instance) return;
+  printf("glyf, gvar and fvar loaded in %.1f us, %d glyphs, %d axes, %d named instances\n", (GetWallClockSeconds() - start) * 1e6,
+         glyphData.numGlyphs, fontVariations.axisCount, fontVariations.instanceCount);
+
+  GlyphOutline *outline = AllocGlyphOutline(arena, &glyphData);
+  InstanceCache *cache = CreateInstanceCache(arena, 2 * glyphData.numGlyphs, 2 * MB);
+  i32 passes = 50;
+  printf("%-24s %8.1f ns per glyph\n", "default outlines", MeasureInstancing(&glyphData, NULL, NULL, outline, passes) * 1e9);
+
+  // Each named instance decoded cold, then through a cache warmed by a first pass.
+  for (i32 i = 0; i < fontVariations.instanceCount; ++i)
+  {
+    f32 *coordinates = fontVariations.instances[i].coordinates;
+    SetVariationInstanceLocation(instance, &fontVariations, coordinates);
+    f64 coldSeconds = MeasureInstancing(&glyphData, instance, NULL, outline, passes);
+    MeasureInstancing(&glyphData, instance, cache, outline, 1);
+    u64 misses = cache->misses;
+    f64 cachedSeconds = MeasureInstancing(&glyphData, instance, cache, outline, passes);
+    printf("instance wght %5.1f wdth %5.1f: instanced %8.1f ns, cached %6.1f ns per glyph (%llu misses)\n", coordinates[0],
+           fontVariations.axisCount > 1 ? coordinates[1] : 0.0f, coldSeconds * 1e9, cachedSeconds * 1e9, (unsigned long long)(cache->misses - misses));
+  }
+
+  // A line of text animated through the weight axis, a new instance every frame, then held still.
+  char *text = "The quick brown fox jumps over the lazy dog, 0123456789.";
+  CodepointMap codepointMap;
+  if (!LoadCodepointMap(arena, &font, &codepointMap, CODEPOINT_MAP_BMP_TABLE)) return;
+  i32 textLength = (i32)strlen(text);
+  u16 *glyphIds = (u16 *)Alloc(arena, (textLength + 16) * sizeof(u16));
+  i32 glyphCount = GlyphIndicesFromUtf8(&codepointMap, (u8 *)text, textLength, glyphIds);
+  i32 wghtAxis = FindVariationAxis(&fontVariations, "wght");
+  if (wghtAxis < 0) return;
+  VariationAxis *axis = &fontVariations.axes[wghtAxis];
+  f32 location[16] = {0};
+  for (i32 i = 0; i < fontVariations.axisCount && i < 16; ++i) location[i] = fontVariations.axes[i].defaultValue;
+
+  i32 frames = 600;
+  for (i32 held = 0; held < 2; ++held)
+  {
+    u64 hits = cache->hits;
+    start = GetWallClockSeconds();
+    for (i32 frame = 0; frame < frames; ++frame)
+    {
+      location[wghtAxis] = held ? axis->maxValue : axis->minValue + (axis->maxValue - axis->minValue) * frame / (frames - 1);
+      SetVariationInstanceLocation(instance, &fontVariations, location);
+      for (i32 i = 0; i < glyphCount; ++i) DecodeCachedGlyphOutline(cache, &glyphData, instance, glyphIds[i], outline);
+    }
+    f64 seconds = GetWallClockSeconds() - start;
+    printf("%-24s %d glyphs, %6.2f us per frame, %5.1f%% cache hits\n", held ? "held weight" : "animated weight", glyphCount,
+           seconds / frames * 1e6, 100.0 * (cache->hits - hits) / ((f64)frames * glyphCount));
+  }
+  printf("cache: %llu hits, %llu misses, %llu rotations\n", (unsigned long long)cache->hits,
+         (unsigned long long)cache->misses, (unsigned long long)cache->rotations);
+  UnloadFont(&font);
+}
+
+// The first glyph of a text, its outline as well, or every table, from a font loaded from memory.
+u32 RunWoffWorkload(Arena *arena, Font *font, i32 workload)
+{
+  u32 result = 0;
+  CodepointMap codepointMap;
+  GlyphData glyphData;
+  if (LoadCodepointMap(arena, font, &codepointMap, CODEPOINT_MAP_BMP_TABLE)) result = GlyphIndexFromCodepoint(&codepointMap, 'A');
+  if (workload == 1 && LoadGlyphData(arena, font, &glyphData))
+  {
+    GlyphOutline *outline = AllocGlyphOutline(arena, &glyphData);
+    if (outline && DecodeGlyphOutline(&glyphData, (u16)result, outline)) result += outline->pointCount;
+  }
+  for (i32 i = 0; workload == 2 && i < font->directory->numTables; ++i)
+  {
+    result += GetTableView(font, font->directory->tableRecords[i].tag.value).length;
+  }
+  return result;
+}
+
+// Loading a WOFF lazily, inflating only the tables the workload reads, against decoding the whole file to
+// an sfnt first. Memory is what the arena grew by, the file itself excluded.
+void BenchmarkWoffDecoding(Arena *arena)
+{
+  size_t fileSize = 0;
+  char *file = ReadWholeFile(arena, BENCHMARK_WOFF_FONT_PATH, &fileSize);
+  if (!file) return;
+  u32 sfntSize = 0;
+  TmpArena tmp;
+  TmpArenaPush(&tmp, arena);
+  u8 *sfnt = DecodeWoffToSfnt(arena, file, fileSize, &sfntSize);
+  TmpArenaPop(&tmp);
+  if (!sfnt) return;
+  printf("%s: %.1f KB, %.1f KB decoded\n", BENCHMARK_WOFF_FONT_PATH, (f64)fileSize / KB, (f64)sfntSize / KB);
+
+  char *workloads[] = { "cmap lookup", "first outline", "all tables" };
+  i32 iterations = 50;
+  for (i32 workload = 0; workload < 3; ++workload)
+  {
+    for (i32 full = 0; full < 2; ++full)
+    {
+      u32 check = 0, inflatedTables = 0;
+      size_t bytes = 0;
+      f64 start = GetWallClockSeconds();
+      for (i32 i = 0; i < iterations; ++i)
+      {
+        TmpArenaPush(&tmp, arena);
+        size_t used = arena->cur;
+        Font font;
+        if (full)
+        {
+          u8 *sfnt = DecodeWoffToSfnt(arena, file, fileSize, &sfntSize);
+          if (sfnt && LoadFontFromMemory(arena, sfnt, sfntSize, &font)) check += RunWoffWorkload(arena, &font, workload);
+        }
+        else if (LoadFontFromMemory(arena, file, fileSize, &font))
+        {
+          check += RunWoffWorkload(arena, &font, workload);
+          inflatedTables = font.woff->inflatedTables;
+        }
+        bytes = arena->cur - used;
+        TmpArenaPop(&tmp);
+      }
+      f64 seconds = (GetWallClockSeconds() - start) / iterations;
+      printf("%-14s %-12s %9.1f us, %8.1f KB", workloads[workload], full ? "decode sfnt" : "lazy woff", seconds * 1e6, (f64)bytes / KB);
+      if (!full) printf(", %d tables inflated", inflatedTables);
+      printf(" (%u)\n", check / iterations);
+    }
+  }
+}
+
+// Every glyph fetched from an OutlineCache large enough to hold the font against decoded from glyf or CFF,
+// then a skewed trace through budgets that force evictions.
+void BenchmarkOutlineCache(Arena *arena)
+{
+  char *fontPaths[] = { BENCHMARK_FONT_PATH, BENCHMARK_CFF_FONT_PATH };
+  for (i32 f = 0; f < 2; ++f)
+  {
+    Font font;
+    GlyphData glyphData;
+    if (!LoadFont(arena, fontPaths[f], &font)) continue;
+    if (!LoadGlyphData(arena, &font, &glyphData))
+    {
+      UnloadFont(&font);
+      continue;
+    }
+    GlyphOutline *outline = AllocGlyphOutline(arena, &glyphData);
+    GlyphOutline *reference = AllocGlyphOutline(arena, &glyphData);
+    OutlineCache *cache = CreateOutlineCache(arena, &glyphData, 16 * MB);
+    if (!cache) return;
+    u16 numGlyphs = glyphData.numGlyphs;
+
+    i32 passes = 20;
+    u64 pointCount = 0, contourCount = 0;
+    f64 start = GetWallClockSeconds();
+    for (i32 pass = 0; pass < passes; ++pass)
+    {
+      for (u16 glyphId = 0; glyphId < numGlyphs; ++glyphId)
+      {
+        DecodeGlyphOutline(&glyphData, glyphId, outline);
+        pointCount += outline->pointCount;
+        contourCount += outline->contourCount;
+      }
+    }
+    f64 decodeSeconds = GetWallClockSeconds() - start;
+
+    // A first fill touches the pages so that the measured one packs into memory that is already mapped.
+    f64 fillSeconds = 0.0;
+    for (i32 warm = 0; warm < 2; ++warm)
+    {
+      TmpArena tmp;
+      TmpArenaPush(&tmp, arena);
+      OutlineCache *fillCache = CreateOutlineCache(arena, &glyphData, 16 * MB);
+      start = GetWallClockSeconds();
+      for (u16 glyphId = 0; glyphId < numGlyphs; ++glyphId) GetCachedGlyphOutline(fillCache, glyphId, outline);
+      fillSeconds = GetWallClockSeconds() - start;
+      TmpArenaPop(&tmp);
+    }
+    for (u16 glyphId = 0; glyphId < numGlyphs; ++glyphId) GetCachedGlyphOutline(cache, glyphId, outline);
+    start = GetWallClockSeconds();
+    for (i32 pass = 0; pass < passes; ++pass)
+    {
+      for (u16 glyphId = 0; glyphId < numGlyphs; ++glyphId) GetCachedGlyphOutline(cache, glyphId, outline);
+    }
+    f64 fetchSeconds = GetWallClockSeconds() - start;
+
+    // Cached outlines must match decoded ones up to the quantization step.
+    i32 mismatches = 0;
+    f32 maxError = 0.0f;
+    for (u16 glyphId = 0; glyphId < numGlyphs; ++glyphId)
+    {
+      i32 decoded = DecodeGlyphOutline(&glyphData, glyphId, reference);
+      if (GetCachedGlyphOutline(cache, glyphId, outline) != decoded || outline->pointCount != reference->pointCount ||
+          outline->contourCount != reference->contourCount || outline->xMin != reference->xMin || outline->yMax != reference->yMax)
+      {
+        ++mismatches;
+        continue;
+      }
+      for (i32 i = 0; i < outline->pointCount; ++i)
+      {
+        f32 errorX = fabsf(outline->x[i] - reference->x[i]), errorY = fabsf(outline->y[i] - reference->y[i]);
+        maxError = errorX > maxError ? errorX : maxError;
+        maxError = errorY > maxError ? errorY : maxError;
+        mismatches += outline->onCurve[i] != reference->onCurve[i];
+      }
+      for (i32 i = 0; i < outline->contourCount; ++i) mismatches += outline->contourEnds[i] != reference->contourEnds[i];
+    }
+
+    u64 recordBytes = 0;
+    for (i32 i = 0; i < cache->pageCount; ++i) recordBytes += cache->pages[i].used;
+    f64 unpackedBytes = (f64)(pointCount * (2 * sizeof(f32) + 1) + contourCount * sizeof(u16)) / passes / numGlyphs;
+    f64 sourceBytes = (f64)(glyphData.compactFont ? GetFontTable(&font, FONT_TABLE_CFF).length + GetFontTable(&font, FONT_TABLE_CFF2).length : glyphData.glyf.length) / numGlyphs;
+    printf("%s: %d glyphs, %.1f points per glyph\n", fontPaths[f], numGlyphs, (f64)pointCount / passes / numGlyphs);
+    printf("  decode %8.1f ns/glyph, cache fill %8.1f ns/glyph, cached fetch %6.1f ns/glyph (%.1fx)\n",
+           decodeSeconds / passes / numGlyphs * 1e9, fillSeconds / numGlyphs * 1e9, fetchSeconds / passes / numGlyphs * 1e9, decodeSeconds / fetchSeconds);
+    printf("  %.1f bytes per cached glyph + %.1f of index, unpacked %.1f, source %.1f; %d mismatches, max error %.4f units\n",
+           (f64)recordBytes / cache->entryCount, (f64)cache->entryCapacity * sizeof(OutlineCacheEntry) / cache->entryCount, unpackedBytes, sourceBytes, mismatches, maxError);
+
+    // Text-like accesses: a few hundred frequent glyphs and a long tail, cubed to skew towards low ids.
+    i32 traceLength = 1 << 20;
+    u16 *trace = (u16 *)AllocNoZero(arena, traceLength * sizeof(u16));
+    u32 random = 0x9E3779B9;
+    for (i32 i = 0; i < traceLength; ++i)
+    {
+      u64 r = RandomU32(&random) % numGlyphs;
+      trace[i] = (u16)(r * r * r / ((u64)numGlyphs * numGlyphs));
+    }
+    u32 budgets[] = { 64 * KB, 256 * KB, 1 * MB };
+    for (i32 b = 0; b < (i32)(sizeof(budgets) / sizeof(budgets[0])); ++b)
+    {
+      TmpArena tmp;
+      TmpArenaPush(&tmp, arena);
+      OutlineCache *tight = CreateOutlineCache(arena, &glyphData, budgets[b]);
+      start = GetWallClockSeconds();
+      for (i32 i = 0; i < traceLength; ++i) GetCachedGlyphOutline(tight, trace[i], outline);
+      f64 seconds = GetWallClockSeconds() - start;
+      printf("  %4u KB budget: hit rate %.2f%%, %llu entries evicted in %llu page evictions, %.1f ns/fetch\n", (u32)(budgets[b] / KB),
+             100.0 * tight->hits / traceLength, (unsigned long long)tight->evictions, (unsigned long long)tight->pageEvictions, seconds / traceLength * 1e9);
+      TmpArenaPop(&tmp);
+    }
+    UnloadFont(&font);
+  }
+}
+
+Benchmark benchmarks[] = {
+  { "load", BenchmarkFontLoading },
+  { "cmap", BenchmarkCodepointLookup },
+  { "batch", BenchmarkBatchLookup },
+  { "byteswap", BenchmarkByteSwap },
+  { "planes", BenchmarkSupplementaryPlanes },
+  { "glyf", BenchmarkOutlineDecoding },
+  { "raster", BenchmarkRasterization },
+  { "atlas", BenchmarkGlyphCache },
+  { "parallel", BenchmarkParallelRasterization },
+  { "sdf", BenchmarkDistanceFields },
+  { "collection", BenchmarkCollectionLoading },
+  { "tables", BenchmarkTableLookup },
+  { "checksum", BenchmarkChecksumVerification },
+  { "hardened", BenchmarkHardenedParsing },
+  { "arena", BenchmarkArenas },
+  { "kerning", BenchmarkKerning },
+  { "layout", BenchmarkTextLayout },
+  { "fontcache", BenchmarkFontCache },
+  { "cff", BenchmarkCompactOutlines },
+  { "profile", BenchmarkProfiling },
+  { "fallback", BenchmarkFallbackResolution },
+  { "subset", BenchmarkSubsetting },
+  { "variations", BenchmarkVariations },
+  { "woff", BenchmarkWoffDecoding },
+  { "outlines", BenchmarkOutlineCache },
+};
+
+i32 RunBenchmarks(Arena *arena, char *filter)
+{
+  i32 ran = 0;
+  for (i32 i = 0; i < (i32)(sizeof(benchmarks) / sizeof(benchmarks[0])); ++i)
+  {
+    Benchmark *benchmark = &benchmarks[i];
+    if (filter && strcmp(filter, benchmark->name) != 0) continue;
+
+    printf("-- Benchmark %s\n", benchmark->name);
+    TmpArena tmp;
+    TmpArenaPush(&tmp, arena);
+    benchmark->run(arena);
+    TmpArenaPop(&tmp);
+    ++ran;
+  }
+
+  if (!ran)
+  {
+    fprintf(stderr, "Unknown benchmark %s\n", filter);
+    return 1;
+  }
+
+  return 0;
+}
@@ -0,0 +1,138 @@
+#define READ_BIG_ENDIAN_U16(p) ((u16)((((u8*)(p))[0] << 8) | (((u8*)(p))[1])))
+#define READ_BIG_ENDIAN_I16(p) ((i16)((((u8*)(p))[0] << 8) | (((u8*)(p))[1])))
+#define READ_BIG_ENDIAN_U32(p) ((u32)(((u32)((u8*)(p))[0] << 24) | (((u8*)(p))[1] << 16) | (((u8*)(p))[2] << 8) | (((u8*)(p))[3])))
+#define PTR_MOVE(p, a) ((p) += (a))
+#define READ_BIG_ENDIAN_U16_MOVE(p) (READ_BIG_ENDIAN_U16((p))); (PTR_MOVE((p), 2))
+#define READ_BIG_ENDIAN_U32_MOVE(p) (READ_BIG_ENDIAN_U32((p))); (PTR_MOVE((p), 4))
+
+// Bulk decoding of big-endian font arrays into native u16/u32 arrays. Source and destination may be
+// unaligned but must not overlap.
+
+void ReadBigEndianU16ArrayScalar(u16 *destination, u8 *source, i32 count)
+{
+  for (i32 i = 0; i < count; ++i)
+  {
+    destination[i] = READ_BIG_ENDIAN_U16(&source[i * 2]);
+  }
+}
+
+void ReadBigEndianU32ArrayScalar(u32 *destination, u8 *source, i32 count)
+{
+  for (i32 i = 0; i < count; ++i)
+  {
+    destination[i] = READ_BIG_ENDIAN_U32(&source[i * 4]);
+  }
+}
+
+#if SIMD_X86
+TARGET_SSSE3 void ReadBigEndianArraySsse3(u8 *destination, u8 *source, i32 byteCount, __m128i shuffle)
+{
+  i32 i = 0;
+  for (; i + 16 <= byteCount; i += 16)
+  {
+    __m128i bytes = _mm_loadu_si128((__m128i *)&source[i]);
+    _mm_storeu_si128((__m128i *)&destination[i], _mm_shuffle_epi8(bytes, shuffle));
+  }
+}
+
+TARGET_AVX2 void ReadBigEndianArrayAvx2(u8 *destination, u8 *source, i32 byteCount, __m256i shuffle)
+{
+  i32 i = 0;
+  for (; i + 64 <= byteCount; i += 64)
+  {
+    __m256i first = _mm256_loadu_si256((__m256i *)&source[i]);
+    __m256i second = _mm256_loadu_si256((__m256i *)&source[i + 32]);
+    _mm256_storeu_si256((__m256i *)&destination[i], _mm256_shuffle_epi8(first, shuffle));
+    _mm256_storeu_si256((__m256i *)&destination[i + 32], _mm256_shuffle_epi8(second, shuffle));
+  }
+  for (; i + 32 <= byteCount; i += 32)
+  {
+    __m256i bytes = _mm256_loadu_si256((__m256i *)&source[i]);
+    _mm256_storeu_si256((__m256i *)&destination[i], _mm256_shuffle_epi8(bytes, shuffle));
+  }
+}
+
+TARGET_SSSE3 void ReadBigEndianU16ArraySsse3(u16 *destination, u8 *source, i32 count)
+{
+  __m128i shuffle = _mm_setr_epi8(1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14);
+  i32 vectorCount = count & ~7;
+  ReadBigEndianArraySsse3((u8 *)destination, source, vectorCount * 2, shuffle);
+  ReadBigEndianU16ArrayScalar(&destination[vectorCount], &source[vectorCount * 2], count - vectorCount);
+}
+
+TARGET_SSSE3 void ReadBigEndianU32ArraySsse3(u32 *destination, u8 *source, i32 count)
+{
+  __m128i shuffle = _mm_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+  i32 vectorCount = count & ~3;
+  ReadBigEndianArraySsse3((u8 *)destination, source, vectorCount * 4, shuffle);
+  ReadBigEndianU32ArrayScalar(&destination[vectorCount], &source[vectorCount * 4], count - vectorCount);
+}
+
+TARGET_AVX2 void ReadBigEndianU16ArrayAvx2(u16 *destination, u8 *source, i32 count)
+{
+  __m256i shuffle = _mm256_setr_epi8(1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14,
+                                     1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14);
+  i32 vectorCount = count & ~15;
+  ReadBigEndianArrayAvx2((u8 *)destination, source, vectorCount * 2, shuffle);
+  ReadBigEndianU16ArrayScalar(&destination[vectorCount], &source[vectorCount * 2], count - vectorCount);
+}
+
+TARGET_AVX2 void ReadBigEndianU32ArrayAvx2(u32 *destination, u8 *source, i32 count)
+{
+  __m256i shuffle = _mm256_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12,
+                                     3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+  i32 vectorCount = count & ~7;
+  ReadBigEndianArrayAvx2((u8 *)destination, source, vectorCount * 4, shuffle);
+  ReadBigEndianU32ArrayScalar(&destination[vectorCount], &source[vectorCount * 4], count - vectorCount);
+}
+#endif
+
+void ReadBigEndianU16Array(u16 *destination, u8 *source, i32 count)
+{
+#if SIMD_X86
+  CpuFeatures *features = GetCpuFeatures();
+  if (features->hasAvx2)
+  {
+    ReadBigEndianU16ArrayAvx2(destination, source, count);
+    return;
+  }
+  if (features->hasSsse3)
+  {
+    ReadBigEndianU16ArraySsse3(destination, source, count);
+    return;
+  }
+#endif
+  ReadBigEndianU16ArrayScalar(destination, source, count);
+}
+
+void ReadBigEndianU32Array(u32 *destination, u8 *source, i32 count)
+{
+#if SIMD_X86
+  CpuFeatures *features = GetCpuFeatures();
+  if (features->hasAvx2)
+  {
+    ReadBigEndianU32ArrayAvx2(destination, source, count);
+    return;
+  }
+  if (features->hasSsse3)
+  {
+    ReadBigEndianU32ArraySsse3(destination, source, count);
+    return;
+  }
+#endif
+  ReadBigEndianU32ArrayScalar(destination, source, count);
+}
+
+void WriteBigEndianU16(u8 *destination, u16 value)
+{
+  destination[0] = (u8)(value >> 8);
+  destination[1] = (u8)value;
+}
+
+void WriteBigEndianU32(u8 *destination, u32 value)
+{
+  destination[0] = (u8)(value >> 24);
+  destination[1] = (u8)(value >> 16);
+  destination[2] = (u8)(value >> 8);
+  destination[3] = (u8)value;
+}
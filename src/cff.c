@@ -0,0 +1,736 @@
+//SPECS: https://adobe-type-tools.github.io/font-tech-notes/pdfs/5176.CFF.pdf
+//SPECS: https://adobe-type-tools.github.io/font-tech-notes/pdfs/5177.Type2.pdf
+//SPECS: https://learn.microsoft.com/en-us/typography/opentype/spec/cff2
+
+// Type 2 charstrings of CFF and CFF2 tables, interpreted into the same GlyphOutline as glyf with cubic
+// control points. Loading only reads the DICTs and locates the INDEX structures, their offsets are read
+// when an object is needed and charstrings are interpreted straight from the font, so nothing is decoded
+// for glyphs that are never drawn. CFF2 variations are not applied yet, blend keeps the default values.
+
+#define CFF_MAX_STACK 48
+#define CFF2_MAX_STACK 513
+#define CFF_MAX_SUBR_DEPTH 10
+#define CFF_MAX_FONT_DICTS 256
+#define CFF_MAX_DICT_OPERANDS 48
+
+typedef enum {
+  CFF_DICT_CHAR_STRINGS = 17,
+  CFF_DICT_PRIVATE = 18, // size and offset.
+  CFF_DICT_SUBRS = 19, // Offset from the start of the private DICT.
+  CFF_DICT_VSINDEX = 22, // CFF2 only.
+  CFF_DICT_BLEND = 23, // CFF2 only.
+  CFF_DICT_VSTORE = 24, // CFF2 only.
+  CFF_DICT_CHARSTRING_TYPE = 0x0C06,
+  CFF_DICT_ROS = 0x0C1E,
+  CFF_DICT_FD_ARRAY = 0x0C24,
+  CFF_DICT_FD_SELECT = 0x0C25,
+} CompactDictOperator; // Two-byte operators are 12 followed by the second byte.
+
+typedef enum {
+  CHARSTRING_HSTEM = 1,
+  CHARSTRING_VSTEM = 3,
+  CHARSTRING_VMOVETO = 4,
+  CHARSTRING_RLINETO = 5,
+  CHARSTRING_HLINETO = 6,
+  CHARSTRING_VLINETO = 7,
+  CHARSTRING_RRCURVETO = 8,
+  CHARSTRING_CALLSUBR = 10,
+  CHARSTRING_RETURN = 11,
+  CHARSTRING_ESCAPE = 12,
+  CHARSTRING_ENDCHAR = 14,
+  CHARSTRING_VSINDEX = 15, // CFF2 only.
+  CHARSTRING_BLEND = 16, // CFF2 only.
+  CHARSTRING_HSTEMHM = 18,
+  CHARSTRING_HINTMASK = 19,
+  CHARSTRING_CNTRMASK = 20,
+  CHARSTRING_RMOVETO = 21,
+  CHARSTRING_HMOVETO = 22,
+  CHARSTRING_VSTEMHM = 23,
+  CHARSTRING_RCURVELINE = 24,
+  CHARSTRING_RLINECURVE = 25,
+  CHARSTRING_VVCURVETO = 26,
+  CHARSTRING_HHCURVETO = 27,
+  CHARSTRING_SHORTINT = 28,
+  CHARSTRING_CALLGSUBR = 29,
+  CHARSTRING_VHCURVETO = 30,
+  CHARSTRING_HVCURVETO = 31,
+  CHARSTRING_FIXED = 255, // 16.16 number.
+} CharStringOperator;
+
+typedef enum {
+  CHARSTRING_HFLEX = 34,
+  CHARSTRING_FLEX = 35,
+  CHARSTRING_HFLEX1 = 36,
+  CHARSTRING_FLEX1 = 37,
+} CharStringEscapeOperator; // The arithmetic and storage operators of the Type 2 spec are not supported.
+
+typedef struct {
+  FontView data; // From the count field to the end of the table.
+  u32 count;
+  u32 offSize; // 1 to 4 bytes per offset.
+  u32 offsetsStart;
+  u32 objectsStart; // Offsets start at 1, this is the byte before the first object.
+  u32 end; // In the table, where the data following the INDEX starts.
+} CompactIndex;
+
+typedef struct {
+  CompactIndex subrs; // Local subroutines, empty when the private DICT has none.
+  i32 subrBias;
+  u16 vsindex; // CFF2 default ItemVariationData for blend.
+} CompactFontDict;
+
+// Referenced from GlyphData, see glyf.c.
+struct CompactFont {
+  FontView table;
+  i32 isCff2;
+  u32 glyphCount; // Number of charstrings.
+  CompactIndex charStrings;
+  CompactIndex globalSubrs;
+  i32 globalSubrBias;
+  i32 fontDictCount; // At least 1, CID-keyed CFF and CFF2 fonts pick one per glyph through FDSelect.
+  CompactFontDict *fontDicts;
+  FontView fdSelect;
+  u16 variationDataCount;
+  u16 *regionCounts; // CFF2: regions of each ItemVariationData, blend skips that many deltas per value.
+};
+
+typedef struct {
+  CompactFont *compactFont;
+  CompactFontDict *fontDict;
+  GlyphOutline *outline;
+  i32 maxStack;
+  i32 count;
+  f32 stack[CFF2_MAX_STACK];
+  f32 x;
+  f32 y;
+  i32 stemCount;
+  i32 maskSize; // Bytes following hintmask and cntrmask, set by the first one.
+  i32 widthParsed; // CFF only: the first stack-clearing operator may take the advance width first.
+  i32 contourStart; // First point of the open contour, -1 when none is open.
+  u16 vsindex;
+} CharStringState;
+
+u32 ReadCompactOffset(CompactIndex *index, u32 i)
+{
+  u8 *offset = index->data.data + index->offsetsStart + i * index->offSize;
+  u32 value = 0;
+  for (u32 b = 0; b < index->offSize; ++b)
+  {
+    value = value << 8 | offset[b];
+  }
+  return value;
+}
+
+// offset is from the start of table. CFF2 INDEX counts are 32 bits, CFF ones 16. Returns 0 when the INDEX
+// does not fit in the table.
+i32 ReadCompactIndex(FontView table, u32 offset, i32 isCff2, CompactIndex *index)
+{
+  memset(index, 0, sizeof(CompactIndex));
+  if (offset > table.length) return 0;
+  FontView view = FontSubView(table, offset, table.length - offset);
+  u32 countSize = isCff2 ? 4 : 2;
+  if (view.length < countSize) return 0;
+
+  index->count = isCff2 ? ViewU32(view, 0) : ViewU16(view, 0);
+  index->end = offset + countSize;
+  if (!index->count) return 1;
+
+  index->offSize = ViewU8(view, countSize);
+  index->offsetsStart = countSize + 1;
+  if (index->offSize < 1 || index->offSize > 4 ||
+      ((u64)index->count + 1) * index->offSize > (u64)view.length - index->offsetsStart)
+  {
+    index->count = 0;
+    return 0;
+  }
+
+  index->data = view;
+  index->objectsStart = index->offsetsStart + (index->count + 1) * index->offSize - 1;
+  u32 last = ReadCompactOffset(index, index->count);
+  if (last < 1 || (u64)index->objectsStart + last > view.length)
+  {
+    index->count = 0;
+    return 0;
+  }
+  index->end = offset + index->objectsStart + last;
+  return 1;
+}
+
+// Empty view for objects past the count or with offsets out of order.
+FontView GetCompactIndexObject(CompactIndex *index, u32 i)
+{
+  FontView object = {0};
+  if (i >= index->count) return object;
+  u32 start = ReadCompactOffset(index, i);
+  u32 end = ReadCompactOffset(index, i + 1);
+  if (start < 1 || end < start) return object;
+  return FontSubView(index->data, index->objectsStart + start, end - start);
+}
+
+i32 GetSubrBias(u32 count)
+{
+  return count < 1240 ? 107 : (count < 33900 ? 1131 : 32768);
+}
+
+// Integer operands of the first occurrence of op in a DICT, real operands read as 0. Returns 0 when op is
+// missing or has fewer than operandCount operands, the last operandCount ones are returned.
+i32 FindCompactDictOperator(FontView dict, u16 op, i32 *operands, i32 operandCount)
+{
+  i32 stack[CFF_MAX_DICT_OPERANDS];
+  i32 count = 0;
+  FontCursor cursor = MakeFontCursor(dict, 0);
+  while (CursorRemaining(&cursor))
+  {
+    u8 b0 = *cursor.at;
+    CursorSkip(&cursor, 1);
+    i32 value = 0;
+    if (b0 >= 32 && b0 <= 246)
+    {
+      value = b0 - 139;
+    }
+    else if (b0 >= 247 && b0 <= 254)
+    {
+      if (!CursorReserve(&cursor, 1)) return 0;
+      i32 magnitude = (b0 & 3) * 256 + *cursor.at + 108;
+      CursorSkip(&cursor, 1);
+      value = b0 < 251 ? magnitude : -magnitude;
+    }
+    else if (b0 == 28)
+    {
+      if (!CursorReserve(&cursor, 2)) return 0;
+      value = (i16)CursorU16(&cursor);
+    }
+    else if (b0 == 29)
+    {
+      if (!CursorReserve(&cursor, 4)) return 0;
+      value = (i32)CursorU32(&cursor);
+    }
+    else if (b0 == 30)
+    {
+      // Reals are nibbles ending with 0xF.
+      while (CursorRemaining(&cursor))
+      {
+        u8 nibbles = *cursor.at;
+        CursorSkip(&cursor, 1);
+        if ((nibbles & 0x0F) == 0x0F || (nibbles & 0xF0) == 0xF0) break;
+      }
+    }
+    else
+    {
+      u16 dictOp = b0;
+      if (b0 == 12)
+      {
+        if (!CursorReserve(&cursor, 1)) return 0;
+        dictOp = 0x0C00 | *cursor.at;
+        CursorSkip(&cursor, 1);
+      }
+
+      if (dictOp == op)
+      {
+        if (count < operandCount) return 0;
+        memcpy(operands, &stack[count - operandCount], operandCount * sizeof(i32));
+        return 1;
+      }
+
+      // CFF2 blend leaves the default values on the stack, followed by the deltas and the value count.
+      if (dictOp == CFF_DICT_BLEND && count > 0)
+      {
+        i32 valueCount = stack[count - 1];
+        if (valueCount > 0 && valueCount < count) count = valueCount;
+        else count = 0;
+        continue;
+      }
+      count = 0;
+      continue;
+    }
+
+    if (count == CFF_MAX_DICT_OPERANDS) return 0;
+    stack[count++] = value;
+  }
+  return 0;
+}
+
+// Reads the private DICT referenced by dict for its local subroutines.
+void LoadCompactFontDict(CompactFont *compactFont, FontView dict, CompactFontDict *fontDict)
+{
+  memset(fontDict, 0, sizeof(CompactFontDict));
+  fontDict->subrBias = GetSubrBias(0);
+
+  i32 privateDict[2];
+  if (!FindCompactDictOperator(dict, CFF_DICT_PRIVATE, privateDict, 2) || privateDict[0] < 0 || privateDict[1] < 0) return;
+  FontView privateView = FontSubView(compactFont->table, (u32)privateDict[1], (u32)privateDict[0]);
+
+  i32 value;
+  if (FindCompactDictOperator(privateView, CFF_DICT_SUBRS, &value, 1) && value > 0 && privateView.length)
+  {
+    ReadCompactIndex(compactFont->table, (u32)privateDict[1] + (u32)value, compactFont->isCff2, &fontDict->subrs);
+    fontDict->subrBias = GetSubrBias(fontDict->subrs.count);
+  }
+  if (compactFont->isCff2 && FindCompactDictOperator(privateView, CFF_DICT_VSINDEX, &value, 1) && value >= 0)
+  {
+    fontDict->vsindex = (u16)value;
+  }
+}
+
+// CFF2 item variation store, only the region count of each ItemVariationData is needed to skip deltas.
+void LoadCompactVariationStore(Arena *arena, CompactFont *compactFont, u32 offset)
+{
+  // The store is preceded by its u16 length.
+  FontView store = FontSubView(compactFont->table, offset + 2, ViewU16(compactFont->table, offset));
+  if (ViewU16(store, 0) != 1) return;
+
+  u16 dataCount = ViewU16(store, 6);
+  if (store.length < 8 + dataCount * 4u) return;
+  compactFont->regionCounts = (u16 *)Alloc(arena, (dataCount + 1) * sizeof(u16));
+  compactFont->variationDataCount = dataCount;
+  for (u16 i = 0; i < dataCount; ++i)
+  {
+    compactFont->regionCounts[i] = ViewU16(store, ViewU32(store, 8 + i * 4) + 4);
+  }
+}
+
+// Font DICTs, one per glyph group for CID-keyed fonts and CFF2, or the top DICT itself.
+i32 LoadCompactFontDicts(Arena *arena, CompactFont *compactFont, FontView topDict)
+{
+  i32 fdArray;
+  if (!FindCompactDictOperator(topDict, CFF_DICT_FD_ARRAY, &fdArray, 1))
+  {
+    if (compactFont->isCff2) return 0;
+    compactFont->fontDictCount = 1;
+    compactFont->fontDicts = (CompactFontDict *)Alloc(arena, sizeof(CompactFontDict));
+    LoadCompactFontDict(compactFont, topDict, &compactFont->fontDicts[0]);
+    return 1;
+  }
+
+  CompactIndex fontDictIndex;
+  if (fdArray < 0 || !ReadCompactIndex(compactFont->table, (u32)fdArray, compactFont->isCff2, &fontDictIndex) ||
+      fontDictIndex.count < 1 || fontDictIndex.count > CFF_MAX_FONT_DICTS)
+  {
+    return 0;
+  }
+
+  compactFont->fontDictCount = (i32)fontDictIndex.count;
+  compactFont->fontDicts = (CompactFontDict *)Alloc(arena, fontDictIndex.count * sizeof(CompactFontDict));
+  for (u32 i = 0; i < fontDictIndex.count; ++i)
+  {
+    LoadCompactFontDict(compactFont, GetCompactIndexObject(&fontDictIndex, i), &compactFont->fontDicts[i]);
+  }
+
+  i32 fdSelect;
+  if (compactFont->fontDictCount > 1 && FindCompactDictOperator(topDict, CFF_DICT_FD_SELECT, &fdSelect, 1) && fdSelect > 0)
+  {
+    compactFont->fdSelect = FontSubView(compactFont->table, (u32)fdSelect, compactFont->table.length - (u32)fdSelect);
+  }
+  return 1;
+}
+
+// Returns NULL when the font has no CFF or CFF2 table or when its structures are invalid.
+CompactFont *LoadCompactFont(Arena *arena, Font *font)
+{
+  FontView table = GetFontTable(font, FONT_TABLE_CFF2);
+  i32 isCff2 = table.length > 0;
+  if (!isCff2) table = GetFontTable(font, FONT_TABLE_CFF);
+  if (table.length < 4 || ViewU8(table, 0) != (isCff2 ? 2 : 1)) return NULL;
+
+  CompactFont *compactFont = (CompactFont *)Alloc(arena, sizeof(CompactFont));
+  compactFont->table = table;
+  compactFont->isCff2 = isCff2;
+
+  // CFF: header, then the name, top DICT and string INDEXes. CFF2: header, then the top DICT itself.
+  u8 headerSize = ViewU8(table, 2);
+  FontView topDict;
+  u32 globalSubrsOffset;
+  if (isCff2)
+  {
+    u16 topDictLength = ViewU16(table, 3);
+    topDict = FontSubView(table, headerSize, topDictLength);
+    globalSubrsOffset = headerSize + topDictLength;
+  }
+  else
+  {
+    CompactIndex names, topDicts, strings;
+    if (!ReadCompactIndex(table, headerSize, 0, &names) || !ReadCompactIndex(table, names.end, 0, &topDicts) ||
+        !ReadCompactIndex(table, topDicts.end, 0, &strings))
+    {
+      return NULL;
+    }
+    topDict = GetCompactIndexObject(&topDicts, 0);
+    globalSubrsOffset = strings.end;
+  }
+
+  i32 value;
+  if (!topDict.length || !ReadCompactIndex(table, globalSubrsOffset, isCff2, &compactFont->globalSubrs) ||
+      (FindCompactDictOperator(topDict, CFF_DICT_CHARSTRING_TYPE, &value, 1) && value != 2) ||
+      !FindCompactDictOperator(topDict, CFF_DICT_CHAR_STRINGS, &value, 1) || value <= 0 ||
+      !ReadCompactIndex(table, (u32)value, isCff2, &compactFont->charStrings) || !compactFont->charStrings.count)
+  {
+    fprintf(stderr, "Invalid %s table\n", isCff2 ? "CFF2" : "CFF");
+    return NULL;
+  }
+  compactFont->glyphCount = compactFont->charStrings.count;
+  compactFont->globalSubrBias = GetSubrBias(compactFont->globalSubrs.count);
+
+  if (!LoadCompactFontDicts(arena, compactFont, topDict))
+  {
+    fprintf(stderr, "Invalid font DICTs in %s table\n", isCff2 ? "CFF2" : "CFF");
+    return NULL;
+  }
+  if (isCff2 && FindCompactDictOperator(topDict, CFF_DICT_VSTORE, &value, 1) && value > 0)
+  {
+    LoadCompactVariationStore(arena, compactFont, (u32)value);
+  }
+  return compactFont;
+}
+
+// Formats 0 and 3, and 4 in CFF2. Glyphs outside of every range use the first font DICT.
+CompactFontDict *GetGlyphFontDict(CompactFont *compactFont, u16 glyphId)
+{
+  FontView fdSelect = compactFont->fdSelect;
+  u32 fontDict = 0;
+  switch (ViewU8(fdSelect, 0))
+  {
+    case 0: {
+      fontDict = ViewU8(fdSelect, 1 + glyphId);
+    } break;
+
+    case 3: case 4: {
+      // Ranges sorted by first glyph, with a sentinel holding the glyph count.
+      i32 wide = ViewU8(fdSelect, 0) == 4;
+      u32 rangeSize = wide ? 6 : 3;
+      u32 rangeCount = wide ? ViewU32(fdSelect, 1) : ViewU16(fdSelect, 1);
+      u32 rangesStart = wide ? 5 : 3;
+      if (!FontViewContains(fdSelect, rangesStart, (rangeCount + 1) * rangeSize) || !rangeCount) break;
+
+      u32 low = 0, high = rangeCount;
+      while (high - low > 1)
+      {
+        u32 middle = (low + high) / 2;
+        u32 first = wide ? ViewU32(fdSelect, rangesStart + middle * rangeSize) : ViewU16(fdSelect, rangesStart + middle * rangeSize);
+        if (first <= glyphId) low = middle;
+        else high = middle;
+      }
+      u32 record = rangesStart + low * rangeSize;
+      fontDict = wide ? ViewU16(fdSelect, record + 4) : ViewU8(fdSelect, record + 2);
+    } break;
+  }
+  return &compactFont->fontDicts[fontDict < (u32)compactFont->fontDictCount ? fontDict : 0];
+}
+
+// The contour ends at the last point and closes back to its first one, an end point on top of the first
+// is dropped, and a contour that is only a moveto is removed.
+i32 CloseCharStringContour(CharStringState *state)
+{
+  GlyphOutline *outline = state->outline;
+  i32 start = state->contourStart;
+  if (start < 0) return 1;
+  state->contourStart = -1;
+
+  i32 end = outline->pointCount - 1;
+  if (end > start && outline->x[end] == outline->x[start] && outline->y[end] == outline->y[start]) --end;
+  outline->pointCount = end + 1;
+  if (end == start)
+  {
+    outline->pointCount = start;
+    return 1;
+  }
+
+  if (outline->contourCount >= outline->contourCapacity) return 0;
+  outline->contourEnds[outline->contourCount++] = (u16)end;
+  return 1;
+}
+
+i32 AddCharStringPoint(CharStringState *state, f32 dx, f32 dy, u8 pointType)
+{
+  GlyphOutline *outline = state->outline;
+  if (outline->pointCount >= outline->pointCapacity) return 0;
+  state->x += dx;
+  state->y += dy;
+  i32 point = outline->pointCount++;
+  outline->x[point] = state->x;
+  outline->y[point] = state->y;
+  outline->onCurve[point] = pointType;
+  return 1;
+}
+
+i32 CharStringMoveTo(CharStringState *state, f32 dx, f32 dy)
+{
+  if (!CloseCharStringContour(state)) return 0;
+  state->contourStart = state->outline->pointCount;
+  return AddCharStringPoint(state, dx, dy, OUTLINE_ON_CURVE);
+}
+
+// Drawing without a moveto starts a contour at the current point.
+i32 CharStringLineTo(CharStringState *state, f32 dx, f32 dy)
+{
+  if (state->contourStart < 0 && !CharStringMoveTo(state, 0, 0)) return 0;
+  return AddCharStringPoint(state, dx, dy, OUTLINE_ON_CURVE);
+}
+
+i32 CharStringCurveTo(CharStringState *state, f32 dx1, f32 dy1, f32 dx2, f32 dy2, f32 dx3, f32 dy3)
+{
+  if (state->contourStart < 0 && !CharStringMoveTo(state, 0, 0)) return 0;
+  return AddCharStringPoint(state, dx1, dy1, OUTLINE_CUBIC_CONTROL) &&
+         AddCharStringPoint(state, dx2, dy2, OUTLINE_CUBIC_CONTROL) &&
+         AddCharStringPoint(state, dx3, dy3, OUTLINE_ON_CURVE);
+}
+
+// Index of the first argument of a stack-clearing operator: 1 when the advance width comes first.
+i32 TakeCharStringWidth(CharStringState *state, i32 hasWidth)
+{
+  i32 first = !state->widthParsed && !state->compactFont->isCff2 && hasWidth;
+  state->widthParsed = 1;
+  return first;
+}
+
+// Returns 1 at the end of a subroutine, 2 at endchar and 0 for malformed charstrings.
+i32 RunCharString(CharStringState *state, FontView charString, i32 depth)
+{
+  if (depth > CFF_MAX_SUBR_DEPTH) return 0;
+
+  CompactFont *compactFont = state->compactFont;
+  f32 *s = state->stack;
+  u8 *at = charString.data;
+  u8 *end = at + charString.length;
+  while (at < end)
+  {
+    u8 b0 = *at++;
+    if (b0 >= 32 || b0 == CHARSTRING_SHORTINT)
+    {
+      if (state->count >= state->maxStack) return 0;
+      if (b0 <= 246 && b0 != CHARSTRING_SHORTINT)
+      {
+        s[state->count++] = (f32)(b0 - 139);
+      }
+      else if (b0 <= 254 && b0 != CHARSTRING_SHORTINT)
+      {
+        if (at >= end) return 0;
+        i32 magnitude = (b0 - 247) % 4 * 256 + *at++ + 108;
+        s[state->count++] = (f32)(b0 < 251 ? magnitude : -magnitude);
+      }
+      else if (b0 == CHARSTRING_SHORTINT)
+      {
+        if (end - at < 2) return 0;
+        s[state->count++] = (f32)READ_BIG_ENDIAN_I16(at);
+        at += 2;
+      }
+      else
+      {
+        if (end - at < 4) return 0;
+        s[state->count++] = (f32)(i32)READ_BIG_ENDIAN_U32(at) / 65536.0f;
+        at += 4;
+      }
+      continue;
+    }
+
+    i32 count = state->count;
+    i32 i = 0;
+    switch (b0)
+    {
+      case CHARSTRING_HSTEM: case CHARSTRING_VSTEM: case CHARSTRING_HSTEMHM: case CHARSTRING_VSTEMHM: {
+        i = TakeCharStringWidth(state, count % 2);
+        state->stemCount += (count - i) / 2;
+      } break;
+
+      case CHARSTRING_HINTMASK: case CHARSTRING_CNTRMASK: {
+        // Arguments before the first mask are vstems, the mask has a bit per stem. Later masks leave the
+        // stack alone, as other interpreters do.
+        if (!state->maskSize)
+        {
+          i = TakeCharStringWidth(state, count % 2);
+          state->stemCount += (count - i) / 2;
+          state->maskSize = (state->stemCount + 7) / 8;
+          state->count = 0;
+        }
+        if (end - at < state->maskSize) return 0;
+        at += state->maskSize;
+      } continue;
+
+      case CHARSTRING_RMOVETO: {
+        i = TakeCharStringWidth(state, count > 2);
+        if (count - i < 2 || !CharStringMoveTo(state, s[i], s[i + 1])) return 0;
+      } break;
+
+      case CHARSTRING_HMOVETO: case CHARSTRING_VMOVETO: {
+        i = TakeCharStringWidth(state, count > 1);
+        if (count - i < 1) return 0;
+        if (!(b0 == CHARSTRING_HMOVETO ? CharStringMoveTo(state, s[i], 0) : CharStringMoveTo(state, 0, s[i]))) return 0;
+      } break;
+
+      case CHARSTRING_RLINETO: {
+        for (; i + 2 <= count; i += 2)
+        {
+          if (!CharStringLineTo(state, s[i], s[i + 1])) return 0;
+        }
+      } break;
+
+      case CHARSTRING_HLINETO: case CHARSTRING_VLINETO: {
+        i32 horizontal = b0 == CHARSTRING_HLINETO;
+        for (; i < count; ++i, horizontal = !horizontal)
+        {
+          if (!(horizontal ? CharStringLineTo(state, s[i], 0) : CharStringLineTo(state, 0, s[i]))) return 0;
+        }
+      } break;
+
+      case CHARSTRING_RRCURVETO: case CHARSTRING_RCURVELINE: case CHARSTRING_RLINECURVE: {
+        // rcurveline ends with a line, rlinecurve starts with lines and ends with a curve.
+        i32 curveEnd = b0 == CHARSTRING_RCURVELINE ? count - 2 : count;
+        if (b0 == CHARSTRING_RLINECURVE)
+        {
+          for (; i + 8 <= count; i += 2)
+          {
+            if (!CharStringLineTo(state, s[i], s[i + 1])) return 0;
+          }
+        }
+        for (; i + 6 <= curveEnd; i += 6)
+        {
+          if (!CharStringCurveTo(state, s[i], s[i + 1], s[i + 2], s[i + 3], s[i + 4], s[i + 5])) return 0;
+        }
+        if (b0 == CHARSTRING_RCURVELINE && (i + 2 > count || !CharStringLineTo(state, s[i], s[i + 1]))) return 0;
+      } break;
+
+      case CHARSTRING_VVCURVETO: case CHARSTRING_HHCURVETO: {
+        // An odd count starts with the delta across the direction of the first curve.
+        f32 across = 0;
+        if (count % 2) across = s[i++];
+        for (; i + 4 <= count; i += 4, across = 0)
+        {
+          i32 success = b0 == CHARSTRING_VVCURVETO ?
+            CharStringCurveTo(state, across, s[i], s[i + 1], s[i + 2], 0, s[i + 3]) :
+            CharStringCurveTo(state, s[i], across, s[i + 1], s[i + 2], s[i + 3], 0);
+          if (!success) return 0;
+        }
+      } break;
+
+      case CHARSTRING_VHCURVETO: case CHARSTRING_HVCURVETO: {
+        // Curves alternate between starting horizontal and vertical, the last one may end on a diagonal.
+        i32 horizontal = b0 == CHARSTRING_HVCURVETO;
+        for (; i + 4 <= count; i += 4, horizontal = !horizontal)
+        {
+          f32 last = count - i == 5 ? s[i + 4] : 0;
+          i32 success = horizontal ?
+            CharStringCurveTo(state, s[i], 0, s[i + 1], s[i + 2], last, s[i + 3]) :
+            CharStringCurveTo(state, 0, s[i], s[i + 1], s[i + 2], s[i + 3], last);
+          if (!success) return 0;
+        }
+      } break;
+
+      case CHARSTRING_CALLSUBR: case CHARSTRING_CALLGSUBR: {
+        if (!count) return 0;
+        i32 local = b0 == CHARSTRING_CALLSUBR;
+        CompactIndex *subrs = local ? &state->fontDict->subrs : &compactFont->globalSubrs;
+        i32 subr = (i32)s[--state->count] + (local ? state->fontDict->subrBias : compactFont->globalSubrBias);
+        if (subr < 0 || (u32)subr >= subrs->count) return 0;
+        i32 result = RunCharString(state, GetCompactIndexObject(subrs, (u32)subr), depth + 1);
+        if (result != 1) return result;
+      } continue; // The subroutine leaves its arguments on the stack.
+
+      case CHARSTRING_RETURN: {
+        if (compactFont->isCff2) return 0;
+      } return 1;
+
+      case CHARSTRING_ENDCHAR: {
+        // Four more arguments are the seac accent composition, not supported.
+        if (compactFont->isCff2) return 0;
+        TakeCharStringWidth(state, count == 1 || count == 5);
+      } return 2;
+
+      case CHARSTRING_VSINDEX: {
+        if (!compactFont->isCff2 || !count) return 0;
+        state->vsindex = (u16)s[count - 1];
+      } break;
+
+      case CHARSTRING_BLEND: {
+        // Keeps the default values, the deltas of every region follow them on the stack.
+        if (!compactFont->isCff2 || !count) return 0;
+        i32 valueCount = (i32)s[count - 1];
+        i32 regionCount = state->vsindex < compactFont->variationDataCount ? compactFont->regionCounts[state->vsindex] : 0;
+        i32 first = count - 1 - valueCount * (regionCount + 1);
+        if (valueCount < 0 || first < 0) return 0;
+        state->count = first + valueCount;
+      } continue;
+
+      case CHARSTRING_ESCAPE: {
+        if (at >= end) return 0;
+        u8 b1 = *at++;
+        switch (b1)
+        {
+          case CHARSTRING_FLEX: {
+            if (count < 13 ||
+                !CharStringCurveTo(state, s[0], s[1], s[2], s[3], s[4], s[5]) ||
+                !CharStringCurveTo(state, s[6], s[7], s[8], s[9], s[10], s[11]))
+            {
+              return 0;
+            }
+          } break;
+
+          case CHARSTRING_HFLEX: {
+            if (count < 7 ||
+                !CharStringCurveTo(state, s[0], 0, s[1], s[2], s[3], 0) ||
+                !CharStringCurveTo(state, s[4], 0, s[5], -s[2], s[6], 0))
+            {
+              return 0;
+            }
+          } break;
+
+          case CHARSTRING_HFLEX1: {
+            if (count < 9 ||
+                !CharStringCurveTo(state, s[0], s[1], s[2], s[3], s[4], 0) ||
+                !CharStringCurveTo(state, s[5], 0, s[6], s[7], s[8], -(s[1] + s[3] + s[7])))
+            {
+              return 0;
+            }
+          } break;
+
+          case CHARSTRING_FLEX1: {
+            // The last delta moves along the dominant direction, the curve ends level with its start.
+            if (count < 11) return 0;
+            f32 dx = s[0] + s[2] + s[4] + s[6] + s[8];
+            f32 dy = s[1] + s[3] + s[5] + s[7] + s[9];
+            i32 horizontal = fabsf(dx) > fabsf(dy);
+            if (!CharStringCurveTo(state, s[0], s[1], s[2], s[3], s[4], s[5]) ||
+                !CharStringCurveTo(state, s[6], s[7], s[8], s[9], horizontal ? s[10] : -dx, horizontal ? -dy : s[10]))
+            {
+              return 0;
+            }
+          } break;
+
+          default: return 0;
+        }
+      } break;
+
+      default: return 0;
+    }
+    state->count = 0;
+  }
+
+  // CFF2 charstrings and subroutines end with their data, CFF ones with return or endchar.
+  return 1;
+}
+
+// Appends the outline of glyphId and sets the bounds from its points, control points included. Contours keep
+// the charstring direction, counter-clockwise outside unlike glyf: the rasterizer fills by the nonzero rule and
+// distance fields orient themselves from the signed area.
+i32 AppendCompactGlyph(CompactFont *compactFont, u16 glyphId, GlyphOutline *outline)
+{
+  if (glyphId >= compactFont->glyphCount) return 0;
+  FontView charString = GetCompactIndexObject(&compactFont->charStrings, glyphId);
+  if (!charString.length) return 1;
+
+  CharStringState state;
+  state.compactFont = compactFont;
+  state.fontDict = GetGlyphFontDict(compactFont, glyphId);
+  state.outline = outline;
+  state.maxStack = compactFont->isCff2 ? CFF2_MAX_STACK : CFF_MAX_STACK;
+  state.count = 0;
+  state.x = state.y = 0;
+  state.stemCount = 0;
+  state.maskSize = 0;
+  state.widthParsed = 0;
+  state.contourStart = -1;
+  state.vsindex = state.fontDict->vsindex;
+
+  i32 firstPoint = outline->pointCount;
+  if (!RunCharString(&state, charString, 0) || !CloseCharStringContour(&state)) return 0;
+  SetOutlineBounds(outline, firstPoint);
+  return 1;
+}
@@ -0,0 +1,301 @@
+//SPECS: https://learn.microsoft.com/en-us/typography/opentype/spec/otff#calculating-checksums
+
+// Opt-in integrity check for untrusted fonts. A checksum is the wrapping sum of the big-endian u32 words
+// of a range, zero-padded to a multiple of 4. Sums of word-aligned pieces add up, so tables are cut in
+// chunks that workers sum independently, and when the tables tile the file the whole-font sum needed for
+// head.checksumAdjustment is rebuilt from the table sums and the gaps between them instead of a second pass.
+
+#define CHECKSUM_CHUNK_SIZE (256 * 1024) // Multiple of 4, pieces stay aligned to the start of their range.
+#define CHECKSUM_PARALLEL_THRESHOLD (4 * 1024 * 1024) // Below this the workers cost more than they save.
+#define CHECKSUM_MAGIC 0xB1B0AFBA
+
+typedef struct {
+  u32 begin;
+  u32 end;
+  u32 origin; // Words are aligned to this offset, the start of the table or 0 for the file.
+  i32 table; // Index in the directory, -1 for ranges only part of the whole-font sum.
+  u32 sum;
+} ChecksumPiece;
+
+typedef struct {
+  FontView view;
+  ChecksumPiece *pieces;
+} ChecksumWork;
+
+typedef struct {
+  i32 tableCount;
+  i32 failedTables;
+  u32 *computedChecksums; // One per table record.
+  i32 adjustmentChecked; // 0 for collection faces and fonts without head, the adjustment covers a single font file.
+  u32 storedAdjustment;
+  u32 computedAdjustment;
+} FontChecksumReport;
+
+u32 SumBigEndianU32Scalar(u8 *data, i32 count)
+{
+  u32 sum = 0;
+  for (i32 i = 0; i < count; ++i)
+  {
+    sum += READ_BIG_ENDIAN_U32(&data[i * 4]);
+  }
+  return sum;
+}
+
+#if SIMD_X86
+TARGET_SSSE3 u32 SumBigEndianU32Ssse3(u8 *data, i32 count)
+{
+  __m128i shuffle = _mm_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+  __m128i first = _mm_setzero_si128();
+  __m128i second = _mm_setzero_si128();
+  i32 i = 0;
+  for (; i + 8 <= count; i += 8)
+  {
+    first = _mm_add_epi32(first, _mm_shuffle_epi8(_mm_loadu_si128((__m128i *)&data[i * 4]), shuffle));
+    second = _mm_add_epi32(second, _mm_shuffle_epi8(_mm_loadu_si128((__m128i *)&data[i * 4 + 16]), shuffle));
+  }
+  __m128i sum = _mm_add_epi32(first, second);
+  sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(1, 0, 3, 2)));
+  sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(2, 3, 0, 1)));
+  return (u32)_mm_cvtsi128_si32(sum) + SumBigEndianU32Scalar(&data[i * 4], count - i);
+}
+
+TARGET_AVX2 u32 SumBigEndianU32Avx2(u8 *data, i32 count)
+{
+  __m256i shuffle = _mm256_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12,
+                                     3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+  // Four independent accumulators hide the latency of the adds.
+  __m256i sums[4] = { _mm256_setzero_si256(), _mm256_setzero_si256(), _mm256_setzero_si256(), _mm256_setzero_si256() };
+  i32 i = 0;
+  for (; i + 32 <= count; i += 32)
+  {
+    for (i32 j = 0; j < 4; ++j)
+    {
+      __m256i words = _mm256_loadu_si256((__m256i *)&data[i * 4 + j * 32]);
+      sums[j] = _mm256_add_epi32(sums[j], _mm256_shuffle_epi8(words, shuffle));
+    }
+  }
+  for (; i + 8 <= count; i += 8)
+  {
+    sums[0] = _mm256_add_epi32(sums[0], _mm256_shuffle_epi8(_mm256_loadu_si256((__m256i *)&data[i * 4]), shuffle));
+  }
+
+  __m256i wide = _mm256_add_epi32(_mm256_add_epi32(sums[0], sums[1]), _mm256_add_epi32(sums[2], sums[3]));
+  __m128i sum = _mm_add_epi32(_mm256_castsi256_si128(wide), _mm256_extracti128_si256(wide, 1));
+  sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(1, 0, 3, 2)));
+  sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(2, 3, 0, 1)));
+  return (u32)_mm_cvtsi128_si32(sum) + SumBigEndianU32Scalar(&data[i * 4], count - i);
+}
+#endif
+
+u32 SumBigEndianU32(u8 *data, i32 count)
+{
+#if SIMD_X86
+  CpuFeatures *features = GetCpuFeatures();
+  if (features->hasAvx2) return SumBigEndianU32Avx2(data, count);
+  if (features->hasSsse3) return SumBigEndianU32Ssse3(data, count);
+#endif
+  return SumBigEndianU32Scalar(data, count);
+}
+
+// Sum of the bytes in [begin, end) with words aligned to origin, bytes outside of the range count as 0.
+u32 ChecksumRange(FontView view, u32 begin, u32 end, u32 origin)
+{
+  if (end > view.length) end = view.length;
+  if (begin >= end) return 0;
+
+  u32 sum = 0;
+  u32 wordStart = begin - ((begin - origin) & 3);
+  if (wordStart != begin)
+  {
+    for (u32 i = begin; i < end && i < wordStart + 4; ++i) sum += (u32)view.data[i] << (24 - 8 * (i - wordStart));
+    begin = wordStart + 4;
+    if (begin >= end) return sum;
+  }
+
+  u32 wordCount = (end - begin) / 4;
+  sum += SumBigEndianU32(&view.data[begin], (i32)wordCount);
+  u32 tailStart = begin + wordCount * 4;
+  for (u32 i = tailStart; i < end; ++i) sum += (u32)view.data[i] << (24 - 8 * (i - tailStart));
+  return sum;
+}
+
+// The checksum of a single table, as stored in its record.
+u32 ComputeTableChecksum(FontView table)
+{
+  return ChecksumRange(table, 0, table.length, 0);
+}
+
+void SumChecksumPieces(JobWorker *worker, void *data, i32 begin, i32 end)
+{
+  (void)worker;
+  ChecksumWork *work = (ChecksumWork *)data;
+  for (i32 i = begin; i < end; ++i)
+  {
+    ChecksumPiece *piece = &work->pieces[i];
+    piece->sum = ChecksumRange(work->view, piece->begin, piece->end, piece->origin);
+  }
+}
+
+i32 AddChecksumPieces(ChecksumPiece *pieces, i32 pieceCount, u32 begin, u32 end, u32 origin, i32 table)
+{
+  for (u32 offset = begin; offset < end; offset += CHECKSUM_CHUNK_SIZE)
+  {
+    ChecksumPiece *piece = &pieces[pieceCount++];
+    piece->begin = offset;
+    piece->end = end - offset > CHECKSUM_CHUNK_SIZE ? offset + CHECKSUM_CHUNK_SIZE : end;
+    piece->origin = origin;
+    piece->table = table;
+  }
+  return pieceCount;
+}
+
+// WOFF tables are checked once inflated. The sfnt they decode to has no gaps between its padded tables, so
+// its sum is the one of its directory plus the table sums.
+i32 VerifyWoffChecksums(Arena *arena, Font *font, FontChecksumReport *report)
+{
+  TableDirectory *directory = font->directory;
+  i32 numTables = directory->numTables;
+  report->tableCount = numTables;
+  report->computedChecksums = (u32 *)Alloc(arena, numTables * sizeof(u32));
+  if (!report->computedChecksums) return 0;
+
+  TmpArena scratch;
+  TmpArenaPush(&scratch, GetScratchArena(arena));
+  u32 directorySize = 12 + numTables * 16;
+  u8 *sfntDirectory = (u8 *)AllocNoZero(scratch.arena, directorySize);
+  WriteSfntDirectory(directory, sfntDirectory);
+  u32 fileSum = ChecksumRange(MakeFontView(sfntDirectory, directorySize), 0, directorySize, 0);
+  TmpArenaPop(&scratch);
+
+  TableRecord *head = FindTableRecord(font, READ_BIG_ENDIAN_U32("head"));
+  for (i32 i = 0; i < numTables; ++i)
+  {
+    TableRecord *tableRecord = &directory->tableRecords[i];
+    FontView table = GetWoffTable(font, tableRecord);
+    report->computedChecksums[i] = ComputeTableChecksum(table);
+    if (tableRecord == head && table.length >= 12)
+    {
+      report->storedAdjustment = ViewU32(table, 8);
+      report->computedChecksums[i] -= report->storedAdjustment;
+      report->adjustmentChecked = 1;
+    }
+    fileSum += report->computedChecksums[i];
+    if (report->computedChecksums[i] != tableRecord->checksum) ++report->failedTables;
+  }
+  report->computedAdjustment = report->adjustmentChecked ? CHECKSUM_MAGIC - fileSum : 0;
+  return report->failedTables == 0 && (!report->adjustmentChecked || report->computedAdjustment == report->storedAdjustment);
+}
+
+// Verifies every table checksum and, for standalone fonts, head.checksumAdjustment. Large fonts are summed
+// on the job system when one is given. Returns 1 when everything matches, the report tells what did not.
+i32 VerifyFontChecksums(Arena *arena, Font *font, JobSystem *system, FontChecksumReport *report)
+{
+  memset(report, 0, sizeof(FontChecksumReport));
+  TableDirectory *directory = font->directory;
+  FontView view = font->view;
+  if (!directory) return 0;
+  if (font->woff) return VerifyWoffChecksums(arena, font, report);
+
+  i32 numTables = directory->numTables;
+  report->tableCount = numTables;
+  report->computedChecksums = (u32 *)Alloc(arena, numTables * sizeof(u32));
+
+  TmpArena scratch;
+  TmpArenaPush(&scratch, GetScratchArena(arena));
+
+  // Tables sorted by offset tell whether they tile the file: word-aligned, inside of it and not overlapping.
+  i32 *order = (i32 *)AllocNoZero(scratch.arena, numTables * sizeof(i32));
+  u64 totalBytes = 0;
+  for (i32 i = 0; i < numTables; ++i)
+  {
+    order[i] = i;
+    TableRecord *tableRecord = &directory->tableRecords[i];
+    if (FontViewContains(view, tableRecord->offset, tableRecord->length)) totalBytes += tableRecord->length;
+  }
+  for (i32 i = 1; i < numTables; ++i)
+  {
+    i32 current = order[i], j = i;
+    for (; j > 0 && directory->tableRecords[order[j - 1]].offset > directory->tableRecords[current].offset; --j) order[j] = order[j - 1];
+    order[j] = current;
+  }
+
+  i32 standalone = ViewU32(view, 0) != READ_BIG_ENDIAN_U32("ttcf");
+  i32 tiled = 1;
+  u32 directoryEnd = 12 + numTables * 16, previousEnd = directoryEnd;
+  for (i32 i = 0; i < numTables; ++i)
+  {
+    TableRecord *tableRecord = &directory->tableRecords[order[i]];
+    if ((tableRecord->offset & 3) || tableRecord->offset < previousEnd || !FontViewContains(view, tableRecord->offset, tableRecord->length)) tiled = 0;
+    previousEnd = tableRecord->offset + tableRecord->length;
+  }
+
+  // Table chunks first, then either the gaps between tables or the whole file.
+  u64 pieceBytes = totalBytes + (u64)view.length;
+  i32 maxPieces = 2 * numTables + 3 + (i32)(pieceBytes / CHECKSUM_CHUNK_SIZE);
+  ChecksumPiece *pieces = (ChecksumPiece *)AllocNoZero(scratch.arena, maxPieces * sizeof(ChecksumPiece));
+
+  i32 pieceCount = 0;
+  for (i32 i = 0; i < numTables; ++i)
+  {
+    TableRecord *tableRecord = &directory->tableRecords[i];
+    if (!FontViewContains(view, tableRecord->offset, tableRecord->length)) continue;
+    pieceCount = AddChecksumPieces(pieces, pieceCount, tableRecord->offset, tableRecord->offset + tableRecord->length, tableRecord->offset, i);
+  }
+  if (standalone)
+  {
+    if (tiled)
+    {
+      pieceCount = AddChecksumPieces(pieces, pieceCount, 0, directoryEnd, 0, -1);
+      previousEnd = directoryEnd;
+      for (i32 i = 0; i < numTables; ++i)
+      {
+        TableRecord *tableRecord = &directory->tableRecords[order[i]];
+        pieceCount = AddChecksumPieces(pieces, pieceCount, previousEnd, tableRecord->offset, 0, -1);
+        previousEnd = tableRecord->offset + tableRecord->length;
+      }
+      pieceCount = AddChecksumPieces(pieces, pieceCount, previousEnd, view.length, 0, -1);
+    }
+    else
+    {
+      pieceCount = AddChecksumPieces(pieces, pieceCount, 0, view.length, 0, -1);
+    }
+  }
+
+  ChecksumWork work = { view, pieces };
+  if (system && system->workerCount > 1 && pieceBytes >= CHECKSUM_PARALLEL_THRESHOLD)
+  {
+    RunParallelFor(system, SumChecksumPieces, &work, pieceCount, 1);
+  }
+  else
+  {
+    SumChecksumPieces(NULL, &work, 0, pieceCount);
+  }
+
+  u32 fileSum = 0;
+  for (i32 i = 0; i < pieceCount; ++i)
+  {
+    if (pieces[i].table >= 0) report->computedChecksums[pieces[i].table] += pieces[i].sum;
+    if (pieces[i].table < 0 || tiled) fileSum += pieces[i].sum;
+  }
+
+  // head is summed with checksumAdjustment taken as 0, for its own checksum and for the file.
+  TableRecord *head = FindTableRecord(font, READ_BIG_ENDIAN_U32("head"));
+  if (head && head->length >= 12 && FontViewContains(view, head->offset, head->length))
+  {
+    report->storedAdjustment = ViewU32(view, head->offset + 8);
+    report->computedChecksums[head - directory->tableRecords] -= report->storedAdjustment;
+    if (standalone)
+    {
+      report->adjustmentChecked = 1;
+      report->computedAdjustment = CHECKSUM_MAGIC - (fileSum - ChecksumRange(view, head->offset + 8, head->offset + 12, 0));
+    }
+  }
+
+  for (i32 i = 0; i < numTables; ++i)
+  {
+    if (report->computedChecksums[i] != directory->tableRecords[i].checksum) ++report->failedTables;
+  }
+
+  TmpArenaPop(&scratch);
+  return report->failedTables == 0 && (!report->adjustmentChecked || report->computedAdjustment == report->storedAdjustment);
+}
@@ -0,0 +1,552 @@
+#define BMP_GLYPH_TABLE_SIZE 65536
+
+#define CODEPOINT_PAGE_SIZE 256
+#define CODEPOINT_PAGE_COUNT (0x110000 / CODEPOINT_PAGE_SIZE)
+
+typedef enum {
+  CODEPOINT_MAP_BMP_TABLE = 1 << 0, // Build the 64K direct-mapped BMP table.
+  CODEPOINT_MAP_PAGE_TABLE = 1 << 1, // Build the two-level page table covering all 17 planes.
+} CodepointMapFlags;
+
+typedef struct {
+  u32 first;
+  u32 last;
+} CodepointRange;
+
+// Two-level table over U+0000 to U+10FFFF, only pages touched by a mapped range are allocated and
+// every other page index points to the shared empty page 0.
+typedef struct {
+  u16 *pageIndices; // CODEPOINT_PAGE_COUNT entries.
+  i32 pageCount;
+  u16 *pages; // pageCount * CODEPOINT_PAGE_SIZE glyph ids.
+} CodepointPageTable;
+
+typedef struct {
+  CodepointMapSubtable *subtable;
+  u16 *bmpGlyphIds; // Optional direct-mapped table of BMP_GLYPH_TABLE_SIZE entries, NULL when not built.
+  CodepointPageTable *pageTable; // Optional, NULL when not built.
+} CodepointMap;
+
+i32 GetFormat4GlyphIdCount(CodepointMapFormat4 *format4)
+{
+  i32 glyphIdCount = ((i32)format4->length - 16 - (format4->segCountX2 / 2) * 8) / 2;
+  return glyphIdCount < 0 ? 0 : glyphIdCount;
+}
+
+u16 GlyphIndexFromFormat4Segment(CodepointMapFormat4 *format4, i32 segment, u32 codepoint)
+{
+  u16 idRangeOffset = format4->idRangeOffset[segment];
+  if (idRangeOffset == 0)
+  {
+    return (u16)(codepoint + format4->idDelta[segment]);
+  }
+
+  // idRangeOffset is a byte offset from its own slot, our arrays keep the file layout so it lands in glyphIdArray.
+  i32 segCount = format4->segCountX2 / 2;
+  i32 glyphIdIndex = idRangeOffset / 2 + (i32)(codepoint - format4->startCode[segment]) - (segCount - segment);
+  if (glyphIdIndex < 0 || glyphIdIndex >= GetFormat4GlyphIdCount(format4)) return 0;
+
+  u16 glyphId = format4->glyphIdArray[glyphIdIndex];
+  return glyphId ? (u16)(glyphId + format4->idDelta[segment]) : 0;
+}
+
+u16 GlyphIndexFromSubtable(CodepointMapSubtable *subtable, u32 codepoint)
+{
+  switch (subtable->format)
+  {
+    case 0: {
+      return codepoint < 256 ? subtable->value.format0->glyphIdArray[codepoint] : 0;
+    } break;
+
+    case 4: {
+      CodepointMapFormat4 *format4 = subtable->value.format4;
+      if (codepoint > 0xFFFF || format4->segCountX2 < 2) return 0;
+
+      // searchRange and rangeShift were derived from segCountX2 when parsing, never taken from the font.
+      u16 *endCode = format4->endCode;
+      i32 step = format4->searchRange / 2;
+      i32 segment = endCode[step - 1] < codepoint ? format4->rangeShift / 2 : 0;
+      for (step /= 2; step > 0; step /= 2)
+      {
+        if (endCode[segment + step - 1] < codepoint) segment += step;
+      }
+
+      if (endCode[segment] < codepoint || format4->startCode[segment] > codepoint) return 0;
+      return GlyphIndexFromFormat4Segment(format4, segment, codepoint);
+    } break;
+
+    case 12: case 13: {
+      CodepointMapFormat12 *format12 = subtable->value.format12;
+      SequentialMapGroup *groups = format12->groups;
+      u32 low = 0;
+      u32 high = format12->numGroups;
+      while (low < high)
+      {
+        u32 middle = low + (high - low) / 2;
+        if (groups[middle].endCharCode < codepoint) low = middle + 1;
+        else high = middle;
+      }
+
+      if (low == format12->numGroups || groups[low].startCharCode > codepoint) return 0;
+      u32 glyphId = groups[low].startGlyphID;
+      if (subtable->format == 12) glyphId += codepoint - groups[low].startCharCode;
+      return glyphId > 0xFFFF ? 0 : (u16)glyphId;
+    } break;
+  }
+
+  return 0;
+}
+
+u16 GlyphIndexFromCodepoint(CodepointMap *codepointMap, u32 codepoint)
+{
+  if (codepointMap->bmpGlyphIds && codepoint < BMP_GLYPH_TABLE_SIZE)
+  {
+    return codepointMap->bmpGlyphIds[codepoint];
+  }
+  if (codepointMap->pageTable)
+  {
+    CodepointPageTable *pageTable = codepointMap->pageTable;
+    if (codepoint >= CODEPOINT_PAGE_COUNT * CODEPOINT_PAGE_SIZE) return 0;
+    return pageTable->pages[pageTable->pageIndices[codepoint / CODEPOINT_PAGE_SIZE] * CODEPOINT_PAGE_SIZE + codepoint % CODEPOINT_PAGE_SIZE];
+  }
+  return GlyphIndexFromSubtable(codepointMap->subtable, codepoint);
+}
+
+// Ranges are format 4 segments or format 12/13 groups, format 0 is a single range.
+i32 GetSubtableRangeCount(CodepointMapSubtable *subtable)
+{
+  switch (subtable->format)
+  {
+    case 0: return 1;
+    case 4: return subtable->value.format4->segCountX2 / 2;
+    case 12: case 13: return (i32)subtable->value.format12->numGroups;
+  }
+  return 0;
+}
+
+CodepointRange GetSubtableRange(CodepointMapSubtable *subtable, i32 index)
+{
+  CodepointRange range = { 1, 0 };
+  switch (subtable->format)
+  {
+    case 0: {
+      range.first = 0;
+      range.last = 255;
+    } break;
+
+    case 4: {
+      range.first = subtable->value.format4->startCode[index];
+      range.last = subtable->value.format4->endCode[index];
+    } break;
+
+    case 12: case 13: {
+      range.first = subtable->value.format12->groups[index].startCharCode;
+      range.last = subtable->value.format12->groups[index].endCharCode;
+      if (range.last > 0x10FFFF) range.last = 0x10FFFF;
+    } break;
+  }
+  return range;
+}
+
+// codepoint must be inside the range at index.
+u16 GlyphIndexFromSubtableRange(CodepointMapSubtable *subtable, i32 index, u32 codepoint)
+{
+  switch (subtable->format)
+  {
+    case 0: return subtable->value.format0->glyphIdArray[codepoint];
+    case 4: return GlyphIndexFromFormat4Segment(subtable->value.format4, index, codepoint);
+    case 12: case 13: {
+      SequentialMapGroup *group = &subtable->value.format12->groups[index];
+      u32 glyphId = group->startGlyphID + (subtable->format == 12 ? codepoint - group->startCharCode : 0);
+      return glyphId > 0xFFFF ? 0 : (u16)glyphId;
+    } break;
+  }
+  return 0;
+}
+
+// Walks the ranges once instead of doing 64K searches, unmapped codepoints stay at glyph 0.
+u16 *BuildBmpGlyphTable(Arena *arena, CodepointMapSubtable *subtable)
+{
+  u16 *bmpGlyphIds = (u16 *)Alloc(arena, BMP_GLYPH_TABLE_SIZE * sizeof(u16) + SIMD_PADDING);
+  if (!bmpGlyphIds) return NULL;
+
+  i32 rangeCount = GetSubtableRangeCount(subtable);
+  for (i32 i = 0; i < rangeCount; ++i)
+  {
+    CodepointRange range = GetSubtableRange(subtable, i);
+    for (u32 codepoint = range.first; codepoint <= range.last && codepoint < BMP_GLYPH_TABLE_SIZE; ++codepoint)
+    {
+      // Keep the first range's mapping, like the search does, for malformed overlapping ranges.
+      if (!bmpGlyphIds[codepoint])
+      {
+        bmpGlyphIds[codepoint] = GlyphIndexFromSubtableRange(subtable, i, codepoint);
+      }
+    }
+  }
+
+  return bmpGlyphIds;
+}
+
+CodepointPageTable *BuildCodepointPageTable(Arena *arena, CodepointMapSubtable *subtable)
+{
+  CodepointPageTable *pageTable = (CodepointPageTable *)Alloc(arena, sizeof(CodepointPageTable));
+  if (!pageTable) return NULL;
+  pageTable->pageIndices = (u16 *)Alloc(arena, CODEPOINT_PAGE_COUNT * sizeof(u16) + SIMD_PADDING);
+  if (!pageTable->pageIndices) return NULL;
+
+  // First pass numbers the touched pages so they can be allocated in one block, page 0 stays empty.
+  i32 rangeCount = GetSubtableRangeCount(subtable);
+  pageTable->pageCount = 1;
+  for (i32 i = 0; i < rangeCount; ++i)
+  {
+    CodepointRange range = GetSubtableRange(subtable, i);
+    for (u32 page = range.first / CODEPOINT_PAGE_SIZE; range.first <= range.last && page <= range.last / CODEPOINT_PAGE_SIZE; ++page)
+    {
+      if (!pageTable->pageIndices[page]) pageTable->pageIndices[page] = (u16)pageTable->pageCount++;
+    }
+  }
+
+  pageTable->pages = (u16 *)Alloc(arena, pageTable->pageCount * CODEPOINT_PAGE_SIZE * sizeof(u16) + SIMD_PADDING);
+  if (!pageTable->pages) return NULL;
+
+  for (i32 i = 0; i < rangeCount; ++i)
+  {
+    CodepointRange range = GetSubtableRange(subtable, i);
+    for (u32 codepoint = range.first; codepoint <= range.last; ++codepoint)
+    {
+      u16 *glyphId = &pageTable->pages[pageTable->pageIndices[codepoint / CODEPOINT_PAGE_SIZE] * CODEPOINT_PAGE_SIZE + codepoint % CODEPOINT_PAGE_SIZE];
+      if (!*glyphId) *glyphId = GlyphIndexFromSubtableRange(subtable, i, codepoint);
+    }
+  }
+
+  return pageTable;
+}
+
+size_t GetCodepointPageTableSize(CodepointPageTable *pageTable)
+{
+  return sizeof(CodepointPageTable) + (CODEPOINT_PAGE_COUNT + pageTable->pageCount * CODEPOINT_PAGE_SIZE) * sizeof(u16);
+}
+
+// Full Unicode subtables first, then BMP ones, then symbol and finally Macintosh records whose codes are
+// not Unicode. 0 means the record is unusable.
+i32 ScoreEncodingRecord(u16 platformID, u16 platformSpecificID, u16 format)
+{
+  i32 fullRepertoire = format == 12 || format == 13;
+  if (format != 0 && format != 4 && !fullRepertoire) return 0;
+
+  switch (platformID)
+  {
+    case UNICODE_ENCODING: {
+      if (platformSpecificID == UNICODE_ENCODING_VARIATION_SEQUENCES) return 0;
+      return fullRepertoire ? (format == 12 ? 6 : 5) : 4;
+    } break;
+
+    case MICROSOFT_ENCODING: {
+      if (platformSpecificID == UNICODE_FULL_ENCODING && fullRepertoire) return format == 12 ? 6 : 5;
+      if (platformSpecificID == UNICODE_BMP_ENCODING) return 4;
+      if (platformSpecificID == SYMBOL_ENCODING) return 2;
+    } break;
+
+    case MACINTOSH_ENCODING: return 1;
+  }
+
+  return 0;
+}
+
+i32 LoadCodepointMap(Arena *arena, Font *font, CodepointMap *codepointMap, u32 flags)
+{
+  memset(codepointMap, 0, sizeof(CodepointMap));
+
+  FontView cmap = GetFontTable(font, FONT_TABLE_CMAP);
+  if (!cmap.length) return 0;
+
+  u16 numTables = ViewU16(cmap, 2);
+  u32 bestOffset = 0;
+  i32 bestScore = 0;
+  for (u16 i = 0; i < numTables; ++i)
+  {
+    u16 platformID = ViewU16(cmap, 4 + i * 8);
+    u16 platformSpecificID = ViewU16(cmap, 4 + i * 8 + 2);
+    u32 offset = ViewU32(cmap, 4 + i * 8 + 4);
+    u16 format = ViewU16(cmap, offset);
+    u32 length = format >= 8 ? ViewU32(cmap, offset + 4) : ViewU16(cmap, offset + 2);
+
+    i32 score = ScoreEncodingRecord(platformID, platformSpecificID, format);
+    if (score > bestScore && FontViewContains(cmap, offset, length))
+    {
+      bestScore = score;
+      bestOffset = offset;
+    }
+  }
+
+  if (!bestScore) return 0;
+  PROFILE_BEGIN(ReadCodepointMapSubtable);
+  codepointMap->subtable = ReadCodepointMapSubtable(arena, FontSubView(cmap, bestOffset, cmap.length - bestOffset));
+  PROFILE_END(ReadCodepointMapSubtable);
+  if (!codepointMap->subtable) return 0;
+
+  if (flags & CODEPOINT_MAP_BMP_TABLE)
+  {
+    PROFILE_BEGIN(BuildBmpGlyphTable);
+    codepointMap->bmpGlyphIds = BuildBmpGlyphTable(arena, codepointMap->subtable);
+    PROFILE_END(BuildBmpGlyphTable);
+  }
+  if (flags & CODEPOINT_MAP_PAGE_TABLE)
+  {
+    PROFILE_BEGIN(BuildCodepointPageTable);
+    codepointMap->pageTable = BuildCodepointPageTable(arena, codepointMap->subtable);
+    PROFILE_END(BuildCodepointPageTable);
+  }
+
+  return 1;
+}
+
+void GlyphIndicesFromCodepointsScalar(CodepointMap *codepointMap, u32 *codepoints, i32 count, u16 *glyphIds)
+{
+  for (i32 i = 0; i < count; ++i)
+  {
+    glyphIds[i] = GlyphIndexFromCodepoint(codepointMap, codepoints[i]);
+  }
+}
+
+#if SIMD_X86
+// Narrows the format 4 search with the usual power-of-two steps until 8 segments remain, then counts
+// the endCodes below the codepoint with a single compare instead of three more dependent steps.
+void GlyphIndicesFromCodepointsSse2(CodepointMap *codepointMap, u32 *codepoints, i32 count, u16 *glyphIds)
+{
+  CodepointMapSubtable *subtable = codepointMap->subtable;
+  if (codepointMap->bmpGlyphIds || codepointMap->pageTable || subtable->format != 4 || subtable->value.format4->segCountX2 < 2)
+  {
+    GlyphIndicesFromCodepointsScalar(codepointMap, codepoints, count, glyphIds);
+    return;
+  }
+
+  CodepointMapFormat4 *format4 = subtable->value.format4;
+  u16 *endCode = format4->endCode;
+  i32 segCount = format4->segCountX2 / 2;
+  i32 window = format4->searchRange / 2;
+  i32 lastWindow = window < 8 ? window : 8;
+  i32 windowMask = (1 << (lastWindow * 2)) - 1; // movemask yields 2 bits per u16 lane.
+  __m128i bias = _mm_set1_epi16((short)0x8000);
+
+  for (i32 i = 0; i < count; ++i)
+  {
+    u32 codepoint = codepoints[i];
+    if (codepoint > 0xFFFF)
+    {
+      glyphIds[i] = 0;
+      continue;
+    }
+
+    i32 segment = endCode[window - 1] < codepoint ? format4->rangeShift / 2 : 0;
+    for (i32 step = window / 2; step >= lastWindow; step /= 2)
+    {
+      if (endCode[segment + step - 1] < codepoint) segment += step;
+    }
+
+    // u16 compares are signed, biasing both sides keeps the order.
+    __m128i ends = _mm_xor_si128(_mm_loadu_si128((__m128i *)&endCode[segment]), bias);
+    __m128i key = _mm_set1_epi16((short)(codepoint ^ 0x8000));
+    u32 below = (u32)_mm_movemask_epi8(_mm_cmplt_epi16(ends, key)) & windowMask;
+    segment += CountTrailingZeros(~below) / 2;
+
+    if (segment >= segCount || format4->startCode[segment] > codepoint || endCode[segment] < codepoint)
+    {
+      glyphIds[i] = 0;
+      continue;
+    }
+    glyphIds[i] = GlyphIndexFromFormat4Segment(format4, segment, codepoint);
+  }
+}
+
+TARGET_AVX2 void StoreU16x8Avx2(u16 *destination, __m256i values)
+{
+  __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi32(values, values), 0x08);
+  _mm_storeu_si128((__m128i *)destination, _mm256_castsi256_si128(packed));
+}
+
+// Runs 8 branchless format 4 searches side by side with gathers, or gathers straight from the BMP or page table.
+TARGET_AVX2 void GlyphIndicesFromCodepointsAvx2(CodepointMap *codepointMap, u32 *codepoints, i32 count, u16 *glyphIds)
+{
+  CodepointMapSubtable *subtable = codepointMap->subtable;
+  __m256i zero = _mm256_setzero_si256();
+  __m256i lowMask = _mm256_set1_epi32(0xFFFF);
+  i32 i = 0;
+
+  if (codepointMap->bmpGlyphIds)
+  {
+    for (; i + 8 <= count; i += 8)
+    {
+      __m256i codepoint = _mm256_loadu_si256((__m256i *)&codepoints[i]);
+      __m256i inBmp = _mm256_cmpeq_epi32(_mm256_srli_epi32(codepoint, 16), zero); // Unsigned, UTF-32 may hold any u32.
+      __m256i glyphId = _mm256_mask_i32gather_epi32(zero, (int *)codepointMap->bmpGlyphIds, codepoint, inBmp, 2);
+      StoreU16x8Avx2(&glyphIds[i], _mm256_and_si256(glyphId, lowMask));
+
+      // Codepoints outside of the BMP go through the subtable.
+      if (_mm256_movemask_epi8(inBmp) != -1)
+      {
+        for (i32 j = i; j < i + 8; ++j)
+        {
+          if (codepoints[j] >= BMP_GLYPH_TABLE_SIZE) glyphIds[j] = GlyphIndexFromCodepoint(codepointMap, codepoints[j]);
+        }
+      }
+    }
+  }
+  else if (codepointMap->pageTable)
+  {
+    CodepointPageTable *pageTable = codepointMap->pageTable;
+    // AVX2 only compares signed, biasing both sides by 0x80000000 gives the unsigned order.
+    __m256i bias = _mm256_set1_epi32((int)0x80000000);
+    __m256i codepointEnd = _mm256_set1_epi32((int)(CODEPOINT_PAGE_COUNT * CODEPOINT_PAGE_SIZE ^ 0x80000000));
+    __m256i slotMask = _mm256_set1_epi32(CODEPOINT_PAGE_SIZE - 1);
+    for (; i + 8 <= count; i += 8)
+    {
+      __m256i codepoint = _mm256_loadu_si256((__m256i *)&codepoints[i]);
+      __m256i valid = _mm256_cmpgt_epi32(codepointEnd, _mm256_xor_si256(codepoint, bias));
+      __m256i page = _mm256_srli_epi32(codepoint, 8);
+      __m256i pageIndex = _mm256_and_si256(_mm256_mask_i32gather_epi32(zero, (int *)pageTable->pageIndices, page, valid, 2), lowMask);
+      __m256i slot = _mm256_add_epi32(_mm256_slli_epi32(pageIndex, 8), _mm256_and_si256(codepoint, slotMask));
+      __m256i glyphId = _mm256_mask_i32gather_epi32(zero, (int *)pageTable->pages, slot, valid, 2);
+      StoreU16x8Avx2(&glyphIds[i], _mm256_and_si256(glyphId, lowMask));
+    }
+  }
+  else if (subtable->format == 4 && subtable->value.format4->segCountX2 >= 2)
+  {
+    CodepointMapFormat4 *format4 = subtable->value.format4;
+    i32 segCount = format4->segCountX2 / 2;
+    i32 window = format4->searchRange / 2;
+    int *endCode = (int *)format4->endCode;
+    int *startCode = (int *)format4->startCode;
+    int *idDelta = (int *)format4->idDelta;
+    int *idRangeOffset = (int *)format4->idRangeOffset;
+    int *glyphIdArray = (int *)format4->glyphIdArray;
+    __m256i firstEnd = _mm256_set1_epi32(format4->endCode[window - 1]);
+    __m256i rangeShift = _mm256_set1_epi32(format4->rangeShift / 2);
+    __m256i lastSegment = _mm256_set1_epi32(segCount - 1);
+    __m256i segCountVector = _mm256_set1_epi32(segCount);
+    __m256i glyphIdCount = _mm256_set1_epi32(GetFormat4GlyphIdCount(format4));
+    __m256i minusOne = _mm256_set1_epi32(-1);
+
+    for (; i + 8 <= count; i += 8)
+    {
+      __m256i codepoint = _mm256_loadu_si256((__m256i *)&codepoints[i]);
+      __m256i inBmp = _mm256_cmpeq_epi32(_mm256_srli_epi32(codepoint, 16), zero);
+
+      // 32-bit gathers at u16 strides, the high half belongs to the next entry and is masked off.
+      __m256i segment = _mm256_and_si256(_mm256_cmpgt_epi32(codepoint, firstEnd), rangeShift);
+      for (i32 step = window / 2; step > 0; step /= 2)
+      {
+        __m256i probe = _mm256_add_epi32(segment, _mm256_set1_epi32(step - 1));
+        __m256i ends = _mm256_and_si256(_mm256_i32gather_epi32(endCode, probe, 2), lowMask);
+        segment = _mm256_add_epi32(segment, _mm256_and_si256(_mm256_cmpgt_epi32(codepoint, ends), _mm256_set1_epi32(step)));
+      }
+      segment = _mm256_min_epi32(segment, lastSegment);
+
+      __m256i ends = _mm256_and_si256(_mm256_i32gather_epi32(endCode, segment, 2), lowMask);
+      __m256i starts = _mm256_and_si256(_mm256_i32gather_epi32(startCode, segment, 2), lowMask);
+      __m256i deltas = _mm256_and_si256(_mm256_i32gather_epi32(idDelta, segment, 2), lowMask);
+      __m256i rangeOffsets = _mm256_and_si256(_mm256_i32gather_epi32(idRangeOffset, segment, 2), lowMask);
+      __m256i outside = _mm256_or_si256(_mm256_cmpgt_epi32(codepoint, ends), _mm256_cmpgt_epi32(starts, codepoint));
+      __m256i inRange = _mm256_andnot_si256(outside, inBmp);
+
+      __m256i glyphId = _mm256_and_si256(_mm256_add_epi32(codepoint, deltas), lowMask);
+      __m256i useRange = _mm256_andnot_si256(_mm256_cmpeq_epi32(rangeOffsets, zero), inRange);
+      if (_mm256_movemask_epi8(useRange))
+      {
+        __m256i index = _mm256_add_epi32(_mm256_srli_epi32(rangeOffsets, 1), _mm256_sub_epi32(codepoint, starts));
+        index = _mm256_sub_epi32(index, _mm256_sub_epi32(segCountVector, segment));
+        __m256i validIndex = _mm256_and_si256(_mm256_cmpgt_epi32(index, minusOne), _mm256_cmpgt_epi32(glyphIdCount, index));
+        validIndex = _mm256_and_si256(validIndex, useRange);
+        __m256i rangeGlyphId = _mm256_and_si256(_mm256_mask_i32gather_epi32(zero, glyphIdArray, index, validIndex, 2), lowMask);
+        __m256i mapped = _mm256_andnot_si256(_mm256_cmpeq_epi32(rangeGlyphId, zero), minusOne);
+        rangeGlyphId = _mm256_and_si256(_mm256_and_si256(_mm256_add_epi32(rangeGlyphId, deltas), lowMask), mapped);
+        glyphId = _mm256_blendv_epi8(glyphId, rangeGlyphId, useRange);
+      }
+
+      StoreU16x8Avx2(&glyphIds[i], _mm256_and_si256(glyphId, inRange));
+    }
+  }
+  else if ((subtable->format == 12 || subtable->format == 13) && subtable->value.format12->numGroups)
+  {
+    CodepointMapFormat12 *format12 = subtable->value.format12;
+    i32 numGroups = (i32)format12->numGroups;
+    i32 window = 1;
+    while (window * 2 <= numGroups) window *= 2;
+
+    // Groups are three u32s, gather indices are scaled by 3 and offset to the wanted field.
+    int *startCharCodes = (int *)&format12->groups[0].startCharCode;
+    int *endCharCodes = (int *)&format12->groups[0].endCharCode;
+    int *startGlyphIds = (int *)&format12->groups[0].startGlyphID;
+    __m256i bias = _mm256_set1_epi32((int)0x80000000);
+    __m256i firstEnd = _mm256_set1_epi32((int)(format12->groups[window - 1].endCharCode ^ 0x80000000));
+    __m256i rangeShift = _mm256_set1_epi32(numGroups - window);
+    __m256i lastGroup = _mm256_set1_epi32(numGroups - 1);
+    __m256i sequential = _mm256_set1_epi32(subtable->format == 12 ? -1 : 0);
+    __m256i three = _mm256_set1_epi32(3);
+
+    for (; i + 8 <= count; i += 8)
+    {
+      // Char codes are compared biased by 0x80000000, AVX2 has no unsigned compare.
+      __m256i codepoint = _mm256_loadu_si256((__m256i *)&codepoints[i]);
+      __m256i biasedCodepoint = _mm256_xor_si256(codepoint, bias);
+      __m256i group = _mm256_and_si256(_mm256_cmpgt_epi32(biasedCodepoint, firstEnd), rangeShift);
+      for (i32 step = window / 2; step > 0; step /= 2)
+      {
+        __m256i probe = _mm256_mullo_epi32(_mm256_add_epi32(group, _mm256_set1_epi32(step - 1)), three);
+        __m256i ends = _mm256_xor_si256(_mm256_i32gather_epi32(endCharCodes, probe, 4), bias);
+        group = _mm256_add_epi32(group, _mm256_and_si256(_mm256_cmpgt_epi32(biasedCodepoint, ends), _mm256_set1_epi32(step)));
+      }
+      group = _mm256_mullo_epi32(_mm256_min_epi32(group, lastGroup), three);
+
+      __m256i starts = _mm256_i32gather_epi32(startCharCodes, group, 4);
+      __m256i ends = _mm256_i32gather_epi32(endCharCodes, group, 4);
+      __m256i glyphId = _mm256_i32gather_epi32(startGlyphIds, group, 4);
+      glyphId = _mm256_add_epi32(glyphId, _mm256_and_si256(_mm256_sub_epi32(codepoint, starts), sequential));
+
+      // Glyph ids past 0xFFFF map to 0.
+      __m256i outside = _mm256_or_si256(_mm256_cmpgt_epi32(biasedCodepoint, _mm256_xor_si256(ends, bias)),
+                                        _mm256_cmpgt_epi32(_mm256_xor_si256(starts, bias), biasedCodepoint));
+      outside = _mm256_or_si256(outside, _mm256_cmpgt_epi32(_mm256_xor_si256(glyphId, bias), _mm256_xor_si256(lowMask, bias)));
+      StoreU16x8Avx2(&glyphIds[i], _mm256_andnot_si256(outside, glyphId));
+    }
+  }
+
+  GlyphIndicesFromCodepointsScalar(codepointMap, &codepoints[i], count - i, &glyphIds[i]);
+}
+#endif
+
+// Picks the widest path the CPU supports at runtime.
+void GlyphIndicesFromCodepoints(CodepointMap *codepointMap, u32 *codepoints, i32 count, u16 *glyphIds)
+{
+#if SIMD_X86
+  CpuFeatures *features = GetCpuFeatures();
+  if (features->hasAvx2)
+  {
+    GlyphIndicesFromCodepointsAvx2(codepointMap, codepoints, count, glyphIds);
+    return;
+  }
+  if (features->hasSse2)
+  {
+    GlyphIndicesFromCodepointsSse2(codepointMap, codepoints, count, glyphIds);
+    return;
+  }
+#endif
+  GlyphIndicesFromCodepointsScalar(codepointMap, codepoints, count, glyphIds);
+}
+
+// glyphIds must have room for length entries, returns the number of glyphs written.
+i32 GlyphIndicesFromUtf8(CodepointMap *codepointMap, u8 *text, i32 length, u16 *glyphIds)
+{
+  u32 codepoints[256];
+  i32 glyphCount = 0;
+  i32 offset = 0;
+  while (offset < length)
+  {
+    i32 consumed = 0;
+    i32 count = DecodeUtf8(&text[offset], length - offset, codepoints, 256, &consumed);
+    GlyphIndicesFromCodepoints(codepointMap, codepoints, count, &glyphIds[glyphCount]);
+    glyphCount += count;
+    offset += consumed;
+  }
+  return glyphCount;
+}
@@ -0,0 +1,197 @@
+//SPECS: https://learn.microsoft.com/en-us/typography/opentype/spec/otff#collections
+
+// Faces of a collection usually point several table records at the same bytes (CJK collections share
+// glyf, loca and cmap between their faces). Decoded tables are recorded by tag and file range, so the
+// first face to need one decodes it and the others get the same pointer.
+
+#define FONT_COLLECTION_MAX_SHARED_TABLES 256
+
+typedef struct {
+  u32 tag;
+  u32 offset; // File range of the table, identical ranges decode to identical data.
+  u32 length;
+  u32 variant; // Decoding parameters besides the bytes, e.g. the loca format or the cmap flags.
+  void *data;
+} SharedTable;
+
+typedef struct {
+  MappedFile file;
+  FontView view;
+  TrueTypeCollectionHeaderV2 *header; // NULL for single-face files.
+  i32 faceCount;
+  Font *faces; // Views into the collection mapping, UnloadFont on a face is a no-op.
+  i32 sharedTableCount;
+  SharedTable sharedTables[FONT_COLLECTION_MAX_SHARED_TABLES];
+  i32 sharedTableHits; // Tables a face got without decoding them again.
+} FontCollection;
+
+// Opens every face of a .ttc/.otc from one mapping. Plain .ttf/.otf files load as a single face.
+i32 LoadFontCollection(Arena *arena, char *filePath, FontCollection *collection)
+{
+  memset(collection, 0, sizeof(FontCollection));
+  if (!MapWholeFile(filePath, &collection->file)) return 0;
+  collection->view = MakeFontView(collection->file.data, collection->file.size);
+
+  u32 *directoryOffsets = NULL;
+  u32 singleOffset = 0;
+  collection->header = ReadTrueTypeCollectionHeader(arena, collection->view);
+  if (collection->header)
+  {
+    collection->faceCount = (i32)collection->header->numFonts;
+    directoryOffsets = collection->header->tableDirectoryOffsets;
+  }
+  else if (ViewU32(collection->view, 0) == READ_BIG_ENDIAN_U32("ttcf"))
+  {
+    UnmapWholeFile(&collection->file);
+    return 0;
+  }
+  else
+  {
+    collection->faceCount = 1;
+    directoryOffsets = &singleOffset;
+  }
+
+  collection->faces = (Font *)Alloc(arena, collection->faceCount * sizeof(Font));
+  for (i32 i = 0; i < collection->faceCount; ++i)
+  {
+    Font *face = &collection->faces[i];
+    face->view = collection->view;
+
+    u32 offset = directoryOffsets[i];
+    PROFILE_BEGIN(ReadTableDirectory);
+    face->directory = ReadTableDirectory(arena, FontSubView(collection->view, offset, collection->view.length - offset));
+    PROFILE_END(ReadTableDirectory);
+    if (!face->directory)
+    {
+      fprintf(stderr, "Failed to parse font directory of face %d in %s\n", i, filePath);
+      UnmapWholeFile(&collection->file);
+      return 0;
+    }
+    BuildFontTableIndex(face);
+  }
+
+  return 1;
+}
+
+void UnloadFontCollection(FontCollection *collection)
+{
+  UnmapWholeFile(&collection->file);
+  memset(collection, 0, sizeof(FontCollection));
+}
+
+SharedTable *FindSharedTable(FontCollection *collection, u32 tag, FontView table, u32 variant)
+{
+  if (!table.length) return NULL;
+  u32 offset = (u32)(table.data - collection->view.data);
+  for (i32 i = 0; i < collection->sharedTableCount; ++i)
+  {
+    SharedTable *shared = &collection->sharedTables[i];
+    if (shared->tag == tag && shared->offset == offset && shared->length == table.length && shared->variant == variant)
+    {
+      ++collection->sharedTableHits;
+      return shared;
+    }
+  }
+  return NULL;
+}
+
+// Recording is best effort, a full list only means later faces decode their own copy.
+void *AddSharedTable(FontCollection *collection, u32 tag, FontView table, u32 variant, void *data)
+{
+  if (data && table.length && collection->sharedTableCount < FONT_COLLECTION_MAX_SHARED_TABLES)
+  {
+    SharedTable *shared = &collection->sharedTables[collection->sharedTableCount++];
+    shared->tag = tag;
+    shared->offset = (u32)(table.data - collection->view.data);
+    shared->length = table.length;
+    shared->variant = variant;
+    shared->data = data;
+  }
+  return data;
+}
+
+// Same as LoadGlyphData, with head, maxp and the decoded loca shared between faces.
+i32 LoadFaceGlyphData(Arena *arena, FontCollection *collection, i32 faceIndex, GlyphData *glyphData)
+{
+  memset(glyphData, 0, sizeof(GlyphData));
+  if (faceIndex < 0 || faceIndex >= collection->faceCount) return 0;
+  Font *face = &collection->faces[faceIndex];
+
+  u32 headTag = READ_BIG_ENDIAN_U32("head");
+  FontView head = GetFontTable(face, FONT_TABLE_HEAD);
+  SharedTable *shared = FindSharedTable(collection, headTag, head, 0);
+  glyphData->fontHeader = shared ? (FontHeaderTable *)shared->data
+                                 : (FontHeaderTable *)AddSharedTable(collection, headTag, head, 0, ReadFontHeaderTable(arena, head));
+
+  u32 maxpTag = READ_BIG_ENDIAN_U32("maxp");
+  FontView maxp = GetFontTable(face, FONT_TABLE_MAXP);
+  shared = FindSharedTable(collection, maxpTag, maxp, 0);
+  glyphData->maximumProfile = shared ? (MaximumProfileTable *)shared->data
+                                     : (MaximumProfileTable *)AddSharedTable(collection, maxpTag, maxp, 0, ReadMaximumProfileTable(arena, maxp));
+  if (!glyphData->fontHeader || !glyphData->maximumProfile)
+  {
+    fprintf(stderr, "Failed to parse head or maxp of face %d\n", faceIndex);
+    return 0;
+  }
+
+  u32 locaTag = READ_BIG_ENDIAN_U32("loca");
+  FontView loca = GetFontTable(face, FONT_TABLE_LOCA);
+  glyphData->glyf = GetFontTable(face, FONT_TABLE_GLYF);
+  glyphData->numGlyphs = glyphData->maximumProfile->numGlyphs;
+  FontView compact = GetFontTable(face, FONT_TABLE_CFF2).length ? GetFontTable(face, FONT_TABLE_CFF2) : GetFontTable(face, FONT_TABLE_CFF);
+  if (!glyphData->glyf.length && compact.length)
+  {
+    u32 compactTag = READ_BIG_ENDIAN_U32("CFF ");
+    shared = FindSharedTable(collection, compactTag, compact, 0);
+    glyphData->compactFont = shared ? (CompactFont *)shared->data
+                                    : (CompactFont *)AddSharedTable(collection, compactTag, compact, 0, LoadCompactFont(arena, face));
+    return glyphData->compactFont != NULL;
+  }
+
+  i32 offsetCount = glyphData->numGlyphs + 1;
+  i32 shortOffsets = glyphData->fontHeader->indexToLocFormat == 0;
+  if (!glyphData->glyf.length || loca.length < (u32)offsetCount * (shortOffsets ? 2 : 4))
+  {
+    fprintf(stderr, "Missing or truncated loca/glyf in face %d\n", faceIndex);
+    return 0;
+  }
+
+  // Faces sharing loca bytes may still disagree on the format or glyph count.
+  u32 variant = (u32)offsetCount << 1 | (u32)shortOffsets;
+  shared = FindSharedTable(collection, locaTag, loca, variant);
+  glyphData->glyphOffsets = shared ? (u32 *)shared->data
+                                   : (u32 *)AddSharedTable(collection, locaTag, loca, variant, ReadGlyphOffsets(arena, loca, shortOffsets, offsetCount));
+
+  u32 gvarTag = READ_BIG_ENDIAN_U32("gvar");
+  FontView gvar = GetFontTable(face, FONT_TABLE_GVAR);
+  if (gvar.length)
+  {
+    shared = FindSharedTable(collection, gvarTag, gvar, glyphData->numGlyphs);
+    glyphData->variations = shared ? (GlyphVariations *)shared->data
+                                   : (GlyphVariations *)AddSharedTable(collection, gvarTag, gvar, glyphData->numGlyphs, LoadGlyphVariations(arena, face, glyphData->numGlyphs));
+  }
+  return 1;
+}
+
+// Same as LoadCodepointMap, faces sharing cmap bytes get the same subtable and lookup tables.
+i32 LoadFaceCodepointMap(Arena *arena, FontCollection *collection, i32 faceIndex, CodepointMap *codepointMap, u32 flags)
+{
+  memset(codepointMap, 0, sizeof(CodepointMap));
+  if (faceIndex < 0 || faceIndex >= collection->faceCount) return 0;
+  Font *face = &collection->faces[faceIndex];
+
+  u32 cmapTag = READ_BIG_ENDIAN_U32("cmap");
+  FontView cmap = GetFontTable(face, FONT_TABLE_CMAP);
+  SharedTable *shared = FindSharedTable(collection, cmapTag, cmap, flags);
+  if (shared)
+  {
+    *codepointMap = *(CodepointMap *)shared->data;
+    return 1;
+  }
+
+  if (!LoadCodepointMap(arena, face, codepointMap, flags)) return 0;
+  CodepointMap *copy = (CodepointMap *)Alloc(arena, sizeof(CodepointMap));
+  *copy = *codepointMap;
+  AddSharedTable(collection, cmapTag, cmap, flags, copy);
+  return 1;
+}
@@ -0,0 +1,148 @@
+// Resolves codepoints against a chain of fallback fonts. The cmaps of every font are merged once into a
+// single two-level table holding, for each codepoint, the position of the first font in the chain that
+// maps it to a glyph, so resolution costs two loads however long the chain is.
+
+#define FALLBACK_MAX_FONTS 255
+#define FALLBACK_NO_FONT 0xFF
+
+// Same paging as CodepointPageTable with one byte per codepoint. Pages resolved to a single font, most of
+// the blocks a font covers entirely and every uncovered one, are shared instead of stored.
+typedef struct {
+  i32 fontCount;
+  CodepointMap **fonts; // The chain, fonts[0] is tried first.
+  u16 *pageIndices; // CODEPOINT_PAGE_COUNT entries.
+  i32 pageCount;
+  u8 *pages; // pageCount * CODEPOINT_PAGE_SIZE chain positions, FALLBACK_NO_FONT when nothing covers it.
+} FallbackIndex;
+
+// Consecutive codepoints resolved to the same font, offset and length in bytes of the UTF-8 text.
+typedef struct {
+  i32 offset;
+  i32 length;
+  u8 font; // Position in the chain, FALLBACK_NO_FONT for text no font covers.
+} FallbackRun;
+
+// fonts stay referenced by the index. Returns NULL for empty or too long chains.
+FallbackIndex *BuildFallbackIndex(Arena *arena, CodepointMap **fonts, i32 fontCount)
+{
+  if (fontCount < 1 || fontCount > FALLBACK_MAX_FONTS) return NULL;
+  PROFILE_BEGIN(BuildFallbackIndex);
+
+  // Resolved flat over all of Unicode first, the pages are then compressed out of it.
+  TmpArena scratch;
+  TmpArenaPush(&scratch, GetScratchArena(arena));
+  u32 codepointCount = CODEPOINT_PAGE_COUNT * CODEPOINT_PAGE_SIZE;
+  u8 *resolved = (u8 *)AllocNoZero(scratch.arena, codepointCount);
+  memset(resolved, FALLBACK_NO_FONT, codepointCount);
+  for (i32 font = 0; font < fontCount; ++font)
+  {
+    CodepointMapSubtable *subtable = fonts[font]->subtable;
+    i32 rangeCount = GetSubtableRangeCount(subtable);
+    for (i32 i = 0; i < rangeCount; ++i)
+    {
+      CodepointRange range = GetSubtableRange(subtable, i);
+      for (u32 codepoint = range.first; codepoint <= range.last && codepoint < codepointCount; ++codepoint)
+      {
+        // Ranges may map codepoints to glyph 0, e.g. the final 0xFFFF segment of format 4.
+        if (resolved[codepoint] == FALLBACK_NO_FONT && GlyphIndexFromSubtableRange(subtable, i, codepoint))
+        {
+          resolved[codepoint] = (u8)font;
+        }
+      }
+    }
+  }
+
+  // uniformPages[font] is the shared page of that font, the last slot the one of uncovered pages.
+  u16 uniformPages[FALLBACK_MAX_FONTS + 1] = {0};
+  u16 *pageIndices = (u16 *)AllocNoZero(arena, CODEPOINT_PAGE_COUNT * sizeof(u16) + SIMD_PADDING);
+  i32 pageCount = 0;
+  for (i32 page = 0; page < CODEPOINT_PAGE_COUNT; ++page)
+  {
+    u8 *cells = &resolved[page * CODEPOINT_PAGE_SIZE];
+    if (!memcmp(cells, cells + 1, CODEPOINT_PAGE_SIZE - 1))
+    {
+      u16 *uniform = &uniformPages[cells[0]];
+      if (!*uniform) *uniform = (u16)++pageCount;
+      pageIndices[page] = *uniform - 1;
+    }
+    else
+    {
+      pageIndices[page] = (u16)pageCount++;
+    }
+  }
+
+  // Uniform pages are written once per codepoint page they stand for, always with the same bytes.
+  u8 *pages = (u8 *)AllocNoZero(arena, pageCount * CODEPOINT_PAGE_SIZE + SIMD_PADDING);
+  for (i32 page = 0; page < CODEPOINT_PAGE_COUNT; ++page)
+  {
+    memcpy(&pages[pageIndices[page] * CODEPOINT_PAGE_SIZE], &resolved[page * CODEPOINT_PAGE_SIZE], CODEPOINT_PAGE_SIZE);
+  }
+  TmpArenaPop(&scratch);
+
+  FallbackIndex *index = (FallbackIndex *)Alloc(arena, sizeof(FallbackIndex));
+  index->fontCount = fontCount;
+  index->fonts = fonts;
+  index->pageIndices = pageIndices;
+  index->pageCount = pageCount;
+  index->pages = pages;
+  PROFILE_END(BuildFallbackIndex);
+  return index;
+}
+
+size_t GetFallbackIndexSize(FallbackIndex *index)
+{
+  return sizeof(FallbackIndex) + CODEPOINT_PAGE_COUNT * sizeof(u16) + (size_t)index->pageCount * CODEPOINT_PAGE_SIZE;
+}
+
+// Position of the first font of the chain covering codepoint, or FALLBACK_NO_FONT.
+u8 FindFallbackFont(FallbackIndex *index, u32 codepoint)
+{
+  if (codepoint >= CODEPOINT_PAGE_COUNT * CODEPOINT_PAGE_SIZE) return FALLBACK_NO_FONT;
+  return index->pages[index->pageIndices[codepoint / CODEPOINT_PAGE_SIZE] * CODEPOINT_PAGE_SIZE + codepoint % CODEPOINT_PAGE_SIZE];
+}
+
+// Bytes DecodeUtf8 consumed for codepoint at text: U+FFFD is either a real 3-byte sequence or a single
+// malformed byte.
+i32 GetUtf8SequenceLength(u32 codepoint, u8 *text, i32 remaining)
+{
+  if (codepoint < 0x80) return 1;
+  if (codepoint < 0x800) return 2;
+  if (codepoint == REPLACEMENT_CHARACTER) return remaining >= 3 && text[0] == 0xEF && text[1] == 0xBF && text[2] == 0xBD ? 3 : 1;
+  return codepoint < 0x10000 ? 3 : 4;
+}
+
+// Splits UTF-8 text into runs of the first font covering each codepoint. A run keeps going through
+// codepoints its own font covers even when an earlier font of the chain covers them too, so spaces and
+// punctuation do not break a run of another script, and through codepoints no font covers. Returns the
+// number of runs, at most maxRuns, the text past the last run was not resolved.
+i32 SplitFallbackRuns(FallbackIndex *index, u8 *text, i32 length, FallbackRun *runs, i32 maxRuns)
+{
+  if (maxRuns < 1) return 0;
+  u32 codepoints[256];
+  i32 runCount = 0;
+  FallbackRun *run = NULL;
+  i32 offset = 0;
+  while (offset < length)
+  {
+    i32 consumed = 0;
+    i32 count = DecodeUtf8(&text[offset], length - offset, codepoints, 256, &consumed);
+    for (i32 i = 0; i < count; ++i)
+    {
+      u32 codepoint = codepoints[i];
+      i32 sequenceLength = GetUtf8SequenceLength(codepoint, &text[offset], length - offset);
+      u8 font = FindFallbackFont(index, codepoint);
+      if (!run || (font != run->font && font != FALLBACK_NO_FONT &&
+                   (run->font == FALLBACK_NO_FONT || !GlyphIndexFromCodepoint(index->fonts[run->font], codepoint))))
+      {
+        if (runCount == maxRuns) return runCount;
+        run = &runs[runCount++];
+        run->offset = offset;
+        run->length = 0;
+        run->font = font;
+      }
+      run->length += sequenceLength;
+      offset += sequenceLength;
+    }
+  }
+  return runCount;
+}
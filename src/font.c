@@ -0,0 +1,934 @@
+//SPECS: https://learn.microsoft.com/en-us/typography/opentype/spec/cmap
+
+#define CASE_PRINT_ENUM(enum) case enum: printf(#enum"\n");
+
+typedef struct {
+  u8 *data;
+  u32 length;
+} FontView; // Read-only window into a mapped font, fields are decoded on access and reads outside of it return 0.
+
+FontView MakeFontView(void *data, size_t length)
+{
+  FontView view = { (u8 *)data, length > UINT32_MAX ? UINT32_MAX : (u32)length };
+  return view;
+}
+
+i32 FontViewContains(FontView view, u32 offset, u32 size)
+{
+  return offset <= view.length && size <= view.length - offset;
+}
+
+FontView FontSubView(FontView view, u32 offset, u32 length)
+{
+  FontView subView = {0};
+  if (FontViewContains(view, offset, length))
+  {
+    subView.data = view.data + offset;
+    subView.length = length;
+  }
+  return subView;
+}
+
+u8 ViewU8(FontView view, u32 offset)
+{
+  return FontViewContains(view, offset, 1) ? view.data[offset] : 0;
+}
+
+u16 ViewU16(FontView view, u32 offset)
+{
+  return FontViewContains(view, offset, 2) ? READ_BIG_ENDIAN_U16(&view.data[offset]) : 0;
+}
+
+i16 ViewI16(FontView view, u32 offset)
+{
+  return FontViewContains(view, offset, 2) ? READ_BIG_ENDIAN_I16(&view.data[offset]) : 0;
+}
+
+u32 ViewU32(FontView view, u32 offset)
+{
+  return FontViewContains(view, offset, 4) ? READ_BIG_ENDIAN_U32(&view.data[offset]) : 0;
+}
+
+// Sequential reader for parsers that decode whole structures. CursorReserve is the only range check: it is
+// called once with the size of a structure (or of an array) and the reads that follow are unchecked, except
+// for an assert in debug and fuzz builds that catches a reserve that was too small.
+typedef struct {
+  u8 *at;
+  u8 *end;
+} FontCursor;
+
+#if DEBUG || FUZZ
+#define CURSOR_ASSERT(cursor, size) assert((u32)((cursor)->end - (cursor)->at) >= (u32)(size))
+#else
+#define CURSOR_ASSERT(cursor, size)
+#endif
+
+FontCursor MakeFontCursor(FontView view, u32 offset)
+{
+  FontCursor cursor = { view.data + (offset < view.length ? offset : view.length), view.data + view.length };
+  return cursor;
+}
+
+u32 CursorRemaining(FontCursor *cursor)
+{
+  return (u32)(cursor->end - cursor->at);
+}
+
+// Returns 0 when fewer than size bytes are left, the parser must then stop reading.
+i32 CursorReserve(FontCursor *cursor, u64 size)
+{
+  return size <= CursorRemaining(cursor);
+}
+
+void CursorSkip(FontCursor *cursor, u32 size)
+{
+  CURSOR_ASSERT(cursor, size);
+  cursor->at += size;
+}
+
+u16 CursorU16(FontCursor *cursor)
+{
+  CURSOR_ASSERT(cursor, 2);
+  u16 value = READ_BIG_ENDIAN_U16(cursor->at);
+  cursor->at += 2;
+  return value;
+}
+
+u32 CursorU32(FontCursor *cursor)
+{
+  CURSOR_ASSERT(cursor, 4);
+  u32 value = READ_BIG_ENDIAN_U32(cursor->at);
+  cursor->at += 4;
+  return value;
+}
+
+void CursorU16Array(FontCursor *cursor, u16 *destination, u32 count)
+{
+  CURSOR_ASSERT(cursor, count * 2);
+  ReadBigEndianU16Array(destination, cursor->at, (i32)count);
+  cursor->at += count * 2;
+}
+
+void CursorU32Array(FontCursor *cursor, u32 *destination, u32 count)
+{
+  CURSOR_ASSERT(cursor, count * 4);
+  ReadBigEndianU32Array(destination, cursor->at, (i32)count);
+  cursor->at += count * 4;
+}
+
+// Largest power of two <= value, for the searchRange fields. value must not be 0.
+u32 FloorPowerOfTwo(u32 value)
+{
+  u32 power = 1;
+  while (power <= value / 2) power *= 2;
+  return power;
+}
+
+typedef enum {
+  TRUETYPE    = 0x00010000, // The font contains TrueType outlines.
+  TRUETYPE_EX = 0x74727565,
+  OPENTYPE    = 0x4F54544F, // The font contains Compact Font Format data (version 1 or 2), structured like in Adobe Tech Note 5176 & 5177.
+  POSTSCRIPT  = 0x74797031,
+} ScalableFontType;
+
+typedef union {
+  char string[4];
+  u32 value;
+} Tag;
+
+typedef struct {
+  Tag tag; // Table tags are the names given to tables in the OpenType font file.
+  u32 checksum;
+  u32 offset;
+  u32 length;
+} TableRecord;
+
+typedef struct {
+  ScalableFontType scalableFontType;
+  u16 numTables;
+  u16 searchRange; // = (2^floor(log2(numTables))) * 16; Provides the largest number of items that can be searched with that constraint.
+  u16 entrySelector; // = log2(searchRange / 16); Indicates the maximum number of levels into the binary tree will need to be entered.
+  u16 rangeShift; // = numTables * 16 - searchRange; Provides the remaining number of items that would also need to be searched.
+  TableRecord *tableRecords; // Must be sorted in ascending order by tag (case-sensitive).
+} TableDirectory;
+
+typedef struct {
+  Tag ttcTag;
+  u16 majorVersion; // = 1
+  u16 minorVersion; // = 0
+  u32 numFonts;
+  u32 *tableDirectoryOffsets; // size = numFonts * sizeof(u32 *)
+} TrueTypeCollectionHeaderV1;
+
+typedef struct {
+  Tag ttcTag;
+  u16 majorVersion; // = 2
+  u16 minorVersion; // = 0
+  u32 numFonts;
+  u32 *tableDirectoryOffsets; // size = numFonts * sizeof(u32 *)
+  u32 dsigTag; // = 0x044534947 or 'DSIG'; Tag indicating that a DSIG table exists. Null if no signature.
+  u32 dsigLength; // Null if no signature.
+  u32 dsigOffset; // Null if no signature.
+} TrueTypeCollectionHeaderV2;
+
+typedef enum {
+  UNICODE_ENCODING,
+  MACINTOSH_ENCODING,
+  ISO_ENCODING, //WARNING: Deprecated.
+  MICROSOFT_ENCODING,
+  CUSTOM_ENCODING,
+} EncodingPlatformID;
+
+typedef enum {
+  UNICODE_ENCODING_V1, //WARNING: Deprecated.
+  UNICODE_ENCODING_V1_1, //WARNING: Deprecated.
+  ISO_IEC_10646, //WARNING: Deprecated.
+  UNICODE_ENCODING_V2_BMP_ONLY, // For use with subtable format 4 or 6.
+  UNICODE_ENCODING_V2_FULL, // For use with subtable format 10 or 12.
+  UNICODE_ENCODING_VARIATION_SEQUENCES, // For use with subtable format 14.
+  UNICODE_FULL, // For use with subtable format 13.
+} UnicodeEncodingPlatformSpecificID; // platformID = 0
+
+typedef enum {
+  ROMAN_ENCODING,
+  JAPANESE_ENCODING,
+  CHINESE_TRADITIONAL_ENCODING,
+  KOREAN_ENCODING,
+  ARABIC_ENCODING,
+  HEBREW_ENCODING,
+  GREEK_ENCODING,
+  RUSSIAN_ENCODING,
+  RSYMBOL_ENCODING,
+  DEVANAGARI_ENCODING,
+  GURMUKHI_ENCODING,
+  GUJARATI_ENCODING,
+  ODIA_ENCODING,
+  BANGLA_ENCODING,
+  TAMIL_ENCODING,
+  TELUGU_ENCODING,
+  KANNADA_ENCODING,
+  MALAYALAM_ENCODING,
+  SINHALESE_ENCODING,
+  BURMESE_ENCODING,
+  KHMER_ENCODING,
+  THAI_ENCODING,
+  LAOTIAN_ENCODING,
+  GEORGIAN_ENCODING,
+  ARMENIAN_ENCODING,
+  CHINESE_SIMPLIFIED_ENCODING,
+  TIBETAN_ENCODING,
+  MOGOLIAN_ENCODING,
+  GEEZ_ENCODING,
+  SLAVIC_ENCODING,
+  VIETNAMESE_ENCODING,
+  SINDHI_ENCODING,
+  UNINTERPRETED_ENCODING,
+} MacintoshEncodingPlatformSpecificID; // platformID = 1
+
+typedef enum {
+  SYMBOL_ENCODING,
+  UNICODE_BMP_ENCODING, // For use with subtable format 4. WARNING: Must not be used to support Unicode supplementary-plane characters.
+  SHIFTJIS_ENCODING,
+  PRC_ENCODING,
+  BIG5_ENCODING,
+  WANSUNG_ENCODING,
+  JOHAB_ENCODING,
+  UNICODE_FULL_ENCODING = 10,
+} WindowsEncodingPlatformSpecificID; // platformID = 3
+
+typedef struct {
+  union {
+    EncodingPlatformID _;
+    u16 value;
+  } platformID;
+  union {
+    UnicodeEncodingPlatformSpecificID unicode;
+    MacintoshEncodingPlatformSpecificID macintosh;
+    WindowsEncodingPlatformSpecificID windows;
+    u16 value;
+  } platformSpecificID;
+  u32 offset;
+} EncodingRecord;
+
+typedef struct {
+  u16 version;
+  u16 numTables;
+  EncodingRecord *encodingRecords;
+} CodepointMapTableHeader; // Indicates the character encodings for which subtables are present.
+
+typedef struct {
+  u16 length;
+  u16 language;
+  u8 glyphIdArray[256];
+} CodepointMapFormat0; // Used on older Macintosh platforms but not required on newer Apple platforms.
+
+typedef struct {
+  u16 length;
+  u16 language;
+  u16 segCountX2;
+  u16 searchRange; // = (2^floor(log2(segCount))) * 2; Provides the largest number of items that can be searched with that constraint.
+  u16 entrySelector; // = log2(searchRange / 2); Indicates the maximum number of levels into the binary tree will need to be entered.
+  u16 rangeShift; // = (segCount * 2) - searchRange; Provides the remaining number of items that would also need to be searched.
+  u16 *endCode; // End characterCode for each segment, last=0xFFFF.
+  u16 reservedPad; // = 0
+  u16 *startCode; // Start character code for each segment.
+  u16 *idDelta; // Delta for all character codes in segment.
+  u16 *idRangeOffset; // Offsets into glyphIdArray or 0
+  u16 *glyphIdArray;
+} CodepointMapFormat4; // For fonts that support only Unicode Basic Multilingual Plane characters (U+0000 to U+FFFF).
+/*
+  WARNING:
+  In early implementations on devices with limited hardware capabilities, optimizations provided by the searchRange, entrySelector and
+  rangeShift fields were of high importance. They have less importance on modern devices but could still be used in some implementations.
+  However, incorrect values could potentially be used as an attack vector against some implementations. Since these values can be derived
+  from the segCountX2 field when the file is parsed, it is strongly recommended that parsing implementations not rely on the searchRange,
+  entrySelector and rangeShift fields in the font but derive them independently from segCountX2. Font files, however, should continue to
+  provide valid values for these fields to maintain compatibility with all existing implementations.
+*/
+
+typedef struct {
+  u32 startCharCode; // First character code in this group.
+  u32 endCharCode; // Last character code in this group.
+  u32 startGlyphID; // Glyph index corresponding to the starting character code, or to every character code for format 13.
+} SequentialMapGroup;
+
+typedef struct {
+  u16 reserved; // = 0
+  u32 length; // Byte length of this subtable (including the header).
+  u32 language;
+  u32 numGroups;
+  SequentialMapGroup *groups; // Sorted in ascending order by startCharCode, must not overlap.
+} CodepointMapFormat12; // For fonts supporting Unicode supplementary-plane characters (U+10000 to U+10FFFF).
+
+typedef CodepointMapFormat12 CodepointMapFormat13; // Same layout, maps every character of a group to the same glyph (last-resort fonts).
+
+typedef struct {
+  u16 format;
+  u16 padding; // = 0
+  union {
+    CodepointMapFormat0 *format0;
+    CodepointMapFormat4 *format4;
+    CodepointMapFormat12 *format12;
+    CodepointMapFormat13 *format13;
+  } value;
+} CodepointMapSubtable;
+
+typedef struct {
+  CodepointMapTableHeader *header;
+  CodepointMapSubtable *subtable;
+} CodepointMapTable;
+
+typedef struct {
+  u16 majorVersion; // = 1
+  u16 minorVersion; // = 0
+  u32 fontRevision; // Fixed 16.16, set by font manufacturer.
+  u32 checksumAdjustment; // = 0xB1B0AFBA - sum of the entire font, computed with this field set to 0.
+  u32 magicNumber; // = 0x5F0F3CF5
+  u16 flags;
+  u16 unitsPerEm; // Valid range is from 16 to 16384.
+  i64 created; // Seconds since 12:00 midnight, January 1, 1904, UTC.
+  i64 modified;
+  i16 xMin; // Bounding box for all glyph bounding boxes.
+  i16 yMin;
+  i16 xMax;
+  i16 yMax;
+  u16 macStyle;
+  u16 lowestRecPPEM; // Smallest readable size in pixels.
+  i16 fontDirectionHint; //WARNING: Deprecated (Set to 2).
+  i16 indexToLocFormat; // 0 for short offsets (Offset16), 1 for long (Offset32).
+  i16 glyphDataFormat; // = 0
+} FontHeaderTable; // 'head'
+
+typedef struct {
+  u32 version; // = 0x00005000 for CFF outlines (only numGlyphs is present), 0x00010000 for TrueType outlines.
+  u16 numGlyphs;
+  u16 maxPoints; // Maximum points in a non-composite glyph.
+  u16 maxContours; // Maximum contours in a non-composite glyph.
+  u16 maxCompositePoints; // Maximum points in a composite glyph.
+  u16 maxCompositeContours; // Maximum contours in a composite glyph.
+  u16 maxZones;
+  u16 maxTwilightPoints;
+  u16 maxStorage;
+  u16 maxFunctionDefs;
+  u16 maxInstructionDefs;
+  u16 maxStackElements;
+  u16 maxSizeOfInstructions;
+  u16 maxComponentElements; // Maximum number of components referenced at "top level" for any composite glyph.
+  u16 maxComponentDepth; // Maximum levels of recursion; 1 for simple components.
+} MaximumProfileTable; // 'maxp'
+
+// view starts at the directory, for collections at the offset of the face.
+TableDirectory *ReadTableDirectory(Arena *arena, FontView view)
+{
+  FontCursor cursor = MakeFontCursor(view, 0);
+  if (!CursorReserve(&cursor, 12)) return NULL;
+
+  TableDirectory *fontDirectory = (TableDirectory *)Alloc(arena, sizeof(TableDirectory));
+  fontDirectory->scalableFontType = CursorU32(&cursor);
+  fontDirectory->numTables = CursorU16(&cursor);
+  fontDirectory->searchRange = CursorU16(&cursor);
+  fontDirectory->entrySelector = CursorU16(&cursor);
+  fontDirectory->rangeShift = CursorU16(&cursor);
+
+  u16 numTables = fontDirectory->numTables;
+  if (numTables == 0) return NULL;
+  u32 searchRange = FloorPowerOfTwo(numTables) * 16;
+  if (fontDirectory->searchRange != searchRange ||
+      fontDirectory->entrySelector != CountTrailingZeros(searchRange / 16) ||
+      fontDirectory->rangeShift != numTables * 16 - searchRange)
+  {
+    return NULL;
+  }
+
+  // TableRecord is four u32s, same as the file layout.
+  if (!CursorReserve(&cursor, numTables * sizeof(TableRecord))) return NULL;
+  fontDirectory->tableRecords = (TableRecord *)AllocNoZero(arena, numTables * sizeof(TableRecord));
+  CursorU32Array(&cursor, (u32 *)fontDirectory->tableRecords, numTables * 4);
+  return fontDirectory;
+}
+
+typedef enum {
+  FONT_TABLE_CMAP,
+  FONT_TABLE_HEAD,
+  FONT_TABLE_HHEA,
+  FONT_TABLE_HMTX,
+  FONT_TABLE_MAXP,
+  FONT_TABLE_NAME,
+  FONT_TABLE_OS2,
+  FONT_TABLE_POST,
+  FONT_TABLE_CVT,
+  FONT_TABLE_FPGM,
+  FONT_TABLE_GLYF,
+  FONT_TABLE_LOCA,
+  FONT_TABLE_PREP,
+  FONT_TABLE_GASP,
+  FONT_TABLE_CFF,
+  FONT_TABLE_CFF2,
+  FONT_TABLE_VORG,
+  FONT_TABLE_KERN,
+  FONT_TABLE_GDEF,
+  FONT_TABLE_GPOS,
+  FONT_TABLE_GSUB,
+  FONT_TABLE_FVAR,
+  FONT_TABLE_GVAR,
+  FONT_TABLE_AVAR,
+  FONT_TABLE_HVAR,
+  FONT_TABLE_STAT,
+  FONT_TABLE_DSIG,
+  FONT_TABLE_COUNT,
+} FontTable; // Tables resolved once at load time, see GetFontTable.
+
+char fontTableTags[FONT_TABLE_COUNT][5] = {
+  "cmap", "head", "hhea", "hmtx", "maxp", "name", "OS/2", "post",
+  "cvt ", "fpgm", "glyf", "loca", "prep", "gasp",
+  "CFF ", "CFF2", "VORG",
+  "kern", "GDEF", "GPOS", "GSUB",
+  "fvar", "gvar", "avar", "HVAR", "STAT", "DSIG",
+};
+
+// WOFF files, see woff.c.
+typedef struct WoffFont WoffFont;
+
+typedef struct {
+  MappedFile file;
+  FontView view;
+  TableDirectory *directory; // For WOFF files, the directory of the sfnt they decode to.
+  i32 sortedDirectory; // Table records are in ascending tag order as the spec requires, unsorted directories are scanned linearly.
+  FontView tables[FONT_TABLE_COUNT]; // Empty views for missing tables.
+  WoffFont *woff; // NULL for sfnt files.
+  u32 pendingTables; // Bit per FontTable of the WOFF tables not inflated yet.
+} Font;
+
+i32 LoadWoffFromMemory(Arena *arena, Font *font);
+FontView GetWoffTable(Font *font, TableRecord *tableRecord);
+
+// Binary search over the directory, falls back to a linear scan when the records are not sorted.
+TableRecord *FindTableRecord(Font *font, u32 tag)
+{
+  TableDirectory *directory = font->directory;
+  if (!directory) return NULL;
+
+  if (!font->sortedDirectory)
+  {
+    for (i32 i = 0; i < directory->numTables; ++i)
+    {
+      if (directory->tableRecords[i].tag.value == tag) return &directory->tableRecords[i];
+    }
+    return NULL;
+  }
+
+  i32 low = 0, high = directory->numTables - 1;
+  while (low <= high)
+  {
+    i32 middle = (low + high) / 2;
+    u32 middleTag = directory->tableRecords[middle].tag.value;
+    if (middleTag == tag) return &directory->tableRecords[middle];
+    if (middleTag < tag) low = middle + 1;
+    else high = middle - 1;
+  }
+  return NULL;
+}
+
+// Checks the record order and resolves the views of every table in fontTableTags, WOFF tables are only
+// marked pending.
+void BuildFontTableIndex(Font *font)
+{
+  TableDirectory *directory = font->directory;
+  font->sortedDirectory = 1;
+  for (i32 i = 1; i < directory->numTables; ++i)
+  {
+    if (directory->tableRecords[i - 1].tag.value >= directory->tableRecords[i].tag.value)
+    {
+      font->sortedDirectory = 0;
+      fprintf(stderr, "Table directory is not sorted by tag, falling back to linear lookups\n");
+      break;
+    }
+  }
+
+  for (i32 i = 0; i < FONT_TABLE_COUNT; ++i)
+  {
+    TableRecord *tableRecord = FindTableRecord(font, READ_BIG_ENDIAN_U32(fontTableTags[i]));
+    FontView empty = {0};
+    font->tables[i] = tableRecord && !font->woff ? FontSubView(font->view, tableRecord->offset, tableRecord->length) : empty;
+    if (tableRecord && font->woff) font->pendingTables |= 1u << i;
+  }
+}
+
+FontView GetFontTable(Font *font, FontTable table)
+{
+  if (font->pendingTables & (1u << table))
+  {
+    font->pendingTables &= ~(1u << table);
+    font->tables[table] = GetWoffTable(font, FindTableRecord(font, READ_BIG_ENDIAN_U32(fontTableTags[table])));
+  }
+  return font->tables[table];
+}
+
+// The font keeps pointing at data, which must outlive it, and for WOFF files at arena, which receives their
+// tables as they are inflated. Returns 0 when the directory is invalid.
+i32 LoadFontFromMemory(Arena *arena, void *data, size_t size, Font *font)
+{
+  memset(font, 0, sizeof(Font));
+  font->view = MakeFontView(data, size);
+  PROFILE_BEGIN(ReadTableDirectory);
+  if (ViewU32(font->view, 0) == READ_BIG_ENDIAN_U32("wOFF")) LoadWoffFromMemory(arena, font);
+  else font->directory = ReadTableDirectory(arena, font->view);
+  PROFILE_END(ReadTableDirectory);
+  if (!font->directory) return 0;
+
+  PROFILE_BEGIN(BuildFontTableIndex);
+  BuildFontTableIndex(font);
+  PROFILE_END(BuildFontTableIndex);
+  return 1;
+}
+
+i32 LoadFont(Arena *arena, char *filePath, Font *font)
+{
+  memset(font, 0, sizeof(Font));
+  MappedFile file;
+  PROFILE_BEGIN(MapWholeFile);
+  i32 mapped = MapWholeFile(filePath, &file);
+  PROFILE_END(MapWholeFile);
+  if (!mapped) return 0;
+
+  if (!LoadFontFromMemory(arena, file.data, file.size, font))
+  {
+    fprintf(stderr, "Failed to parse font directory of %s\n", filePath);
+    UnmapWholeFile(&file);
+    return 0;
+  }
+
+  font->file = file;
+  return 1;
+}
+
+void UnloadFont(Font *font)
+{
+  UnmapWholeFile(&font->file);
+  memset(font, 0, sizeof(Font));
+}
+
+// V1 headers are returned with the DSIG fields left at 0. Returns NULL when the view is not a collection.
+TrueTypeCollectionHeaderV2 *ReadTrueTypeCollectionHeader(Arena *arena, FontView view)
+{
+  if (ViewU32(view, 0) != READ_BIG_ENDIAN_U32("ttcf")) return NULL;
+
+  u16 majorVersion = ViewU16(view, 4);
+  u32 numFonts = ViewU32(view, 8);
+  if ((majorVersion != 1 && majorVersion != 2) || numFonts == 0 || numFonts > (view.length - 12) / 4)
+  {
+    fprintf(stderr, "Invalid collection header, version %d with %u fonts\n", majorVersion, numFonts);
+    return NULL;
+  }
+
+  TrueTypeCollectionHeaderV2 *header = (TrueTypeCollectionHeaderV2 *)Alloc(arena, sizeof(TrueTypeCollectionHeaderV2));
+  header->ttcTag.value = ViewU32(view, 0);
+  header->majorVersion = majorVersion;
+  header->minorVersion = ViewU16(view, 6);
+  header->numFonts = numFonts;
+  header->tableDirectoryOffsets = (u32 *)AllocNoZero(arena, numFonts * sizeof(u32));
+  ReadBigEndianU32Array(header->tableDirectoryOffsets, &view.data[12], (i32)numFonts);
+
+  if (majorVersion == 2)
+  {
+    u32 dsigOffset = 12 + numFonts * 4;
+    header->dsigTag = ViewU32(view, dsigOffset);
+    header->dsigLength = ViewU32(view, dsigOffset + 4);
+    header->dsigOffset = ViewU32(view, dsigOffset + 8);
+  }
+  return header;
+}
+
+// Returns an empty view when the table is missing or its record points outside of the file.
+// Prefer GetFontTable for the tables listed in fontTableTags.
+FontView GetTableView(Font *font, u32 tag)
+{
+  FontView tableView = {0};
+  TableRecord *tableRecord = FindTableRecord(font, tag);
+  if (tableRecord) tableView = font->woff ? GetWoffTable(font, tableRecord) : FontSubView(font->view, tableRecord->offset, tableRecord->length);
+  return tableView;
+}
+
+FontHeaderTable *ReadFontHeaderTable(Arena *arena, FontView head)
+{
+  if (head.length < 54 || ViewU32(head, 12) != 0x5F0F3CF5)
+  {
+    return NULL;
+  }
+
+  FontHeaderTable *fontHeader = (FontHeaderTable *)Alloc(arena, sizeof(FontHeaderTable));
+  fontHeader->majorVersion = ViewU16(head, 0);
+  fontHeader->minorVersion = ViewU16(head, 2);
+  fontHeader->fontRevision = ViewU32(head, 4);
+  fontHeader->checksumAdjustment = ViewU32(head, 8);
+  fontHeader->magicNumber = ViewU32(head, 12);
+  fontHeader->flags = ViewU16(head, 16);
+  fontHeader->unitsPerEm = ViewU16(head, 18);
+  fontHeader->created = (i64)((u64)ViewU32(head, 20) << 32 | ViewU32(head, 24));
+  fontHeader->modified = (i64)((u64)ViewU32(head, 28) << 32 | ViewU32(head, 32));
+  fontHeader->xMin = ViewI16(head, 36);
+  fontHeader->yMin = ViewI16(head, 38);
+  fontHeader->xMax = ViewI16(head, 40);
+  fontHeader->yMax = ViewI16(head, 42);
+  fontHeader->macStyle = ViewU16(head, 44);
+  fontHeader->lowestRecPPEM = ViewU16(head, 46);
+  fontHeader->fontDirectionHint = ViewI16(head, 48);
+  fontHeader->indexToLocFormat = ViewI16(head, 50);
+  fontHeader->glyphDataFormat = ViewI16(head, 52);
+  return fontHeader;
+}
+
+MaximumProfileTable *ReadMaximumProfileTable(Arena *arena, FontView maxp)
+{
+  u32 version = ViewU32(maxp, 0);
+  if (maxp.length < 6 || (version == 0x00010000 && maxp.length < 32))
+  {
+    return NULL;
+  }
+
+  // Version 0.5 stops after numGlyphs, the other fields stay 0.
+  MaximumProfileTable *maximumProfile = (MaximumProfileTable *)Alloc(arena, sizeof(MaximumProfileTable));
+  maximumProfile->version = version;
+  maximumProfile->numGlyphs = ViewU16(maxp, 4);
+  if (version == 0x00010000)
+  {
+    ReadBigEndianU16Array(&maximumProfile->maxPoints, &maxp.data[6], 13);
+  }
+  return maximumProfile;
+}
+
+CodepointMapTableHeader *ReadCodepointMapTableHeader(Arena *arena, FontView cmap)
+{
+  FontCursor cursor = MakeFontCursor(cmap, 0);
+  if (!CursorReserve(&cursor, 4)) return NULL;
+
+  CodepointMapTableHeader *codepointMapTable = (CodepointMapTableHeader *)Alloc(arena, sizeof(CodepointMapTableHeader));
+  codepointMapTable->version = CursorU16(&cursor);
+  codepointMapTable->numTables = CursorU16(&cursor);
+
+  i32 numTables = codepointMapTable->numTables;
+  if (!CursorReserve(&cursor, numTables * 8)) return NULL;
+  codepointMapTable->encodingRecords = (EncodingRecord *)Alloc(arena, numTables * sizeof(EncodingRecord));
+  for (i32 i = 0; i < numTables; ++i)
+  {
+    EncodingRecord *encodingRecord = &codepointMapTable->encodingRecords[i];
+    encodingRecord->platformID.value = CursorU16(&cursor);
+    encodingRecord->platformSpecificID.value = CursorU16(&cursor);
+    encodingRecord->offset = CursorU32(&cursor);
+  }
+
+  return codepointMapTable;
+}
+
+// subtable starts at the format field, array counts are clamped to the bytes it actually holds.
+CodepointMapSubtable *ReadCodepointMapSubtable(Arena *arena, FontView subtable)
+{
+  FontCursor cursor = MakeFontCursor(subtable, 0);
+  if (!CursorReserve(&cursor, 2)) return NULL;
+
+  CodepointMapSubtable *codepointMapSubtable;
+  u16 format = CursorU16(&cursor);
+  switch (format)
+  {
+    case 0: {
+      if (!CursorReserve(&cursor, 4 + 256)) return NULL;
+      codepointMapSubtable = (CodepointMapSubtable *)Alloc(arena, sizeof(CodepointMapSubtable));
+      codepointMapSubtable->format = format;
+      codepointMapSubtable->value.format0 = (CodepointMapFormat0 *)Alloc(arena, sizeof(CodepointMapFormat0));
+      
+      CodepointMapFormat0 *format0 = codepointMapSubtable->value.format0;
+      format0->length = CursorU16(&cursor);
+      format0->language = CursorU16(&cursor);
+      memcpy(format0->glyphIdArray, cursor.at, 256);
+      CursorSkip(&cursor, 256);
+    } break;
+    
+    case 4: {
+      if (!CursorReserve(&cursor, 12)) return NULL;
+      u16 length = CursorU16(&cursor);
+      u16 language = CursorU16(&cursor);
+      u16 segCountX2 = CursorU16(&cursor);
+      CursorSkip(&cursor, 6);
+
+      // 14 bytes of header, 4 segment arrays and the reservedPad come before glyphIdArray.
+      u16 segCount = segCountX2 / 2;
+      if (segCount == 0 || !CursorReserve(&cursor, segCount * 8 + 2)) return NULL;
+      i32 glyphIdCount = ((i32)length - 16 - segCount * 8) / 2;
+      i32 availableGlyphIds = (i32)(CursorRemaining(&cursor) - segCount * 8 - 2) / 2;
+      if (glyphIdCount > availableGlyphIds) glyphIdCount = availableGlyphIds;
+      if (glyphIdCount < 0) glyphIdCount = 0;
+
+      codepointMapSubtable = (CodepointMapSubtable *)Alloc(arena, sizeof(CodepointMapSubtable));
+      codepointMapSubtable->format = format;
+      codepointMapSubtable->value.format4 = (CodepointMapFormat4 *)Alloc(arena, sizeof(CodepointMapFormat4));
+
+      // length is rewritten to what was read, GetFormat4GlyphIdCount bounds lookups with it.
+      CodepointMapFormat4 *format4 = codepointMapSubtable->value.format4;
+      format4->length = (u16)(16 + segCount * 8 + glyphIdCount * 2);
+      format4->language = language;
+      format4->segCountX2 = segCount * 2;
+      format4->searchRange = (u16)(FloorPowerOfTwo(segCount) * 2);
+      format4->entrySelector = (u16)CountTrailingZeros(format4->searchRange / 2);
+      format4->rangeShift = (u16)(segCount * 2 - format4->searchRange);
+
+      format4->endCode = (u16 *)Alloc(arena, (segCount * 4 + glyphIdCount) * sizeof(u16) + SIMD_PADDING);
+      format4->startCode = format4->endCode + segCount;
+      format4->idDelta = format4->startCode + segCount;
+      format4->idRangeOffset = format4->idDelta + segCount;
+      format4->glyphIdArray = format4->idRangeOffset + segCount;
+
+      // startCode, idDelta, idRangeOffset and glyphIdArray follow each other after reservedPad.
+      CursorU16Array(&cursor, format4->endCode, segCount);
+      CursorSkip(&cursor, 2);
+      CursorU16Array(&cursor, format4->startCode, segCount * 3 + glyphIdCount);
+    } break;
+
+    case 12: case 13: {
+      if (!CursorReserve(&cursor, 14)) return NULL;
+      codepointMapSubtable = (CodepointMapSubtable *)Alloc(arena, sizeof(CodepointMapSubtable));
+      codepointMapSubtable->format = format;
+      codepointMapSubtable->value.format12 = (CodepointMapFormat12 *)Alloc(arena, sizeof(CodepointMapFormat12));
+
+      CodepointMapFormat12 *format12 = codepointMapSubtable->value.format12;
+      format12->reserved = CursorU16(&cursor);
+      format12->length = CursorU32(&cursor);
+      format12->language = CursorU32(&cursor);
+      format12->numGroups = CursorU32(&cursor);
+
+      // Never trust numGroups beyond what the subtable length and the view can hold.
+      u32 maxGroups = format12->length >= 16 ? (format12->length - 16) / sizeof(SequentialMapGroup) : 0;
+      u32 availableGroups = CursorRemaining(&cursor) / sizeof(SequentialMapGroup);
+      if (maxGroups > availableGroups) maxGroups = availableGroups;
+      if (format12->numGroups > maxGroups) format12->numGroups = maxGroups;
+
+      // SequentialMapGroup is three u32s, same as the file layout.
+      format12->groups = (SequentialMapGroup *)AllocNoZero(arena, format12->numGroups * sizeof(SequentialMapGroup));
+      CursorU32Array(&cursor, (u32 *)format12->groups, format12->numGroups * 3);
+    } break;
+    
+    default: {
+      fprintf(stderr, "Failed to read the codepoint map subtable\n,");
+      return NULL;
+    } break;
+  }
+  
+  return codepointMapSubtable;
+}
+
+#if DEBUG
+void PrintTableDirectory(TableDirectory *fontDirectory)
+{
+  printf("-- Font directory\nScalable font type: ");
+  switch (fontDirectory->scalableFontType)
+  {
+    CASE_PRINT_ENUM(TRUETYPE); break;
+    CASE_PRINT_ENUM(OPENTYPE); break;
+    CASE_PRINT_ENUM(POSTSCRIPT); break;
+    default: printf("\n"); break;
+  }
+  
+  TableRecord *tableRecords = fontDirectory->tableRecords;
+  i32 numTables = fontDirectory->numTables;
+  for (i32 i = 0; i < numTables; ++i)
+  {
+    TableRecord *tableRecord = &tableRecords[i];
+    printf("%c%c%c%c %d %d\n",
+           tableRecord->tag.string[3],
+           tableRecord->tag.string[2],
+           tableRecord->tag.string[1],
+           tableRecord->tag.string[0],
+           tableRecord->length,
+           tableRecord->offset);
+  }
+}
+
+void PrintCodepointMapTableHeader(CodepointMapTableHeader *codepointMapTable)
+{
+  printf("-- Codepoint map\n");
+  i32 numTables = codepointMapTable->numTables;
+	for (i32 i = 0; i < numTables; ++i)
+	{
+		EncodingRecord* encodingRecord = &codepointMapTable->encodingRecords[i];
+		printf("%d:\n  platformID: ", i);
+		switch (encodingRecord->platformID.value)
+		{
+      case UNICODE_ENCODING: {
+    		printf("UNICODE_ENCODING\n  platformSpecificID: ");
+    		switch(encodingRecord->platformSpecificID.unicode)
+    		{
+          CASE_PRINT_ENUM(UNICODE_ENCODING_V1); break;
+          CASE_PRINT_ENUM(UNICODE_ENCODING_V1_1); break;
+          CASE_PRINT_ENUM(ISO_IEC_10646); break;
+          CASE_PRINT_ENUM(UNICODE_ENCODING_V2_BMP_ONLY); break;
+          CASE_PRINT_ENUM(UNICODE_ENCODING_V2_FULL); break;
+          CASE_PRINT_ENUM(UNICODE_ENCODING_VARIATION_SEQUENCES); break;
+          CASE_PRINT_ENUM(UNICODE_FULL); break;
+    			default: fprintf(stderr, "Unrecognizable platformSpecificID\n"); break;
+    		}
+      } break;
+      
+      case MACINTOSH_ENCODING: {
+    		printf("MACINTOSH_ENCODING\n  platformSpecificID: ");
+    		switch(encodingRecord->platformSpecificID.macintosh)
+    		{
+          CASE_PRINT_ENUM(ROMAN_ENCODING); break;
+          CASE_PRINT_ENUM(JAPANESE_ENCODING); break;
+          CASE_PRINT_ENUM(CHINESE_TRADITIONAL_ENCODING); break;
+          CASE_PRINT_ENUM(KOREAN_ENCODING); break;
+          CASE_PRINT_ENUM(ARABIC_ENCODING); break;
+          CASE_PRINT_ENUM(HEBREW_ENCODING); break;
+          CASE_PRINT_ENUM(GREEK_ENCODING); break;
+          CASE_PRINT_ENUM(RUSSIAN_ENCODING); break;
+          CASE_PRINT_ENUM(RSYMBOL_ENCODING); break;
+          CASE_PRINT_ENUM(DEVANAGARI_ENCODING); break;
+          CASE_PRINT_ENUM(GURMUKHI_ENCODING); break;
+          CASE_PRINT_ENUM(GUJARATI_ENCODING); break;
+          CASE_PRINT_ENUM(ODIA_ENCODING); break;
+          CASE_PRINT_ENUM(BANGLA_ENCODING); break;
+          CASE_PRINT_ENUM(TAMIL_ENCODING); break;
+          CASE_PRINT_ENUM(TELUGU_ENCODING); break;
+          CASE_PRINT_ENUM(KANNADA_ENCODING); break;
+          CASE_PRINT_ENUM(MALAYALAM_ENCODING); break;
+          CASE_PRINT_ENUM(SINHALESE_ENCODING); break;
+          CASE_PRINT_ENUM(BURMESE_ENCODING); break;
+          CASE_PRINT_ENUM(KHMER_ENCODING); break;
+          CASE_PRINT_ENUM(THAI_ENCODING); break;
+          CASE_PRINT_ENUM(LAOTIAN_ENCODING); break;
+          CASE_PRINT_ENUM(GEORGIAN_ENCODING); break;
+          CASE_PRINT_ENUM(ARMENIAN_ENCODING); break;
+          CASE_PRINT_ENUM(CHINESE_SIMPLIFIED_ENCODING); break;
+          CASE_PRINT_ENUM(TIBETAN_ENCODING); break;
+          CASE_PRINT_ENUM(MOGOLIAN_ENCODING); break;
+          CASE_PRINT_ENUM(GEEZ_ENCODING); break;
+          CASE_PRINT_ENUM(SLAVIC_ENCODING); break;
+          CASE_PRINT_ENUM(VIETNAMESE_ENCODING); break;
+          CASE_PRINT_ENUM(SINDHI_ENCODING); break;
+          CASE_PRINT_ENUM(UNINTERPRETED_ENCODING); break;
+    			default: fprintf(stderr, "Unrecognizable platformSpecificID\n"); break;
+    		}
+      } break;
+        
+      case MICROSOFT_ENCODING: {
+    		printf("MICROSOFT_ENCODING\n  platformSpecificID: ");
+    		switch(encodingRecord->platformSpecificID.windows)
+    		{
+          CASE_PRINT_ENUM(SYMBOL_ENCODING); break;
+          CASE_PRINT_ENUM(UNICODE_BMP_ENCODING); break;
+          CASE_PRINT_ENUM(SHIFTJIS_ENCODING); break;
+          CASE_PRINT_ENUM(PRC_ENCODING); break;
+          CASE_PRINT_ENUM(BIG5_ENCODING); break;
+          CASE_PRINT_ENUM(WANSUNG_ENCODING); break;
+          CASE_PRINT_ENUM(JOHAB_ENCODING); break;
+          CASE_PRINT_ENUM(UNICODE_FULL_ENCODING); break;
+    			default: fprintf(stderr, "Unrecognizable platformSpecificID\n"); break;
+    		}
+      } break;
+      
+      case ISO_ENCODING: case CUSTOM_ENCODING: default: fprintf(stderr, "Unsupported platformSpecificID\n"); break;
+		}
+		
+		printf("  offset: %d\n", encodingRecord->offset);
+	}
+}
+
+void PrintCodepointMapSubtable(CodepointMapSubtable *codepointMapSubtable)
+{
+  u16 format = codepointMapSubtable->format;
+  switch (format)
+  {
+    case 0: {
+      CodepointMapFormat0 *format0 = codepointMapSubtable->value.format0;
+      u16 length = format0->length;
+      printf("-- Format 0:\nlength: %d\nlanguage: %d\nglyphIdArray:\n", length, format0->language);
+      for (i32 i = 0; i < length; ++i)
+      {
+        printf("%d ", format0->glyphIdArray[i]);
+      }
+      printf("\n");
+    } break;
+
+    case 4: {
+      CodepointMapFormat4 *format4 = codepointMapSubtable->value.format4;
+      i32 segCount = format4->segCountX2 / 2;
+      printf("-- Format 4:\nlength: %d\nlanguage: %d\nsegCount: %d\nsearchRange: %d\nentrySelector: %d\nrangeShift: %d\nSegment ranges:\n",
+             format4->length,
+             format4->language,
+             segCount,
+          	 format4->searchRange,
+          	 format4->entrySelector,
+          	 format4->rangeShift);
+    
+      for (i32 i = 0; i < segCount; ++i)
+      {
+      	printf("[%d]: startCode: %9d endCode: %7d idDelta: %7d idRangeOffset: %12d\n",
+      	       i,
+      	       format4->startCode[i],
+      	       format4->endCode[i],
+      	       format4->idDelta[i],
+      	       format4->idRangeOffset[i]);
+      }
+
+      //TODO: Print glyphIdArray
+    } break;
+
+    case 12: case 13: {
+      CodepointMapFormat12 *format12 = codepointMapSubtable->value.format12;
+      printf("-- Format %d:\nlength: %d\nlanguage: %d\nnumGroups: %d\nGroups:\n",
+             format,
+             format12->length,
+             format12->language,
+             format12->numGroups);
+
+      for (u32 i = 0; i < format12->numGroups; ++i)
+      {
+        SequentialMapGroup *group = &format12->groups[i];
+        printf("[%d]: startCharCode: %7d endCharCode: %7d startGlyphID: %5d\n",
+               i,
+               group->startCharCode,
+               group->endCharCode,
+               group->startGlyphID);
+      }
+    } break;
+  }
+}
+#endif
@@ -0,0 +1,449 @@
+// Precompiled font cache: the parsed state needed to start rendering text (direct-mapped cmap tables,
+// expanded metrics, compiled kerning, head, maxp and the decoded loca offsets) written once as a blob that
+// later runs map and use in place. Sections are addressed by offsets from the start of the blob, so a load
+// only validates them and points the usual structures at the mapping, nothing is decoded or copied.
+//
+// The blob is in host byte order, little-endian on every supported target, with the layout of the
+// structures it holds, the version is bumped whenever one of them changes. It records the size of the
+// source font, head.checksumAdjustment and the sum of the directory's table checksums, which font tools
+// rewrite with the font, and is rebuilt when they no longer match.
+
+#define FONT_CACHE_MAGIC 0x48434C46 // "FLCH" read as a little-endian u32.
+#define FONT_CACHE_VERSION 1
+#define FONT_CACHE_BYTE_ORDER 0xFEFF // Reads 0xFFFE on a host of the other byte order.
+#define FONT_CACHE_SECTION_ALIGNMENT 64
+
+typedef enum {
+  FONT_CACHE_BMP_GLYPH_IDS,
+  FONT_CACHE_PAGE_INDICES,
+  FONT_CACHE_PAGES,
+  FONT_CACHE_HORIZONTAL_HEADER,
+  FONT_CACHE_ADVANCE_WIDTHS,
+  FONT_CACHE_LEFT_SIDE_BEARINGS,
+  FONT_CACHE_KERNING_BUCKETS,
+  FONT_CACHE_KERNING_CLASS_TABLES,
+  FONT_CACHE_KERNING_CLASS_DATA, // Arrays of the class tables.
+  FONT_CACHE_FONT_HEADER,
+  FONT_CACHE_MAXIMUM_PROFILE,
+  FONT_CACHE_GLYPH_OFFSETS, // Empty for fonts without glyf.
+  FONT_CACHE_SECTION_COUNT,
+} FontCacheSectionType;
+
+typedef struct {
+  u32 offset; // From the start of the blob, a multiple of FONT_CACHE_SECTION_ALIGNMENT.
+  u32 size; // Followed by SIMD_PADDING zero bytes for the gathers.
+} FontCacheSection;
+
+typedef struct {
+  u32 magic;
+  u16 version;
+  u16 byteOrder;
+  u32 size; // Of the whole blob.
+  u32 sourceSize;
+  u32 sourceChecksumAdjustment;
+  u32 sourceTableChecksums; // Wrapping sum of the checksums of the table records.
+  u16 numGlyphs;
+  u16 unitsPerEm;
+  u32 pageCount;
+  u32 kerningPairCount;
+  u32 kerningBucketMask;
+  u32 kerningBucketShift;
+  u32 kerningClassTableCount;
+  FontCacheSection sections[FONT_CACHE_SECTION_COUNT];
+} FontCacheHeader;
+
+// KerningClassTable with its arrays as offsets from the start of the blob.
+typedef struct {
+  u16 lookup;
+  u16 class1Count;
+  u16 class2Count;
+  u16 padding; // = 0
+  u32 firstClasses;
+  u32 secondClasses; // Shared by the tables that shared it when compiled.
+  u32 values;
+} FontCacheClassTable;
+
+// textFont and glyphData point into the mapped blob, or into the arena when the cache could not be written
+// and the font was parsed instead. CFF outlines are not cached, their charstrings are read from the font.
+typedef struct {
+  Font font;
+  MappedFile cacheFile;
+  TextFont textFont;
+  GlyphData glyphData;
+} CachedFont;
+
+void GetFontCacheSource(Font *font, FontCacheHeader *header)
+{
+  header->sourceSize = font->view.length;
+  header->sourceChecksumAdjustment = ViewU32(GetFontTable(font, FONT_TABLE_HEAD), 8);
+  header->sourceTableChecksums = 0;
+  for (i32 i = 0; i < font->directory->numTables; ++i)
+  {
+    header->sourceTableChecksums += font->directory->tableRecords[i].checksum;
+  }
+}
+
+void AddFontCacheSection(FontCacheHeader *header, u64 *blobSize, FontCacheSectionType type, u64 size)
+{
+  u64 offset = (*blobSize + FONT_CACHE_SECTION_ALIGNMENT - 1) & ~(u64)(FONT_CACHE_SECTION_ALIGNMENT - 1);
+  header->sections[type].offset = (u32)offset;
+  header->sections[type].size = (u32)size;
+  *blobSize = offset + size + SIMD_PADDING;
+}
+
+void *GetFontCacheSection(u8 *blob, FontCacheHeader *header, FontCacheSectionType type)
+{
+  return blob + header->sections[type].offset;
+}
+
+// Lays out and fills the blob in arena. Returns NULL when the font lacks the tables the cache holds.
+u8 *BuildFontCache(Arena *arena, Font *font, u32 *size)
+{
+  CodepointMap codepointMap;
+  HorizontalMetrics metrics;
+  KerningTable kerning;
+  GlyphData glyphData = {0};
+  FontHeaderTable *fontHeader = ReadFontHeaderTable(arena, GetFontTable(font, FONT_TABLE_HEAD));
+  MaximumProfileTable *maximumProfile = ReadMaximumProfileTable(arena, GetFontTable(font, FONT_TABLE_MAXP));
+  if (!fontHeader || !fontHeader->unitsPerEm || !maximumProfile ||
+      !LoadCodepointMap(arena, font, &codepointMap, CODEPOINT_MAP_BMP_TABLE | CODEPOINT_MAP_PAGE_TABLE) ||
+      !codepointMap.bmpGlyphIds || !codepointMap.pageTable || !LoadHorizontalMetrics(arena, font, &metrics))
+  {
+    return NULL;
+  }
+  LoadKerningTable(arena, font, &kerning);
+  if (GetFontTable(font, FONT_TABLE_GLYF).length && !LoadGlyphData(arena, font, &glyphData)) return NULL;
+
+  FontCacheHeader header = {0};
+  header.magic = FONT_CACHE_MAGIC;
+  header.version = FONT_CACHE_VERSION;
+  header.byteOrder = FONT_CACHE_BYTE_ORDER;
+  GetFontCacheSource(font, &header);
+  header.numGlyphs = metrics.numGlyphs;
+  header.unitsPerEm = fontHeader->unitsPerEm;
+  header.pageCount = (u32)codepointMap.pageTable->pageCount;
+  header.kerningPairCount = kerning.pairCount;
+  header.kerningBucketMask = kerning.bucketMask;
+  header.kerningBucketShift = kerning.bucketShift;
+  header.kerningClassTableCount = (u32)kerning.classTableCount;
+
+  // Class arrays are placed relative to their section first, tables sharing secondClasses store it once.
+  i32 classTableCount = kerning.classTableCount;
+  FontCacheClassTable *classTables = (FontCacheClassTable *)Alloc(arena, (classTableCount + 1) * sizeof(FontCacheClassTable));
+  u64 classDataSize = 0;
+  u64 classArraySize = (u64)header.numGlyphs * sizeof(u16);
+  for (i32 t = 0; t < classTableCount; ++t)
+  {
+    KerningClassTable *table = &kerning.classTables[t];
+    FontCacheClassTable *record = &classTables[t];
+    record->lookup = table->lookup;
+    record->class1Count = table->class1Count;
+    record->class2Count = table->class2Count;
+    record->firstClasses = (u32)classDataSize;
+    classDataSize += classArraySize;
+
+    record->secondClasses = (u32)classDataSize;
+    for (i32 other = 0; other < t; ++other)
+    {
+      if (kerning.classTables[other].secondClasses == table->secondClasses) record->secondClasses = classTables[other].secondClasses;
+    }
+    if (record->secondClasses == classDataSize) classDataSize += classArraySize;
+
+    record->values = (u32)classDataSize;
+    classDataSize += (u64)(table->class1Count + 1) * (table->class2Count + 1) * sizeof(i16);
+  }
+
+  u64 blobSize = sizeof(FontCacheHeader);
+  AddFontCacheSection(&header, &blobSize, FONT_CACHE_BMP_GLYPH_IDS, BMP_GLYPH_TABLE_SIZE * sizeof(u16));
+  AddFontCacheSection(&header, &blobSize, FONT_CACHE_PAGE_INDICES, CODEPOINT_PAGE_COUNT * sizeof(u16));
+  AddFontCacheSection(&header, &blobSize, FONT_CACHE_PAGES, (u64)header.pageCount * CODEPOINT_PAGE_SIZE * sizeof(u16));
+  AddFontCacheSection(&header, &blobSize, FONT_CACHE_HORIZONTAL_HEADER, sizeof(HorizontalHeaderTable));
+  AddFontCacheSection(&header, &blobSize, FONT_CACHE_ADVANCE_WIDTHS, classArraySize);
+  AddFontCacheSection(&header, &blobSize, FONT_CACHE_LEFT_SIDE_BEARINGS, classArraySize);
+  AddFontCacheSection(&header, &blobSize, FONT_CACHE_KERNING_BUCKETS, kerning.pairCount ? (u64)(kerning.bucketMask + 1) * sizeof(KerningBucket) : 0);
+  AddFontCacheSection(&header, &blobSize, FONT_CACHE_KERNING_CLASS_TABLES, classTableCount * sizeof(FontCacheClassTable));
+  AddFontCacheSection(&header, &blobSize, FONT_CACHE_KERNING_CLASS_DATA, classDataSize);
+  AddFontCacheSection(&header, &blobSize, FONT_CACHE_FONT_HEADER, sizeof(FontHeaderTable));
+  AddFontCacheSection(&header, &blobSize, FONT_CACHE_MAXIMUM_PROFILE, sizeof(MaximumProfileTable));
+  AddFontCacheSection(&header, &blobSize, FONT_CACHE_GLYPH_OFFSETS, glyphData.glyphOffsets ? ((u64)header.numGlyphs + 1) * sizeof(u32) : 0);
+  if (blobSize > UINT32_MAX) return NULL;
+  header.size = (u32)blobSize;
+
+  u8 *blob = (u8 *)AllocAlign(arena, blobSize, FONT_CACHE_SECTION_ALIGNMENT);
+  if (!blob) return NULL;
+
+  u32 classDataOffset = header.sections[FONT_CACHE_KERNING_CLASS_DATA].offset;
+  for (i32 t = 0; t < classTableCount; ++t)
+  {
+    KerningClassTable *table = &kerning.classTables[t];
+    FontCacheClassTable *record = &classTables[t];
+    record->firstClasses += classDataOffset;
+    record->secondClasses += classDataOffset;
+    record->values += classDataOffset;
+    memcpy(blob + record->firstClasses, table->firstClasses, classArraySize);
+    memcpy(blob + record->secondClasses, table->secondClasses, classArraySize);
+    memcpy(blob + record->values, table->values, (u64)(table->class1Count + 1) * (table->class2Count + 1) * sizeof(i16));
+  }
+
+  void *sources[FONT_CACHE_SECTION_COUNT] = {
+    codepointMap.bmpGlyphIds, codepointMap.pageTable->pageIndices, codepointMap.pageTable->pages,
+    metrics.horizontalHeader, metrics.advanceWidths, metrics.leftSideBearings,
+    kerning.buckets, classTables, NULL,
+    fontHeader, maximumProfile, glyphData.glyphOffsets,
+  };
+  memcpy(blob, &header, sizeof(FontCacheHeader));
+  for (i32 i = 0; i < FONT_CACHE_SECTION_COUNT; ++i)
+  {
+    if (sources[i] && header.sections[i].size) memcpy(GetFontCacheSection(blob, &header, i), sources[i], header.sections[i].size);
+  }
+
+  *size = header.size;
+  return blob;
+}
+
+// Parses font and writes its cache next to the destination before moving it over, so a reader never maps
+// a partly written blob.
+i32 WriteFontCache(Arena *arena, Font *font, char *cachePath)
+{
+  TmpArena scratch;
+  TmpArenaPush(&scratch, GetScratchArena(arena));
+
+  u32 size = 0;
+  u8 *blob = BuildFontCache(scratch.arena, font, &size);
+  if (!blob)
+  {
+    fprintf(stderr, "Failed to build the font cache %s\n", cachePath);
+    TmpArenaPop(&scratch);
+    return 0;
+  }
+
+  size_t pathLength = strlen(cachePath);
+  char *temporaryPath = (char *)Alloc(scratch.arena, pathLength + 5);
+  memcpy(temporaryPath, cachePath, pathLength);
+  memcpy(temporaryPath + pathLength, ".tmp", 5);
+
+  FILE *file = fopen(temporaryPath, "wb");
+  i32 success = file && fwrite(blob, size, 1, file) == 1;
+  if (file && fclose(file) != 0) success = 0;
+  if (success) success = PlatformReplaceFile(temporaryPath, cachePath);
+  if (!success)
+  {
+    fprintf(stderr, "Failed to write the font cache %s\n", cachePath);
+    if (file) remove(temporaryPath);
+  }
+
+  TmpArenaPop(&scratch);
+  return success;
+}
+
+i32 IsFontCacheArray(FontCacheHeader *header, u32 offset, u64 size, u32 alignment)
+{
+  FontCacheSection section = header->sections[FONT_CACHE_KERNING_CLASS_DATA];
+  return offset % alignment == 0 && offset >= section.offset && offset - section.offset <= section.size &&
+         size <= section.size - (offset - section.offset);
+}
+
+// Returns 1 when every value is below limit, the class and page indices of a blob are checked with it.
+i32 AreU16Below(u16 *values, u32 count, u32 limit)
+{
+  if (limit > UINT16_MAX) return 1;
+  if (!limit) return !count;
+
+  u32 i = 0;
+  i32 above = 0;
+#if SIMD_X86
+  if (GetCpuFeatures()->hasSse2)
+  {
+    // Saturating subtraction leaves non-zero lanes only for values >= limit.
+    __m128i floor = _mm_set1_epi16((short)(limit - 1));
+    __m128i excess = _mm_setzero_si128();
+    for (; i + 8 <= count; i += 8)
+    {
+      excess = _mm_or_si128(excess, _mm_subs_epu16(_mm_loadu_si128((__m128i *)&values[i]), floor));
+    }
+    above = _mm_movemask_epi8(_mm_cmpeq_epi16(excess, _mm_setzero_si128())) != 0xFFFF;
+  }
+#endif
+  for (; i < count; ++i)
+  {
+    above |= values[i] >= limit;
+  }
+  return !above;
+}
+
+// Checks everything a lookup indexes with, so a damaged blob is rebuilt instead of read out of bounds.
+// Glyph offsets are not checked, GetGlyphView bounds them against glyf.
+i32 ValidateFontCache(u8 *blob, u32 size, Font *font)
+{
+  FontCacheHeader *header = (FontCacheHeader *)blob;
+  if (size < sizeof(FontCacheHeader) || header->magic != FONT_CACHE_MAGIC || header->version != FONT_CACHE_VERSION ||
+      header->byteOrder != FONT_CACHE_BYTE_ORDER || header->size != size)
+  {
+    return 0;
+  }
+
+  FontCacheHeader source;
+  GetFontCacheSource(font, &source);
+  if (header->sourceSize != source.sourceSize || header->sourceChecksumAdjustment != source.sourceChecksumAdjustment ||
+      header->sourceTableChecksums != source.sourceTableChecksums)
+  {
+    return 0;
+  }
+
+  u32 bucketCount = header->kerningBucketMask + 1;
+  u64 numGlyphs = header->numGlyphs;
+  u64 expectedSizes[FONT_CACHE_SECTION_COUNT] = {
+    BMP_GLYPH_TABLE_SIZE * sizeof(u16), CODEPOINT_PAGE_COUNT * sizeof(u16), (u64)header->pageCount * CODEPOINT_PAGE_SIZE * sizeof(u16),
+    sizeof(HorizontalHeaderTable), numGlyphs * sizeof(u16), numGlyphs * sizeof(u16),
+    header->kerningPairCount ? (u64)bucketCount * sizeof(KerningBucket) : 0,
+    (u64)header->kerningClassTableCount * sizeof(FontCacheClassTable), header->sections[FONT_CACHE_KERNING_CLASS_DATA].size,
+    sizeof(FontHeaderTable), sizeof(MaximumProfileTable),
+    header->sections[FONT_CACHE_GLYPH_OFFSETS].size ? (numGlyphs + 1) * sizeof(u32) : 0,
+  };
+  for (i32 i = 0; i < FONT_CACHE_SECTION_COUNT; ++i)
+  {
+    FontCacheSection section = header->sections[i];
+    if (section.offset % FONT_CACHE_SECTION_ALIGNMENT || section.size != expectedSizes[i] ||
+        section.offset < sizeof(FontCacheHeader) || (u64)section.offset + section.size + SIMD_PADDING > size)
+    {
+      return 0;
+    }
+  }
+
+  u16 *pageIndices = (u16 *)GetFontCacheSection(blob, header, FONT_CACHE_PAGE_INDICES);
+  if (!header->pageCount || header->pageCount > CODEPOINT_PAGE_COUNT + 1 ||
+      !AreU16Below(pageIndices, CODEPOINT_PAGE_COUNT, header->pageCount))
+  {
+    return 0;
+  }
+
+  // A probe only stops on a bucket whose last key is empty, there must be one.
+  if (header->kerningPairCount)
+  {
+    if (!bucketCount || bucketCount & header->kerningBucketMask || header->kerningBucketShift != 32u - CountTrailingZeros(bucketCount)) return 0;
+    KerningBucket *buckets = (KerningBucket *)GetFontCacheSection(blob, header, FONT_CACHE_KERNING_BUCKETS);
+    u32 openBuckets = 0;
+    for (u32 b = 0; b < bucketCount; ++b)
+    {
+      openBuckets += buckets[b].keys[KERNING_BUCKET_SIZE - 1] == KERNING_EMPTY_KEY;
+    }
+    if (!openBuckets) return 0;
+  }
+
+  FontCacheClassTable *classTables = (FontCacheClassTable *)GetFontCacheSection(blob, header, FONT_CACHE_KERNING_CLASS_TABLES);
+  for (u32 t = 0; t < header->kerningClassTableCount; ++t)
+  {
+    FontCacheClassTable *record = &classTables[t];
+    u64 valueCount = (u64)(record->class1Count + 1) * (record->class2Count + 1);
+    if (!IsFontCacheArray(header, record->firstClasses, numGlyphs * sizeof(u16), sizeof(u16)) ||
+        !IsFontCacheArray(header, record->secondClasses, numGlyphs * sizeof(u16), sizeof(u16)) ||
+        !IsFontCacheArray(header, record->values, valueCount * sizeof(i16), sizeof(i16)) ||
+        !AreU16Below((u16 *)(blob + record->firstClasses), header->numGlyphs, record->class1Count + 1u) ||
+        !AreU16Below((u16 *)(blob + record->secondClasses), header->numGlyphs, record->class2Count + 1u))
+    {
+      return 0;
+    }
+  }
+  return 1;
+}
+
+// cached->font must be loaded. Maps the blob and points textFont and glyphData into it, returns 0 when the
+// blob is stale or invalid and leaves nothing mapped.
+i32 LoadFontCache(Arena *arena, CachedFont *cached, char *cachePath)
+{
+  memset(&cached->textFont, 0, sizeof(TextFont));
+  memset(&cached->glyphData, 0, sizeof(GlyphData));
+  if (!MapWholeFile(cachePath, &cached->cacheFile)) return 0;
+
+  u8 *blob = cached->cacheFile.data;
+  PROFILE_BEGIN(ValidateFontCache);
+  i32 valid = cached->cacheFile.size <= UINT32_MAX && ValidateFontCache(blob, (u32)cached->cacheFile.size, &cached->font);
+  PROFILE_END(ValidateFontCache);
+  if (!valid)
+  {
+    UnmapWholeFile(&cached->cacheFile);
+    return 0;
+  }
+
+  // Both direct tables cover every codepoint, the subtable is an empty format 0 that lookups never reach.
+  FontCacheHeader *header = (FontCacheHeader *)blob;
+  CodepointMap *codepointMap = &cached->textFont.codepointMap;
+  codepointMap->subtable = (CodepointMapSubtable *)Alloc(arena, sizeof(CodepointMapSubtable));
+  codepointMap->subtable->value.format0 = (CodepointMapFormat0 *)Alloc(arena, sizeof(CodepointMapFormat0));
+  codepointMap->bmpGlyphIds = (u16 *)GetFontCacheSection(blob, header, FONT_CACHE_BMP_GLYPH_IDS);
+  codepointMap->pageTable = (CodepointPageTable *)Alloc(arena, sizeof(CodepointPageTable));
+  codepointMap->pageTable->pageIndices = (u16 *)GetFontCacheSection(blob, header, FONT_CACHE_PAGE_INDICES);
+  codepointMap->pageTable->pageCount = (i32)header->pageCount;
+  codepointMap->pageTable->pages = (u16 *)GetFontCacheSection(blob, header, FONT_CACHE_PAGES);
+
+  HorizontalMetrics *metrics = &cached->textFont.metrics;
+  metrics->horizontalHeader = (HorizontalHeaderTable *)GetFontCacheSection(blob, header, FONT_CACHE_HORIZONTAL_HEADER);
+  metrics->numGlyphs = header->numGlyphs;
+  metrics->advanceWidths = (u16 *)GetFontCacheSection(blob, header, FONT_CACHE_ADVANCE_WIDTHS);
+  metrics->leftSideBearings = (i16 *)GetFontCacheSection(blob, header, FONT_CACHE_LEFT_SIDE_BEARINGS);
+
+  KerningTable *kerning = &cached->textFont.kerning;
+  kerning->numGlyphs = header->numGlyphs;
+  kerning->pairCount = header->kerningPairCount;
+  kerning->bucketMask = header->kerningBucketMask;
+  kerning->bucketShift = header->kerningBucketShift;
+  kerning->buckets = (KerningBucket *)GetFontCacheSection(blob, header, FONT_CACHE_KERNING_BUCKETS);
+  kerning->classTableCount = (i32)header->kerningClassTableCount;
+  kerning->classTables = (KerningClassTable *)Alloc(arena, (kerning->classTableCount + 1) * sizeof(KerningClassTable));
+  FontCacheClassTable *classTables = (FontCacheClassTable *)GetFontCacheSection(blob, header, FONT_CACHE_KERNING_CLASS_TABLES);
+  for (i32 t = 0; t < kerning->classTableCount; ++t)
+  {
+    KerningClassTable *table = &kerning->classTables[t];
+    table->lookup = classTables[t].lookup;
+    table->class1Count = classTables[t].class1Count;
+    table->class2Count = classTables[t].class2Count;
+    table->firstClasses = (u16 *)(blob + classTables[t].firstClasses);
+    table->secondClasses = (u16 *)(blob + classTables[t].secondClasses);
+    table->values = (i16 *)(blob + classTables[t].values);
+  }
+  cached->textFont.unitsPerEm = header->unitsPerEm;
+
+  GlyphData *glyphData = &cached->glyphData;
+  glyphData->fontHeader = (FontHeaderTable *)GetFontCacheSection(blob, header, FONT_CACHE_FONT_HEADER);
+  glyphData->maximumProfile = (MaximumProfileTable *)GetFontCacheSection(blob, header, FONT_CACHE_MAXIMUM_PROFILE);
+  if (header->sections[FONT_CACHE_GLYPH_OFFSETS].size)
+  {
+    glyphData->numGlyphs = header->numGlyphs;
+    glyphData->glyphOffsets = (u32 *)GetFontCacheSection(blob, header, FONT_CACHE_GLYPH_OFFSETS);
+    glyphData->glyf = GetFontTable(&cached->font, FONT_TABLE_GLYF);
+  }
+  else if (GetFontTable(&cached->font, FONT_TABLE_CFF).length || GetFontTable(&cached->font, FONT_TABLE_CFF2).length)
+  {
+    glyphData->numGlyphs = header->numGlyphs;
+    glyphData->compactFont = LoadCompactFont(arena, &cached->font);
+    if (!glyphData->compactFont) glyphData->numGlyphs = 0;
+  }
+  return 1;
+}
+
+// Loads the font through its cache, building the cache when it is missing or stale. When the cache cannot
+// be written the font is parsed as usual, only slower.
+i32 OpenCachedFont(Arena *arena, char *fontPath, char *cachePath, CachedFont *cached)
+{
+  memset(cached, 0, sizeof(CachedFont));
+  if (!LoadFont(arena, fontPath, &cached->font)) return 0;
+
+  if (PlatformFileExists(cachePath) && LoadFontCache(arena, cached, cachePath)) return 1;
+  if (WriteFontCache(arena, &cached->font, cachePath) && LoadFontCache(arena, cached, cachePath)) return 1;
+
+  if (!LoadTextFont(arena, &cached->font, &cached->textFont) ||
+      ((GetFontTable(&cached->font, FONT_TABLE_GLYF).length || GetFontTable(&cached->font, FONT_TABLE_CFF).length ||
+        GetFontTable(&cached->font, FONT_TABLE_CFF2).length) && !LoadGlyphData(arena, &cached->font, &cached->glyphData)))
+  {
+    UnloadFont(&cached->font);
+    return 0;
+  }
+  return 1;
+}
+
+void UnloadCachedFont(CachedFont *cached)
+{
+  UnmapWholeFile(&cached->cacheFile);
+  UnloadFont(&cached->font);
+  memset(cached, 0, sizeof(CachedFont));
+}
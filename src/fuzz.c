@@ -0,0 +1,213 @@
+// Fuzz target running an input through every parser, built in place of the regular main with FUZZ=1.
+//
+// libFuzzer:
+//   clang -g -O1 -fsanitize=fuzzer,address,undefined -DFUZZ=1 -DFUZZ_LIBFUZZER=1 src/main.c -lm -lpthread -o fleuret_fuzz
+//   ./fleuret_fuzz -max_len=1048576 corpus fonts
+// AFL, or replaying crashes with any compiler (files as arguments, stdin otherwise):
+//   afl-clang-fast -g -O1 -DFUZZ=1 src/main.c -lm -lpthread -o fleuret_afl
+//   afl-fuzz -i fonts -o findings -- ./fleuret_afl @@
+
+#define FUZZ_MAX_GLYPHS 1024 // Keeps each input fast, offsets past it still go through loca.
+#define FUZZ_RASTER_SIZE 128
+
+Arena fuzzArena;
+
+void FuzzFont(Arena *arena, Font *font, u8 *text, i32 textLength)
+{
+  FontChecksumReport report;
+  VerifyFontChecksums(arena, font, NULL, &report);
+
+  ReadCodepointMapTableHeader(arena, GetFontTable(font, FONT_TABLE_CMAP));
+  CodepointMap codepointMap;
+  if (LoadCodepointMap(arena, font, &codepointMap, CODEPOINT_MAP_BMP_TABLE | CODEPOINT_MAP_PAGE_TABLE))
+  {
+    // The input doubles as text, odd bytes make for invalid UTF-8 sequences too.
+    u16 *glyphIds = (u16 *)Alloc(arena, (textLength + 16) * sizeof(u16));
+    GlyphIndicesFromUtf8(&codepointMap, text, textLength, glyphIds);
+
+    // Runs the same codepoints through the BMP table, the page table and the subtable search.
+    // UTF-32 input may hold any u32, the values past 0x7FFFFFFF sit in the first 8 to reach the vector paths.
+    CodepointMap pageMap = codepointMap;
+    pageMap.bmpGlyphIds = NULL;
+    CodepointMap searchMap = pageMap;
+    searchMap.pageTable = NULL;
+    u32 codepoints[] = { 0x80000000, 0x20, 0xFFFFFFFF, 0xFF, 0x80000041, 0xFFFF, 0x10000, 0xC001F600, 0, 0x41, 0x100, 0x1F600, 0x10FFFF, 0x110000 };
+    CodepointMap *maps[] = { &codepointMap, &pageMap, &searchMap };
+    for (i32 i = 0; i < 3; ++i)
+    {
+      GlyphIndicesFromCodepoints(maps[i], codepoints, (i32)(sizeof(codepoints) / sizeof(codepoints[0])), glyphIds);
+    }
+
+    // Runs must tile the text exactly whatever the font covers.
+    CodepointMap *chain[] = { &codepointMap, &searchMap };
+    FallbackIndex *fallback = BuildFallbackIndex(arena, chain, 2);
+    FallbackRun *runs = (FallbackRun *)Alloc(arena, (textLength + 1) * sizeof(FallbackRun));
+    i32 runCount = fallback ? SplitFallbackRuns(fallback, text, textLength, runs, textLength + 1) : 0;
+    for (i32 i = 0, offset = 0; i < runCount; offset += runs[i++].length) assert(runs[i].offset == offset && runs[i].length > 0);
+
+    // Advances over the text, then raw input bytes as glyph id pairs to reach the bounds checks.
+    HorizontalMetrics metrics;
+    KerningTable kerning;
+    if (LoadHorizontalMetrics(arena, font, &metrics) && LoadKerningTable(arena, font, &kerning))
+    {
+      i32 *advances = (i32 *)Alloc(arena, (textLength + 1) * sizeof(i32));
+      i32 glyphCount = GlyphIndicesFromUtf8(&codepointMap, text, textLength, glyphIds);
+      GetGlyphRunAdvances(&metrics, &kerning, glyphIds, glyphCount, advances);
+      for (i32 i = 0; i + 3 < textLength; i += 4) GetKerning(&kerning, READ_BIG_ENDIAN_U16(&text[i]), READ_BIG_ENDIAN_U16(&text[i + 2]));
+    }
+  }
+
+  // Twice through a small cache so that runs hit, move between generations and rotate.
+  TextFont textFont;
+  if (LoadTextFont(arena, font, &textFont))
+  {
+    RunCache *cache = CreateRunCache(arena, 16, 4 * KB);
+    LayoutText(arena, &textFont, cache, text, textLength, 16.0f, 200.0f);
+    LayoutText(arena, &textFont, cache, text, textLength, 16.0f, 0.0f);
+  }
+
+  // A blob built from any font that parses must pass the checks run when it is loaded.
+  u32 cacheSize = 0;
+  u8 *cacheBlob = BuildFontCache(arena, font, &cacheSize);
+  if (cacheBlob) assert(ValidateFontCache(cacheBlob, cacheSize, font));
+
+  // So must a subset of the codepoints of the text, whatever glyf and loca hold.
+  FontSubsetter subsetter;
+  if (LoadFontSubsetter(arena, font, &subsetter))
+  {
+    u32 *codepoints = (u32 *)Alloc(arena, (textLength + 1) * sizeof(u32));
+    i32 consumed = 0;
+    i32 codepointCount = DecodeUtf8(text, textLength, codepoints, textLength, &consumed);
+    u32 subsetSize = 0;
+    u8 *subsetData = SubsetFont(arena, &subsetter, codepoints, codepointCount, &subsetSize);
+    if (subsetData)
+    {
+      Font subset;
+      FontChecksumReport subsetReport;
+      assert(LoadFontFromMemory(arena, subsetData, subsetSize, &subset));
+      assert(VerifyFontChecksums(arena, &subset, NULL, &subsetReport));
+    }
+  }
+
+  GlyphData glyphData;
+  if (!LoadGlyphData(arena, font, &glyphData)) return;
+  GlyphOutline *outline = AllocGlyphOutline(arena, &glyphData);
+
+  // Variable fonts are drawn at coordinates taken from the input, through a cache small enough to rotate.
+  VariationInstance *instance = CreateVariationInstance(arena, &glyphData);
+  InstanceCache *instanceCache = CreateInstanceCache(arena, 16, 16 * KB);
+  OutlineCache *outlineCache = CreateOutlineCache(arena, &glyphData, 4 * KB);
+  FontVariations fontVariations;
+  if (instance)
+  {
+    i16 *coordinates = (i16 *)Alloc(arena, instance->axisCount * sizeof(i16));
+    for (i32 i = 0; i < instance->axisCount; ++i) coordinates[i] = (i16)((i32)text[i % textLength] * 257 / 2 - 16384);
+    if (LoadFontVariations(arena, font, &fontVariations) && fontVariations.axisCount == instance->axisCount)
+    {
+      f32 *location = (f32 *)Alloc(arena, fontVariations.axisCount * sizeof(f32));
+      for (i32 i = 0; i < fontVariations.axisCount; ++i) location[i] = fontVariations.axes[i].maxValue * text[i % textLength] / 255.0f;
+      NormalizeVariationCoordinates(&fontVariations, location, coordinates);
+    }
+    SetVariationInstanceCoordinates(instance, coordinates);
+  }
+
+  Rasterizer *rasterizer = AllocRasterizer(arena, FUZZ_RASTER_SIZE, FUZZ_RASTER_SIZE);
+  f32 scale = glyphData.fontHeader->unitsPerEm ? 64.0f / glyphData.fontHeader->unitsPerEm : 1.0f;
+  i32 glyphCount = glyphData.numGlyphs < FUZZ_MAX_GLYPHS ? glyphData.numGlyphs : FUZZ_MAX_GLYPHS;
+  for (i32 glyphId = 0; glyphId < glyphCount; ++glyphId)
+  {
+    // Packed default outlines, evicted every few glyphs by the small budget.
+    if (outlineCache && GetCachedGlyphOutline(outlineCache, (u16)glyphId, outline))
+    {
+      i32 packedPoints = outline->pointCount;
+      assert(GetCachedGlyphOutline(outlineCache, (u16)glyphId, outline) && outline->pointCount == packedPoints);
+    }
+
+    if (!DecodeCachedGlyphOutline(instanceCache, &glyphData, instance, (u16)glyphId, outline)) continue;
+    i32 pointCount = outline->pointCount;
+    assert(DecodeCachedGlyphOutline(instanceCache, &glyphData, instance, (u16)glyphId, outline) && outline->pointCount == pointCount);
+
+    GlyphBitmap bitmap;
+    GetGlyphBitmapBounds(outline, scale, &bitmap);
+    if (bitmap.width <= 0 || bitmap.height <= 0 || bitmap.width > FUZZ_RASTER_SIZE || bitmap.height > FUZZ_RASTER_SIZE) continue;
+    TmpArena tmp;
+    TmpArenaPush(&tmp, arena);
+    bitmap.pixels = (u8 *)Alloc(arena, bitmap.width * bitmap.height + SIMD_PADDING);
+    RasterizeGlyphOutline(rasterizer, outline, scale, &bitmap);
+    TmpArenaPop(&tmp);
+  }
+}
+
+int LLVMFuzzerTestOneInput(const u8 *data, size_t size)
+{
+  if (!fuzzArena.data && !InitVirtualArena(&fuzzArena, ARENA_DEFAULT_RESERVE)) return 0;
+  TmpArena tmp;
+  TmpArenaPush(&tmp, &fuzzArena);
+
+  // Parsers never write to the font, the const is only dropped to fit FontView.
+  FontView view = MakeFontView((void *)data, size);
+  i32 textLength = size < 4096 ? (i32)size : 4096;
+  TrueTypeCollectionHeaderV2 *header = ReadTrueTypeCollectionHeader(&fuzzArena, view);
+  if (header)
+  {
+    for (u32 i = 0; i < header->numFonts && i < 4; ++i)
+    {
+      u32 offset = header->tableDirectoryOffsets[i];
+      Font face;
+      memset(&face, 0, sizeof(Font));
+      face.view = view;
+      face.directory = ReadTableDirectory(&fuzzArena, FontSubView(view, offset, view.length - offset));
+      if (!face.directory) continue;
+      BuildFontTableIndex(&face);
+      FuzzFont(&fuzzArena, &face, (u8 *)data, textLength);
+    }
+  }
+  else
+  {
+    Font font;
+    if (LoadFontFromMemory(&fuzzArena, (void *)data, size, &font)) FuzzFont(&fuzzArena, &font, (u8 *)data, textLength);
+  }
+
+  TmpArenaPop(&tmp);
+  return 0;
+}
+
+#if !FUZZ_LIBFUZZER
+// Inputs are copied into blocks of their exact size so that sanitizers catch any read past the end.
+i32 FuzzFile(FILE *file)
+{
+  size_t capacity = 1 << 16, size = 0;
+  u8 *data = (u8 *)malloc(capacity);
+  for (size_t read; data && (read = fread(data + size, 1, capacity - size, file)) > 0;)
+  {
+    size += read;
+    if (size == capacity) data = (u8 *)realloc(data, capacity *= 2);
+  }
+  if (!data) return 0;
+
+  u8 *input = (u8 *)malloc(size ? size : 1);
+  memcpy(input, data, size);
+  free(data);
+  LLVMFuzzerTestOneInput(input, size);
+  free(input);
+  return 1;
+}
+
+int main(int argc, char **argv)
+{
+  if (argc < 2) return FuzzFile(stdin) ? 0 : 1;
+
+  for (i32 i = 1; i < argc; ++i)
+  {
+    FILE *file = fopen(argv[i], "rb");
+    if (!file)
+    {
+      fprintf(stderr, "Failed to open file %s\n", argv[i]);
+      continue;
+    }
+    FuzzFile(file);
+    fclose(file);
+  }
+  return 0;
+}
+#endif
@@ -0,0 +1,483 @@
+//SPECS: https://learn.microsoft.com/en-us/typography/opentype/spec/glyf
+
+#define GLYPH_MAX_COMPONENT_DEPTH 16 // Guards against cyclic composites in malformed fonts.
+#define F2DOT14_TO_F32(value) ((f32)(i16)(value) / 16384.0f)
+#define COMPACT_GLYPH_MAX_POINTS 8192 // CFF has no maxp limits, charstrings exceeding these fail to decode.
+#define COMPACT_GLYPH_MAX_CONTOURS 1024
+#define GLYPH_VARIATION_MAX_COMPONENTS 256 // Composites of variable fonts with more components fail to decode.
+
+typedef enum {
+  ON_CURVE_POINT = 0x01,
+  X_SHORT_VECTOR = 0x02, // The x-coordinate is 1 byte long, its sign is given by X_IS_SAME_OR_POSITIVE_X_SHORT_VECTOR.
+  Y_SHORT_VECTOR = 0x04,
+  REPEAT_FLAG = 0x08, // The next byte specifies the number of additional times this flag byte is to be repeated.
+  X_IS_SAME_OR_POSITIVE_X_SHORT_VECTOR = 0x10, // Without X_SHORT_VECTOR, the x-coordinate is the same as the previous one.
+  Y_IS_SAME_OR_POSITIVE_Y_SHORT_VECTOR = 0x20,
+  OVERLAP_SIMPLE = 0x40,
+} SimpleGlyphFlags;
+
+typedef enum {
+  ARG_1_AND_2_ARE_WORDS = 0x0001, // Otherwise the arguments are bytes.
+  ARGS_ARE_XY_VALUES = 0x0002, // Otherwise the arguments are point numbers to match.
+  ROUND_XY_TO_GRID = 0x0004,
+  WE_HAVE_A_SCALE = 0x0008,
+  MORE_COMPONENTS = 0x0020,
+  WE_HAVE_AN_X_AND_Y_SCALE = 0x0040,
+  WE_HAVE_A_TWO_BY_TWO = 0x0080,
+  WE_HAVE_INSTRUCTIONS = 0x0100,
+  USE_MY_METRICS = 0x0200,
+  OVERLAP_COMPOUND = 0x0400,
+  SCALED_COMPONENT_OFFSET = 0x0800, // The component offset is transformed along with the component.
+  UNSCALED_COMPONENT_OFFSET = 0x1000,
+} CompositeGlyphFlags;
+
+typedef enum {
+  OUTLINE_QUADRATIC_CONTROL = 0,
+  OUTLINE_ON_CURVE = 1,
+  OUTLINE_CUBIC_CONTROL = 2, // Always in pairs between two on-curve points, only CFF outlines have them.
+} OutlinePointType;
+
+// Structure-of-arrays outline in font units, composites are flattened into their components' points.
+typedef struct {
+  i32 pointCount;
+  i32 contourCount;
+  i32 pointCapacity;
+  i32 contourCapacity;
+  f32 *x;
+  f32 *y;
+  u8 *onCurve; // OutlinePointType of each point.
+  u16 *contourEnds; // Index of the last point of each contour.
+  i16 xMin; // Bounding box from the glyph header, or of the points for CFF.
+  i16 yMin;
+  i16 xMax;
+  i16 yMax;
+} GlyphOutline;
+
+// Charstring outlines of CFF and CFF2 fonts, see cff.c.
+typedef struct CompactFont CompactFont;
+CompactFont *LoadCompactFont(Arena *arena, Font *font);
+i32 AppendCompactGlyph(CompactFont *compactFont, u16 glyphId, GlyphOutline *outline);
+
+// gvar deltas of variable fonts, see variation.c.
+typedef struct GlyphVariations GlyphVariations;
+typedef struct VariationInstance VariationInstance;
+GlyphVariations *LoadGlyphVariations(Arena *arena, Font *font, u16 numGlyphs);
+i32 ApplySimpleGlyphVariations(VariationInstance *instance, u16 glyphId, GlyphOutline *outline, i32 firstPoint, i32 firstContour);
+i32 GetCompositeGlyphVariations(VariationInstance *instance, u16 glyphId, i32 componentCount, f32 *deltaX, f32 *deltaY);
+i32 IsDefaultVariationInstance(VariationInstance *instance);
+
+typedef struct {
+  FontHeaderTable *fontHeader;
+  MaximumProfileTable *maximumProfile;
+  u16 numGlyphs;
+  u32 *glyphOffsets; // numGlyphs + 1 byte offsets into glyf, decoded from loca.
+  FontView glyf;
+  CompactFont *compactFont; // Set instead of glyphOffsets for fonts without glyf.
+  GlyphVariations *variations; // gvar of variable fonts, NULL otherwise.
+} GlyphData;
+
+// loca must hold offsetCount entries.
+u32 *ReadGlyphOffsets(Arena *arena, FontView loca, i32 shortOffsets, i32 offsetCount)
+{
+  u32 *glyphOffsets = (u32 *)AllocNoZero(arena, offsetCount * sizeof(u32));
+  if (shortOffsets)
+  {
+    // Short offsets are stored divided by 2.
+    TmpArena scratch;
+    TmpArenaPush(&scratch, GetScratchArena(arena));
+    u16 *halfOffsets = (u16 *)AllocNoZero(scratch.arena, offsetCount * sizeof(u16));
+    ReadBigEndianU16Array(halfOffsets, loca.data, offsetCount);
+    for (i32 i = 0; i < offsetCount; ++i)
+    {
+      glyphOffsets[i] = (u32)halfOffsets[i] * 2;
+    }
+    TmpArenaPop(&scratch);
+  }
+  else
+  {
+    ReadBigEndianU32Array(glyphOffsets, loca.data, offsetCount);
+  }
+  return glyphOffsets;
+}
+
+i32 LoadGlyphData(Arena *arena, Font *font, GlyphData *glyphData)
+{
+  memset(glyphData, 0, sizeof(GlyphData));
+
+  glyphData->fontHeader = ReadFontHeaderTable(arena, GetFontTable(font, FONT_TABLE_HEAD));
+  glyphData->maximumProfile = ReadMaximumProfileTable(arena, GetFontTable(font, FONT_TABLE_MAXP));
+  if (!glyphData->fontHeader || !glyphData->maximumProfile)
+  {
+    fprintf(stderr, "Failed to parse head or maxp\n");
+    return 0;
+  }
+
+  FontView loca = GetFontTable(font, FONT_TABLE_LOCA);
+  glyphData->glyf = GetFontTable(font, FONT_TABLE_GLYF);
+  glyphData->numGlyphs = glyphData->maximumProfile->numGlyphs;
+  if (!glyphData->glyf.length && (GetFontTable(font, FONT_TABLE_CFF).length || GetFontTable(font, FONT_TABLE_CFF2).length))
+  {
+    PROFILE_BEGIN(LoadCompactFont);
+    glyphData->compactFont = LoadCompactFont(arena, font);
+    PROFILE_END(LoadCompactFont);
+    return glyphData->compactFont != NULL;
+  }
+
+  i32 offsetCount = glyphData->numGlyphs + 1;
+  i32 shortOffsets = glyphData->fontHeader->indexToLocFormat == 0;
+  if (!glyphData->glyf.length || loca.length < (u32)offsetCount * (shortOffsets ? 2 : 4))
+  {
+    fprintf(stderr, "Missing or truncated loca/glyf\n");
+    return 0;
+  }
+
+  PROFILE_BEGIN(ReadGlyphOffsets);
+  glyphData->glyphOffsets = ReadGlyphOffsets(arena, loca, shortOffsets, offsetCount);
+  PROFILE_END(ReadGlyphOffsets);
+
+  // A gvar that does not parse leaves the font static.
+  if (GetFontTable(font, FONT_TABLE_GVAR).length) glyphData->variations = LoadGlyphVariations(arena, font, glyphData->numGlyphs);
+  return 1;
+}
+
+// Sized once from maxp so decoding never reallocates, composites are covered by maxCompositePoints.
+GlyphOutline *AllocGlyphOutline(Arena *arena, GlyphData *glyphData)
+{
+  MaximumProfileTable *maximumProfile = glyphData->maximumProfile;
+  i32 pointCapacity = maximumProfile->maxPoints > maximumProfile->maxCompositePoints ? maximumProfile->maxPoints : maximumProfile->maxCompositePoints;
+  i32 contourCapacity = maximumProfile->maxContours > maximumProfile->maxCompositeContours ? maximumProfile->maxContours : maximumProfile->maxCompositeContours;
+  if (glyphData->compactFont)
+  {
+    pointCapacity = COMPACT_GLYPH_MAX_POINTS;
+    contourCapacity = COMPACT_GLYPH_MAX_CONTOURS;
+  }
+
+  GlyphOutline *outline = (GlyphOutline *)Alloc(arena, sizeof(GlyphOutline));
+  outline->pointCapacity = pointCapacity;
+  outline->contourCapacity = contourCapacity;
+  outline->x = (f32 *)Alloc(arena, pointCapacity * sizeof(f32) + SIMD_PADDING);
+  outline->y = (f32 *)Alloc(arena, pointCapacity * sizeof(f32) + SIMD_PADDING);
+  outline->onCurve = (u8 *)Alloc(arena, pointCapacity + SIMD_PADDING);
+  outline->contourEnds = (u16 *)Alloc(arena, contourCapacity * sizeof(u16));
+  return outline;
+}
+
+// Empty view for glyphs without outlines (e.g. space), or when loca points outside of glyf.
+FontView GetGlyphView(GlyphData *glyphData, u16 glyphId)
+{
+  FontView glyph = {0};
+  if (glyphId >= glyphData->numGlyphs) return glyph;
+
+  u32 start = glyphData->glyphOffsets[glyphId];
+  u32 end = glyphData->glyphOffsets[glyphId + 1];
+  if (end > start) glyph = FontSubView(glyphData->glyf, start, end - start);
+  return glyph;
+}
+
+i32 AppendSimpleGlyph(FontView glyph, i16 numberOfContours, GlyphOutline *outline)
+{
+  u8 *p = glyph.data + 10;
+  u8 *end = glyph.data + glyph.length;
+  i32 firstPoint = outline->pointCount;
+  i32 firstContour = outline->contourCount;
+  if (firstContour + numberOfContours > outline->contourCapacity || p + numberOfContours * 2 + 2 > end) return 0;
+
+  u16 *contourEnds = &outline->contourEnds[firstContour];
+  ReadBigEndianU16Array(contourEnds, p, numberOfContours);
+  p += numberOfContours * 2;
+
+  i32 glyphPointCount = numberOfContours ? contourEnds[numberOfContours - 1] + 1 : 0;
+  if (firstPoint + glyphPointCount > outline->pointCapacity) return 0;
+  for (i32 i = numberOfContours - 1; i >= 0; --i)
+  {
+    if (i > 0 && contourEnds[i] < contourEnds[i - 1]) return 0;
+    contourEnds[i] = (u16)(contourEnds[i] + firstPoint);
+  }
+
+  u16 instructionLength = READ_BIG_ENDIAN_U16(p);
+  p += 2 + instructionLength;
+
+  // Raw flags are kept in onCurve until both coordinate arrays are decoded.
+  u8 *flags = &outline->onCurve[firstPoint];
+  for (i32 i = 0; i < glyphPointCount;)
+  {
+    if (p >= end) return 0;
+    u8 flag = *p++;
+    flags[i++] = flag;
+    if (flag & REPEAT_FLAG)
+    {
+      if (p >= end) return 0;
+      for (i32 repeat = *p++; repeat > 0 && i < glyphPointCount; --repeat)
+      {
+        flags[i++] = flag;
+      }
+    }
+  }
+
+  f32 *x = &outline->x[firstPoint];
+  i32 value = 0;
+  for (i32 i = 0; i < glyphPointCount; ++i)
+  {
+    u8 flag = flags[i];
+    if (flag & X_SHORT_VECTOR)
+    {
+      if (p >= end) return 0;
+      value += (flag & X_IS_SAME_OR_POSITIVE_X_SHORT_VECTOR) ? *p : -*p;
+      p += 1;
+    }
+    else if (!(flag & X_IS_SAME_OR_POSITIVE_X_SHORT_VECTOR))
+    {
+      if (p + 2 > end) return 0;
+      value += READ_BIG_ENDIAN_I16(p);
+      p += 2;
+    }
+    x[i] = (f32)value;
+  }
+
+  f32 *y = &outline->y[firstPoint];
+  value = 0;
+  for (i32 i = 0; i < glyphPointCount; ++i)
+  {
+    u8 flag = flags[i];
+    if (flag & Y_SHORT_VECTOR)
+    {
+      if (p >= end) return 0;
+      value += (flag & Y_IS_SAME_OR_POSITIVE_Y_SHORT_VECTOR) ? *p : -*p;
+      p += 1;
+    }
+    else if (!(flag & Y_IS_SAME_OR_POSITIVE_Y_SHORT_VECTOR))
+    {
+      if (p + 2 > end) return 0;
+      value += READ_BIG_ENDIAN_I16(p);
+      p += 2;
+    }
+    y[i] = (f32)value;
+    flags[i] &= ON_CURVE_POINT;
+  }
+
+  outline->pointCount += glyphPointCount;
+  outline->contourCount += numberOfContours;
+  return 1;
+}
+
+i32 AppendGlyphOutline(GlyphData *glyphData, VariationInstance *instance, u16 glyphId, GlyphOutline *outline, i32 depth);
+
+// Returns the glyph index field of the component at *at and moves *at to the next one, NULL after the
+// last component or when the component runs past end.
+u8 *NextGlyphComponent(u8 **at, u8 *end)
+{
+  u8 *component = *at;
+  if (!component || end - component < 4) return NULL;
+
+  u16 flags = READ_BIG_ENDIAN_U16(component);
+  u32 size = 4 + (flags & ARG_1_AND_2_ARE_WORDS ? 4 : 2);
+  size += flags & WE_HAVE_A_SCALE ? 2 : flags & WE_HAVE_AN_X_AND_Y_SCALE ? 4 : flags & WE_HAVE_A_TWO_BY_TWO ? 8 : 0;
+  if ((u32)(end - component) < size) return NULL;
+
+  *at = flags & MORE_COMPONENTS ? component + size : NULL;
+  return component + 2;
+}
+
+i32 AppendCompositeGlyph(GlyphData *glyphData, VariationInstance *instance, u16 glyphId, FontView glyph, GlyphOutline *outline, i32 depth)
+{
+  if (depth >= GLYPH_MAX_COMPONENT_DEPTH) return 0;
+
+  u8 *p = glyph.data + 10;
+  u8 *end = glyph.data + glyph.length;
+
+  // gvar moves the offset of each component, its points are varied by the component's own deltas.
+  f32 deltaX[GLYPH_VARIATION_MAX_COMPONENTS + 4];
+  f32 deltaY[GLYPH_VARIATION_MAX_COMPONENTS + 4];
+  if (instance)
+  {
+    i32 componentCount = 0;
+    for (u8 *at = p; NextGlyphComponent(&at, end);) ++componentCount;
+    if (componentCount > GLYPH_VARIATION_MAX_COMPONENTS) return 0;
+    if (!GetCompositeGlyphVariations(instance, glyphId, componentCount, deltaX, deltaY)) return 0;
+  }
+
+  // Point numbers of matched components count from this composite's first point, not the whole outline's.
+  i32 basePoint = outline->pointCount;
+  i32 component = 0;
+  u16 flags;
+  do
+  {
+    if (p + 4 > end) return 0;
+    flags = READ_BIG_ENDIAN_U16(p);
+    u16 componentGlyphId = READ_BIG_ENDIAN_U16(p + 2);
+    p += 4;
+
+    i32 argument1, argument2;
+    if (flags & ARG_1_AND_2_ARE_WORDS)
+    {
+      if (p + 4 > end) return 0;
+      argument1 = (flags & ARGS_ARE_XY_VALUES) ? READ_BIG_ENDIAN_I16(p) : READ_BIG_ENDIAN_U16(p);
+      argument2 = (flags & ARGS_ARE_XY_VALUES) ? READ_BIG_ENDIAN_I16(p + 2) : READ_BIG_ENDIAN_U16(p + 2);
+      p += 4;
+    }
+    else
+    {
+      if (p + 2 > end) return 0;
+      argument1 = (flags & ARGS_ARE_XY_VALUES) ? (i8)p[0] : p[0];
+      argument2 = (flags & ARGS_ARE_XY_VALUES) ? (i8)p[1] : p[1];
+      p += 2;
+    }
+
+    // x' = xx * x + yx * y, y' = xy * x + yy * y
+    f32 xx = 1, xy = 0, yx = 0, yy = 1;
+    if (flags & WE_HAVE_A_SCALE)
+    {
+      if (p + 2 > end) return 0;
+      xx = yy = F2DOT14_TO_F32(READ_BIG_ENDIAN_U16(p));
+      p += 2;
+    }
+    else if (flags & WE_HAVE_AN_X_AND_Y_SCALE)
+    {
+      if (p + 4 > end) return 0;
+      xx = F2DOT14_TO_F32(READ_BIG_ENDIAN_U16(p));
+      yy = F2DOT14_TO_F32(READ_BIG_ENDIAN_U16(p + 2));
+      p += 4;
+    }
+    else if (flags & WE_HAVE_A_TWO_BY_TWO)
+    {
+      if (p + 8 > end) return 0;
+      xx = F2DOT14_TO_F32(READ_BIG_ENDIAN_U16(p));
+      xy = F2DOT14_TO_F32(READ_BIG_ENDIAN_U16(p + 2));
+      yx = F2DOT14_TO_F32(READ_BIG_ENDIAN_U16(p + 4));
+      yy = F2DOT14_TO_F32(READ_BIG_ENDIAN_U16(p + 6));
+      p += 8;
+    }
+
+    i32 firstPoint = outline->pointCount;
+    if (!AppendGlyphOutline(glyphData, instance, componentGlyphId, outline, depth + 1)) return 0;
+
+    f32 *x = outline->x;
+    f32 *y = outline->y;
+    if (xx != 1 || xy != 0 || yx != 0 || yy != 1)
+    {
+      for (i32 i = firstPoint; i < outline->pointCount; ++i)
+      {
+        f32 pointX = x[i];
+        f32 pointY = y[i];
+        x[i] = xx * pointX + yx * pointY;
+        y[i] = xy * pointX + yy * pointY;
+      }
+    }
+
+    f32 offsetX, offsetY;
+    if (flags & ARGS_ARE_XY_VALUES)
+    {
+      offsetX = (f32)argument1;
+      offsetY = (f32)argument2;
+      if (instance)
+      {
+        offsetX += deltaX[component];
+        offsetY += deltaY[component];
+      }
+      if ((flags & SCALED_COMPONENT_OFFSET) && !(flags & UNSCALED_COMPONENT_OFFSET))
+      {
+        f32 unscaledX = offsetX;
+        offsetX = xx * unscaledX + yx * offsetY;
+        offsetY = xy * unscaledX + yy * offsetY;
+      }
+    }
+    else
+    {
+      // Align the component's point argument2 onto point argument1 of the components placed so far.
+      i32 parentPoint = basePoint + argument1;
+      i32 childPoint = firstPoint + argument2;
+      if (parentPoint >= firstPoint || childPoint >= outline->pointCount) return 0;
+      offsetX = x[parentPoint] - x[childPoint];
+      offsetY = y[parentPoint] - y[childPoint];
+    }
+
+    if (offsetX != 0 || offsetY != 0)
+    {
+      for (i32 i = firstPoint; i < outline->pointCount; ++i)
+      {
+        x[i] += offsetX;
+        y[i] += offsetY;
+      }
+    }
+    ++component;
+  } while (flags & MORE_COMPONENTS);
+
+  return 1;
+}
+
+i32 AppendGlyphOutline(GlyphData *glyphData, VariationInstance *instance, u16 glyphId, GlyphOutline *outline, i32 depth)
+{
+  FontView glyph = GetGlyphView(glyphData, glyphId);
+  if (!glyph.length) return glyphId < glyphData->numGlyphs;
+  if (glyph.length < 10) return 0;
+
+  i16 numberOfContours = ViewI16(glyph, 0);
+  if (depth == 0)
+  {
+    outline->xMin = ViewI16(glyph, 2);
+    outline->yMin = ViewI16(glyph, 4);
+    outline->xMax = ViewI16(glyph, 6);
+    outline->yMax = ViewI16(glyph, 8);
+  }
+
+  if (numberOfContours >= 0)
+  {
+    i32 firstPoint = outline->pointCount;
+    i32 firstContour = outline->contourCount;
+    if (!AppendSimpleGlyph(glyph, numberOfContours, outline)) return 0;
+    return !instance || ApplySimpleGlyphVariations(instance, glyphId, outline, firstPoint, firstContour);
+  }
+  return AppendCompositeGlyph(glyphData, instance, glyphId, glyph, outline, depth);
+}
+
+// Control box of the points from firstPoint on, rounded outwards.
+void SetOutlineBounds(GlyphOutline *outline, i32 firstPoint)
+{
+  if (outline->pointCount <= firstPoint) return;
+
+  f32 xMin = outline->x[firstPoint], xMax = xMin;
+  f32 yMin = outline->y[firstPoint], yMax = yMin;
+  for (i32 i = firstPoint + 1; i < outline->pointCount; ++i)
+  {
+    xMin = outline->x[i] < xMin ? outline->x[i] : xMin;
+    xMax = outline->x[i] > xMax ? outline->x[i] : xMax;
+    yMin = outline->y[i] < yMin ? outline->y[i] : yMin;
+    yMax = outline->y[i] > yMax ? outline->y[i] : yMax;
+  }
+  outline->xMin = (i16)floorf(xMin);
+  outline->yMin = (i16)floorf(yMin);
+  outline->xMax = (i16)ceilf(xMax);
+  outline->yMax = (i16)ceilf(yMax);
+}
+
+// Outline at the coordinates of instance, the default outline when instance is NULL or the font has no
+// gvar. CFF2 blends are not applied. Returns 0 for malformed glyphs or ones that exceed the maxp sized
+// capacity, the outline is then empty.
+i32 DecodeInstancedGlyphOutline(GlyphData *glyphData, VariationInstance *instance, u16 glyphId, GlyphOutline *outline)
+{
+  outline->pointCount = 0;
+  outline->contourCount = 0;
+  outline->xMin = outline->yMin = outline->xMax = outline->yMax = 0;
+  if (instance && (!glyphData->variations || IsDefaultVariationInstance(instance))) instance = NULL;
+
+  PROFILE_BEGIN(DecodeGlyphOutline);
+  i32 success = glyphData->compactFont ?
+    AppendCompactGlyph(glyphData->compactFont, glyphId, outline) :
+    AppendGlyphOutline(glyphData, instance, glyphId, outline, 0);
+  PROFILE_END(DecodeGlyphOutline);
+  if (!success)
+  {
+    outline->pointCount = 0;
+    outline->contourCount = 0;
+    return 0;
+  }
+
+  // The bounding box stored in glyf is the one of the default outline.
+  if (instance) SetOutlineBounds(outline, 0);
+  return 1;
+}
+
+i32 DecodeGlyphOutline(GlyphData *glyphData, u16 glyphId, GlyphOutline *outline)
+{
+  return DecodeInstancedGlyphOutline(glyphData, NULL, glyphId, outline);
+}
@@ -0,0 +1,304 @@
+//SPECS: https://www.rfc-editor.org/rfc/rfc1950
+//SPECS: https://www.rfc-editor.org/rfc/rfc1951
+
+// Bundled zlib/DEFLATE decoder for WOFF tables, which are always inflated whole into a buffer of their known
+// size, so there is no window or streaming state: matches copy straight from the output. Huffman codes up to
+// INFLATE_FAST_BITS long are decoded with a single table lookup, longer ones bit by bit from the canonical
+// code counts. Malformed or truncated streams fail instead of producing partial output.
+
+#define INFLATE_FAST_BITS 10
+#define INFLATE_MAX_BITS 15
+#define INFLATE_LITERAL_CODES 288
+#define INFLATE_DISTANCE_CODES 32
+
+typedef struct {
+  u16 fast[1 << INFLATE_FAST_BITS]; // symbol << 4 | length of codes up to INFLATE_FAST_BITS, 0 for longer ones.
+  u16 counts[INFLATE_MAX_BITS + 1]; // Number of codes of each length.
+  u16 symbols[INFLATE_LITERAL_CODES]; // Ordered by code.
+} InflateHuffman;
+
+typedef struct {
+  u8 *at;
+  u8 *end;
+  u64 bits; // Read LSB first.
+  i32 bitCount;
+  i32 failed; // Set when the input ran out or a code was invalid, reads then return 0.
+  u8 *output;
+  u32 outputLength;
+  u32 outputCapacity;
+} Inflater;
+
+u16 inflateLengthBase[29] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+u8 inflateLengthExtra[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+u16 inflateDistanceBase[30] = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073,
+                                4097, 6145, 8193, 12289, 16385, 24577 };
+u8 inflateDistanceExtra[30] = { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+u8 inflateCodeLengthOrder[19] = { 16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
+
+void RefillInflateBits(Inflater *inflater)
+{
+  while (inflater->bitCount <= 56 && inflater->at < inflater->end)
+  {
+    inflater->bits |= (u64)*inflater->at++ << inflater->bitCount;
+    inflater->bitCount += 8;
+  }
+}
+
+u32 ReadInflateBits(Inflater *inflater, i32 count)
+{
+  if (inflater->bitCount < count)
+  {
+    RefillInflateBits(inflater);
+    if (inflater->bitCount < count)
+    {
+      inflater->failed = 1;
+      return 0;
+    }
+  }
+  u32 value = (u32)(inflater->bits & ((1ull << count) - 1));
+  inflater->bits >>= count;
+  inflater->bitCount -= count;
+  return value;
+}
+
+// lengths holds the code length of each of count symbols, 0 for unused ones. Returns 0 for over-subscribed
+// codes, incomplete ones are accepted and fail when a missing code is read.
+i32 BuildInflateHuffman(InflateHuffman *huffman, u8 *lengths, i32 count)
+{
+  memset(huffman->counts, 0, sizeof(huffman->counts));
+  for (i32 i = 0; i < count; ++i) ++huffman->counts[lengths[i]];
+  huffman->counts[0] = 0;
+
+  i32 left = 1;
+  u16 offsets[INFLATE_MAX_BITS + 1];
+  offsets[1] = 0;
+  for (i32 length = 1; length <= INFLATE_MAX_BITS; ++length)
+  {
+    left = (left << 1) - huffman->counts[length];
+    if (left < 0) return 0;
+    if (length < INFLATE_MAX_BITS) offsets[length + 1] = offsets[length] + huffman->counts[length];
+  }
+  for (i32 i = 0; i < count; ++i)
+  {
+    if (lengths[i]) huffman->symbols[offsets[lengths[i]]++] = (u16)i;
+  }
+
+  // Codes are assigned in symbol order within a length and come out of the stream bit reversed.
+  memset(huffman->fast, 0, sizeof(huffman->fast));
+  u32 code = 0;
+  i32 index = 0;
+  for (i32 length = 1; length <= INFLATE_FAST_BITS; ++length)
+  {
+    for (i32 i = 0; i < huffman->counts[length]; ++i, ++code, ++index)
+    {
+      u32 reversed = 0;
+      for (i32 bit = 0; bit < length; ++bit) reversed |= ((code >> bit) & 1) << (length - 1 - bit);
+      u16 entry = (u16)(huffman->symbols[index] << 4 | length);
+      for (u32 slot = reversed; slot < (1u << INFLATE_FAST_BITS); slot += 1u << length) huffman->fast[slot] = entry;
+    }
+    code <<= 1;
+  }
+  return 1;
+}
+
+i32 DecodeInflateSymbol(Inflater *inflater, InflateHuffman *huffman)
+{
+  if (inflater->bitCount < INFLATE_MAX_BITS) RefillInflateBits(inflater);
+  u16 entry = huffman->fast[inflater->bits & ((1u << INFLATE_FAST_BITS) - 1)];
+  i32 length = entry & 15;
+  if (entry && length <= inflater->bitCount)
+  {
+    inflater->bits >>= length;
+    inflater->bitCount -= length;
+    return entry >> 4;
+  }
+
+  // Canonical decoding: codes of each length follow the ones of the previous length.
+  i32 code = 0, first = 0, index = 0;
+  for (length = 1; length <= INFLATE_MAX_BITS; ++length)
+  {
+    code |= (i32)ReadInflateBits(inflater, 1);
+    i32 count = huffman->counts[length];
+    if (code - first < count) return huffman->symbols[index + code - first];
+    index += count;
+    first = (first + count) << 1;
+    code <<= 1;
+  }
+  inflater->failed = 1;
+  return 0;
+}
+
+i32 InflateStoredBlock(Inflater *inflater)
+{
+  // The length follows at the next byte boundary, whole bytes still in the bit buffer come first.
+  ReadInflateBits(inflater, inflater->bitCount & 7);
+  u32 length = ReadInflateBits(inflater, 16);
+  u32 lengthComplement = ReadInflateBits(inflater, 16);
+  if (inflater->failed || length != (~lengthComplement & 0xFFFF) || length > inflater->outputCapacity - inflater->outputLength) return 0;
+
+  u8 *output = &inflater->output[inflater->outputLength];
+  for (; length && inflater->bitCount; --length) *output++ = (u8)ReadInflateBits(inflater, 8);
+  if ((u32)(inflater->end - inflater->at) < length) return 0;
+  memcpy(output, inflater->at, length);
+  inflater->at += length;
+  inflater->outputLength = (u32)(output + length - inflater->output);
+  return 1;
+}
+
+i32 InflateCompressedBlock(Inflater *inflater, InflateHuffman *literals, InflateHuffman *distances)
+{
+  u8 *output = inflater->output;
+  u32 position = inflater->outputLength;
+  u32 capacity = inflater->outputCapacity;
+  for (;;)
+  {
+    i32 symbol = DecodeInflateSymbol(inflater, literals);
+    if (inflater->failed) return 0;
+    if (symbol < 256)
+    {
+      if (position == capacity) return 0;
+      output[position++] = (u8)symbol;
+      continue;
+    }
+    if (symbol == 256) break;
+
+    symbol -= 257;
+    if (symbol >= 29) return 0;
+    u32 length = inflateLengthBase[symbol] + ReadInflateBits(inflater, inflateLengthExtra[symbol]);
+    i32 distanceSymbol = DecodeInflateSymbol(inflater, distances);
+    if (distanceSymbol >= 30) return 0;
+    u32 distance = inflateDistanceBase[distanceSymbol] + ReadInflateBits(inflater, inflateDistanceExtra[distanceSymbol]);
+    if (inflater->failed || distance > position || length > capacity - position) return 0;
+
+    // Overlapping matches repeat the last distance bytes, they must be copied forwards one at a time.
+    u8 *source = &output[position - distance];
+    u8 *destination = &output[position];
+    if (distance >= length) memcpy(destination, source, length);
+    else for (u32 i = 0; i < length; ++i) destination[i] = source[i];
+    position += length;
+  }
+  inflater->outputLength = position;
+  return 1;
+}
+
+i32 ReadDynamicInflateCodes(Inflater *inflater, InflateHuffman *literals, InflateHuffman *distances)
+{
+  i32 literalCount = (i32)ReadInflateBits(inflater, 5) + 257;
+  i32 distanceCount = (i32)ReadInflateBits(inflater, 5) + 1;
+  i32 codeLengthCount = (i32)ReadInflateBits(inflater, 4) + 4;
+  if (inflater->failed || literalCount > 286 || distanceCount > 30) return 0;
+
+  u8 lengths[INFLATE_LITERAL_CODES + INFLATE_DISTANCE_CODES] = {0};
+  for (i32 i = 0; i < codeLengthCount; ++i) lengths[inflateCodeLengthOrder[i]] = (u8)ReadInflateBits(inflater, 3);
+  InflateHuffman codeLengths;
+  if (inflater->failed || !BuildInflateHuffman(&codeLengths, lengths, 19)) return 0;
+
+  // Literal and distance lengths are one sequence, repeats may cross from one to the other.
+  memset(lengths, 0, sizeof(lengths));
+  for (i32 i = 0; i < literalCount + distanceCount;)
+  {
+    i32 symbol = DecodeInflateSymbol(inflater, &codeLengths);
+    if (inflater->failed) return 0;
+    if (symbol < 16)
+    {
+      lengths[i++] = (u8)symbol;
+      continue;
+    }
+
+    u8 repeated = 0;
+    i32 repeat;
+    if (symbol == 16)
+    {
+      if (!i) return 0;
+      repeated = lengths[i - 1];
+      repeat = 3 + (i32)ReadInflateBits(inflater, 2);
+    }
+    else if (symbol == 17) repeat = 3 + (i32)ReadInflateBits(inflater, 3);
+    else repeat = 11 + (i32)ReadInflateBits(inflater, 7);
+    if (i + repeat > literalCount + distanceCount) return 0;
+    while (repeat--) lengths[i++] = repeated;
+  }
+  if (!lengths[256]) return 0;
+
+  return BuildInflateHuffman(literals, lengths, literalCount) && BuildInflateHuffman(distances, &lengths[literalCount], distanceCount);
+}
+
+u32 ComputeAdler32(u8 *data, u32 length)
+{
+  u32 a = 1, b = 0;
+  while (length)
+  {
+    // Largest run before b can overflow 32 bits.
+    u32 run = length < 5552 ? length : 5552;
+    length -= run;
+    for (u32 i = 0; i < run; ++i)
+    {
+      a += data[i];
+      b += a;
+    }
+    data += run;
+    a %= 65521;
+    b %= 65521;
+  }
+  return b << 16 | a;
+}
+
+// Inflates the zlib stream in data into output, which must receive exactly outputLength bytes. Returns 0 when
+// the stream is malformed, truncated, or does not decode to that length.
+i32 InflateZlib(u8 *data, u32 length, u8 *output, u32 outputLength)
+{
+  PROFILE_BEGIN(InflateZlib);
+  Inflater inflater = {0};
+  inflater.at = data;
+  inflater.end = data + length;
+  inflater.output = output;
+  inflater.outputCapacity = outputLength;
+
+  // Deflate with any window size and without a preset dictionary.
+  i32 success = length >= 6 && (data[0] & 15) == 8 && (data[0] >> 4) <= 7 && !(data[1] & 0x20) && (data[0] << 8 | data[1]) % 31 == 0;
+  inflater.at += 2;
+
+  InflateHuffman literalCodes, distanceCodes;
+  InflateHuffman *literals = &literalCodes;
+  InflateHuffman *distances = &distanceCodes;
+  i32 lastBlock = 0;
+  while (success && !lastBlock)
+  {
+    lastBlock = (i32)ReadInflateBits(&inflater, 1);
+    u32 type = ReadInflateBits(&inflater, 2);
+    if (type == 0)
+    {
+      success = InflateStoredBlock(&inflater);
+    }
+    else if (type == 1)
+    {
+      u8 lengths[INFLATE_LITERAL_CODES + INFLATE_DISTANCE_CODES];
+      memset(lengths, 8, 144);
+      memset(&lengths[144], 9, 112);
+      memset(&lengths[256], 7, 24);
+      memset(&lengths[280], 8, 8);
+      memset(&lengths[INFLATE_LITERAL_CODES], 5, INFLATE_DISTANCE_CODES);
+      BuildInflateHuffman(literals, lengths, INFLATE_LITERAL_CODES);
+      BuildInflateHuffman(distances, &lengths[INFLATE_LITERAL_CODES], INFLATE_DISTANCE_CODES);
+      success = InflateCompressedBlock(&inflater, literals, distances);
+    }
+    else if (type == 2)
+    {
+      success = ReadDynamicInflateCodes(&inflater, literals, distances) && InflateCompressedBlock(&inflater, literals, distances);
+    }
+    else success = 0;
+    success &= !inflater.failed;
+  }
+
+  // The Adler-32 of the output follows at the next byte boundary.
+  if (success)
+  {
+    ReadInflateBits(&inflater, inflater.bitCount & 7);
+    u32 adler = ReadInflateBits(&inflater, 16) << 16;
+    adler |= ReadInflateBits(&inflater, 16);
+    adler = (adler & 0xFF00FF00) >> 8 | (adler & 0x00FF00FF) << 8; // Stored big endian, read LSB first.
+    success = !inflater.failed && inflater.outputLength == outputLength && adler == ComputeAdler32(output, outputLength);
+  }
+  PROFILE_END(InflateZlib);
+  return success;
+}
@@ -0,0 +1,258 @@
+// Work-stealing job system. Every worker owns a Chase-Lev deque: the owner pushes and pops at the bottom,
+// idle workers steal from the top. Ranges are split lazily, a worker keeps halving its range and pushes
+// the upper halves so that thieves always take the largest pieces of work available.
+
+#define JOB_DEQUE_CAPACITY 64 // Lazy splitting keeps about log2(count / grain) jobs per deque.
+#define JOB_MAX_WORKERS 64
+#define CACHE_LINE_SIZE 64
+
+typedef struct JobWorker JobWorker;
+typedef void JobFunction(JobWorker *worker, void *data, i32 begin, i32 end);
+
+typedef struct {
+  JobFunction *run;
+  void *data;
+  i32 begin;
+  i32 end;
+} Job;
+
+typedef struct {
+  volatile i64 top;
+  u8 topPadding[CACHE_LINE_SIZE - sizeof(i64)];
+  volatile i64 bottom;
+  u8 bottomPadding[CACHE_LINE_SIZE - sizeof(i64)];
+  Job jobs[JOB_DEQUE_CAPACITY];
+} JobDeque;
+
+struct JobWorker {
+  JobDeque deque;
+  i32 index; // 0 is the thread that called RunParallelFor.
+  Arena arena; // Only touched by this worker, so allocations never contend.
+  struct JobSystem *system;
+  PlatformThread thread;
+  i64 generation; // Last RunParallelFor this worker joined.
+  u32 random;
+  i64 itemsRun;
+  i64 steals;
+};
+
+typedef struct JobSystem {
+  i32 workerCount;
+  JobWorker *workers;
+  i32 grainSize;
+  volatile i64 remaining; // Items not yet processed in the current RunParallelFor.
+
+  // Worker threads sleep on wake between calls, the caller sleeps on idle until they all went back.
+  i32 threadCount; // Workers 1 to threadCount have a thread.
+  PlatformMutex mutex;
+  PlatformCondition wake;
+  PlatformCondition idle;
+  i64 generation; // Bumped by every RunParallelFor, guarded by mutex.
+  i32 busyThreads;
+  i32 stopping;
+} JobSystem;
+
+// Returns 0 when the deque is full, the caller then runs the job itself.
+i32 PushJob(JobDeque *deque, Job *job)
+{
+  i64 bottom = deque->bottom;
+  i64 top = AtomicLoadI64(&deque->top);
+  if (bottom - top >= JOB_DEQUE_CAPACITY) return 0;
+
+  deque->jobs[bottom & (JOB_DEQUE_CAPACITY - 1)] = *job;
+  AtomicStoreI64(&deque->bottom, bottom + 1);
+  return 1;
+}
+
+i32 PopJob(JobDeque *deque, Job *job)
+{
+  i64 bottom = deque->bottom - 1;
+  AtomicStoreI64(&deque->bottom, bottom);
+  i64 top = AtomicLoadI64(&deque->top);
+  if (top > bottom)
+  {
+    AtomicStoreI64(&deque->bottom, bottom + 1);
+    return 0;
+  }
+
+  *job = deque->jobs[bottom & (JOB_DEQUE_CAPACITY - 1)];
+  if (top == bottom)
+  {
+    // Last job, race the thieves for it.
+    i32 won = AtomicCompareExchangeI64(&deque->top, top, top + 1);
+    AtomicStoreI64(&deque->bottom, bottom + 1);
+    return won;
+  }
+  return 1;
+}
+
+i32 StealJob(JobDeque *deque, Job *job)
+{
+  i64 top = AtomicLoadI64(&deque->top);
+  i64 bottom = AtomicLoadI64(&deque->bottom);
+  if (top >= bottom) return 0;
+
+  *job = deque->jobs[top & (JOB_DEQUE_CAPACITY - 1)];
+  return AtomicCompareExchangeI64(&deque->top, top, top + 1);
+}
+
+void RunJob(JobWorker *worker, Job *job)
+{
+  i32 grainSize = worker->system->grainSize;
+  while (job->end - job->begin > grainSize)
+  {
+    i32 middle = job->begin + (job->end - job->begin) / 2;
+    Job upper = { job->run, job->data, middle, job->end };
+    if (!PushJob(&worker->deque, &upper)) break;
+    job->end = middle;
+  }
+
+  PROFILE_BEGIN(RunJob);
+  job->run(worker, job->data, job->begin, job->end);
+  PROFILE_END(RunJob);
+  worker->itemsRun += job->end - job->begin;
+  AtomicAddI64(&worker->system->remaining, -(i64)(job->end - job->begin));
+}
+
+i32 TryStealJob(JobWorker *worker, Job *job)
+{
+  JobSystem *system = worker->system;
+  if (system->workerCount < 2) return 0;
+
+  // xorshift, start from a random victim so thieves spread out.
+  worker->random ^= worker->random << 13;
+  worker->random ^= worker->random >> 17;
+  worker->random ^= worker->random << 5;
+  i32 first = (i32)(worker->random % (u32)system->workerCount);
+  for (i32 i = 0; i < system->workerCount; ++i)
+  {
+    JobWorker *victim = &system->workers[(first + i) % system->workerCount];
+    if (victim == worker) continue;
+    if (StealJob(&victim->deque, job))
+    {
+      ++worker->steals;
+      return 1;
+    }
+  }
+  return 0;
+}
+
+void WorkerLoop(JobWorker *worker)
+{
+  Job job;
+  while (AtomicLoadI64(&worker->system->remaining) > 0)
+  {
+    if (PopJob(&worker->deque, &job) || TryStealJob(worker, &job)) RunJob(worker, &job);
+    else PlatformYield();
+  }
+}
+
+// Sleeps until RunParallelFor starts a new generation of work, helps with it and reports back as idle.
+PLATFORM_THREAD_PROC(WorkerThreadProc)
+{
+  PROFILE_THREAD_NAME("job worker");
+  JobWorker *worker = (JobWorker *)parameter;
+  JobSystem *system = worker->system;
+  PlatformLockMutex(&system->mutex);
+  for (;;)
+  {
+    while (!system->stopping && system->generation == worker->generation) PlatformWaitCondition(&system->wake, &system->mutex);
+    if (system->stopping) break;
+    worker->generation = system->generation;
+    PlatformUnlockMutex(&system->mutex);
+
+    WorkerLoop(worker);
+
+    PlatformLockMutex(&system->mutex);
+    if (--system->busyThreads == 0) PlatformWakeAllCondition(&system->idle);
+  }
+  PlatformUnlockMutex(&system->mutex);
+  ReleaseScratchArenas();
+  PLATFORM_THREAD_RETURN;
+}
+
+void DestroyJobSystem(JobSystem *system)
+{
+  PlatformLockMutex(&system->mutex);
+  system->stopping = 1;
+  PlatformWakeAllCondition(&system->wake);
+  PlatformUnlockMutex(&system->mutex);
+  for (i32 i = 1; i <= system->threadCount; ++i)
+  {
+    PlatformJoinThread(system->workers[i].thread);
+  }
+  PlatformDestroyCondition(&system->idle);
+  PlatformDestroyCondition(&system->wake);
+  PlatformDestroyMutex(&system->mutex);
+
+  for (i32 i = 0; i < system->workerCount; ++i)
+  {
+    ReleaseArena(&system->workers[i].arena);
+  }
+}
+
+// Each worker gets an arena reserving arenaSize bytes, committed as it grows. Workers other than the
+// caller's get a thread that lives until DestroyJobSystem.
+JobSystem *CreateJobSystem(Arena *arena, i32 workerCount, size_t arenaSize)
+{
+  if (workerCount < 1) workerCount = 1;
+  if (workerCount > JOB_MAX_WORKERS) workerCount = JOB_MAX_WORKERS;
+
+  JobSystem *system = (JobSystem *)Alloc(arena, sizeof(JobSystem));
+  system->workerCount = workerCount;
+  system->workers = (JobWorker *)AllocAlign(arena, workerCount * sizeof(JobWorker), CACHE_LINE_SIZE);
+  PlatformInitMutex(&system->mutex);
+  PlatformInitCondition(&system->wake);
+  PlatformInitCondition(&system->idle);
+  for (i32 i = 0; i < workerCount; ++i)
+  {
+    JobWorker *worker = &system->workers[i];
+    worker->index = i;
+    worker->system = system;
+    worker->random = 0x9E3779B9u * (u32)(i + 1);
+    if (!InitVirtualArena(&worker->arena, arenaSize))
+    {
+      fprintf(stderr, "Failed to reserve the arena of worker %d\n", i);
+      system->workerCount = i;
+      DestroyJobSystem(system);
+      return NULL;
+    }
+  }
+
+  // Workers whose thread fails to start keep an empty deque, the others do their share.
+  for (i32 i = 1; i < workerCount; ++i)
+  {
+    if (!PlatformCreateThread(&system->workers[i].thread, WorkerThreadProc, &system->workers[i])) break;
+    system->threadCount = i;
+  }
+  return system;
+}
+
+// Calls run over [0, count) in ranges of at most grainSize items and returns once all of them are done
+// and every worker is asleep again. The calling thread works as worker 0.
+void RunParallelFor(JobSystem *system, JobFunction *run, void *data, i32 count, i32 grainSize)
+{
+  if (count <= 0) return;
+
+  system->grainSize = grainSize > 0 ? grainSize : 1;
+  AtomicStoreI64(&system->remaining, count);
+  Job job = { run, data, 0, count };
+  PushJob(&system->workers[0].deque, &job);
+
+  PlatformLockMutex(&system->mutex);
+  system->busyThreads = system->threadCount;
+  ++system->generation;
+  PlatformWakeAllCondition(&system->wake);
+  PlatformUnlockMutex(&system->mutex);
+
+  WorkerLoop(&system->workers[0]);
+
+  PlatformLockMutex(&system->mutex);
+  while (system->busyThreads) PlatformWaitCondition(&system->idle, &system->mutex);
+  PlatformUnlockMutex(&system->mutex);
+#if PROFILE
+  i64 highWater = 0;
+  for (i32 i = 0; i < system->workerCount; ++i) highWater += (i64)system->workers[i].arena.highWater;
+  PROFILE_COUNTER("worker arenas", "high water", highWater);
+#endif
+}
@@ -0,0 +1,588 @@
+//SPECS: https://learn.microsoft.com/en-us/typography/opentype/spec/gpos#lookup-type-2-subtable-pair-adjustment-positioning
+
+// Pair kerning compiled at load time from the GPOS 'kern' feature, or from the legacy kern table when
+// GPOS has none. Glyph pairs (PairPos format 1, kern format 0) go into one bucketed hash table,
+// class kerning (PairPos format 2) keeps per-glyph class arrays and the dense class-pair matrix. Glyphs a
+// class subtable does not apply to point at a zero row or column and the class values are folded into
+// the glyph pairs that override them, so a lookup is one bucket compare plus two loads per class subtable
+// with no branch on the data. Only the x advance of the first glyph is kept, which is what kerning uses;
+// placements and device tables are ignored.
+
+#define KERNING_EMPTY_KEY 0xFFFFFFFF // Glyph ids stop at 0xFFFE, the key of 0xFFFF/0xFFFF never occurs.
+#define KERNING_MAX_LOOKUPS 32 // Lookups past this share the last precedence bit.
+#define KERNING_BUCKET_SIZE 4
+#define KERNING_NO_GLYPH 0xFFFF
+
+typedef enum {
+  VALUE_X_PLACEMENT = 0x0001,
+  VALUE_Y_PLACEMENT = 0x0002,
+  VALUE_X_ADVANCE = 0x0004,
+  VALUE_Y_ADVANCE = 0x0008,
+  VALUE_X_PLACEMENT_DEVICE = 0x0010,
+  VALUE_Y_PLACEMENT_DEVICE = 0x0020,
+  VALUE_X_ADVANCE_DEVICE = 0x0040,
+  VALUE_Y_ADVANCE_DEVICE = 0x0080,
+} ValueFormatFlags; // Fields present in a ValueRecord, each one is 2 bytes.
+
+typedef enum {
+  KERN_HORIZONTAL = 0x0001,
+  KERN_MINIMUM = 0x0002,
+  KERN_CROSS_STREAM = 0x0004,
+  KERN_OVERRIDE = 0x0008,
+} KernCoverageFlags; // Version 0 kern subtables, the format is in the high byte.
+
+typedef struct {
+  u32 key; // left << 16 | right
+  i32 value;
+  u32 lookups; // Bit per GPOS lookup that matched the pair, class subtables of those lookups no longer apply.
+} KerningPair;
+
+// Open-addressed pairs while compiling, in a scratch arena.
+typedef struct {
+  u32 capacity;
+  u32 shift; // 32 - log2(capacity), the hash keeps the high bits of the product.
+  u32 count;
+  KerningPair *pairs;
+} KerningPairSet;
+
+typedef struct {
+  u32 keys[KERNING_BUCKET_SIZE]; // Filled in order, a bucket whose last key is empty ends a probe.
+  i32 values[KERNING_BUCKET_SIZE];
+} KerningBucket; // 32 bytes, a probe reads half a cache line.
+
+typedef struct {
+  u16 lookup; // Index of the precedence bit, subtables of one lookup stop at the first that matches.
+  u16 class1Count; // Row class1Count is zero, for glyphs not covered or covered by an earlier subtable.
+  u16 class2Count; // Column class2Count is zero, for classes past class2Count.
+  u16 *firstClasses; // Per glyph.
+  u16 *secondClasses; // Per glyph.
+  i16 *values; // (class1Count + 1) * (class2Count + 1) x advance adjustments.
+  u32 classDef2; // Offset in GPOS, subtables reading the same ClassDef2 share secondClasses.
+} KerningClassTable;
+
+typedef struct {
+  u16 numGlyphs;
+  u32 pairCount;
+  u32 bucketMask; // Bucket count - 1, a power of two.
+  u32 bucketShift;
+  KerningBucket *buckets;
+  i32 classTableCount;
+  KerningClassTable *classTables;
+} KerningTable;
+
+u32 HashKerningKey(u32 key, u32 shift)
+{
+  return (key * 0x9E3779B1u) >> shift;
+}
+
+// Sized for a load factor of at most 2/3, so probes stay short and the set never fills up.
+void InitKerningPairSet(Arena *arena, KerningPairSet *pairSet, u32 pairBound)
+{
+  pairSet->capacity = 16;
+  pairSet->shift = 28;
+  pairSet->count = 0;
+  while (pairSet->capacity < pairBound + pairBound / 2)
+  {
+    pairSet->capacity <<= 1;
+    --pairSet->shift;
+  }
+  pairSet->pairs = (KerningPair *)Alloc(arena, pairSet->capacity * sizeof(KerningPair));
+  for (u32 i = 0; i < pairSet->capacity; ++i) pairSet->pairs[i].key = KERNING_EMPTY_KEY;
+}
+
+KerningPair *FindOrAddKerningPair(KerningPairSet *pairSet, u32 key)
+{
+  u32 mask = pairSet->capacity - 1;
+  for (u32 slot = HashKerningKey(key, pairSet->shift);; slot = (slot + 1) & mask)
+  {
+    KerningPair *pair = &pairSet->pairs[slot];
+    if (pair->key == key) return pair;
+    if (pair->key == KERNING_EMPTY_KEY)
+    {
+      pair->key = key;
+      ++pairSet->count;
+      return pair;
+    }
+  }
+}
+
+i32 CountValueRecordFields(u16 valueFormat)
+{
+  i32 count = 0;
+  for (u16 bits = valueFormat & 0xFF; bits; bits &= bits - 1) ++count;
+  return count;
+}
+
+// Byte offset of XAdvance in a ValueRecord, -1 when the format has none.
+i32 GetXAdvanceOffset(u16 valueFormat)
+{
+  if (!(valueFormat & VALUE_X_ADVANCE)) return -1;
+  return CountValueRecordFields(valueFormat & (VALUE_X_PLACEMENT | VALUE_Y_PLACEMENT)) * 2;
+}
+
+// Glyphs by coverage index, KERNING_NO_GLYPH for indices no range provides.
+u16 *ReadCoverage(Arena *arena, FontView coverage, i32 *count)
+{
+  u16 format = ViewU16(coverage, 0);
+  u16 recordCount = ViewU16(coverage, 2);
+  *count = 0;
+  if (format == 1)
+  {
+    if (!FontViewContains(coverage, 4, recordCount * 2)) return NULL;
+    u16 *glyphs = (u16 *)AllocNoZero(arena, recordCount * sizeof(u16));
+    ReadBigEndianU16Array(glyphs, &coverage.data[4], recordCount);
+    *count = recordCount;
+    return glyphs;
+  }
+  if (format != 2 || !FontViewContains(coverage, 4, recordCount * 6)) return NULL;
+
+  i32 glyphCount = 0;
+  for (u16 i = 0; i < recordCount; ++i)
+  {
+    u16 start = ViewU16(coverage, 4 + i * 6), end = ViewU16(coverage, 6 + i * 6);
+    i32 last = ViewU16(coverage, 8 + i * 6) + end - start;
+    if (end >= start && last + 1 > glyphCount) glyphCount = last + 1;
+  }
+  u16 *glyphs = (u16 *)AllocNoZero(arena, glyphCount * sizeof(u16));
+  memset(glyphs, 0xFF, glyphCount * sizeof(u16));
+  for (u16 i = 0; i < recordCount; ++i)
+  {
+    u16 start = ViewU16(coverage, 4 + i * 6), end = ViewU16(coverage, 6 + i * 6);
+    u16 startCoverageIndex = ViewU16(coverage, 8 + i * 6);
+    for (i32 glyph = start; glyph <= end; ++glyph) glyphs[startCoverageIndex + glyph - start] = (u16)glyph;
+  }
+  *count = glyphCount;
+  return glyphs;
+}
+
+// Fills classes (numGlyphs entries, already holding the default class 0) from a ClassDef table.
+void ReadClassDef(FontView classDef, u16 *classes, u16 numGlyphs)
+{
+  u16 format = ViewU16(classDef, 0);
+  if (format == 1)
+  {
+    u16 startGlyph = ViewU16(classDef, 2);
+    u16 glyphCount = ViewU16(classDef, 4);
+    for (u32 i = 0; i < glyphCount && startGlyph + i < numGlyphs; ++i) classes[startGlyph + i] = ViewU16(classDef, 6 + i * 2);
+  }
+  else if (format == 2)
+  {
+    u16 rangeCount = ViewU16(classDef, 2);
+    for (u16 i = 0; i < rangeCount; ++i)
+    {
+      u16 start = ViewU16(classDef, 4 + i * 6), end = ViewU16(classDef, 6 + i * 6), value = ViewU16(classDef, 8 + i * 6);
+      for (u32 glyph = start; glyph <= end && glyph < numGlyphs; ++glyph) classes[glyph] = value;
+    }
+  }
+}
+
+// True when an earlier class subtable of the lookup applies to the first glyph, later pairs never match.
+i32 IsCoveredByClassTable(KerningTable *kerning, u16 left, u32 lookupBit)
+{
+  for (i32 i = 0; i < kerning->classTableCount; ++i)
+  {
+    KerningClassTable *table = &kerning->classTables[i];
+    if ((1u << table->lookup) == lookupBit && table->firstClasses[left] != table->class1Count) return 1;
+  }
+  return 0;
+}
+
+// Adds the pairs of a PairPos format 1 subtable, or only counts them when pairSet is NULL.
+u32 AddPairPosFormat1(KerningTable *kerning, KerningPairSet *pairSet, FontView subtable, u32 lookupBit)
+{
+  i32 coverageCount = 0;
+  TmpArena scratch;
+  TmpArenaPush(&scratch, GetScratchArena(NULL));
+  u16 *coverage = ReadCoverage(scratch.arena, FontSubView(subtable, ViewU16(subtable, 2), subtable.length - ViewU16(subtable, 2)), &coverageCount);
+
+  u16 valueFormat1 = ViewU16(subtable, 4), valueFormat2 = ViewU16(subtable, 6);
+  u16 pairSetCount = ViewU16(subtable, 8);
+  i32 recordSize = 2 + (CountValueRecordFields(valueFormat1) + CountValueRecordFields(valueFormat2)) * 2;
+  i32 xAdvanceOffset = GetXAdvanceOffset(valueFormat1);
+
+  u32 added = 0;
+  for (i32 i = 0; i < coverageCount && i < pairSetCount; ++i)
+  {
+    u16 left = coverage[i];
+    u16 pairSetOffset = ViewU16(subtable, 10 + i * 2);
+    FontView pairSetTable = FontSubView(subtable, pairSetOffset, subtable.length - pairSetOffset);
+    u16 pairValueCount = ViewU16(pairSetTable, 0);
+    if (left == KERNING_NO_GLYPH || !FontViewContains(pairSetTable, 2, pairValueCount * recordSize)) continue;
+    if (!pairSet)
+    {
+      added += pairValueCount;
+      continue;
+    }
+    if (left >= kerning->numGlyphs || IsCoveredByClassTable(kerning, left, lookupBit)) continue;
+
+    for (u16 j = 0; j < pairValueCount; ++j)
+    {
+      u8 *record = &pairSetTable.data[2 + j * recordSize];
+      u16 right = READ_BIG_ENDIAN_U16(record);
+      if (right >= kerning->numGlyphs) continue;
+
+      // An earlier subtable of the same lookup already matched this pair.
+      KerningPair *pair = FindOrAddKerningPair(pairSet, (u32)left << 16 | right);
+      if (pair->lookups & lookupBit) continue;
+      if (xAdvanceOffset >= 0) pair->value += READ_BIG_ENDIAN_I16(&record[2 + xAdvanceOffset]);
+      pair->lookups |= lookupBit;
+      ++added;
+    }
+  }
+
+  TmpArenaPop(&scratch);
+  return added;
+}
+
+// Fonts split large class kerning into subtables of one lookup that share ClassDef2 and cover different
+// glyphs. Their rows are stacked into the earlier table, so a lookup reads one matrix per lookup instead.
+void MergeLastClassTable(Arena *arena, KerningTable *kerning)
+{
+  KerningClassTable *table = &kerning->classTables[kerning->classTableCount - 1];
+  for (i32 i = 0; i < kerning->classTableCount - 1; ++i)
+  {
+    KerningClassTable *other = &kerning->classTables[i];
+    u32 rowCount = other->class1Count + table->class1Count;
+    if (other->lookup != table->lookup || other->secondClasses != table->secondClasses || rowCount >= KERNING_NO_GLYPH) continue;
+
+    u32 stride = table->class2Count + 1;
+    i16 *values = (i16 *)Alloc(arena, (u64)(rowCount + 1) * stride * sizeof(i16));
+    memcpy(values, other->values, (u64)other->class1Count * stride * sizeof(i16));
+    memcpy(&values[other->class1Count * stride], table->values, (u64)table->class1Count * stride * sizeof(i16));
+    for (u32 glyph = 0; glyph < kerning->numGlyphs; ++glyph)
+    {
+      u16 firstClass = table->firstClasses[glyph];
+      if (other->firstClasses[glyph] != other->class1Count) continue;
+      other->firstClasses[glyph] = (u16)(firstClass != table->class1Count ? other->class1Count + firstClass : rowCount);
+    }
+    other->class1Count = (u16)rowCount;
+    other->values = values;
+    --kerning->classTableCount;
+    return;
+  }
+}
+
+void AddPairPosFormat2(Arena *arena, KerningTable *kerning, FontView gpos, FontView subtable, u16 lookup)
+{
+  u16 coverageOffset = ViewU16(subtable, 2);
+  u16 valueFormat1 = ViewU16(subtable, 4), valueFormat2 = ViewU16(subtable, 6);
+  u16 classDef1Offset = ViewU16(subtable, 8), classDef2Offset = ViewU16(subtable, 10);
+  u16 class1Count = ViewU16(subtable, 12), class2Count = ViewU16(subtable, 14);
+  i32 recordSize = (CountValueRecordFields(valueFormat1) + CountValueRecordFields(valueFormat2)) * 2;
+  i32 xAdvanceOffset = GetXAdvanceOffset(valueFormat1);
+  if (xAdvanceOffset < 0 || !class1Count || !class2Count) return;
+  if (!FontViewContains(subtable, 16, (u32)class1Count * class2Count * recordSize)) return;
+
+  u16 numGlyphs = kerning->numGlyphs;
+  KerningClassTable *table = &kerning->classTables[kerning->classTableCount++];
+  memset(table, 0, sizeof(KerningClassTable));
+  table->lookup = lookup;
+  table->class1Count = class1Count;
+  table->class2Count = class2Count;
+
+  TmpArena scratch;
+  TmpArenaPush(&scratch, GetScratchArena(arena));
+  i32 coverageCount = 0;
+  u16 *coverage = ReadCoverage(scratch.arena, FontSubView(subtable, coverageOffset, subtable.length - coverageOffset), &coverageCount);
+  u16 *classes = (u16 *)Alloc(scratch.arena, numGlyphs * sizeof(u16));
+  ReadClassDef(FontSubView(subtable, classDef1Offset, subtable.length - classDef1Offset), classes, numGlyphs);
+  table->firstClasses = (u16 *)AllocNoZero(arena, numGlyphs * sizeof(u16) + SIMD_PADDING);
+  for (u32 i = 0; i < numGlyphs; ++i) table->firstClasses[i] = class1Count;
+  for (i32 i = 0; i < coverageCount; ++i)
+  {
+    u16 glyph = coverage[i];
+    if (glyph < numGlyphs && classes[glyph] < class1Count) table->firstClasses[glyph] = classes[glyph];
+  }
+  TmpArenaPop(&scratch);
+
+  // The first subtable of a lookup that covers a glyph is the only one to apply to it. A second glyph
+  // class past class2Count would let the next subtable try, such fonts keep the zero of the first instead.
+  for (i32 i = 0; i < kerning->classTableCount - 1; ++i)
+  {
+    KerningClassTable *other = &kerning->classTables[i];
+    if (other->lookup != lookup) continue;
+    for (u32 glyph = 0; glyph < numGlyphs; ++glyph)
+    {
+      if (other->firstClasses[glyph] != other->class1Count) table->firstClasses[glyph] = class1Count;
+    }
+  }
+
+  table->classDef2 = (u32)(subtable.data - gpos.data) + classDef2Offset;
+  for (i32 i = 0; i < kerning->classTableCount - 1; ++i)
+  {
+    KerningClassTable *other = &kerning->classTables[i];
+    if (other->classDef2 == table->classDef2 && other->class2Count == class2Count) table->secondClasses = other->secondClasses;
+  }
+  if (!table->secondClasses)
+  {
+    table->secondClasses = (u16 *)Alloc(arena, numGlyphs * sizeof(u16) + SIMD_PADDING);
+    ReadClassDef(FontSubView(subtable, classDef2Offset, subtable.length - classDef2Offset), table->secondClasses, numGlyphs);
+    for (u32 i = 0; i < numGlyphs; ++i)
+    {
+      if (table->secondClasses[i] > class2Count) table->secondClasses[i] = class2Count;
+    }
+  }
+
+  u32 stride = class2Count + 1;
+  table->values = (i16 *)Alloc(arena, (u64)(class1Count + 1) * stride * sizeof(i16));
+  for (u32 i = 0; i < class1Count; ++i)
+  {
+    u8 *records = &subtable.data[16 + i * class2Count * recordSize];
+    for (u32 j = 0; j < class2Count; ++j) table->values[i * stride + j] = READ_BIG_ENDIAN_I16(&records[j * recordSize + xAdvanceOffset]);
+  }
+  MergeLastClassTable(arena, kerning);
+}
+
+i32 GetClassKerning(KerningTable *kerning, u16 left, u16 right)
+{
+  i32 value = 0;
+  for (i32 i = 0; i < kerning->classTableCount; ++i)
+  {
+    KerningClassTable *table = &kerning->classTables[i];
+    value += table->values[table->firstClasses[left] * (table->class2Count + 1) + table->secondClasses[right]];
+  }
+  return value;
+}
+
+// Adds to every glyph pair the class values of the lookups it did not match, so that a pair found in the
+// hash table has its final value, then packs the pairs into buckets.
+void CompileKerningPairs(Arena *arena, KerningTable *kerning, KerningPairSet *pairSet)
+{
+  u32 bucketCount = 2;
+  kerning->bucketShift = 31;
+  while (bucketCount * KERNING_BUCKET_SIZE < pairSet->count + pairSet->count / 2)
+  {
+    bucketCount <<= 1;
+    --kerning->bucketShift;
+  }
+  kerning->bucketMask = bucketCount - 1;
+  kerning->buckets = (KerningBucket *)AllocAlign(arena, bucketCount * sizeof(KerningBucket), sizeof(KerningBucket));
+  memset(kerning->buckets, 0xFF, bucketCount * sizeof(KerningBucket));
+
+  for (u32 i = 0; i < pairSet->capacity; ++i)
+  {
+    KerningPair *pair = &pairSet->pairs[i];
+    if (pair->key == KERNING_EMPTY_KEY) continue;
+    u16 left = (u16)(pair->key >> 16), right = (u16)pair->key;
+    for (i32 t = 0; t < kerning->classTableCount; ++t)
+    {
+      KerningClassTable *table = &kerning->classTables[t];
+      if (pair->lookups & (1u << table->lookup)) continue;
+      pair->value += table->values[table->firstClasses[left] * (table->class2Count + 1) + table->secondClasses[right]];
+    }
+
+    for (u32 b = HashKerningKey(pair->key, kerning->bucketShift);; b = (b + 1) & kerning->bucketMask)
+    {
+      KerningBucket *bucket = &kerning->buckets[b];
+      if (bucket->keys[KERNING_BUCKET_SIZE - 1] != KERNING_EMPTY_KEY) continue;
+      i32 slot = 0;
+      while (bucket->keys[slot] != KERNING_EMPTY_KEY) ++slot;
+      bucket->keys[slot] = pair->key;
+      bucket->values[slot] = pair->value;
+      break;
+    }
+  }
+  kerning->pairCount = pairSet->count;
+}
+
+// PairPos subtables of a lookup, seen through Extension lookups (type 9) when needed.
+FontView GetPairPosSubtable(FontView lookup, u16 index)
+{
+  FontView none = {0};
+  u16 lookupType = ViewU16(lookup, 0);
+  u16 offset = ViewU16(lookup, 6 + index * 2);
+  FontView subtable = FontSubView(lookup, offset, lookup.length - offset);
+  if (lookupType == 9)
+  {
+    if (ViewU16(subtable, 0) != 1 || ViewU16(subtable, 2) != 2) return none;
+    u32 extensionOffset = ViewU32(subtable, 4);
+    return FontSubView(subtable, extensionOffset, subtable.length > extensionOffset ? subtable.length - extensionOffset : 0);
+  }
+  return lookupType == 2 ? subtable : none;
+}
+
+// Marks the lookups referenced by every 'kern' feature, whatever the script and language.
+i32 FindKerningLookups(FontView gpos, u8 *isKerning, u16 lookupCount)
+{
+  u16 featureListOffset = ViewU16(gpos, 6);
+  FontView featureList = FontSubView(gpos, featureListOffset, gpos.length - featureListOffset);
+  u16 featureCount = ViewU16(featureList, 0);
+  i32 found = 0;
+  for (u16 i = 0; i < featureCount; ++i)
+  {
+    if (ViewU32(featureList, 2 + i * 6) != READ_BIG_ENDIAN_U32("kern")) continue;
+    u16 featureOffset = ViewU16(featureList, 6 + i * 6);
+    FontView feature = FontSubView(featureList, featureOffset, featureList.length - featureOffset);
+    u16 lookupIndexCount = ViewU16(feature, 2);
+    for (u16 j = 0; j < lookupIndexCount; ++j)
+    {
+      u16 lookupIndex = ViewU16(feature, 4 + j * 2);
+      if (lookupIndex < lookupCount && !isKerning[lookupIndex])
+      {
+        isKerning[lookupIndex] = 1;
+        ++found;
+      }
+    }
+  }
+  return found;
+}
+
+i32 LoadGposKerning(Arena *arena, Font *font, KerningTable *kerning)
+{
+  FontView gpos = GetFontTable(font, FONT_TABLE_GPOS);
+  if (ViewU16(gpos, 0) != 1) return 0;
+
+  u16 lookupListOffset = ViewU16(gpos, 8);
+  FontView lookupList = FontSubView(gpos, lookupListOffset, gpos.length - lookupListOffset);
+  u16 lookupCount = ViewU16(lookupList, 0);
+
+  TmpArena scratch;
+  TmpArenaPush(&scratch, GetScratchArena(arena));
+  u8 *isKerning = (u8 *)Alloc(scratch.arena, lookupCount + 1);
+  if (!FindKerningLookups(gpos, isKerning, lookupCount))
+  {
+    TmpArenaPop(&scratch);
+    return 0;
+  }
+
+  // Sizing pass, lookups apply in LookupList order.
+  u32 pairBound = 0;
+  i32 classTableBound = 0;
+  for (u16 i = 0; i < lookupCount; ++i)
+  {
+    if (!isKerning[i]) continue;
+    u16 lookupOffset = ViewU16(lookupList, 2 + i * 2);
+    FontView lookup = FontSubView(lookupList, lookupOffset, lookupList.length - lookupOffset);
+    for (u16 j = 0; j < ViewU16(lookup, 4); ++j)
+    {
+      FontView subtable = GetPairPosSubtable(lookup, j);
+      u16 format = ViewU16(subtable, 0);
+      if (format == 1) pairBound += AddPairPosFormat1(kerning, NULL, subtable, 0);
+      else if (format == 2) ++classTableBound;
+    }
+  }
+
+  KerningPairSet pairSet;
+  InitKerningPairSet(scratch.arena, &pairSet, pairBound);
+  kerning->classTables = (KerningClassTable *)Alloc(arena, classTableBound * sizeof(KerningClassTable));
+
+  u16 order = 0;
+  for (u16 i = 0; i < lookupCount; ++i)
+  {
+    if (!isKerning[i]) continue;
+    u16 lookupIndex = order < KERNING_MAX_LOOKUPS ? order : KERNING_MAX_LOOKUPS - 1;
+    ++order;
+    u16 lookupOffset = ViewU16(lookupList, 2 + i * 2);
+    FontView lookup = FontSubView(lookupList, lookupOffset, lookupList.length - lookupOffset);
+    for (u16 j = 0; j < ViewU16(lookup, 4); ++j)
+    {
+      FontView subtable = GetPairPosSubtable(lookup, j);
+      u16 format = ViewU16(subtable, 0);
+      if (format == 1) AddPairPosFormat1(kerning, &pairSet, subtable, 1u << lookupIndex);
+      else if (format == 2 && kerning->classTableCount < classTableBound) AddPairPosFormat2(arena, kerning, gpos, subtable, lookupIndex);
+    }
+  }
+  CompileKerningPairs(arena, kerning, &pairSet);
+
+  TmpArenaPop(&scratch);
+  return 1;
+}
+
+// Format 0 subtables of the legacy table, Microsoft (version 0) and Apple (version 1.0) headers.
+// Adds the pairs, or only counts them when pairSet is NULL.
+u32 AddLegacyKerning(KerningTable *kerning, KerningPairSet *pairSet, FontView kern)
+{
+  i32 apple = ViewU32(kern, 0) == 0x00010000;
+  u32 tableCount = apple ? ViewU32(kern, 4) : ViewU16(kern, 2);
+  u32 offset = apple ? 8 : 4;
+  u32 added = 0;
+  for (u32 i = 0; i < tableCount && offset < kern.length; ++i)
+  {
+    u32 length = apple ? ViewU32(kern, offset) : ViewU16(kern, offset + 2);
+    u16 coverage = ViewU16(kern, offset + 4);
+    u32 headerSize = apple ? 8 : 6;
+    i32 format = apple ? coverage & 0xFF : coverage >> 8;
+    i32 horizontal = apple ? !(coverage & 0xE000) : (coverage & (KERN_HORIZONTAL | KERN_MINIMUM | KERN_CROSS_STREAM)) == KERN_HORIZONTAL;
+    i32 override = !apple && (coverage & KERN_OVERRIDE);
+
+    // Version 0 lengths are 16 bits, a large format 0 subtable overflows its own length field.
+    u16 pairCount = ViewU16(kern, offset + headerSize);
+    u32 pairsOffset = offset + headerSize + 8;
+    if (format == 0 && horizontal && FontViewContains(kern, pairsOffset, pairCount * 6))
+    {
+      for (u16 j = 0; j < pairCount; ++j)
+      {
+        u8 *record = &kern.data[pairsOffset + j * 6];
+        u16 left = READ_BIG_ENDIAN_U16(record), right = READ_BIG_ENDIAN_U16(&record[2]);
+        ++added;
+        if (!pairSet || left >= kerning->numGlyphs || right >= kerning->numGlyphs) continue;
+        KerningPair *pair = FindOrAddKerningPair(pairSet, (u32)left << 16 | right);
+        i16 value = READ_BIG_ENDIAN_I16(&record[4]);
+        pair->value = override ? value : pair->value + value;
+      }
+      length = length > pairsOffset + pairCount * 6 - offset ? length : pairsOffset + pairCount * 6 - offset;
+    }
+    if (!length) break;
+    offset += length;
+  }
+  return added;
+}
+
+i32 LoadKerningTable(Arena *arena, Font *font, KerningTable *kerning)
+{
+  memset(kerning, 0, sizeof(KerningTable));
+  kerning->numGlyphs = ViewU16(GetFontTable(font, FONT_TABLE_MAXP), 4);
+  if (LoadGposKerning(arena, font, kerning)) return 1;
+
+  FontView kern = GetFontTable(font, FONT_TABLE_KERN);
+  u32 pairBound = AddLegacyKerning(kerning, NULL, kern);
+  if (!pairBound) return 0;
+
+  TmpArena scratch;
+  TmpArenaPush(&scratch, GetScratchArena(arena));
+  KerningPairSet pairSet;
+  InitKerningPairSet(scratch.arena, &pairSet, pairBound);
+  AddLegacyKerning(kerning, &pairSet, kern);
+  CompileKerningPairs(arena, kerning, &pairSet);
+  TmpArenaPop(&scratch);
+  return 1;
+}
+
+// x advance adjustment in font units between two consecutive glyphs.
+i32 GetKerning(KerningTable *kerning, u16 left, u16 right)
+{
+  if (left >= kerning->numGlyphs || right >= kerning->numGlyphs) return 0;
+
+  i32 value = GetClassKerning(kerning, left, right);
+  if (!kerning->pairCount) return value;
+
+  // Compares every key of a bucket and selects the value without branching, only a full bucket moves on.
+  u32 key = (u32)left << 16 | right;
+  i32 found = 0, pairValue = 0;
+  for (u32 b = HashKerningKey(key, kerning->bucketShift);; b = (b + 1) & kerning->bucketMask)
+  {
+    KerningBucket *bucket = &kerning->buckets[b];
+    for (i32 i = 0; i < KERNING_BUCKET_SIZE; ++i)
+    {
+      i32 match = bucket->keys[i] == key;
+      found |= match;
+      pairValue += bucket->values[i] & -match;
+    }
+    if (found || bucket->keys[KERNING_BUCKET_SIZE - 1] == KERNING_EMPTY_KEY) break;
+  }
+  return found ? pairValue : value;
+}
+
+// Advance of every glyph including the kerning with the next one, in font units. Returns the run width.
+i64 GetGlyphRunAdvances(HorizontalMetrics *metrics, KerningTable *kerning, u16 *glyphIds, i32 count, i32 *advances)
+{
+  i64 width = 0;
+  for (i32 i = 0; i < count; ++i)
+  {
+    i32 advance = GetAdvanceWidth(metrics, glyphIds[i]);
+    if (kerning && i + 1 < count) advance += GetKerning(kerning, glyphIds[i], glyphIds[i + 1]);
+    advances[i] = advance;
+    width += advance;
+  }
+  return width;
+}
@@ -0,0 +1,412 @@
+// Single-font text layout: UTF-8 is cut into runs that end after the spaces following a word, each run
+// is shaped once (cmap, advances and the kerning inside it) and then placed on lines by greedy breaking.
+// Shaped runs are kept in a cache keyed by a hash of their bytes, so repeated words, labels and log
+// lines only go through the cmap and the kerning table the first time they are seen.
+//
+// Lines break after ASCII spaces and tabs and on '\n', a run wider than a line is broken between glyphs.
+// Positions are kept in font units and only scaled to pixels when written out.
+
+#define RUN_CACHE_MAX_TEXT 256 // Longer runs are shaped every time, they rarely repeat.
+#define RUN_MAX_TEXT 4096 // Words past this are cut into several runs, they are broken between glyphs anyway.
+
+typedef struct {
+  CodepointMap codepointMap;
+  HorizontalMetrics metrics;
+  KerningTable kerning; // Empty when the font has no pair kerning.
+  u16 unitsPerEm;
+} TextFont;
+
+typedef struct {
+  u64 hash; // 0 marks an empty slot.
+  TextFont *font;
+  u8 *data; // Advances, then glyph ids, then the text bytes.
+  u16 textLength;
+  u16 glyphCount;
+  u16 trailingGlyphCount; // Spaces ending the run, they hang past the end of a line.
+  i32 width; // Sum of the advances, in font units.
+  i32 trailingWidth;
+} ShapedRun;
+
+typedef struct {
+  u32 entryCount;
+  ShapedRun *entries;
+  u8 *data;
+  u32 dataUsed;
+} RunCacheGeneration;
+
+// Two generations: runs are added to the current one and a hit in the previous one moves the run over.
+// When the current generation fills up the previous one is dropped and they swap, so runs still in use
+// survive and runs unused for a whole generation go away, without bookkeeping on hits.
+typedef struct {
+  u32 entryCapacity; // Per generation, a power of two. Tables are open addressed with linear probing.
+  u32 dataCapacity; // Per generation.
+  i32 current;
+  RunCacheGeneration generations[2];
+
+  u64 hits;
+  u64 misses;
+  u64 rotations;
+} RunCache;
+
+typedef struct {
+  u16 glyphId;
+  f32 x; // Pen position in pixels.
+  f32 y; // Baseline in pixels, growing downwards.
+} PositionedGlyph;
+
+typedef struct {
+  i32 firstGlyph;
+  i32 glyphCount;
+  i32 textOffset; // Bytes of the text on this line, including trailing spaces but not the line break.
+  i32 textLength;
+  f32 width; // In pixels, without the trailing spaces.
+  f32 baseline;
+} TextLine;
+
+typedef struct {
+  PositionedGlyph *glyphs;
+  i32 glyphCount;
+  TextLine *lines;
+  i32 lineCount;
+  f32 width; // Widest line.
+  f32 height;
+} TextLayout;
+
+i32 LoadTextFont(Arena *arena, Font *font, TextFont *textFont)
+{
+  memset(textFont, 0, sizeof(TextFont));
+  FontHeaderTable *fontHeader = ReadFontHeaderTable(arena, GetFontTable(font, FONT_TABLE_HEAD));
+  if (!fontHeader || !fontHeader->unitsPerEm) return 0;
+  if (!LoadCodepointMap(arena, font, &textFont->codepointMap, CODEPOINT_MAP_BMP_TABLE)) return 0;
+  PROFILE_BEGIN(LoadHorizontalMetrics);
+  i32 loaded = LoadHorizontalMetrics(arena, font, &textFont->metrics);
+  PROFILE_END(LoadHorizontalMetrics);
+  if (!loaded) return 0;
+  PROFILE_BEGIN(LoadKerningTable);
+  LoadKerningTable(arena, font, &textFont->kerning);
+  PROFILE_END(LoadKerningTable);
+  textFont->unitsPerEm = fontHeader->unitsPerEm;
+  return 1;
+}
+
+RunCache *CreateRunCache(Arena *arena, u32 entryCapacity, u32 dataCapacity)
+{
+  RunCache *cache = (RunCache *)Alloc(arena, sizeof(RunCache));
+  cache->entryCapacity = 16;
+  while (cache->entryCapacity < entryCapacity) cache->entryCapacity <<= 1;
+  cache->dataCapacity = dataCapacity;
+  for (i32 i = 0; i < 2; ++i)
+  {
+    cache->generations[i].entries = (ShapedRun *)Alloc(arena, cache->entryCapacity * sizeof(ShapedRun));
+    cache->generations[i].data = (u8 *)AllocNoZero(arena, dataCapacity);
+  }
+  return cache;
+}
+
+void RotateRunCache(RunCache *cache)
+{
+  cache->current ^= 1;
+  RunCacheGeneration *generation = &cache->generations[cache->current];
+  memset(generation->entries, 0, cache->entryCapacity * sizeof(ShapedRun));
+  generation->entryCount = 0;
+  generation->dataUsed = 0;
+  ++cache->rotations;
+}
+
+u64 HashRunText(u8 *text, i32 length, u64 seed)
+{
+  u64 hash = seed ^ ((u64)length * 0x9E3779B97F4A7C15ull);
+  i32 i = 0;
+  for (; i + 8 <= length; i += 8)
+  {
+    u64 word;
+    memcpy(&word, &text[i], 8);
+    hash = (hash ^ word) * 0xFF51AFD7ED558CCDull;
+    hash ^= hash >> 32;
+  }
+  u64 tail = 0;
+  memcpy(&tail, &text[i], length - i);
+  hash = (hash ^ tail) * 0xC4CEB9FE1A85EC53ull;
+  hash ^= hash >> 29;
+  return hash | 1;
+}
+
+i32 *GetShapedRunAdvances(ShapedRun *run)
+{
+  return (i32 *)run->data;
+}
+
+u16 *GetShapedRunGlyphIds(ShapedRun *run)
+{
+  return (u16 *)&run->data[run->glyphCount * sizeof(i32)];
+}
+
+// Shapes text into glyphIds and advances (room for length entries each), fills the run widths.
+void ShapeRun(TextFont *font, u8 *text, i32 length, u16 *glyphIds, i32 *advances, ShapedRun *run)
+{
+  run->glyphCount = (u16)GlyphIndicesFromUtf8(&font->codepointMap, text, length, glyphIds);
+  KerningTable *kerning = font->kerning.pairCount || font->kerning.classTableCount ? &font->kerning : NULL;
+  run->width = (i32)GetGlyphRunAdvances(&font->metrics, kerning, glyphIds, run->glyphCount, advances);
+
+  // Spaces are single bytes that decode to one glyph each, so the trailing ones are the last glyphs.
+  run->trailingGlyphCount = 0;
+  run->trailingWidth = 0;
+  for (i32 i = length - 1; i >= 0 && (text[i] == ' ' || text[i] == '\t'); --i)
+  {
+    run->trailingWidth += advances[run->glyphCount - ++run->trailingGlyphCount];
+  }
+}
+
+ShapedRun *FindShapedRun(RunCacheGeneration *generation, u32 mask, u64 hash, TextFont *font, u8 *text, i32 length)
+{
+  u32 slot = (u32)(hash >> 32) & mask;
+  for (ShapedRun *run = &generation->entries[slot]; run->hash; slot = (slot + 1) & mask, run = &generation->entries[slot])
+  {
+    if (run->hash == hash && run->font == font && run->textLength == length &&
+        !memcmp(&GetShapedRunGlyphIds(run)[run->glyphCount], text, length))
+    {
+      return run;
+    }
+  }
+  return NULL;
+}
+
+// Takes a slot and size bytes of data in the current generation, NULL when it is full.
+ShapedRun *AddShapedRun(RunCache *cache, u64 hash, u32 size)
+{
+  RunCacheGeneration *generation = &cache->generations[cache->current];
+  if (generation->entryCount + 1 > cache->entryCapacity / 4 * 3 || generation->dataUsed + size > cache->dataCapacity) return NULL;
+
+  u32 mask = cache->entryCapacity - 1;
+  u32 slot = (u32)(hash >> 32) & mask;
+  while (generation->entries[slot].hash) slot = (slot + 1) & mask;
+  ShapedRun *run = &generation->entries[slot];
+  run->hash = hash;
+  run->data = &generation->data[generation->dataUsed];
+  ++generation->entryCount;
+  generation->dataUsed += (size + 3) & ~3u;
+  return run;
+}
+
+// Returns the cached run, shaping it on a miss. NULL when the run does not fit in the cache.
+ShapedRun *GetShapedRun(RunCache *cache, TextFont *font, u8 *text, i32 length)
+{
+  u32 size = length * (sizeof(i32) + sizeof(u16) + 1) + SIMD_PADDING; // A run never has more glyphs than bytes.
+  if (length > RUN_CACHE_MAX_TEXT || size > cache->dataCapacity) return NULL;
+
+  u64 hash = HashRunText(text, length, (u64)(uintptr_t)font);
+  u32 mask = cache->entryCapacity - 1;
+  ShapedRun *run = FindShapedRun(&cache->generations[cache->current], mask, hash, font, text, length);
+  if (run)
+  {
+    ++cache->hits;
+    return run;
+  }
+
+  // Still valid until the next rotation, moved over when the current generation has room.
+  ShapedRun *previous = FindShapedRun(&cache->generations[cache->current ^ 1], mask, hash, font, text, length);
+  if (previous)
+  {
+    ++cache->hits;
+    u32 dataSize = previous->glyphCount * (sizeof(i32) + sizeof(u16)) + length;
+    run = AddShapedRun(cache, hash, dataSize);
+    if (!run) return previous;
+    u8 *data = run->data;
+    *run = *previous;
+    run->data = data;
+    memcpy(run->data, previous->data, dataSize);
+    return run;
+  }
+
+  ++cache->misses;
+  run = AddShapedRun(cache, hash, size);
+  if (!run)
+  {
+    RotateRunCache(cache);
+    run = AddShapedRun(cache, hash, size);
+  }
+  run->font = font;
+  run->textLength = (u16)length;
+
+  // The glyph count is only known after shaping, the glyph ids are moved down next to the advances and
+  // the unused part of the reservation is given back.
+  RunCacheGeneration *generation = &cache->generations[cache->current];
+  i32 *advances = (i32 *)run->data;
+  u16 *glyphIds = (u16 *)&run->data[length * sizeof(i32)];
+  ShapeRun(font, text, length, glyphIds, advances, run);
+  memmove(GetShapedRunGlyphIds(run), glyphIds, run->glyphCount * sizeof(u16));
+  memcpy(&GetShapedRunGlyphIds(run)[run->glyphCount], text, length);
+  generation->dataUsed = (u32)(run->data - generation->data) + ((run->glyphCount * (sizeof(i32) + sizeof(u16)) + length + 3) & ~3u);
+  return run;
+}
+
+typedef struct {
+  TextLayout *layout;
+  TextFont *font;
+  u8 *text;
+  f32 scale;
+  f32 lineHeight;
+  i32 maxWidth; // In font units.
+  i32 pen;
+  i32 contentWidth; // Pen position before the trailing spaces of the last run.
+  i32 lineStart; // Text offset of the current line.
+  i32 lineEnd;
+} LineBreaker;
+
+void StartLine(LineBreaker *breaker, i32 textOffset)
+{
+  TextLayout *layout = breaker->layout;
+  TextLine *line = &layout->lines[layout->lineCount++];
+  line->firstGlyph = layout->glyphCount;
+  line->glyphCount = 0;
+  line->baseline = breaker->font->metrics.horizontalHeader->ascender * breaker->scale + (layout->lineCount - 1) * breaker->lineHeight;
+  breaker->pen = 0;
+  breaker->contentWidth = 0;
+  breaker->lineStart = textOffset;
+  breaker->lineEnd = textOffset;
+}
+
+void FinishLine(LineBreaker *breaker)
+{
+  TextLayout *layout = breaker->layout;
+  TextLine *line = &layout->lines[layout->lineCount - 1];
+  line->glyphCount = layout->glyphCount - line->firstGlyph;
+  line->textOffset = breaker->lineStart;
+  line->textLength = breaker->lineEnd - breaker->lineStart;
+  line->width = breaker->contentWidth * breaker->scale;
+  if (line->width > layout->width) layout->width = line->width;
+}
+
+void PlaceGlyph(LineBreaker *breaker, u16 glyphId, i32 advance)
+{
+  TextLayout *layout = breaker->layout;
+  PositionedGlyph *glyph = &layout->glyphs[layout->glyphCount++];
+  glyph->glyphId = glyphId;
+  glyph->x = breaker->pen * breaker->scale;
+  glyph->y = layout->lines[layout->lineCount - 1].baseline;
+  breaker->pen += advance;
+}
+
+void PlaceRun(LineBreaker *breaker, u16 *glyphIds, i32 *advances, ShapedRun *run, i32 textOffset)
+{
+  TextLayout *layout = breaker->layout;
+  if (!run->glyphCount) return;
+
+  // Kerning with the last glyph of the line, runs are shaped on their own.
+  i32 kerning = 0;
+  TextLine *line = &layout->lines[layout->lineCount - 1];
+  if (layout->glyphCount > line->firstGlyph) kerning = GetKerning(&breaker->font->kerning, layout->glyphs[layout->glyphCount - 1].glyphId, glyphIds[0]);
+  i32 contentWidth = run->width - run->trailingWidth;
+  if (layout->glyphCount > line->firstGlyph && breaker->pen + kerning + contentWidth > breaker->maxWidth)
+  {
+    FinishLine(breaker);
+    StartLine(breaker, textOffset);
+    kerning = 0;
+  }
+  breaker->pen += kerning;
+
+  if (contentWidth <= breaker->maxWidth - breaker->pen)
+  {
+    for (i32 i = 0; i < run->glyphCount; ++i) PlaceGlyph(breaker, glyphIds[i], advances[i]);
+    breaker->contentWidth = breaker->pen - run->trailingWidth;
+  }
+  else
+  {
+    // Wider than a whole line, broken before the first glyph that overflows. Every glyph comes from one
+    // decoded sequence, decoding them again gives the text offset of the break.
+    i32 contentGlyphs = run->glyphCount - run->trailingGlyphCount;
+    i32 at = textOffset;
+    for (i32 i = 0; i < run->glyphCount; ++i)
+    {
+      if (i < contentGlyphs && layout->glyphCount > layout->lines[layout->lineCount - 1].firstGlyph &&
+          breaker->pen + advances[i] > breaker->maxWidth)
+      {
+        breaker->lineEnd = at;
+        FinishLine(breaker);
+        StartLine(breaker, at);
+      }
+      PlaceGlyph(breaker, glyphIds[i], advances[i]);
+      if (i < contentGlyphs) breaker->contentWidth = breaker->pen;
+
+      u32 codepoint;
+      i32 consumed = 0;
+      DecodeUtf8(&breaker->text[at], textOffset + run->textLength - at, &codepoint, 1, &consumed);
+      at += consumed;
+    }
+  }
+  breaker->lineEnd = textOffset + run->textLength;
+}
+
+// Lays out text at pixelSize in lines of at most maxWidth pixels. cache may be NULL to shape every run.
+TextLayout *LayoutText(Arena *arena, TextFont *font, RunCache *cache, u8 *text, i32 length, f32 pixelSize, f32 maxWidth)
+{
+  PROFILE_BEGIN(LayoutText);
+  TextLayout *layout = (TextLayout *)Alloc(arena, sizeof(TextLayout));
+  layout->glyphs = (PositionedGlyph *)AllocNoZero(arena, (length + 1) * sizeof(PositionedGlyph));
+  layout->lines = (TextLine *)AllocNoZero(arena, (length + 1) * sizeof(TextLine));
+
+  HorizontalHeaderTable *horizontalHeader = font->metrics.horizontalHeader;
+  LineBreaker breaker = {0};
+  breaker.layout = layout;
+  breaker.font = font;
+  breaker.text = text;
+  breaker.scale = pixelSize / font->unitsPerEm;
+  breaker.lineHeight = (horizontalHeader->ascender - horizontalHeader->descender + horizontalHeader->lineGap) * breaker.scale;
+  f32 maxUnits = maxWidth / breaker.scale;
+  breaker.maxWidth = maxUnits < (f32)INT32_MAX ? (i32)maxUnits : INT32_MAX;
+  StartLine(&breaker, 0);
+
+  TmpArena scratch;
+  TmpArenaPush(&scratch, GetScratchArena(arena));
+  u16 *glyphIds = (u16 *)AllocNoZero(scratch.arena, length * sizeof(u16) + SIMD_PADDING);
+  i32 *advances = (i32 *)AllocNoZero(scratch.arena, length * sizeof(i32) + SIMD_PADDING);
+
+  i32 offset = 0;
+  while (offset < length)
+  {
+    // A run is a word and the spaces after it, or the text up to a line break.
+    i32 end = offset;
+    while (end < length && end - offset < RUN_MAX_TEXT && text[end] != ' ' && text[end] != '\t' && text[end] != '\n') ++end;
+    if (end - offset == RUN_MAX_TEXT && end < length)
+    {
+      while (end > offset + 1 && (text[end] & 0xC0) == 0x80) --end;
+    }
+    else
+    {
+      while (end < length && end - offset < RUN_MAX_TEXT && (text[end] == ' ' || text[end] == '\t')) ++end;
+    }
+    i32 runLength = end;
+    if (runLength > offset && end < length && text[end] == '\n' && text[end - 1] == '\r') --runLength;
+
+    ShapedRun *run = cache ? GetShapedRun(cache, font, &text[offset], runLength - offset) : NULL;
+    if (run) PlaceRun(&breaker, GetShapedRunGlyphIds(run), GetShapedRunAdvances(run), run, offset);
+    else
+    {
+      ShapedRun shaped = {0};
+      shaped.textLength = (u16)(runLength - offset);
+      ShapeRun(font, &text[offset], runLength - offset, glyphIds, advances, &shaped);
+      PlaceRun(&breaker, glyphIds, advances, &shaped, offset);
+    }
+
+    offset = end;
+    if (offset < length && text[offset] == '\n')
+    {
+      FinishLine(&breaker);
+      StartLine(&breaker, ++offset);
+    }
+  }
+  FinishLine(&breaker);
+
+  PROFILE_ARENA("scratch arena", scratch.arena);
+  TmpArenaPop(&scratch);
+  layout->height = layout->lineCount * breaker.lineHeight;
+#if PROFILE
+  if (cache)
+  {
+    PROFILE_COUNTER("run cache", "hits", cache->hits);
+    PROFILE_COUNTER("run cache", "misses", cache->misses);
+  }
+#endif
+  PROFILE_END(LayoutText);
+  return layout;
+}
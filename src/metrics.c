@@ -0,0 +1,98 @@
+//SPECS: https://learn.microsoft.com/en-us/typography/opentype/spec/hmtx
+
+typedef struct {
+  u16 majorVersion; // = 1
+  u16 minorVersion; // = 0
+  i16 ascender; // Distance from baseline of highest ascender.
+  i16 descender; // Distance from baseline of lowest descender, negative below the baseline.
+  i16 lineGap;
+  u16 advanceWidthMax;
+  i16 minLeftSideBearing;
+  i16 minRightSideBearing;
+  i16 xMaxExtent; // = max(lsb + (xMax - xMin))
+  i16 caretSlopeRise; // = 1 for vertical carets.
+  i16 caretSlopeRun; // = 0 for vertical carets.
+  i16 caretOffset;
+  i16 metricDataFormat; // = 0
+  u16 numberOfHMetrics; // Glyphs past this share the last advance width, as in monospaced fonts.
+} HorizontalHeaderTable; // 'hhea'
+
+// hmtx expanded to one entry per glyph, so lookups never branch on numberOfHMetrics.
+typedef struct {
+  HorizontalHeaderTable *horizontalHeader;
+  u16 numGlyphs;
+  u16 *advanceWidths;
+  i16 *leftSideBearings;
+} HorizontalMetrics;
+
+HorizontalHeaderTable *ReadHorizontalHeaderTable(Arena *arena, FontView hhea)
+{
+  FontCursor cursor = MakeFontCursor(hhea, 0);
+  if (!CursorReserve(&cursor, 36)) return NULL;
+
+  HorizontalHeaderTable *horizontalHeader = (HorizontalHeaderTable *)Alloc(arena, sizeof(HorizontalHeaderTable));
+  horizontalHeader->majorVersion = CursorU16(&cursor);
+  horizontalHeader->minorVersion = CursorU16(&cursor);
+  horizontalHeader->ascender = (i16)CursorU16(&cursor);
+  horizontalHeader->descender = (i16)CursorU16(&cursor);
+  horizontalHeader->lineGap = (i16)CursorU16(&cursor);
+  horizontalHeader->advanceWidthMax = CursorU16(&cursor);
+  horizontalHeader->minLeftSideBearing = (i16)CursorU16(&cursor);
+  horizontalHeader->minRightSideBearing = (i16)CursorU16(&cursor);
+  horizontalHeader->xMaxExtent = (i16)CursorU16(&cursor);
+  horizontalHeader->caretSlopeRise = (i16)CursorU16(&cursor);
+  horizontalHeader->caretSlopeRun = (i16)CursorU16(&cursor);
+  horizontalHeader->caretOffset = (i16)CursorU16(&cursor);
+  CursorSkip(&cursor, 8);
+  horizontalHeader->metricDataFormat = (i16)CursorU16(&cursor);
+  horizontalHeader->numberOfHMetrics = CursorU16(&cursor);
+  return horizontalHeader;
+}
+
+i32 LoadHorizontalMetrics(Arena *arena, Font *font, HorizontalMetrics *metrics)
+{
+  memset(metrics, 0, sizeof(HorizontalMetrics));
+
+  metrics->horizontalHeader = ReadHorizontalHeaderTable(arena, GetFontTable(font, FONT_TABLE_HHEA));
+  FontView maxp = GetFontTable(font, FONT_TABLE_MAXP);
+  if (!metrics->horizontalHeader || maxp.length < 6)
+  {
+    fprintf(stderr, "Failed to parse hhea or maxp\n");
+    return 0;
+  }
+
+  // A truncated hmtx keeps the metrics it has, missing bearings read as 0.
+  u16 numGlyphs = ViewU16(maxp, 4);
+  FontCursor cursor = MakeFontCursor(GetFontTable(font, FONT_TABLE_HMTX), 0);
+  u32 longMetricCount = metrics->horizontalHeader->numberOfHMetrics;
+  if (longMetricCount > numGlyphs) longMetricCount = numGlyphs;
+  if (longMetricCount > CursorRemaining(&cursor) / 4) longMetricCount = CursorRemaining(&cursor) / 4;
+  if (!longMetricCount && numGlyphs)
+  {
+    fprintf(stderr, "Missing hmtx\n");
+    return 0;
+  }
+
+  metrics->numGlyphs = numGlyphs;
+  metrics->advanceWidths = (u16 *)AllocNoZero(arena, numGlyphs * sizeof(u16) + SIMD_PADDING);
+  metrics->leftSideBearings = (i16 *)Alloc(arena, numGlyphs * sizeof(i16) + SIMD_PADDING);
+  for (u32 i = 0; i < longMetricCount; ++i)
+  {
+    metrics->advanceWidths[i] = CursorU16(&cursor);
+    metrics->leftSideBearings[i] = (i16)CursorU16(&cursor);
+  }
+
+  u32 bearingCount = numGlyphs - longMetricCount;
+  if (bearingCount > CursorRemaining(&cursor) / 2) bearingCount = CursorRemaining(&cursor) / 2;
+  CursorU16Array(&cursor, (u16 *)&metrics->leftSideBearings[longMetricCount], bearingCount);
+  for (u32 i = longMetricCount; i < numGlyphs; ++i)
+  {
+    metrics->advanceWidths[i] = metrics->advanceWidths[longMetricCount - 1];
+  }
+  return 1;
+}
+
+u16 GetAdvanceWidth(HorizontalMetrics *metrics, u16 glyphId)
+{
+  return glyphId < metrics->numGlyphs ? metrics->advanceWidths[glyphId] : 0;
+}
@@ -0,0 +1,327 @@
+// Decoded outlines of one font kept in a packed form for glyphs drawn over and over, e.g. at many sizes.
+// A record is a PackedOutline header followed by i16 x then y coordinates, the u16 contour ends and one
+// on-curve bit per point, stored back to back in fixed-size pages taken from the arena as the cache grows.
+// Like the atlas (atlas.c), pages are the unit of eviction: once the byte budget is spent, the least
+// recently used page is emptied and its glyphs dropped from the index.
+//
+// Coordinates are stored multiplied by 1 << shift, the largest shift up to OUTLINE_CACHE_MAX_SHIFT that
+// keeps the glyph in i16 range. Integral coordinates, every glyf outline without scaled components, come
+// back exactly, fractional ones to the nearest 1 / (1 << shift) unit. Outlines are the default ones, glyphs
+// of variable fonts drawn at other coordinates go through an InstanceCache (variation.c).
+
+#define OUTLINE_CACHE_PAGE_SIZE (64 * 1024)
+#define OUTLINE_CACHE_MAX_SHIFT 4
+
+typedef struct {
+  u16 pointCount;
+  u16 contourCount;
+  u8 shift;
+  u8 cubic; // Off-curve points are OUTLINE_CUBIC_CONTROL, quadratic otherwise. Outlines never mix both.
+  i16 xMin;
+  i16 yMin;
+  i16 xMax;
+  i16 yMax;
+} PackedOutline;
+
+typedef struct {
+  u32 key; // glyphId + 1, 0 marks an empty slot.
+  u16 page;
+  u32 offset; // Of the record in its page.
+} OutlineCacheEntry;
+
+typedef struct {
+  u8 *data; // NULL until the page is first used.
+  u32 used;
+  i32 entryCount;
+  u64 lastUse;
+} OutlineCachePage;
+
+typedef struct {
+  Arena *arena; // Pages are allocated from it on first use.
+  GlyphData *glyphData;
+  u32 pageSize;
+  i32 pageCount;
+  i32 currentPage; // Receives new records until full.
+  OutlineCachePage *pages;
+
+  u32 entryCapacity; // Power of two, the table is open addressed with linear probing.
+  i32 entryCount;
+  OutlineCacheEntry *entries;
+  u64 tick;
+
+  u64 hits;
+  u64 misses;
+  u64 uncached; // Glyphs decoded without being kept: larger than a page or out of i16 range.
+  u64 evictions; // Entries dropped with their page.
+  u64 pageEvictions;
+} OutlineCache;
+
+u32 GetPackedOutlineSize(u32 pointCount, u32 contourCount)
+{
+  u32 size = sizeof(PackedOutline) + pointCount * 2 * sizeof(i16) + contourCount * sizeof(u16) + (pointCount + 7) / 8;
+  return (size + 3) & ~3u;
+}
+
+// budget bounds the bytes of the pages, rounded down to whole pages. The index is sized for as many
+// records as the pages can hold and at most one per glyph, so it never gets more than half full.
+OutlineCache *CreateOutlineCache(Arena *arena, GlyphData *glyphData, u32 budget)
+{
+  u32 pageSize = budget < OUTLINE_CACHE_PAGE_SIZE ? budget & ~3u : OUTLINE_CACHE_PAGE_SIZE;
+  if (pageSize < GetPackedOutlineSize(0, 0) || budget / pageSize > 0xFFFF)
+  {
+    fprintf(stderr, "Invalid outline cache budget %u\n", budget);
+    return NULL;
+  }
+
+  OutlineCache *cache = (OutlineCache *)Alloc(arena, sizeof(OutlineCache));
+  if (!cache) return NULL;
+  cache->arena = arena;
+  cache->glyphData = glyphData;
+  cache->pageSize = pageSize;
+  cache->pageCount = (i32)(budget / pageSize);
+  cache->pages = (OutlineCachePage *)Alloc(arena, cache->pageCount * sizeof(OutlineCachePage));
+
+  u32 maxEntries = budget / GetPackedOutlineSize(0, 0);
+  if (maxEntries > glyphData->numGlyphs) maxEntries = glyphData->numGlyphs;
+  cache->entryCapacity = 16;
+  while (cache->entryCapacity < maxEntries * 2) cache->entryCapacity <<= 1;
+  cache->entries = (OutlineCacheEntry *)Alloc(arena, cache->entryCapacity * sizeof(OutlineCacheEntry));
+  if (!cache->pages || !cache->entries) return NULL;
+  return cache;
+}
+
+u32 OutlineCacheSlot(OutlineCache *cache, u32 key)
+{
+  return (u32)(((u64)key * 0x9E3779B97F4A7C15ull) >> 32) & (cache->entryCapacity - 1);
+}
+
+OutlineCacheEntry *FindOutlineCacheEntry(OutlineCache *cache, u32 key)
+{
+  u32 mask = cache->entryCapacity - 1;
+  for (u32 slot = OutlineCacheSlot(cache, key); cache->entries[slot].key; slot = (slot + 1) & mask)
+  {
+    if (cache->entries[slot].key == key) return &cache->entries[slot];
+  }
+  return NULL;
+}
+
+void InsertOutlineCacheEntry(OutlineCache *cache, OutlineCacheEntry *entry)
+{
+  u32 mask = cache->entryCapacity - 1;
+  u32 slot = OutlineCacheSlot(cache, entry->key);
+  while (cache->entries[slot].key) slot = (slot + 1) & mask;
+  cache->entries[slot] = *entry;
+  ++cache->entryCount;
+}
+
+// Empties the least recently used page, never used pages first, and rebuilds the table without its entries.
+OutlineCachePage *EvictOutlineCachePage(OutlineCache *cache)
+{
+  i32 victim = 0;
+  for (i32 i = 1; i < cache->pageCount; ++i)
+  {
+    if (cache->pages[i].lastUse < cache->pages[victim].lastUse) victim = i;
+  }
+
+  OutlineCachePage *page = &cache->pages[victim];
+  if (page->entryCount)
+  {
+    TmpArena scratch;
+    TmpArenaPush(&scratch, GetScratchArena(cache->arena));
+    OutlineCacheEntry *kept = (OutlineCacheEntry *)AllocNoZero(scratch.arena, cache->entryCount * sizeof(OutlineCacheEntry));
+    i32 keptCount = 0;
+    for (u32 slot = 0; slot < cache->entryCapacity; ++slot)
+    {
+      OutlineCacheEntry *entry = &cache->entries[slot];
+      if (!entry->key) continue;
+      if (entry->page == victim) ++cache->evictions;
+      else kept[keptCount++] = *entry;
+    }
+
+    memset(cache->entries, 0, cache->entryCapacity * sizeof(OutlineCacheEntry));
+    cache->entryCount = 0;
+    for (i32 i = 0; i < keptCount; ++i) InsertOutlineCacheEntry(cache, &kept[i]);
+    TmpArenaPop(&scratch);
+    ++cache->pageEvictions;
+  }
+
+  page->used = 0;
+  page->entryCount = 0;
+  page->lastUse = cache->tick;
+  cache->currentPage = victim;
+  return page;
+}
+
+// Packs a decoded outline under glyphId. Returns 0 when it cannot be kept, the outline is then decoded on
+// every fetch.
+i32 AddPackedOutline(OutlineCache *cache, u16 glyphId, GlyphOutline *outline)
+{
+  u32 size = GetPackedOutlineSize(outline->pointCount, outline->contourCount);
+  if (size > cache->pageSize || outline->pointCount > 0xFFFF) return 0;
+
+  // The largest scale that keeps every coordinate in i16. Kept branchless, point types are as good as random.
+  f32 maxMagnitude = 0.0f;
+  i32 invalid = 0;
+  u32 types = 0;
+  for (i32 i = 0; i < outline->pointCount; ++i)
+  {
+    f32 x = fabsf(outline->x[i]), y = fabsf(outline->y[i]);
+    maxMagnitude = x > maxMagnitude ? x : maxMagnitude;
+    maxMagnitude = y > maxMagnitude ? y : maxMagnitude;
+    invalid |= (outline->x[i] != outline->x[i]) | (outline->y[i] != outline->y[i]);
+    types |= 1u << outline->onCurve[i];
+  }
+  if (invalid || ((types & (1u << OUTLINE_QUADRATIC_CONTROL)) && (types & (1u << OUTLINE_CUBIC_CONTROL)))) return 0;
+  i32 shift = OUTLINE_CACHE_MAX_SHIFT;
+  while (shift >= 0 && maxMagnitude * (f32)(1 << shift) + 0.5f >= 32767.0f) --shift;
+  if (shift < 0) return 0;
+
+  OutlineCachePage *page = &cache->pages[cache->currentPage];
+  if (!page->data || page->used + size > cache->pageSize) page = EvictOutlineCachePage(cache);
+  if (!page->data)
+  {
+    page->data = (u8 *)AllocNoZero(cache->arena, cache->pageSize);
+    if (!page->data) return 0;
+  }
+
+  u8 *data = &page->data[page->used];
+  PackedOutline *packed = (PackedOutline *)data;
+  packed->pointCount = (u16)outline->pointCount;
+  packed->contourCount = (u16)outline->contourCount;
+  packed->shift = (u8)shift;
+  packed->cubic = (types & (1u << OUTLINE_CUBIC_CONTROL)) != 0;
+  packed->xMin = outline->xMin;
+  packed->yMin = outline->yMin;
+  packed->xMax = outline->xMax;
+  packed->yMax = outline->yMax;
+
+  i32 pointCount = outline->pointCount;
+  f32 scale = (f32)(1 << shift);
+  i16 *x = (i16 *)(data + sizeof(PackedOutline));
+  i16 *y = x + pointCount;
+  for (i32 i = 0; i < pointCount; ++i)
+  {
+    x[i] = (i16)floorf(outline->x[i] * scale + 0.5f);
+    y[i] = (i16)floorf(outline->y[i] * scale + 0.5f);
+  }
+  u16 *contourEnds = (u16 *)(y + pointCount);
+  memcpy(contourEnds, outline->contourEnds, outline->contourCount * sizeof(u16));
+  u8 *onCurveBits = (u8 *)(contourEnds + outline->contourCount);
+  for (i32 i = 0; i < pointCount; i += 8)
+  {
+    u32 bits = 0;
+    for (i32 j = 0; j < 8 && i + j < pointCount; ++j) bits |= (u32)(outline->onCurve[i + j] == OUTLINE_ON_CURVE) << j;
+    onCurveBits[i >> 3] = (u8)bits;
+  }
+
+  OutlineCacheEntry entry = {0};
+  entry.key = (u32)glyphId + 1;
+  entry.page = (u16)cache->currentPage;
+  entry.offset = page->used;
+  InsertOutlineCacheEntry(cache, &entry);
+  page->used += size;
+  ++page->entryCount;
+  page->lastUse = cache->tick;
+  return 1;
+}
+
+void DequantizeCoordinatesScalar(f32 *destination, i16 *source, i32 count, f32 scale)
+{
+  for (i32 i = 0; i < count; ++i) destination[i] = (f32)source[i] * scale;
+}
+
+#if SIMD_X86
+void DequantizeCoordinatesSse2(f32 *destination, i16 *source, i32 count, f32 scale)
+{
+  __m128 scales = _mm_set1_ps(scale);
+  i32 i = 0;
+  for (; i + 8 <= count; i += 8)
+  {
+    // Sign extended by moving each value to the high half of a lane, then shifting it back.
+    __m128i values = _mm_loadu_si128((__m128i *)&source[i]);
+    __m128i low = _mm_srai_epi32(_mm_unpacklo_epi16(values, values), 16);
+    __m128i high = _mm_srai_epi32(_mm_unpackhi_epi16(values, values), 16);
+    _mm_storeu_ps(&destination[i], _mm_mul_ps(_mm_cvtepi32_ps(low), scales));
+    _mm_storeu_ps(&destination[i + 4], _mm_mul_ps(_mm_cvtepi32_ps(high), scales));
+  }
+  DequantizeCoordinatesScalar(&destination[i], &source[i], count - i, scale);
+}
+#endif
+
+void DequantizeCoordinates(f32 *destination, i16 *source, i32 count, f32 scale)
+{
+#if SIMD_X86
+  if (GetCpuFeatures()->hasSse2)
+  {
+    DequantizeCoordinatesSse2(destination, source, count, scale);
+    return;
+  }
+#endif
+  DequantizeCoordinatesScalar(destination, source, count, scale);
+}
+
+// Bit i of bits moved to the lowest bit of byte i.
+u64 SpreadBitsToBytes(u32 bits)
+{
+  u64 spread = bits;
+  spread = (spread | spread << 28) & 0x0000000F0000000Full;
+  spread = (spread | spread << 14) & 0x0003000300030003ull;
+  spread = (spread | spread << 7) & 0x0101010101010101ull;
+  return spread;
+}
+
+// Point types are written 8 at a time, past pointCount into the padding of AllocGlyphOutline.
+void UnpackOutline(PackedOutline *packed, GlyphOutline *outline)
+{
+  i32 pointCount = packed->pointCount;
+  outline->pointCount = pointCount;
+  outline->contourCount = packed->contourCount;
+  outline->xMin = packed->xMin;
+  outline->yMin = packed->yMin;
+  outline->xMax = packed->xMax;
+  outline->yMax = packed->yMax;
+
+  f32 scale = 1.0f / (f32)(1 << packed->shift);
+  i16 *x = (i16 *)(packed + 1);
+  i16 *y = x + pointCount;
+  DequantizeCoordinates(outline->x, x, pointCount, scale);
+  DequantizeCoordinates(outline->y, y, pointCount, scale);
+  u16 *contourEnds = (u16 *)(y + pointCount);
+  memcpy(outline->contourEnds, contourEnds, packed->contourCount * sizeof(u16));
+
+  // Off-curve bytes are 0, or 2 for cubic outlines: on-curve bytes of 1 subtracted from 2 stay 1.
+  u8 *onCurveBits = (u8 *)(contourEnds + packed->contourCount);
+  for (i32 i = 0; i < pointCount; i += 8)
+  {
+    u64 types = SpreadBitsToBytes(onCurveBits[i >> 3]);
+    if (packed->cubic) types = 0x0202020202020202ull - types;
+    memcpy(&outline->onCurve[i], &types, 8);
+  }
+}
+
+// Same as DecodeGlyphOutline, unpacking the outline from the cache when the glyph was decoded before.
+i32 GetCachedGlyphOutline(OutlineCache *cache, u16 glyphId, GlyphOutline *outline)
+{
+  PROFILE_BEGIN(GetCachedGlyphOutline);
+  ++cache->tick;
+  OutlineCacheEntry *entry = FindOutlineCacheEntry(cache, (u32)glyphId + 1);
+  if (entry)
+  {
+    OutlineCachePage *page = &cache->pages[entry->page];
+    PackedOutline *packed = (PackedOutline *)&page->data[entry->offset];
+    if (packed->pointCount <= outline->pointCapacity && packed->contourCount <= outline->contourCapacity)
+    {
+      ++cache->hits;
+      page->lastUse = cache->tick;
+      UnpackOutline(packed, outline);
+      PROFILE_END(GetCachedGlyphOutline);
+      return 1;
+    }
+  }
+
+  ++cache->misses;
+  i32 success = DecodeGlyphOutline(cache->glyphData, glyphId, outline);
+  if (success && !entry && !AddPackedOutline(cache, glyphId, outline)) ++cache->uncached;
+  PROFILE_END(GetCachedGlyphOutline);
+  return success;
+}
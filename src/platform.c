@@ -0,0 +1,424 @@
+#if _WIN32
+#include <Windows.h>
+#include <psapi.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <time.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#endif
+
+#if _MSC_VER
+#define THREAD_LOCAL __declspec(thread)
+#else
+#define THREAD_LOCAL __thread
+#endif
+
+#if _WIN32
+typedef HANDLE PlatformThread;
+typedef SRWLOCK PlatformMutex;
+typedef CONDITION_VARIABLE PlatformCondition;
+#define PLATFORM_THREAD_PROC(name) DWORD WINAPI name(LPVOID parameter)
+#define PLATFORM_THREAD_RETURN return 0
+#else
+typedef pthread_t PlatformThread;
+typedef pthread_mutex_t PlatformMutex;
+typedef pthread_cond_t PlatformCondition;
+#define PLATFORM_THREAD_PROC(name) void *name(void *parameter)
+#define PLATFORM_THREAD_RETURN return NULL
+#endif
+
+typedef struct {
+  u8 *data;
+  size_t size;
+#if _WIN32
+  HANDLE file;
+  HANDLE mapping;
+#endif
+} MappedFile;
+
+void *PlatformAllocate(size_t size)
+{
+#if _WIN32
+  return VirtualAlloc(NULL, size, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+#else
+  void *memory = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+  return memory == MAP_FAILED ? NULL : memory;
+#endif
+}
+
+void PlatformFree(void *memory, size_t size)
+{
+#if _WIN32
+  (void)size;
+  VirtualFree(memory, 0, MEM_RELEASE);
+#else
+  munmap(memory, size);
+#endif
+}
+
+// Address space only, nothing is backed until PlatformCommit.
+void *PlatformReserve(size_t size)
+{
+#if _WIN32
+  return VirtualAlloc(NULL, size, MEM_RESERVE, PAGE_NOACCESS);
+#else
+  void *memory = mmap(NULL, size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+  return memory == MAP_FAILED ? NULL : memory;
+#endif
+}
+
+// Committed pages read as zero until written.
+i32 PlatformCommit(void *memory, size_t size)
+{
+#if _WIN32
+  return VirtualAlloc(memory, size, MEM_COMMIT, PAGE_READWRITE) != NULL;
+#else
+  return mprotect(memory, size, PROT_READ | PROT_WRITE) == 0;
+#endif
+}
+
+// Gives the pages back to the system but keeps the range reserved.
+void PlatformDecommit(void *memory, size_t size)
+{
+#if _WIN32
+  VirtualFree(memory, size, MEM_DECOMMIT);
+#else
+  madvise(memory, size, MADV_DONTNEED);
+  mprotect(memory, size, PROT_NONE);
+#endif
+}
+
+// Maps the whole file read-only, pages are only faulted in when a table is actually touched.
+i32 MapWholeFile(char *filePath, MappedFile *mappedFile)
+{
+  memset(mappedFile, 0, sizeof(MappedFile));
+
+#if _WIN32
+  HANDLE file = CreateFileA(filePath, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+  if (file == INVALID_HANDLE_VALUE)
+  {
+    fprintf(stderr, "Failed to open file %s\n", filePath);
+    return 0;
+  }
+
+  LARGE_INTEGER fileSize;
+  if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0)
+  {
+    fprintf(stderr, "Failed to get the size of file %s\n", filePath);
+    CloseHandle(file);
+    return 0;
+  }
+
+  HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+  u8 *data = mapping ? (u8 *)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : NULL;
+  if (!data)
+  {
+    fprintf(stderr, "Failed to map file %s\n", filePath);
+    if (mapping) CloseHandle(mapping);
+    CloseHandle(file);
+    return 0;
+  }
+
+  mappedFile->data = data;
+  mappedFile->size = (size_t)fileSize.QuadPart;
+  mappedFile->file = file;
+  mappedFile->mapping = mapping;
+#else
+  i32 file = open(filePath, O_RDONLY);
+  if (file < 0)
+  {
+    fprintf(stderr, "Failed to open file %s\n", filePath);
+    return 0;
+  }
+
+  struct stat fileStat;
+  if (fstat(file, &fileStat) != 0 || fileStat.st_size == 0)
+  {
+    fprintf(stderr, "Failed to get the size of file %s\n", filePath);
+    close(file);
+    return 0;
+  }
+
+  void *data = mmap(NULL, (size_t)fileStat.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+  close(file); // The mapping keeps its own reference to the file.
+  if (data == MAP_FAILED)
+  {
+    fprintf(stderr, "Failed to map file %s\n", filePath);
+    return 0;
+  }
+
+  mappedFile->data = (u8 *)data;
+  mappedFile->size = (size_t)fileStat.st_size;
+#endif
+
+  return 1;
+}
+
+void UnmapWholeFile(MappedFile *mappedFile)
+{
+  if (!mappedFile->data) return;
+
+#if _WIN32
+  UnmapViewOfFile(mappedFile->data);
+  CloseHandle(mappedFile->mapping);
+  CloseHandle(mappedFile->file);
+#else
+  munmap(mappedFile->data, mappedFile->size);
+#endif
+
+  memset(mappedFile, 0, sizeof(MappedFile));
+}
+
+i32 PlatformFileExists(char *filePath)
+{
+#if _WIN32
+  return GetFileAttributesA(filePath) != INVALID_FILE_ATTRIBUTES;
+#else
+  struct stat fileStat;
+  return stat(filePath, &fileStat) == 0;
+#endif
+}
+
+// Moves a fully written file over the destination in one step, readers see the old file or the new one.
+i32 PlatformReplaceFile(char *sourcePath, char *destinationPath)
+{
+#if _WIN32
+  return MoveFileExA(sourcePath, destinationPath, MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+  return rename(sourcePath, destinationPath) == 0;
+#endif
+}
+
+// Drops the clean pages of a file from the OS cache so the next read goes to the disk. Returns 0 when
+// the platform cannot do it.
+i32 PlatformEvictFileCache(char *filePath)
+{
+#if _WIN32
+  (void)filePath;
+  return 0;
+#else
+  i32 file = open(filePath, O_RDONLY);
+  if (file < 0) return 0;
+  i32 success = fdatasync(file) == 0 && posix_fadvise(file, 0, 0, POSIX_FADV_DONTNEED) == 0;
+  close(file);
+  return success;
+#endif
+}
+
+f64 GetWallClockSeconds(void)
+{
+#if _WIN32
+  static f64 invFrequency;
+  if (invFrequency == 0)
+  {
+    LARGE_INTEGER frequency;
+    QueryPerformanceFrequency(&frequency);
+    invFrequency = 1.0 / (f64)frequency.QuadPart;
+  }
+  LARGE_INTEGER counter;
+  QueryPerformanceCounter(&counter);
+  return (f64)counter.QuadPart * invFrequency;
+#else
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (f64)now.tv_sec + (f64)now.tv_nsec * 1e-9;
+#endif
+}
+
+size_t GetResidentBytes(void)
+{
+#if _WIN32
+  PROCESS_MEMORY_COUNTERS counters;
+  if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) return 0;
+  return counters.WorkingSetSize;
+#else
+  FILE *statm = fopen("/proc/self/statm", "r");
+  if (!statm) return 0;
+
+  unsigned long totalPages = 0, residentPages = 0;
+  i32 success = fscanf(statm, "%lu %lu", &totalPages, &residentPages) == 2;
+  fclose(statm);
+  return success ? (size_t)residentPages * (size_t)sysconf(_SC_PAGESIZE) : 0;
+#endif
+}
+
+i32 GetProcessorCount(void)
+{
+#if _WIN32
+  SYSTEM_INFO info;
+  GetSystemInfo(&info);
+  return (i32)info.dwNumberOfProcessors;
+#else
+  long count = sysconf(_SC_NPROCESSORS_ONLN);
+  return count > 0 ? (i32)count : 1;
+#endif
+}
+
+// Same ids as the OS tools show, so traces line up with perf or the Windows profilers.
+u32 GetProcessId32(void)
+{
+#if _WIN32
+  return (u32)GetCurrentProcessId();
+#else
+  return (u32)getpid();
+#endif
+}
+
+u32 GetThreadId32(void)
+{
+#if _WIN32
+  return (u32)GetCurrentThreadId();
+#else
+  return (u32)syscall(SYS_gettid);
+#endif
+}
+
+// proc is declared with PLATFORM_THREAD_PROC and ends with PLATFORM_THREAD_RETURN.
+#if _WIN32
+i32 PlatformCreateThread(PlatformThread *thread, LPTHREAD_START_ROUTINE proc, void *parameter)
+{
+  *thread = CreateThread(NULL, 0, proc, parameter, 0, NULL);
+  return *thread != NULL;
+}
+#else
+i32 PlatformCreateThread(PlatformThread *thread, void *(*proc)(void *), void *parameter)
+{
+  return pthread_create(thread, NULL, proc, parameter) == 0;
+}
+#endif
+
+void PlatformJoinThread(PlatformThread thread)
+{
+#if _WIN32
+  WaitForSingleObject(thread, INFINITE);
+  CloseHandle(thread);
+#else
+  pthread_join(thread, NULL);
+#endif
+}
+
+void PlatformInitMutex(PlatformMutex *mutex)
+{
+#if _WIN32
+  InitializeSRWLock(mutex);
+#else
+  pthread_mutex_init(mutex, NULL);
+#endif
+}
+
+void PlatformDestroyMutex(PlatformMutex *mutex)
+{
+#if _WIN32
+  (void)mutex; // SRW locks hold no resources.
+#else
+  pthread_mutex_destroy(mutex);
+#endif
+}
+
+void PlatformLockMutex(PlatformMutex *mutex)
+{
+#if _WIN32
+  AcquireSRWLockExclusive(mutex);
+#else
+  pthread_mutex_lock(mutex);
+#endif
+}
+
+void PlatformUnlockMutex(PlatformMutex *mutex)
+{
+#if _WIN32
+  ReleaseSRWLockExclusive(mutex);
+#else
+  pthread_mutex_unlock(mutex);
+#endif
+}
+
+void PlatformInitCondition(PlatformCondition *condition)
+{
+#if _WIN32
+  InitializeConditionVariable(condition);
+#else
+  pthread_cond_init(condition, NULL);
+#endif
+}
+
+void PlatformDestroyCondition(PlatformCondition *condition)
+{
+#if _WIN32
+  (void)condition;
+#else
+  pthread_cond_destroy(condition);
+#endif
+}
+
+// Releases mutex while sleeping and holds it again on return. Wake-ups can be spurious, recheck the state.
+void PlatformWaitCondition(PlatformCondition *condition, PlatformMutex *mutex)
+{
+#if _WIN32
+  SleepConditionVariableSRW(condition, mutex, INFINITE, 0);
+#else
+  pthread_cond_wait(condition, mutex);
+#endif
+}
+
+void PlatformWakeAllCondition(PlatformCondition *condition)
+{
+#if _WIN32
+  WakeAllConditionVariable(condition);
+#else
+  pthread_cond_broadcast(condition);
+#endif
+}
+
+void PlatformYield(void)
+{
+#if _WIN32
+  SwitchToThread();
+#else
+  sched_yield();
+#endif
+}
+
+// Sequentially consistent atomics on 64-bit integers.
+i64 AtomicLoadI64(volatile i64 *value)
+{
+#if _MSC_VER
+  return InterlockedCompareExchange64((volatile LONG64 *)value, 0, 0);
+#else
+  return __atomic_load_n(value, __ATOMIC_SEQ_CST);
+#endif
+}
+
+void AtomicStoreI64(volatile i64 *value, i64 newValue)
+{
+#if _MSC_VER
+  InterlockedExchange64((volatile LONG64 *)value, newValue);
+#else
+  __atomic_store_n(value, newValue, __ATOMIC_SEQ_CST);
+#endif
+}
+
+// Returns the value after the addition.
+i64 AtomicAddI64(volatile i64 *value, i64 addend)
+{
+#if _MSC_VER
+  return InterlockedExchangeAdd64((volatile LONG64 *)value, addend) + addend;
+#else
+  return __atomic_add_fetch(value, addend, __ATOMIC_SEQ_CST);
+#endif
+}
+
+// Returns 1 when value held expected and was replaced.
+i32 AtomicCompareExchangeI64(volatile i64 *value, i64 expected, i64 newValue)
+{
+#if _MSC_VER
+  return InterlockedCompareExchange64((volatile LONG64 *)value, newValue, expected) == expected;
+#else
+  return __atomic_compare_exchange_n(value, &expected, newValue, 0, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+#endif
+}
@@ -0,0 +1,243 @@
+//SPECS: https://docs.google.com/document/d/1CvAClvFfyA5R-PhYUmn5OOQtYMH4h6I0nSsKchNAySU
+
+// Scoped timers, counters and arena usage written as a Chrome trace (chrome://tracing, ui.perfetto.dev).
+// Everything compiles to nothing unless PROFILE=1. Scopes are explicit pairs so they survive MSVC:
+//
+//   PROFILE_BEGIN(LoadGlyphData);
+//   ...
+//   PROFILE_END(LoadGlyphData);
+//
+// Every thread fills its own chunk of a preallocated event array, only taking a new chunk costs an atomic
+// add. Timestamps are CLOCK_MONOTONIC microseconds and ids are the OS process and thread ids, the same
+// clock and ids as perf (perf record -k CLOCK_MONOTONIC) and perf script use.
+
+#if PROFILE
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define PROFILE_USE_TSC 1
+#if _MSC_VER
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+#else
+#define PROFILE_USE_TSC 0
+#endif
+
+#define PROFILE_CHUNK_EVENTS 256
+#define PROFILE_DEFAULT_EVENTS (1 << 20)
+
+typedef enum {
+  PROFILE_EVENT_SCOPE = 1,
+  PROFILE_EVENT_COUNTER,
+  PROFILE_EVENT_THREAD_NAME,
+} ProfileEventType;
+
+typedef struct {
+  char *name; // NULL for slots of a chunk that were never written.
+  char *series; // Counter series, or the name given to the thread.
+  u64 start; // Ticks of ReadProfileClock.
+  i64 value; // Duration in ticks for scopes, the value for counters.
+  u32 threadId;
+  u32 type;
+} ProfileEvent;
+
+typedef struct {
+  char *name;
+  u64 start;
+} ProfileScope;
+
+typedef struct {
+  ProfileEvent *events;
+  i64 capacity; // Multiple of PROFILE_CHUNK_EVENTS.
+  volatile i64 reserved; // Events handed out to threads in chunks, may run past capacity.
+  volatile i64 dropped;
+  u32 session; // Bumped by BeginProfiling so threads drop chunks of a previous session.
+  u32 processId;
+  u64 startTicks;
+  f64 startSeconds;
+} Profiler;
+
+Profiler profiler;
+THREAD_LOCAL ProfileEvent *profileEventAt;
+THREAD_LOCAL ProfileEvent *profileEventEnd;
+THREAD_LOCAL u32 profileSession;
+THREAD_LOCAL u32 profileThreadId;
+
+u64 ReadProfileClock(void)
+{
+#if PROFILE_USE_TSC
+  return __rdtsc();
+#else
+  return (u64)(GetWallClockSeconds() * 1e9);
+#endif
+}
+
+// Events past eventCapacity are dropped and counted. Returns 0 when the events cannot be allocated.
+i32 BeginProfiling(Arena *arena, i64 eventCapacity)
+{
+  eventCapacity = (eventCapacity + PROFILE_CHUNK_EVENTS - 1) / PROFILE_CHUNK_EVENTS * PROFILE_CHUNK_EVENTS;
+  ProfileEvent *events = (ProfileEvent *)Alloc(arena, eventCapacity * sizeof(ProfileEvent));
+  if (!events) return 0;
+
+  u32 session = profiler.session + 1;
+  memset(&profiler, 0, sizeof(Profiler));
+  profiler.events = events;
+  profiler.capacity = eventCapacity;
+  profiler.session = session;
+  profiler.processId = GetProcessId32();
+  profiler.startSeconds = GetWallClockSeconds();
+  profiler.startTicks = ReadProfileClock();
+  return 1;
+}
+
+// Forgets the recorded events but keeps their memory, which is already committed.
+void ResetProfiling(void)
+{
+  i64 used = AtomicLoadI64(&profiler.reserved);
+  if (used > profiler.capacity) used = profiler.capacity;
+  memset(profiler.events, 0, used * sizeof(ProfileEvent));
+  ++profiler.session;
+  profiler.reserved = 0;
+  profiler.dropped = 0;
+  profiler.startSeconds = GetWallClockSeconds();
+  profiler.startTicks = ReadProfileClock();
+}
+
+ProfileEvent *ReserveProfileEvent(void)
+{
+  if (!profiler.events) return NULL;
+  if (profileSession != profiler.session || profileEventAt == profileEventEnd)
+  {
+    profileSession = profiler.session;
+    profileThreadId = GetThreadId32();
+    profileEventAt = profileEventEnd = NULL;
+    i64 end = AtomicAddI64(&profiler.reserved, PROFILE_CHUNK_EVENTS);
+    if (end > profiler.capacity)
+    {
+      AtomicAddI64(&profiler.dropped, 1);
+      return NULL;
+    }
+    profileEventAt = &profiler.events[end - PROFILE_CHUNK_EVENTS];
+    profileEventEnd = profileEventAt + PROFILE_CHUNK_EVENTS;
+  }
+  ProfileEvent *event = profileEventAt++;
+  event->threadId = profileThreadId;
+  return event;
+}
+
+ProfileScope BeginProfileScope(char *name)
+{
+  ProfileScope scope = { name, ReadProfileClock() };
+  return scope;
+}
+
+void EndProfileScope(ProfileScope *scope)
+{
+  u64 end = ReadProfileClock();
+  ProfileEvent *event = ReserveProfileEvent();
+  if (!event) return;
+  event->start = scope->start;
+  event->value = (i64)(end - scope->start);
+  event->series = NULL;
+  event->type = PROFILE_EVENT_SCOPE;
+  event->name = scope->name;
+}
+
+void RecordProfileCounter(char *name, char *series, i64 value)
+{
+  ProfileEvent *event = ReserveProfileEvent();
+  if (!event) return;
+  event->start = ReadProfileClock();
+  event->value = value;
+  event->series = series;
+  event->type = PROFILE_EVENT_COUNTER;
+  event->name = name;
+}
+
+// Bytes in use and the high water mark, which for virtual arenas is also what stays committed.
+void RecordArenaUsage(char *name, Arena *arena)
+{
+  RecordProfileCounter(name, "used", (i64)arena->cur);
+  RecordProfileCounter(name, "high water", (i64)arena->highWater);
+}
+
+void NameProfileThread(char *name)
+{
+  ProfileEvent *event = ReserveProfileEvent();
+  if (!event) return;
+  event->start = 0;
+  event->value = 0;
+  event->series = name;
+  event->type = PROFILE_EVENT_THREAD_NAME;
+  event->name = "thread_name";
+}
+
+// Writes every recorded event and keeps recording. Returns 0 when the file cannot be written.
+i32 WriteProfileTrace(char *path)
+{
+  if (!profiler.events) return 0;
+  FILE *file = fopen(path, "wb");
+  if (!file)
+  {
+    fprintf(stderr, "Failed to open trace file %s\n", path);
+    return 0;
+  }
+
+  // The tick rate is measured over the whole session, rdtsc runs at a constant rate on current CPUs.
+  f64 seconds = GetWallClockSeconds() - profiler.startSeconds;
+  u64 ticks = ReadProfileClock() - profiler.startTicks;
+  f64 microsecondsPerTick = PROFILE_USE_TSC && ticks && seconds > 0 ? seconds * 1e6 / (f64)ticks : 1e-3;
+  f64 startMicroseconds = profiler.startSeconds * 1e6;
+
+  i64 count = AtomicLoadI64(&profiler.reserved);
+  if (count > profiler.capacity) count = profiler.capacity;
+  fprintf(file, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+  fprintf(file, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%u,\"tid\":0,\"args\":{\"name\":\"fleuret\"}}", profiler.processId);
+  for (i64 i = 0; i < count; ++i)
+  {
+    ProfileEvent *event = &profiler.events[i];
+    if (!event->name) continue;
+
+    f64 timestamp = startMicroseconds + (f64)(i64)(event->start - profiler.startTicks) * microsecondsPerTick;
+    switch (event->type)
+    {
+      case PROFILE_EVENT_SCOPE: {
+        fprintf(file, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":%u,\"tid\":%u}",
+                event->name, timestamp, (f64)event->value * microsecondsPerTick, profiler.processId, event->threadId);
+      } break;
+
+      case PROFILE_EVENT_COUNTER: {
+        fprintf(file, ",\n{\"name\":\"%s\",\"ph\":\"C\",\"ts\":%.3f,\"pid\":%u,\"tid\":%u,\"args\":{\"%s\":%lld}}",
+                event->name, timestamp, profiler.processId, event->threadId, event->series, (long long)event->value);
+      } break;
+
+      case PROFILE_EVENT_THREAD_NAME: {
+        fprintf(file, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%u,\"tid\":%u,\"args\":{\"name\":\"%s\"}}",
+                profiler.processId, event->threadId, event->series);
+      } break;
+    }
+  }
+  fprintf(file, "\n]}\n");
+  i32 success = !ferror(file);
+  fclose(file);
+
+  if (profiler.dropped) fprintf(stderr, "Profiler ran out of events, %lld dropped\n", (long long)profiler.dropped);
+  return success;
+}
+
+#define PROFILE_BEGIN(scope) ProfileScope profileScope##scope = BeginProfileScope(#scope)
+#define PROFILE_END(scope) EndProfileScope(&profileScope##scope)
+#define PROFILE_COUNTER(name, series, value) RecordProfileCounter(name, series, (i64)(value))
+#define PROFILE_ARENA(name, arena) RecordArenaUsage(name, arena)
+#define PROFILE_THREAD_NAME(name) NameProfileThread(name)
+
+#else
+
+#define PROFILE_BEGIN(scope)
+#define PROFILE_END(scope)
+#define PROFILE_COUNTER(name, series, value)
+#define PROFILE_ARENA(name, arena)
+#define PROFILE_THREAD_NAME(name)
+
+#endif
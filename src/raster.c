@@ -0,0 +1,468 @@
+// Anti-aliased coverage rasterizer. Every line segment adds its signed area to the cells it crosses and
+// a single running sum over the buffer turns the accumulated deltas into coverage.
+
+#define RASTER_FLATTEN_TOLERANCE 3.0f
+
+typedef struct {
+  i32 width;
+  i32 height;
+  i32 left; // Pixels from the pen position to the left edge.
+  i32 top; // Pixels from the baseline up to the top edge.
+  u8 *pixels; // width * height coverage values, top row first.
+} GlyphBitmap;
+
+typedef struct {
+  i32 capacity; // Number of accumulation cells, the bitmap area plus the cells right of the last pixel.
+  f32 *accumulation; // Kept zeroed between glyphs by the accumulation pass.
+  f32 scale;
+  f32 offsetX;
+  f32 offsetY;
+} Rasterizer;
+
+Rasterizer *AllocRasterizer(Arena *arena, i32 maxWidth, i32 maxHeight)
+{
+  Rasterizer *rasterizer = (Rasterizer *)Alloc(arena, sizeof(Rasterizer));
+  rasterizer->capacity = maxWidth * maxHeight + 4;
+  rasterizer->accumulation = (f32 *)Alloc(arena, rasterizer->capacity * sizeof(f32) + SIMD_PADDING);
+  return rasterizer;
+}
+
+// Bounds come from the points themselves since composite transforms can leave the header bbox stale.
+void GetGlyphBitmapBounds(GlyphOutline *outline, f32 scale, GlyphBitmap *bitmap)
+{
+  memset(bitmap, 0, sizeof(GlyphBitmap));
+  if (!outline->pointCount) return;
+
+  f32 xMin = outline->x[0], xMax = outline->x[0];
+  f32 yMin = outline->y[0], yMax = outline->y[0];
+  for (i32 i = 1; i < outline->pointCount; ++i)
+  {
+    if (outline->x[i] < xMin) xMin = outline->x[i];
+    if (outline->x[i] > xMax) xMax = outline->x[i];
+    if (outline->y[i] < yMin) yMin = outline->y[i];
+    if (outline->y[i] > yMax) yMax = outline->y[i];
+  }
+
+  bitmap->left = (i32)floorf(xMin * scale);
+  bitmap->top = (i32)ceilf(yMax * scale);
+  bitmap->width = (i32)ceilf(xMax * scale) - bitmap->left;
+  bitmap->height = bitmap->top - (i32)floorf(yMin * scale);
+}
+
+void RasterizeLine(Rasterizer *rasterizer, i32 width, i32 height, f32 x0, f32 y0, f32 x1, f32 y1)
+{
+  if (fabsf(y0 - y1) <= 1e-6f) return;
+
+  f32 direction = 1.0f;
+  if (y0 > y1)
+  {
+    f32 swap;
+    swap = x0; x0 = x1; x1 = swap;
+    swap = y0; y0 = y1; y1 = swap;
+    direction = -1.0f;
+  }
+
+  f32 dxdy = (x1 - x0) / (y1 - y0);
+  f32 x = x0;
+  if (y0 < 0) x -= y0 * dxdy;
+
+  f32 *accumulation = rasterizer->accumulation;
+  i32 yStart = y0 < 0 ? 0 : (i32)y0;
+  i32 yEnd = (i32)ceilf(y1);
+  if (yEnd > height) yEnd = height;
+
+  for (i32 y = yStart; y < yEnd; ++y)
+  {
+    i32 lineStart = y * width;
+    f32 dy = ((f32)(y + 1) < y1 ? (f32)(y + 1) : y1) - ((f32)y > y0 ? (f32)y : y0);
+    f32 xNext = x + dxdy * dy;
+    f32 d = dy * direction;
+    f32 xLeft = x < xNext ? x : xNext;
+    f32 xRight = x < xNext ? xNext : x;
+    f32 xLeftFloor = floorf(xLeft);
+    i32 xLeftIndex = (i32)xLeftFloor;
+    f32 xRightCeil = ceilf(xRight);
+    i32 xRightIndex = (i32)xRightCeil;
+    if (lineStart + xLeftIndex < 0)
+    {
+      x = xNext;
+      continue;
+    }
+
+    f32 *cells = &accumulation[lineStart];
+    if (xRightIndex <= xLeftIndex + 1)
+    {
+      // The segment stays within one pixel column on this row.
+      f32 xMid = 0.5f * (x + xNext) - xLeftFloor;
+      cells[xLeftIndex] += d - d * xMid;
+      cells[xLeftIndex + 1] += d * xMid;
+    }
+    else
+    {
+      f32 s = 1.0f / (xRight - xLeft);
+      f32 xLeftFraction = xLeft - xLeftFloor;
+      f32 areaFirst = 0.5f * s * (1.0f - xLeftFraction) * (1.0f - xLeftFraction);
+      f32 xRightFraction = xRight - xRightCeil + 1.0f;
+      f32 areaLast = 0.5f * s * xRightFraction * xRightFraction;
+      cells[xLeftIndex] += d * areaFirst;
+      if (xRightIndex == xLeftIndex + 2)
+      {
+        cells[xLeftIndex + 1] += d * (1.0f - areaFirst - areaLast);
+      }
+      else
+      {
+        f32 areaSecond = s * (1.5f - xLeftFraction);
+        cells[xLeftIndex + 1] += d * (areaSecond - areaFirst);
+        for (i32 xi = xLeftIndex + 2; xi < xRightIndex - 1; ++xi)
+        {
+          cells[xi] += d * s;
+        }
+        f32 areaBeforeLast = areaSecond + (f32)(xRightIndex - xLeftIndex - 3) * s;
+        cells[xRightIndex - 1] += d * (1.0f - areaBeforeLast - areaLast);
+      }
+      cells[xRightIndex] += d * areaLast;
+    }
+
+    x = xNext;
+  }
+}
+
+// Subdivision count grows with the fourth root of the control point deviation.
+void RasterizeQuadratic(Rasterizer *rasterizer, i32 width, i32 height, f32 x0, f32 y0, f32 x1, f32 y1, f32 x2, f32 y2)
+{
+  f32 deviationX = x0 - 2.0f * x1 + x2;
+  f32 deviationY = y0 - 2.0f * y1 + y2;
+  f32 deviationSquared = deviationX * deviationX + deviationY * deviationY;
+  if (deviationSquared < 0.333f)
+  {
+    RasterizeLine(rasterizer, width, height, x0, y0, x2, y2);
+    return;
+  }
+
+  i32 segments = 1 + (i32)floorf(sqrtf(sqrtf(RASTER_FLATTEN_TOLERANCE * deviationSquared)));
+  f32 step = 1.0f / (f32)segments;
+  f32 t = 0;
+  f32 previousX = x0, previousY = y0;
+  for (i32 i = 0; i < segments - 1; ++i)
+  {
+    t += step;
+    f32 ax = x0 + t * (x1 - x0), ay = y0 + t * (y1 - y0);
+    f32 bx = x1 + t * (x2 - x1), by = y1 + t * (y2 - y1);
+    f32 nextX = ax + t * (bx - ax), nextY = ay + t * (by - ay);
+    RasterizeLine(rasterizer, width, height, previousX, previousY, nextX, nextY);
+    previousX = nextX;
+    previousY = nextY;
+  }
+  RasterizeLine(rasterizer, width, height, previousX, previousY, x2, y2);
+}
+
+// Same subdivision as RasterizeQuadratic, a cubic bends up to three times its largest second difference.
+void RasterizeCubic(Rasterizer *rasterizer, i32 width, i32 height, f32 x0, f32 y0, f32 x1, f32 y1, f32 x2, f32 y2, f32 x3, f32 y3)
+{
+  f32 deviation1X = x0 - 2.0f * x1 + x2, deviation1Y = y0 - 2.0f * y1 + y2;
+  f32 deviation2X = x1 - 2.0f * x2 + x3, deviation2Y = y1 - 2.0f * y2 + y3;
+  f32 deviation1 = deviation1X * deviation1X + deviation1Y * deviation1Y;
+  f32 deviation2 = deviation2X * deviation2X + deviation2Y * deviation2Y;
+  f32 deviationSquared = 9.0f * (deviation1 > deviation2 ? deviation1 : deviation2);
+  if (deviationSquared < 0.333f)
+  {
+    RasterizeLine(rasterizer, width, height, x0, y0, x3, y3);
+    return;
+  }
+
+  i32 segments = 1 + (i32)floorf(sqrtf(sqrtf(RASTER_FLATTEN_TOLERANCE * deviationSquared)));
+  f32 step = 1.0f / (f32)segments;
+  f32 t = 0;
+  f32 previousX = x0, previousY = y0;
+  for (i32 i = 0; i < segments - 1; ++i)
+  {
+    t += step;
+    f32 u = 1.0f - t;
+    f32 b0 = u * u * u, b1 = 3.0f * u * u * t, b2 = 3.0f * u * t * t, b3 = t * t * t;
+    f32 nextX = b0 * x0 + b1 * x1 + b2 * x2 + b3 * x3;
+    f32 nextY = b0 * y0 + b1 * y1 + b2 * y2 + b3 * y3;
+    RasterizeLine(rasterizer, width, height, previousX, previousY, nextX, nextY);
+    previousX = nextX;
+    previousY = nextY;
+  }
+  RasterizeLine(rasterizer, width, height, previousX, previousY, x3, y3);
+}
+
+// Receives the segments of a contour, pointCount is 2 for lines, 3 for quadratics and 4 for cubics.
+typedef void ContourSegmentFunction(void *context, i32 pointCount, f32 *x, f32 *y);
+
+// Walks one contour in bitmap pixels with y down, emitting closed segments. TrueType contours imply an
+// on-curve point between two consecutive control points, CFF contours have pairs of cubic control points.
+void WalkContour(GlyphOutline *outline, i32 contourStart, i32 contourEnd, f32 scale, f32 offsetX, f32 offsetY,
+                 ContourSegmentFunction *emit, void *context)
+{
+  i32 count = contourEnd - contourStart + 1;
+  if (count < 2) return;
+
+  // Start from an on-curve point, or from the midpoint of the first two control points.
+  i32 first = 0;
+  while (first < count && outline->onCurve[contourStart + first] != OUTLINE_ON_CURVE) ++first;
+  f32 startX, startY;
+  if (first == count)
+  {
+    first = 0;
+    startX = 0.5f * (outline->x[contourStart] + outline->x[contourStart + 1]) * scale - offsetX;
+    startY = offsetY - 0.5f * (outline->y[contourStart] + outline->y[contourStart + 1]) * scale;
+  }
+  else
+  {
+    startX = outline->x[contourStart + first] * scale - offsetX;
+    startY = offsetY - outline->y[contourStart + first] * scale;
+  }
+
+  f32 x[4] = { startX }, y[4] = { startY }; // The pen, then the points of the segment.
+  i32 hasControl = 0;
+  for (i32 i = 1; i <= count; ++i)
+  {
+    i32 index = contourStart + (first + i) % count;
+    f32 pointX = outline->x[index] * scale - offsetX;
+    f32 pointY = offsetY - outline->y[index] * scale;
+
+    if (outline->onCurve[index] == OUTLINE_CUBIC_CONTROL && i + 2 <= count)
+    {
+      // The curve ends on the next point after the second control point, or back on the start.
+      i32 secondIndex = contourStart + (first + i + 1) % count;
+      i32 endIndex = contourStart + (first + i + 2) % count;
+      x[1] = pointX;
+      y[1] = pointY;
+      x[2] = outline->x[secondIndex] * scale - offsetX;
+      y[2] = offsetY - outline->y[secondIndex] * scale;
+      x[3] = i + 2 == count ? startX : outline->x[endIndex] * scale - offsetX;
+      y[3] = i + 2 == count ? startY : offsetY - outline->y[endIndex] * scale;
+      emit(context, 4, x, y);
+      x[0] = x[3];
+      y[0] = y[3];
+      i += 2;
+    }
+    else if (outline->onCurve[index] == OUTLINE_ON_CURVE)
+    {
+      x[1 + hasControl] = pointX;
+      y[1 + hasControl] = pointY;
+      emit(context, 2 + hasControl, x, y);
+      x[0] = pointX;
+      y[0] = pointY;
+      hasControl = 0;
+    }
+    else if (hasControl)
+    {
+      x[2] = 0.5f * (x[1] + pointX);
+      y[2] = 0.5f * (y[1] + pointY);
+      emit(context, 3, x, y);
+      x[0] = x[2];
+      y[0] = y[2];
+      x[1] = pointX;
+      y[1] = pointY;
+    }
+    else
+    {
+      x[1] = pointX;
+      y[1] = pointY;
+      hasControl = 1;
+    }
+  }
+
+  // Only contours without on-curve points end on a control point, the one between the midpoint of the
+  // last two control points and the start.
+  if (hasControl)
+  {
+    x[2] = startX;
+    y[2] = startY;
+    emit(context, 3, x, y);
+  }
+}
+
+typedef struct {
+  Rasterizer *rasterizer;
+  i32 width;
+  i32 height;
+} RasterizeSegmentContext;
+
+void RasterizeSegment(void *context, i32 pointCount, f32 *x, f32 *y)
+{
+  RasterizeSegmentContext *segment = (RasterizeSegmentContext *)context;
+  Rasterizer *rasterizer = segment->rasterizer;
+  i32 width = segment->width, height = segment->height;
+  if (pointCount == 2) RasterizeLine(rasterizer, width, height, x[0], y[0], x[1], y[1]);
+  else if (pointCount == 3) RasterizeQuadratic(rasterizer, width, height, x[0], y[0], x[1], y[1], x[2], y[2]);
+  else RasterizeCubic(rasterizer, width, height, x[0], y[0], x[1], y[1], x[2], y[2], x[3], y[3]);
+}
+
+void RasterizeContours(Rasterizer *rasterizer, GlyphOutline *outline, i32 width, i32 height)
+{
+  RasterizeSegmentContext context = { rasterizer, width, height };
+  i32 contourStart = 0;
+  for (i32 contour = 0; contour < outline->contourCount; ++contour)
+  {
+    i32 contourEnd = outline->contourEnds[contour];
+    WalkContour(outline, contourStart, contourEnd, rasterizer->scale, rasterizer->offsetX, rasterizer->offsetY,
+                RasterizeSegment, &context);
+    contourStart = contourEnd + 1;
+  }
+}
+
+// Running sum of the accumulated deltas, clamped to [0, 255]. Cells are zeroed as they are read.
+void AccumulateCoverageScalar(f32 *accumulation, u8 *pixels, i32 count)
+{
+  f32 sum = 0;
+  for (i32 i = 0; i < count; ++i)
+  {
+    sum += accumulation[i];
+    accumulation[i] = 0;
+    f32 coverage = fabsf(sum);
+    if (coverage > 1.0f) coverage = 1.0f;
+    pixels[i] = (u8)(coverage * 255.0f + 0.5f);
+  }
+}
+
+#if SIMD_X86
+// 4-wide in-register prefix sum, the running total is broadcast from the last lane.
+void AccumulateCoverageSse2(f32 *accumulation, u8 *pixels, i32 count)
+{
+  __m128 sum = _mm_setzero_ps();
+  __m128 zero = _mm_setzero_ps();
+  __m128 one = _mm_set1_ps(1.0f);
+  __m128 maxValue = _mm_set1_ps(255.0f);
+  __m128 half = _mm_set1_ps(0.5f);
+  __m128 signMask = _mm_set1_ps(-0.0f);
+
+  i32 i = 0;
+  for (; i + 4 <= count; i += 4)
+  {
+    __m128 deltas = _mm_loadu_ps(&accumulation[i]);
+    _mm_storeu_ps(&accumulation[i], zero);
+    deltas = _mm_add_ps(deltas, _mm_castsi128_ps(_mm_slli_si128(_mm_castps_si128(deltas), 4)));
+    deltas = _mm_add_ps(deltas, _mm_castsi128_ps(_mm_slli_si128(_mm_castps_si128(deltas), 8)));
+    __m128 total = _mm_add_ps(deltas, sum);
+    sum = _mm_shuffle_ps(total, total, _MM_SHUFFLE(3, 3, 3, 3));
+
+    __m128 coverage = _mm_min_ps(_mm_andnot_ps(signMask, total), one);
+    __m128i values = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(coverage, maxValue), half));
+    values = _mm_packs_epi32(values, values);
+    values = _mm_packus_epi16(values, values);
+    i32 packed = _mm_cvtsi128_si32(values);
+    memcpy(&pixels[i], &packed, 4);
+  }
+
+  f32 tailSum = _mm_cvtss_f32(sum);
+  for (; i < count; ++i)
+  {
+    tailSum += accumulation[i];
+    accumulation[i] = 0;
+    f32 coverage = fabsf(tailSum);
+    if (coverage > 1.0f) coverage = 1.0f;
+    pixels[i] = (u8)(coverage * 255.0f + 0.5f);
+  }
+}
+#endif
+
+void AccumulateCoverage(f32 *accumulation, u8 *pixels, i32 count)
+{
+#if SIMD_X86
+  if (GetCpuFeatures()->hasSse2)
+  {
+    AccumulateCoverageSse2(accumulation, pixels, count);
+    return;
+  }
+#endif
+  AccumulateCoverageScalar(accumulation, pixels, count);
+}
+
+// bitmap must come from GetGlyphBitmapBounds with the same scale and have width * height pixels.
+// Returns 0 when the glyph does not fit the rasterizer.
+i32 RasterizeGlyphOutline(Rasterizer *rasterizer, GlyphOutline *outline, f32 scale, GlyphBitmap *bitmap)
+{
+  i32 area = bitmap->width * bitmap->height;
+  if (!area) return 1;
+  if (area + 4 > rasterizer->capacity) return 0;
+
+  rasterizer->scale = scale;
+  rasterizer->offsetX = (f32)bitmap->left;
+  rasterizer->offsetY = (f32)bitmap->top;
+  PROFILE_BEGIN(RasterizeGlyphOutline);
+  RasterizeContours(rasterizer, outline, bitmap->width, bitmap->height);
+  AccumulateCoverage(rasterizer->accumulation, bitmap->pixels, area);
+  PROFILE_END(RasterizeGlyphOutline);
+
+  // Segments touching the right edge of the last row spill past the bitmap area.
+  memset(&rasterizer->accumulation[area], 0, 4 * sizeof(f32));
+  return 1;
+}
+
+typedef struct {
+  GlyphData *glyphData;
+  u16 *pixelSizes;
+  GlyphBitmap *bitmaps;
+  GlyphOutline **outlines; // One per worker.
+  Rasterizer **rasterizers;
+  volatile i64 failures;
+} PrerasterizeWork;
+
+void PrerasterizeGlyphRange(JobWorker *worker, void *data, i32 begin, i32 end)
+{
+  PrerasterizeWork *work = (PrerasterizeWork *)data;
+  GlyphData *glyphData = work->glyphData;
+  GlyphOutline *outline = work->outlines[worker->index];
+  Rasterizer *rasterizer = work->rasterizers[worker->index];
+  f32 unitsPerEm = (f32)glyphData->fontHeader->unitsPerEm;
+
+  i64 failures = 0;
+  for (i32 i = begin; i < end; ++i)
+  {
+    u16 glyphId = (u16)(i % glyphData->numGlyphs);
+    f32 scale = (f32)work->pixelSizes[i / glyphData->numGlyphs] / unitsPerEm;
+    GlyphBitmap *bitmap = &work->bitmaps[i];
+    if (!DecodeGlyphOutline(glyphData, glyphId, outline))
+    {
+      memset(bitmap, 0, sizeof(GlyphBitmap));
+      ++failures;
+      continue;
+    }
+
+    GetGlyphBitmapBounds(outline, scale, bitmap);
+    bitmap->pixels = (u8 *)AllocNoZero(&worker->arena, (size_t)bitmap->width * bitmap->height + SIMD_PADDING);
+    if (!bitmap->pixels || !RasterizeGlyphOutline(rasterizer, outline, scale, bitmap))
+    {
+      memset(bitmap, 0, sizeof(GlyphBitmap));
+      ++failures;
+    }
+  }
+  if (failures) AtomicAddI64(&work->failures, failures);
+}
+
+// Rasterizes every glyph at every pixel size across the job system. bitmaps holds sizeCount * numGlyphs
+// entries, size major, with pixels allocated from the arena of the worker that produced them. Glyphs
+// that fail are left empty. Returns the number of failures.
+i32 PrerasterizeGlyphs(JobSystem *system, Arena *arena, GlyphData *glyphData, u16 *pixelSizes, i32 sizeCount, GlyphBitmap *bitmaps)
+{
+  PrerasterizeWork work = {0};
+  work.glyphData = glyphData;
+  work.pixelSizes = pixelSizes;
+  work.bitmaps = bitmaps;
+  work.outlines = (GlyphOutline **)Alloc(arena, system->workerCount * sizeof(GlyphOutline *));
+  work.rasterizers = (Rasterizer **)Alloc(arena, system->workerCount * sizeof(Rasterizer *));
+
+  // The head bbox bounds every simple glyph, the margin covers rounding and most composite transforms.
+  u16 maxPixelSize = 0;
+  for (i32 i = 0; i < sizeCount; ++i)
+  {
+    if (pixelSizes[i] > maxPixelSize) maxPixelSize = pixelSizes[i];
+  }
+  FontHeaderTable *fontHeader = glyphData->fontHeader;
+  f32 maxScale = (f32)maxPixelSize / (f32)fontHeader->unitsPerEm;
+  i32 maxWidth = (i32)ceilf((f32)(fontHeader->xMax - fontHeader->xMin) * maxScale) + 4;
+  i32 maxHeight = (i32)ceilf((f32)(fontHeader->yMax - fontHeader->yMin) * maxScale) + 4;
+  for (i32 i = 0; i < system->workerCount; ++i)
+  {
+    Arena *workerArena = &system->workers[i].arena;
+    work.outlines[i] = AllocGlyphOutline(workerArena, glyphData);
+    work.rasterizers[i] = AllocRasterizer(workerArena, maxWidth, maxHeight);
+  }
+
+  RunParallelFor(system, PrerasterizeGlyphRange, &work, sizeCount * glyphData->numGlyphs, 16);
+  return (i32)work.failures;
+}
@@ -0,0 +1,638 @@
+// Signed distance field generation from glyf outlines. Distances are measured to the quadratic contours
+// themselves, the sign comes from the nonzero winding rule evaluated at each pixel center. The
+// multi-channel variant colors edges so that corners survive bilinear sampling, the shape is the median
+// of the three channels.
+//SPECS: https://github.com/Chlumsky/msdfgen/files/3050967/thesis.pdf
+
+typedef enum {
+  DISTANCE_FIELD_SINGLE = 1, // One byte per pixel.
+  DISTANCE_FIELD_MULTI = 3, // Three bytes per pixel, RGB.
+} DistanceFieldMode;
+
+typedef enum {
+  EDGE_RED = 1,
+  EDGE_GREEN = 2,
+  EDGE_BLUE = 4,
+  EDGE_YELLOW = EDGE_RED | EDGE_GREEN,
+  EDGE_MAGENTA = EDGE_RED | EDGE_BLUE,
+  EDGE_CYAN = EDGE_GREEN | EDGE_BLUE,
+  EDGE_WHITE = EDGE_RED | EDGE_GREEN | EDGE_BLUE,
+} EdgeColor;
+
+// fminf/fmaxf handle NaN and compile to library calls, none of these inputs can be NaN.
+#define MIN_F32(a, b) ((a) < (b) ? (a) : (b))
+#define MAX_F32(a, b) ((a) > (b) ? (a) : (b))
+
+#define DISTANCE_FIELD_CORNER_COSINE 0.95f // Contours bending more than ~18 degrees have a corner.
+
+typedef struct {
+  i32 edgeCapacity;
+  i32 edgeCount;
+  i32 maxWidth;
+  f32 orientation; // 1 when outer contours are clockwise in font units as in glyf, -1 when reversed as in CFF.
+  // Quadratic edges in bitmap pixels with y down, lines have their control point halfway.
+  f32 *x0;
+  f32 *y0;
+  f32 *x1;
+  f32 *y1;
+  f32 *x2;
+  f32 *y2;
+  f32 *xMin; // Control point bounds, the hull contains the curve.
+  f32 *yMin;
+  f32 *xMax;
+  f32 *yMax;
+  u8 *lines;
+  u8 *colors; // EdgeColor, only used by the multi-channel mode.
+
+  // Per row scratch.
+  i32 *rowEdges;
+  f32 *crossingX;
+  i8 *crossingDirection;
+  u8 *inside;
+  f32 *distanceSquared; // maxWidth per channel.
+  f32 *pseudoDistance;
+  f32 *orthogonality;
+} DistanceFieldGenerator;
+
+DistanceFieldGenerator *AllocDistanceFieldGenerator(Arena *arena, i32 maxPoints, i32 maxContours, i32 maxWidth)
+{
+  DistanceFieldGenerator *generator = (DistanceFieldGenerator *)Alloc(arena, sizeof(DistanceFieldGenerator));
+  i32 capacity = maxPoints + maxContours;
+  generator->edgeCapacity = capacity;
+  generator->maxWidth = maxWidth;
+
+  f32 **edgeArrays[] = { &generator->x0, &generator->y0, &generator->x1, &generator->y1, &generator->x2, &generator->y2,
+                         &generator->xMin, &generator->yMin, &generator->xMax, &generator->yMax };
+  for (i32 i = 0; i < (i32)(sizeof(edgeArrays) / sizeof(edgeArrays[0])); ++i)
+  {
+    *edgeArrays[i] = (f32 *)Alloc(arena, capacity * sizeof(f32));
+  }
+  generator->lines = (u8 *)Alloc(arena, capacity);
+  generator->colors = (u8 *)Alloc(arena, capacity);
+
+  generator->rowEdges = (i32 *)Alloc(arena, capacity * sizeof(i32));
+  generator->crossingX = (f32 *)Alloc(arena, 2 * capacity * sizeof(f32));
+  generator->crossingDirection = (i8 *)Alloc(arena, 2 * capacity);
+  generator->inside = (u8 *)Alloc(arena, maxWidth + SIMD_PADDING);
+  // Rows are processed 8 pixels at a time, round up so vector stores stay in bounds.
+  i32 paddedWidth = (maxWidth + 7) & ~7;
+  generator->distanceSquared = (f32 *)Alloc(arena, 3 * paddedWidth * sizeof(f32));
+  generator->pseudoDistance = (f32 *)Alloc(arena, 3 * paddedWidth * sizeof(f32));
+  generator->orthogonality = (f32 *)Alloc(arena, 3 * paddedWidth * sizeof(f32));
+  return generator;
+}
+
+// Same as GetGlyphBitmapBounds with spread pixels of margin on every side.
+void GetDistanceFieldBounds(GlyphOutline *outline, f32 scale, i32 spread, GlyphBitmap *bitmap)
+{
+  GetGlyphBitmapBounds(outline, scale, bitmap);
+  if (!bitmap->width || !bitmap->height) return;
+  bitmap->left -= spread;
+  bitmap->top += spread;
+  bitmap->width += 2 * spread;
+  bitmap->height += 2 * spread;
+}
+
+void AddDistanceFieldEdge(DistanceFieldGenerator *generator, f32 x0, f32 y0, f32 x1, f32 y1, f32 x2, f32 y2, i32 line)
+{
+  if (x0 == x2 && y0 == y2 && (line || (x0 == x1 && y0 == y1))) return;
+
+  // A control point on an end point makes the curve a line, and its end tangent undefined.
+  if (!line && ((x0 == x1 && y0 == y1) || (x1 == x2 && y1 == y2))) line = 1;
+  if (line)
+  {
+    x1 = 0.5f * (x0 + x2);
+    y1 = 0.5f * (y0 + y2);
+  }
+
+  i32 i = generator->edgeCount++;
+  generator->x0[i] = x0; generator->y0[i] = y0;
+  generator->x1[i] = x1; generator->y1[i] = y1;
+  generator->x2[i] = x2; generator->y2[i] = y2;
+  generator->xMin[i] = MIN_F32(x0, MIN_F32(x1, x2));
+  generator->yMin[i] = MIN_F32(y0, MIN_F32(y1, y2));
+  generator->xMax[i] = MAX_F32(x0, MAX_F32(x1, x2));
+  generator->yMax[i] = MAX_F32(y0, MAX_F32(y1, y2));
+  generator->lines[i] = (u8)line;
+  generator->colors[i] = EDGE_WHITE;
+}
+
+// Switches color at every corner, so both edges meeting at a corner share exactly one channel.
+void ColorContourEdges(DistanceFieldGenerator *generator, i32 first, i32 count)
+{
+  if (count <= 0) return;
+
+  i32 cornerCount = 0;
+  i32 firstCorner = -1;
+  for (i32 i = 0; i < count; ++i)
+  {
+    i32 previous = first + (i + count - 1) % count;
+    i32 edge = first + i;
+    f32 inX = generator->x2[previous] - generator->x1[previous];
+    f32 inY = generator->y2[previous] - generator->y1[previous];
+    f32 outX = generator->x1[edge] - generator->x0[edge];
+    f32 outY = generator->y1[edge] - generator->y0[edge];
+    f32 lengths = sqrtf((inX * inX + inY * inY) * (outX * outX + outY * outY));
+    if (lengths > 0 && (inX * outX + inY * outY) < DISTANCE_FIELD_CORNER_COSINE * lengths)
+    {
+      generator->colors[edge] = 1; // Marks a corner at the start of the edge until colors are assigned.
+      if (firstCorner < 0) firstCorner = i;
+      ++cornerCount;
+    }
+    else
+    {
+      generator->colors[edge] = 0;
+    }
+  }
+
+  if (cornerCount == 0)
+  {
+    for (i32 i = 0; i < count; ++i) generator->colors[first + i] = EDGE_WHITE;
+    return;
+  }
+
+  // A single corner splits its spline in three so the corner still sees two color changes.
+  u8 cycle[3] = { EDGE_CYAN, EDGE_MAGENTA, EDGE_YELLOW };
+  i32 spline = 0;
+  for (i32 i = 0; i < count; ++i)
+  {
+    i32 edge = first + (firstCorner + i) % count;
+    if (i > 0 && (generator->colors[edge] == 1 || (cornerCount == 1 && (i == count / 3 || i == 2 * count / 3)))) ++spline;
+    i32 color = spline % 3;
+    // The last spline also meets the first one, with 3n + 1 corners it would get the same color.
+    if (cornerCount > 1 && spline == cornerCount - 1 && color == 0) color = 1;
+    generator->colors[edge] = cycle[color];
+  }
+}
+
+// Edges are quadratic, a cubic is split in halves each approximated by the quadratic through its end points
+// whose control point is (3 * (c1 + c2) - (p0 + p3)) / 4.
+void AddCubicDistanceFieldEdges(DistanceFieldGenerator *generator, f32 x0, f32 y0, f32 x1, f32 y1, f32 x2, f32 y2, f32 x3, f32 y3)
+{
+  f32 x01 = 0.5f * (x0 + x1), y01 = 0.5f * (y0 + y1);
+  f32 x12 = 0.5f * (x1 + x2), y12 = 0.5f * (y1 + y2);
+  f32 x23 = 0.5f * (x2 + x3), y23 = 0.5f * (y2 + y3);
+  f32 xa = 0.5f * (x01 + x12), ya = 0.5f * (y01 + y12);
+  f32 xb = 0.5f * (x12 + x23), yb = 0.5f * (y12 + y23);
+  f32 xm = 0.5f * (xa + xb), ym = 0.5f * (ya + yb);
+  AddDistanceFieldEdge(generator, x0, y0, 0.25f * (3.0f * (x01 + xa) - x0 - xm), 0.25f * (3.0f * (y01 + ya) - y0 - ym), xm, ym, 0);
+  AddDistanceFieldEdge(generator, xm, ym, 0.25f * (3.0f * (xb + x23) - xm - x3), 0.25f * (3.0f * (yb + y23) - ym - y3), x3, y3, 0);
+}
+
+void AddDistanceFieldSegment(void *context, i32 pointCount, f32 *x, f32 *y)
+{
+  DistanceFieldGenerator *generator = (DistanceFieldGenerator *)context;
+  if (pointCount == 2) AddDistanceFieldEdge(generator, x[0], y[0], 0, 0, x[1], y[1], 1);
+  else if (pointCount == 3) AddDistanceFieldEdge(generator, x[0], y[0], x[1], y[1], x[2], y[2], 0);
+  else AddCubicDistanceFieldEdges(generator, x[0], y[0], x[1], y[1], x[2], y[2], x[3], y[3]);
+}
+
+// Same contour walk as RasterizeContours, collecting edges instead of accumulating them.
+void BuildDistanceFieldEdges(DistanceFieldGenerator *generator, GlyphOutline *outline, f32 scale, f32 offsetX, f32 offsetY)
+{
+  generator->edgeCount = 0;
+  i32 contourStart = 0;
+  for (i32 contour = 0; contour < outline->contourCount; ++contour)
+  {
+    i32 contourEnd = outline->contourEnds[contour];
+    i32 firstEdge = generator->edgeCount;
+    WalkContour(outline, contourStart, contourEnd, scale, offsetX, offsetY, AddDistanceFieldSegment, generator);
+    ColorContourEdges(generator, firstEdge, generator->edgeCount - firstEdge);
+    contourStart = contourEnd + 1;
+  }
+
+  // Outer contours enclose more than the holes they contain, so the total signed area has their direction.
+  // Each edge adds its chord to the shoelace sum plus the 2/3 of its control triangle bulging past it.
+  f32 area = 0;
+  for (i32 i = 0; i < generator->edgeCount; ++i)
+  {
+    f32 x0 = generator->x0[i], y0 = generator->y0[i];
+    f32 chord = x0 * generator->y2[i] - generator->x2[i] * y0;
+    f32 bulge = (generator->x1[i] - x0) * (generator->y2[i] - y0) - (generator->y1[i] - y0) * (generator->x2[i] - x0);
+    area += chord + (2.0f / 3.0f) * bulge;
+  }
+  generator->orientation = area < 0 ? -1.0f : 1.0f;
+}
+
+// Nonzero winding at the pixel centers of one row. Quadratics are split at their y extremum so every
+// piece crosses the row at most once, end points follow the half-open rule to avoid double counts.
+void ComputeRowInside(DistanceFieldGenerator *generator, f32 centerY, i32 width)
+{
+  i32 crossingCount = 0;
+  for (i32 edge = 0; edge < generator->edgeCount; ++edge)
+  {
+    if (centerY < generator->yMin[edge] || centerY >= generator->yMax[edge]) continue;
+
+    f32 y0 = generator->y0[edge], y1 = generator->y1[edge], y2 = generator->y2[edge];
+    f32 a = y0 - 2.0f * y1 + y2;
+    f32 b = 2.0f * (y1 - y0);
+    f32 c = y0 - centerY;
+    f32 pieces[3] = { 0, 1, 1 };
+    i32 pieceCount = 1;
+    i32 line = generator->lines[edge] || a == 0;
+    if (!line)
+    {
+      f32 extremum = (y0 - y1) / a;
+      if (extremum > 0 && extremum < 1)
+      {
+        pieces[1] = extremum;
+        pieceCount = 2;
+      }
+    }
+
+    for (i32 piece = 0; piece < pieceCount; ++piece)
+    {
+      f32 tStart = pieces[piece], tEnd = pieces[piece + 1];
+      f32 yStart = (a * tStart + b) * tStart + y0;
+      f32 yEnd = (a * tEnd + b) * tEnd + y0;
+      if (yStart == yEnd) continue;
+      i32 direction = yEnd > yStart ? 1 : -1;
+      if (direction > 0 ? (centerY < yStart || centerY >= yEnd) : (centerY < yEnd || centerY >= yStart)) continue;
+
+      f32 t;
+      if (line)
+      {
+        t = (centerY - y0) / (generator->y2[edge] - y0);
+      }
+      else
+      {
+        // Cancellation-free form of the quadratic formula, keep the root inside the piece.
+        f32 q = -0.5f * (b + (b < 0 ? -1.0f : 1.0f) * sqrtf(MAX_F32(b * b - 4.0f * a * c, 0)));
+        f32 middle = 0.5f * (tStart + tEnd);
+        t = q / a;
+        if (q != 0 && fabsf(c / q - middle) < fabsf(t - middle)) t = c / q;
+      }
+      t = MIN_F32(MAX_F32(t, tStart), tEnd);
+      f32 mt = 1.0f - t;
+      generator->crossingX[crossingCount] = mt * mt * generator->x0[edge] + 2.0f * mt * t * generator->x1[edge] + t * t * generator->x2[edge];
+      generator->crossingDirection[crossingCount] = (i8)direction;
+      ++crossingCount;
+    }
+  }
+
+  // Rows cross few edges, insertion sort them by x.
+  for (i32 i = 1; i < crossingCount; ++i)
+  {
+    f32 x = generator->crossingX[i];
+    i8 direction = generator->crossingDirection[i];
+    i32 j = i - 1;
+    for (; j >= 0 && generator->crossingX[j] > x; --j)
+    {
+      generator->crossingX[j + 1] = generator->crossingX[j];
+      generator->crossingDirection[j + 1] = generator->crossingDirection[j];
+    }
+    generator->crossingX[j + 1] = x;
+    generator->crossingDirection[j + 1] = direction;
+  }
+
+  i32 winding = 0;
+  i32 crossing = 0;
+  for (i32 x = 0; x < width; ++x)
+  {
+    f32 centerX = (f32)x + 0.5f;
+    while (crossing < crossingCount && generator->crossingX[crossing] < centerX)
+    {
+      winding += generator->crossingDirection[crossing++];
+    }
+    generator->inside[x] = winding != 0;
+  }
+}
+
+// Real roots of a t^3 + b t^2 + c t + d, lower degrees when the leading coefficients vanish.
+i32 SolveCubic(f64 a, f64 b, f64 c, f64 d, f64 *roots)
+{
+  f64 scale = fabs(b) + fabs(c) + fabs(d);
+  if (fabs(a) <= 1e-9 * scale)
+  {
+    if (fabs(b) <= 1e-12 * scale)
+    {
+      if (c == 0) return 0;
+      roots[0] = -d / c;
+      return 1;
+    }
+    f64 discriminant = c * c - 4.0 * b * d;
+    if (discriminant < 0) return 0;
+    f64 root = sqrt(discriminant);
+    roots[0] = (-c + root) / (2.0 * b);
+    roots[1] = (-c - root) / (2.0 * b);
+    return 2;
+  }
+
+  f64 a2 = b / a, a1 = c / a, a0 = d / a;
+  f64 q = (3.0 * a1 - a2 * a2) / 9.0;
+  f64 r = (9.0 * a2 * a1 - 27.0 * a0 - 2.0 * a2 * a2 * a2) / 54.0;
+  f64 discriminant = q * q * q + r * r;
+  if (discriminant >= 0)
+  {
+    f64 root = sqrt(discriminant);
+    f64 s = cbrt(r + root);
+    f64 u = cbrt(r - root);
+    roots[0] = s + u - a2 / 3.0;
+    roots[1] = -0.5 * (s + u) - a2 / 3.0;
+    return 2;
+  }
+
+  f64 theta = acos(r / sqrt(-q * q * q));
+  f64 radius = 2.0 * sqrt(-q);
+  for (i32 k = 0; k < 3; ++k)
+  {
+    roots[k] = radius * cos((theta + 2.0 * 3.14159265358979323846 * k) / 3.0) - a2 / 3.0;
+  }
+  return 3;
+}
+
+// Exact squared distance from a point to an edge, with the parameter of the closest point.
+// The derivative of |B(t) - P|^2 is a cubic in t, its roots in [0, 1] and both end points are tried.
+f32 EdgeDistanceSquared(DistanceFieldGenerator *generator, i32 edge, f32 pointX, f32 pointY, f32 *closest)
+{
+  f64 mx = generator->x0[edge] - pointX, my = generator->y0[edge] - pointY;
+  f64 ax = generator->x1[edge] - generator->x0[edge], ay = generator->y1[edge] - generator->y0[edge];
+  f64 bx = generator->x2[edge] - 2.0 * generator->x1[edge] + generator->x0[edge];
+  f64 by = generator->y2[edge] - 2.0 * generator->y1[edge] + generator->y0[edge];
+
+  f64 candidates[5] = { 0, 1 };
+  i32 candidateCount = 2;
+  if (generator->lines[edge])
+  {
+    f64 length = ax * ax + ay * ay;
+    if (length > 0) candidates[candidateCount++] = -(mx * ax + my * ay) / (2.0 * length);
+  }
+  else
+  {
+    candidateCount += SolveCubic(bx * bx + by * by, 3.0 * (ax * bx + ay * by),
+                                 2.0 * (ax * ax + ay * ay) + mx * bx + my * by, mx * ax + my * ay, &candidates[2]);
+  }
+
+  f64 best = 1e30, bestT = 0;
+  for (i32 i = 0; i < candidateCount; ++i)
+  {
+    f64 t = candidates[i] < 0 ? 0 : candidates[i] > 1 ? 1 : candidates[i];
+    f64 dx = mx + t * (2.0 * ax + t * bx);
+    f64 dy = my + t * (2.0 * ay + t * by);
+    f64 distance = dx * dx + dy * dy;
+    if (distance < best)
+    {
+      best = distance;
+      bestT = t;
+    }
+  }
+  *closest = (f32)bestT;
+  return (f32)best;
+}
+
+// Signed distance to the edge's extension past its end points, for points beyond them, and the signed
+// true distance otherwise. Positive on the right of the edge direction, which is inside for TrueType's
+// clockwise outer contours once y points down.
+f32 EdgePseudoDistance(DistanceFieldGenerator *generator, i32 edge, f32 pointX, f32 pointY, f32 t, f32 distanceSquared, f32 *orthogonality)
+{
+  f32 ax = generator->x1[edge] - generator->x0[edge], ay = generator->y1[edge] - generator->y0[edge];
+  f32 bx = generator->x2[edge] - 2.0f * generator->x1[edge] + generator->x0[edge];
+  f32 by = generator->y2[edge] - 2.0f * generator->y1[edge] + generator->y0[edge];
+  f32 directionX = ax + t * bx, directionY = ay + t * by;
+  f32 mt = 1.0f - t;
+  f32 vx = pointX - (mt * mt * generator->x0[edge] + 2.0f * mt * t * generator->x1[edge] + t * t * generator->x2[edge]);
+  f32 vy = pointY - (mt * mt * generator->y0[edge] + 2.0f * mt * t * generator->y1[edge] + t * t * generator->y2[edge]);
+  f32 directionLength = MAX_F32(sqrtf(directionX * directionX + directionY * directionY), 1e-12f);
+  f32 cross = (directionX * vy - directionY * vx) / directionLength;
+  f32 along = directionX * vx + directionY * vy;
+  f32 distance = sqrtf(distanceSquared);
+  *orthogonality = distance > 0 ? fabsf(cross) / distance : 1.0f;
+
+  if ((t <= 0 && along < 0) || (t >= 1 && along > 0)) return cross;
+  return cross >= 0 ? distance : -distance;
+}
+
+// Edges that can come closer than the spread to some pixel of the row.
+i32 GatherRowEdges(DistanceFieldGenerator *generator, f32 centerY, f32 limit)
+{
+  i32 count = 0;
+  for (i32 edge = 0; edge < generator->edgeCount; ++edge)
+  {
+    f32 dy = MAX_F32(MAX_F32(generator->yMin[edge] - centerY, centerY - generator->yMax[edge]), 0);
+    if (dy * dy < limit) generator->rowEdges[count++] = edge;
+  }
+  return count;
+}
+
+// Offers one edge to one pixel of the row. The scalar and AVX2 rows both end up here, so they
+// produce the same field. dy is the distance from the row to the edge's vertical bounds.
+void UpdateSingleChannelPixel(DistanceFieldGenerator *generator, i32 edge, f32 dy, i32 x, f32 centerY)
+{
+  f32 *best = &generator->distanceSquared[x];
+  f32 centerX = (f32)x + 0.5f;
+  f32 dx = MAX_F32(MAX_F32(generator->xMin[edge] - centerX, centerX - generator->xMax[edge]), 0);
+  if (dx * dx + dy * dy >= *best) return;
+  f32 t;
+  f32 distance = EdgeDistanceSquared(generator, edge, centerX, centerY, &t);
+  if (distance < *best) *best = distance;
+}
+
+void SingleChannelRowScalar(DistanceFieldGenerator *generator, i32 edgeCount, f32 centerY, i32 width)
+{
+  for (i32 i = 0; i < edgeCount; ++i)
+  {
+    i32 edge = generator->rowEdges[i];
+    f32 dy = MAX_F32(MAX_F32(generator->yMin[edge] - centerY, centerY - generator->yMax[edge]), 0);
+    for (i32 x = 0; x < width; ++x) UpdateSingleChannelPixel(generator, edge, dy, x, centerY);
+  }
+}
+
+// Within this relative distance two edges are tied, the one seen more head-on wins. That settles the
+// pixels closest to the corner shared by two edges.
+#define DISTANCE_FIELD_TIE 1e-3f
+
+// Multi-channel counterpart of UpdateSingleChannelPixel.
+void UpdateMultiChannelPixel(DistanceFieldGenerator *generator, i32 edge, f32 dy, i32 x, f32 centerY)
+{
+  i32 stride = (generator->maxWidth + 7) & ~7;
+  u8 color = generator->colors[edge];
+  f32 centerX = (f32)x + 0.5f;
+  f32 dx = MAX_F32(MAX_F32(generator->xMin[edge] - centerX, centerX - generator->xMax[edge]), 0);
+  f32 bound = dx * dx + dy * dy;
+  f32 *best = &generator->distanceSquared[x];
+  f32 largest = MAX_F32(best[0], MAX_F32(best[stride], best[2 * stride]));
+  if (bound > largest * (1.0f + DISTANCE_FIELD_TIE)) return;
+
+  f32 t;
+  f32 distance = EdgeDistanceSquared(generator, edge, centerX, centerY, &t);
+  f32 orthogonality = 0;
+  f32 pseudo = 0;
+  i32 computed = 0;
+  for (i32 channel = 0; channel < 3; ++channel)
+  {
+    if (!(color & (1 << channel))) continue;
+    i32 index = channel * stride + x;
+    f32 current = generator->distanceSquared[index];
+    f32 tie = DISTANCE_FIELD_TIE * current;
+    if (distance > current + tie) continue;
+    if (!computed)
+    {
+      pseudo = generator->orientation * EdgePseudoDistance(generator, edge, centerX, centerY, t, distance, &orthogonality);
+      computed = 1;
+    }
+    if (distance >= current - tie && orthogonality <= generator->orthogonality[index]) continue;
+    generator->distanceSquared[index] = distance;
+    generator->pseudoDistance[index] = pseudo;
+    generator->orthogonality[index] = orthogonality;
+  }
+}
+
+void MultiChannelRowScalar(DistanceFieldGenerator *generator, i32 edgeCount, f32 centerY, i32 width)
+{
+  for (i32 i = 0; i < edgeCount; ++i)
+  {
+    i32 edge = generator->rowEdges[i];
+    f32 dy = MAX_F32(MAX_F32(generator->yMin[edge] - centerY, centerY - generator->yMax[edge]), 0);
+    for (i32 x = 0; x < width; ++x) UpdateMultiChannelPixel(generator, edge, dy, x, centerY);
+  }
+}
+
+#if SIMD_X86
+// Bounds of 8 pixel centers of a row to one edge, slightly shrunk so that rounding never rejects a pixel
+// the exact test in the Update functions would keep.
+TARGET_AVX2 __m256 EdgeBoundAvx2(DistanceFieldGenerator *generator, i32 edge, __m256 centerX, f32 dy)
+{
+  __m256 dx = _mm256_max_ps(_mm256_max_ps(_mm256_sub_ps(_mm256_set1_ps(generator->xMin[edge]), centerX),
+                                          _mm256_sub_ps(centerX, _mm256_set1_ps(generator->xMax[edge]))), _mm256_setzero_ps());
+  __m256 bound = _mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_set1_ps(dy * dy));
+  return _mm256_mul_ps(bound, _mm256_set1_ps(1.0f - 1e-5f));
+}
+
+// Rejects 8 pixels at a time against the edge bounds, which is where almost every pixel ends. The few
+// left get the exact closest point per lane, so the field matches the scalar rows.
+TARGET_AVX2 void SingleChannelRowAvx2(DistanceFieldGenerator *generator, i32 edgeCount, f32 centerY, i32 width)
+{
+  __m256 lanes = _mm256_setr_ps(0.5f, 1.5f, 2.5f, 3.5f, 4.5f, 5.5f, 6.5f, 7.5f);
+  for (i32 i = 0; i < edgeCount; ++i)
+  {
+    i32 edge = generator->rowEdges[i];
+    f32 dy = MAX_F32(MAX_F32(generator->yMin[edge] - centerY, centerY - generator->yMax[edge]), 0);
+    for (i32 x = 0; x < width; x += 8)
+    {
+      __m256 centerX = _mm256_add_ps(_mm256_set1_ps((f32)x), lanes);
+      __m256 best = _mm256_loadu_ps(&generator->distanceSquared[x]);
+      u32 pending = (u32)_mm256_movemask_ps(_mm256_cmp_ps(EdgeBoundAvx2(generator, edge, centerX, dy), best, _CMP_LT_OQ));
+      if (width - x < 8) pending &= (1u << (width - x)) - 1;
+      for (; pending; pending &= pending - 1) UpdateSingleChannelPixel(generator, edge, dy, x + CountTrailingZeros(pending), centerY);
+    }
+  }
+}
+
+TARGET_AVX2 void MultiChannelRowAvx2(DistanceFieldGenerator *generator, i32 edgeCount, f32 centerY, i32 width)
+{
+  i32 stride = (generator->maxWidth + 7) & ~7;
+  __m256 lanes = _mm256_setr_ps(0.5f, 1.5f, 2.5f, 3.5f, 4.5f, 5.5f, 6.5f, 7.5f);
+  __m256 tieScale = _mm256_set1_ps(1.0f + DISTANCE_FIELD_TIE);
+  for (i32 i = 0; i < edgeCount; ++i)
+  {
+    i32 edge = generator->rowEdges[i];
+    f32 dy = MAX_F32(MAX_F32(generator->yMin[edge] - centerY, centerY - generator->yMax[edge]), 0);
+    for (i32 x = 0; x < width; x += 8)
+    {
+      __m256 centerX = _mm256_add_ps(_mm256_set1_ps((f32)x), lanes);
+      __m256 largest = _mm256_max_ps(_mm256_loadu_ps(&generator->distanceSquared[x]),
+                                     _mm256_max_ps(_mm256_loadu_ps(&generator->distanceSquared[stride + x]),
+                                                   _mm256_loadu_ps(&generator->distanceSquared[2 * stride + x])));
+      __m256 bound = EdgeBoundAvx2(generator, edge, centerX, dy);
+      u32 pending = (u32)_mm256_movemask_ps(_mm256_cmp_ps(bound, _mm256_mul_ps(largest, tieScale), _CMP_LE_OQ));
+      if (width - x < 8) pending &= (1u << (width - x)) - 1;
+      for (; pending; pending &= pending - 1) UpdateMultiChannelPixel(generator, edge, dy, x + CountTrailingZeros(pending), centerY);
+    }
+  }
+}
+#endif
+
+u8 EncodeDistance(f32 distance, f32 spread)
+{
+  f32 value = 0.5f + distance / (2.0f * spread);
+  value = value < 0 ? 0 : value > 1 ? 1 : value;
+  return (u8)(value * 255.0f + 0.5f);
+}
+
+f32 MedianOfThree(f32 a, f32 b, f32 c)
+{
+  return MAX_F32(MIN_F32(a, b), MIN_F32(MAX_F32(a, b), c));
+}
+
+// bitmap comes from GetDistanceFieldBounds with the same scale and spread and holds width * height * mode
+// bytes. 128 is the outline, every step of 127 / spread is one pixel further inside. Pixels whose median
+// disagrees with the winding rule fall back to the true distance in all channels. Returns 0 when the
+// glyph does not fit the generator.
+i32 GenerateDistanceFieldWith(DistanceFieldGenerator *generator, GlyphOutline *outline, f32 scale, i32 spread,
+                              DistanceFieldMode mode, GlyphBitmap *bitmap, i32 vectorized)
+{
+  if (!bitmap->width || !bitmap->height) return 1;
+  if (bitmap->width > generator->maxWidth || outline->pointCount + outline->contourCount > generator->edgeCapacity) return 0;
+
+  BuildDistanceFieldEdges(generator, outline, scale, (f32)bitmap->left, (f32)bitmap->top);
+
+  // Pixels further than the spread all encode the same, so nothing beyond it needs to be exact.
+  f32 limit = (f32)(spread + 1) * (f32)(spread + 1);
+  i32 stride = (generator->maxWidth + 7) & ~7;
+  i32 paddedWidth = (bitmap->width + 7) & ~7;
+  i32 channelCount = mode == DISTANCE_FIELD_MULTI ? 3 : 1;
+  for (i32 y = 0; y < bitmap->height; ++y)
+  {
+    f32 centerY = (f32)y + 0.5f;
+    ComputeRowInside(generator, centerY, bitmap->width);
+    for (i32 channel = 0; channel < channelCount; ++channel)
+    {
+      for (i32 x = 0; x < paddedWidth; ++x)
+      {
+        generator->distanceSquared[channel * stride + x] = limit;
+        generator->pseudoDistance[channel * stride + x] = FLT_MAX;
+        generator->orthogonality[channel * stride + x] = 0;
+      }
+    }
+
+    i32 edgeCount = GatherRowEdges(generator, centerY, limit);
+#if SIMD_X86
+    if (vectorized && GetCpuFeatures()->hasAvx2)
+    {
+      if (mode == DISTANCE_FIELD_MULTI) MultiChannelRowAvx2(generator, edgeCount, centerY, bitmap->width);
+      else SingleChannelRowAvx2(generator, edgeCount, centerY, bitmap->width);
+    }
+    else
+#endif
+    {
+      if (mode == DISTANCE_FIELD_MULTI) MultiChannelRowScalar(generator, edgeCount, centerY, bitmap->width);
+      else SingleChannelRowScalar(generator, edgeCount, centerY, bitmap->width);
+    }
+
+    u8 *pixels = &bitmap->pixels[y * bitmap->width * channelCount];
+    for (i32 x = 0; x < bitmap->width; ++x)
+    {
+      f32 sign = generator->inside[x] ? 1.0f : -1.0f;
+      if (mode == DISTANCE_FIELD_SINGLE)
+      {
+        pixels[x] = EncodeDistance(sign * sqrtf(generator->distanceSquared[x]), (f32)spread);
+        continue;
+      }
+
+      f32 channels[3];
+      f32 nearest = limit;
+      for (i32 channel = 0; channel < 3; ++channel)
+      {
+        f32 pseudo = generator->pseudoDistance[channel * stride + x];
+        channels[channel] = pseudo == FLT_MAX ? sign * (f32)spread : pseudo;
+        nearest = MIN_F32(nearest, generator->distanceSquared[channel * stride + x]);
+      }
+      f32 median = MedianOfThree(channels[0], channels[1], channels[2]);
+      if ((median > 0) != (sign > 0))
+      {
+        channels[0] = channels[1] = channels[2] = sign * sqrtf(nearest);
+      }
+      for (i32 channel = 0; channel < 3; ++channel)
+      {
+        pixels[x * 3 + channel] = EncodeDistance(channels[channel], (f32)spread);
+      }
+    }
+  }
+  return 1;
+}
+
+i32 GenerateDistanceField(DistanceFieldGenerator *generator, GlyphOutline *outline, f32 scale, i32 spread,
+                          DistanceFieldMode mode, GlyphBitmap *bitmap)
+{
+  return GenerateDistanceFieldWith(generator, outline, scale, spread, mode, bitmap, 1);
+}
@@ -0,0 +1,72 @@
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define SIMD_X86 1
+#include <immintrin.h>
+#if _MSC_VER
+#include <intrin.h>
+#endif
+#else
+#define SIMD_X86 0
+#endif
+
+// MSVC lets any function use any intrinsic, GCC and Clang need the target spelled out per function.
+#if SIMD_X86 && !_MSC_VER
+#define TARGET_SSSE3 __attribute__((target("ssse3")))
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define TARGET_SSSE3
+#define TARGET_AVX2
+#endif
+
+// Extra bytes allocated past arrays that are read with unaligned vector loads or gathers.
+#define SIMD_PADDING 32
+
+typedef struct {
+  i32 detected;
+  i32 hasSse2;
+  i32 hasSsse3;
+  i32 hasAvx2;
+} CpuFeatures;
+
+CpuFeatures cpuFeatures;
+
+CpuFeatures *GetCpuFeatures(void)
+{
+  if (cpuFeatures.detected) return &cpuFeatures;
+  cpuFeatures.detected = 1;
+
+#if SIMD_X86
+#if _MSC_VER
+  i32 info[4];
+  __cpuid(info, 0);
+  i32 maxLeaf = info[0];
+  __cpuid(info, 1);
+  cpuFeatures.hasSse2 = (info[3] >> 26) & 1;
+  cpuFeatures.hasSsse3 = (info[2] >> 9) & 1;
+  i32 osSavesYmm = ((info[2] >> 27) & 1) && (_xgetbv(0) & 6) == 6;
+  if (maxLeaf >= 7 && osSavesYmm)
+  {
+    __cpuidex(info, 7, 0);
+    cpuFeatures.hasAvx2 = (info[1] >> 5) & 1;
+  }
+#else
+  __builtin_cpu_init();
+  cpuFeatures.hasSse2 = __builtin_cpu_supports("sse2");
+  cpuFeatures.hasSsse3 = __builtin_cpu_supports("ssse3");
+  cpuFeatures.hasAvx2 = __builtin_cpu_supports("avx2");
+#endif
+#endif
+
+  return &cpuFeatures;
+}
+
+// x must not be 0.
+i32 CountTrailingZeros(u32 x)
+{
+#if _MSC_VER
+  unsigned long index;
+  _BitScanForward(&index, x);
+  return (i32)index;
+#else
+  return __builtin_ctz(x);
+#endif
+}
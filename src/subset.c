@@ -0,0 +1,381 @@
+//SPECS: https://learn.microsoft.com/en-us/typography/opentype/spec/otff
+
+// Writes a TrueType font holding only the glyphs a set of codepoints reaches, composites pulling in their
+// components. Kept glyphs stay in their original order and are numbered from 0, .notdef always stays first.
+// cmap, glyf, loca, hmtx and post are rebuilt, head, hhea, maxp and OS/2 patched and the tables that do not
+// reference glyphs copied. Every other table, GSUB, GPOS, GDEF and kern included, is dropped since its glyph
+// ids would no longer match.
+
+#define SUBSET_TABLE_COUNT 14 // OS/2 cmap cvt fpgm gasp glyf head hhea hmtx loca maxp name post prep, written in this tag order.
+
+// Parsed once per font so that each subset only walks the glyphs it keeps.
+typedef struct {
+  Font *font;
+  CodepointMap codepointMap;
+  GlyphData glyphData;
+  HorizontalMetrics metrics;
+} FontSubsetter;
+
+typedef struct {
+  u32 codepoint;
+  u16 glyphId; // Original id until the glyphs are renumbered.
+} SubsetMapping;
+
+// Output being assembled, tables are appended at 4-byte boundaries after room left for the directory.
+typedef struct {
+  u8 *data;
+  u32 size;
+  i32 tableCount;
+  TableRecord records[SUBSET_TABLE_COUNT];
+} SubsetWriter;
+
+// Returns 0 for fonts without glyf, CFF outlines are not subset.
+i32 LoadFontSubsetter(Arena *arena, Font *font, FontSubsetter *subsetter)
+{
+  memset(subsetter, 0, sizeof(FontSubsetter));
+  subsetter->font = font;
+  if (!GetFontTable(font, FONT_TABLE_GLYF).length)
+  {
+    fprintf(stderr, "Only fonts with TrueType outlines can be subset\n");
+    return 0;
+  }
+
+  return LoadCodepointMap(arena, font, &subsetter->codepointMap, CODEPOINT_MAP_BMP_TABLE) &&
+         LoadGlyphData(arena, font, &subsetter->glyphData) && subsetter->glyphData.numGlyphs &&
+         LoadHorizontalMetrics(arena, font, &subsetter->metrics) && GetFontTable(font, FONT_TABLE_HHEA).length >= 36;
+}
+
+int CompareSubsetMappings(const void *a, const void *b)
+{
+  u32 first = ((SubsetMapping *)a)->codepoint;
+  u32 second = ((SubsetMapping *)b)->codepoint;
+  return first < second ? -1 : first > second;
+}
+
+u8 *BeginSubsetTable(SubsetWriter *writer)
+{
+  return &writer->data[writer->size];
+}
+
+void EndSubsetTable(SubsetWriter *writer, FontTable table, u32 length)
+{
+  TableRecord *record = &writer->records[writer->tableCount++];
+  record->tag.value = READ_BIG_ENDIAN_U32(fontTableTags[table]);
+  record->offset = writer->size;
+  record->length = length;
+  writer->size += (length + 3) & ~3u;
+}
+
+// Copies the first length bytes of a table, missing tables are left out of the subset.
+u8 *CopySubsetTable(SubsetWriter *writer, Font *font, FontTable table, u32 length)
+{
+  FontView source = GetFontTable(font, table);
+  if (!source.length) return NULL;
+  if (length > source.length) length = source.length;
+  u8 *data = BeginSubsetTable(writer);
+  memcpy(data, source.data, length);
+  EndSubsetTable(writer, table, length);
+  return data;
+}
+
+// Format 4 for the BMP, plus format 12 when supplementary codepoints are mapped. Segments and groups
+// cover runs of consecutive codepoints mapped to consecutive glyphs, so idRangeOffset is never used.
+u32 WriteSubsetCodepointMap(u8 *cmap, SubsetMapping *mappings, i32 mappingCount)
+{
+  i32 bmpCount = 0;
+  while (bmpCount < mappingCount && mappings[bmpCount].codepoint < 0xFFFF) ++bmpCount;
+  i32 hasFormat12 = mappingCount && mappings[mappingCount - 1].codepoint > 0xFFFF;
+
+  i32 segCount = 1;
+  for (i32 i = 0; i < bmpCount; ++i)
+  {
+    if (!i || mappings[i].codepoint != mappings[i - 1].codepoint + 1 || mappings[i].glyphId != mappings[i - 1].glyphId + 1) ++segCount;
+  }
+
+  u32 headerSize = 4 + (hasFormat12 ? 2 : 1) * 8;
+  u32 format4Length = 16 + segCount * 8;
+  WriteBigEndianU16(&cmap[0], 0);
+  WriteBigEndianU16(&cmap[2], (u16)(hasFormat12 ? 2 : 1));
+  WriteBigEndianU16(&cmap[4], MICROSOFT_ENCODING);
+  WriteBigEndianU16(&cmap[6], UNICODE_BMP_ENCODING);
+  WriteBigEndianU32(&cmap[8], headerSize);
+
+  u8 *format4 = &cmap[headerSize];
+  u32 searchRange = FloorPowerOfTwo(segCount) * 2;
+  WriteBigEndianU16(&format4[0], 4);
+  WriteBigEndianU16(&format4[2], (u16)format4Length);
+  WriteBigEndianU16(&format4[4], 0);
+  WriteBigEndianU16(&format4[6], (u16)(segCount * 2));
+  WriteBigEndianU16(&format4[8], (u16)searchRange);
+  WriteBigEndianU16(&format4[10], (u16)CountTrailingZeros(searchRange / 2));
+  WriteBigEndianU16(&format4[12], (u16)(segCount * 2 - searchRange));
+  u8 *endCodes = &format4[14];
+  u8 *startCodes = &format4[16 + segCount * 2];
+  u8 *idDeltas = &format4[16 + segCount * 4];
+  u8 *idRangeOffsets = &format4[16 + segCount * 6];
+  WriteBigEndianU16(&format4[14 + segCount * 2], 0);
+
+  i32 segment = 0;
+  for (i32 i = 0; i < bmpCount;)
+  {
+    i32 last = i;
+    while (last + 1 < bmpCount && mappings[last + 1].codepoint == mappings[last].codepoint + 1 &&
+           mappings[last + 1].glyphId == mappings[last].glyphId + 1) ++last;
+    WriteBigEndianU16(&endCodes[segment * 2], (u16)mappings[last].codepoint);
+    WriteBigEndianU16(&startCodes[segment * 2], (u16)mappings[i].codepoint);
+    WriteBigEndianU16(&idDeltas[segment * 2], (u16)(mappings[i].glyphId - mappings[i].codepoint));
+    WriteBigEndianU16(&idRangeOffsets[segment * 2], 0);
+    ++segment;
+    i = last + 1;
+  }
+  // The required final segment maps 0xFFFF to glyph 0.
+  WriteBigEndianU16(&endCodes[segment * 2], 0xFFFF);
+  WriteBigEndianU16(&startCodes[segment * 2], 0xFFFF);
+  WriteBigEndianU16(&idDeltas[segment * 2], 1);
+  WriteBigEndianU16(&idRangeOffsets[segment * 2], 0);
+  if (!hasFormat12) return headerSize + format4Length;
+
+  u32 format12Offset = headerSize + format4Length;
+  WriteBigEndianU16(&cmap[12], MICROSOFT_ENCODING);
+  WriteBigEndianU16(&cmap[14], UNICODE_FULL_ENCODING);
+  WriteBigEndianU32(&cmap[16], format12Offset);
+
+  u8 *format12 = &cmap[format12Offset];
+  u32 groupCount = 0;
+  for (i32 i = 0; i < mappingCount;)
+  {
+    i32 last = i;
+    while (last + 1 < mappingCount && mappings[last + 1].codepoint == mappings[last].codepoint + 1 &&
+           mappings[last + 1].glyphId == mappings[last].glyphId + 1) ++last;
+    u8 *group = &format12[16 + groupCount++ * 12];
+    WriteBigEndianU32(&group[0], mappings[i].codepoint);
+    WriteBigEndianU32(&group[4], mappings[last].codepoint);
+    WriteBigEndianU32(&group[8], mappings[i].glyphId);
+    i = last + 1;
+  }
+  u32 format12Length = 16 + groupCount * 12;
+  WriteBigEndianU16(&format12[0], 12);
+  WriteBigEndianU16(&format12[2], 0);
+  WriteBigEndianU32(&format12[4], format12Length);
+  WriteBigEndianU32(&format12[8], 0);
+  WriteBigEndianU32(&format12[12], groupCount);
+  return format12Offset + format12Length;
+}
+
+// Returns the subset font in arena, or NULL when the font cannot be subset. Codepoints may repeat and
+// come in any order, those the font does not map are ignored.
+u8 *SubsetFont(Arena *arena, FontSubsetter *subsetter, u32 *codepoints, i32 codepointCount, u32 *subsetSize)
+{
+  PROFILE_BEGIN(SubsetFont);
+  Font *font = subsetter->font;
+  GlyphData *glyphData = &subsetter->glyphData;
+  u16 numGlyphs = glyphData->numGlyphs;
+  TmpArena scratch;
+  TmpArenaPush(&scratch, GetScratchArena(arena));
+
+  // Glyphs the codepoints map to, then the components of every composite kept, each glyph queued once.
+  u8 *kept = (u8 *)Alloc(scratch.arena, numGlyphs);
+  u16 *pending = (u16 *)AllocNoZero(scratch.arena, numGlyphs * sizeof(u16));
+  SubsetMapping *mappings = (SubsetMapping *)AllocNoZero(scratch.arena, (codepointCount + 1) * sizeof(SubsetMapping));
+  i32 pendingCount = 0;
+  i32 mappingCount = 0;
+  kept[0] = 1;
+  pending[pendingCount++] = 0;
+  for (i32 i = 0; i < codepointCount; ++i)
+  {
+    u16 glyphId = GlyphIndexFromCodepoint(&subsetter->codepointMap, codepoints[i]);
+    if (!glyphId || glyphId >= numGlyphs || codepoints[i] == 0xFFFF) continue;
+    mappings[mappingCount].codepoint = codepoints[i];
+    mappings[mappingCount++].glyphId = glyphId;
+    if (!kept[glyphId])
+    {
+      kept[glyphId] = 1;
+      pending[pendingCount++] = glyphId;
+    }
+  }
+
+  u64 glyfBound = 0;
+  while (pendingCount)
+  {
+    FontView glyph = GetGlyphView(glyphData, pending[--pendingCount]);
+    glyfBound += glyph.length + 3;
+    if (glyph.length < 10 || ViewI16(glyph, 0) >= 0) continue;
+
+    u8 *at = glyph.data + 10;
+    for (u8 *field; (field = NextGlyphComponent(&at, glyph.data + glyph.length));)
+    {
+      u16 component = READ_BIG_ENDIAN_U16(field);
+      if (component < numGlyphs && !kept[component])
+      {
+        kept[component] = 1;
+        pending[pendingCount++] = component;
+      }
+    }
+  }
+
+  // New ids follow the original order.
+  u16 *newGlyphIds = (u16 *)AllocNoZero(scratch.arena, numGlyphs * sizeof(u16));
+  u16 *oldGlyphIds = (u16 *)AllocNoZero(scratch.arena, numGlyphs * sizeof(u16));
+  u16 glyphCount = 0;
+  for (u32 glyphId = 0; glyphId < numGlyphs; ++glyphId)
+  {
+    newGlyphIds[glyphId] = glyphCount;
+    if (kept[glyphId]) oldGlyphIds[glyphCount++] = (u16)glyphId;
+  }
+
+  // Sorted and without duplicates for the cmap.
+  qsort(mappings, mappingCount, sizeof(SubsetMapping), CompareSubsetMappings);
+  i32 uniqueCount = 0;
+  for (i32 i = 0; i < mappingCount; ++i)
+  {
+    if (uniqueCount && mappings[uniqueCount - 1].codepoint == mappings[i].codepoint) continue;
+    mappings[uniqueCount].codepoint = mappings[i].codepoint;
+    mappings[uniqueCount++].glyphId = newGlyphIds[mappings[i].glyphId];
+  }
+  mappingCount = uniqueCount;
+
+  // Trailing glyphs sharing the last advance only store their bearing.
+  HorizontalMetrics *metrics = &subsetter->metrics;
+  u16 longMetricCount = glyphCount;
+  while (longMetricCount > 1 && metrics->advanceWidths[oldGlyphIds[longMetricCount - 1]] == metrics->advanceWidths[oldGlyphIds[longMetricCount - 2]])
+  {
+    --longMetricCount;
+  }
+
+  // Every table at most 3 bytes of padding over its final size.
+  u64 capacity = 12 + SUBSET_TABLE_COUNT * 16 + SUBSET_TABLE_COUNT * 3 + glyfBound;
+  capacity += 20 + 16 + (mappingCount + 1) * 8 + 16 + mappingCount * 12; // cmap
+  capacity += glyphCount * 4 + (glyphCount + 1) * 4; // hmtx, loca
+
+  // The rebuilt tables and head, hhea and maxp are always written, post only when it has a header.
+  FontView post = GetFontTable(font, FONT_TABLE_POST);
+  i32 tableCount = 7 + (post.length >= 32);
+  FontTable copiedTables[] = { FONT_TABLE_OS2, FONT_TABLE_CVT, FONT_TABLE_FPGM, FONT_TABLE_GASP, FONT_TABLE_NAME, FONT_TABLE_PREP,
+                               FONT_TABLE_HEAD, FONT_TABLE_HHEA, FONT_TABLE_MAXP, FONT_TABLE_POST };
+  for (i32 i = 0; i < (i32)(sizeof(copiedTables) / sizeof(copiedTables[0])); ++i)
+  {
+    FontView table = GetFontTable(font, copiedTables[i]);
+    capacity += table.length;
+    tableCount += i < 6 && table.length;
+  }
+
+  SubsetWriter writer = {0};
+  writer.data = (u8 *)Alloc(arena, capacity);
+  if (!writer.data)
+  {
+    TmpArenaPop(&scratch);
+    PROFILE_END(SubsetFont);
+    return NULL;
+  }
+  writer.size = 12 + tableCount * 16;
+
+  u8 *os2 = CopySubsetTable(&writer, font, FONT_TABLE_OS2, UINT32_MAX);
+  if (os2 && writer.records[writer.tableCount - 1].length >= 68 && mappingCount)
+  {
+    // Both fields are u16, supplementary codepoints are clamped to 0xFFFF as the spec asks.
+    u32 first = mappings[0].codepoint;
+    u32 last = mappings[mappingCount - 1].codepoint;
+    WriteBigEndianU16(&os2[64], (u16)(first > 0xFFFF ? 0xFFFF : first));
+    WriteBigEndianU16(&os2[66], (u16)(last > 0xFFFF ? 0xFFFF : last));
+  }
+
+  u8 *cmap = BeginSubsetTable(&writer);
+  EndSubsetTable(&writer, FONT_TABLE_CMAP, WriteSubsetCodepointMap(cmap, mappings, mappingCount));
+
+  CopySubsetTable(&writer, font, FONT_TABLE_CVT, UINT32_MAX);
+  CopySubsetTable(&writer, font, FONT_TABLE_FPGM, UINT32_MAX);
+  CopySubsetTable(&writer, font, FONT_TABLE_GASP, UINT32_MAX);
+
+  // Glyphs are padded to 4 bytes so that short offsets work up to 128 KB of glyf.
+  u32 *glyphOffsets = (u32 *)AllocNoZero(scratch.arena, (glyphCount + 1) * sizeof(u32));
+  u8 *glyf = BeginSubsetTable(&writer);
+  u32 glyfLength = 0;
+  for (u16 i = 0; i < glyphCount; ++i)
+  {
+    glyphOffsets[i] = glyfLength;
+    FontView glyph = GetGlyphView(glyphData, oldGlyphIds[i]);
+    if (!glyph.length) continue;
+    u8 *copy = &glyf[glyfLength];
+    memcpy(copy, glyph.data, glyph.length);
+    glyfLength += (glyph.length + 3) & ~3u;
+    if (glyph.length < 10 || ViewI16(glyph, 0) >= 0) continue;
+
+    u8 *at = copy + 10;
+    for (u8 *field; (field = NextGlyphComponent(&at, copy + glyph.length));)
+    {
+      u16 component = READ_BIG_ENDIAN_U16(field);
+      WriteBigEndianU16(field, component < numGlyphs ? newGlyphIds[component] : 0);
+    }
+  }
+  glyphOffsets[glyphCount] = glyfLength;
+  EndSubsetTable(&writer, FONT_TABLE_GLYF, glyfLength);
+  i32 shortOffsets = glyfLength / 2 <= 0xFFFF;
+
+  u8 *head = CopySubsetTable(&writer, font, FONT_TABLE_HEAD, 54);
+  WriteBigEndianU32(&head[8], 0);
+  WriteBigEndianU16(&head[50], (u16)!shortOffsets);
+
+  u8 *hhea = CopySubsetTable(&writer, font, FONT_TABLE_HHEA, 36);
+  WriteBigEndianU16(&hhea[34], longMetricCount);
+
+  u8 *hmtx = BeginSubsetTable(&writer);
+  u32 hmtxLength = 0;
+  for (u16 i = 0; i < glyphCount; ++i)
+  {
+    if (i < longMetricCount)
+    {
+      WriteBigEndianU16(&hmtx[hmtxLength], metrics->advanceWidths[oldGlyphIds[i]]);
+      hmtxLength += 2;
+    }
+    WriteBigEndianU16(&hmtx[hmtxLength], (u16)metrics->leftSideBearings[oldGlyphIds[i]]);
+    hmtxLength += 2;
+  }
+  EndSubsetTable(&writer, FONT_TABLE_HMTX, hmtxLength);
+
+  u8 *loca = BeginSubsetTable(&writer);
+  for (u32 i = 0; i <= glyphCount; ++i)
+  {
+    if (shortOffsets) WriteBigEndianU16(&loca[i * 2], (u16)(glyphOffsets[i] / 2));
+    else WriteBigEndianU32(&loca[i * 4], glyphOffsets[i]);
+  }
+  EndSubsetTable(&writer, FONT_TABLE_LOCA, (glyphCount + 1) * (shortOffsets ? 2 : 4));
+
+  u8 *maxp = CopySubsetTable(&writer, font, FONT_TABLE_MAXP, UINT32_MAX);
+  WriteBigEndianU16(&maxp[4], glyphCount);
+
+  CopySubsetTable(&writer, font, FONT_TABLE_NAME, UINT32_MAX);
+
+  // Version 3 drops the glyph names, which are indexed by glyph.
+  if (post.length >= 32)
+  {
+    u8 *postHeader = CopySubsetTable(&writer, font, FONT_TABLE_POST, 32);
+    WriteBigEndianU32(postHeader, 0x00030000);
+  }
+
+  CopySubsetTable(&writer, font, FONT_TABLE_PREP, UINT32_MAX);
+  assert(writer.tableCount == tableCount);
+
+  u8 *directory = writer.data;
+  u32 searchRange = FloorPowerOfTwo(writer.tableCount) * 16;
+  WriteBigEndianU32(&directory[0], TRUETYPE);
+  WriteBigEndianU16(&directory[4], (u16)writer.tableCount);
+  WriteBigEndianU16(&directory[6], (u16)searchRange);
+  WriteBigEndianU16(&directory[8], (u16)CountTrailingZeros(searchRange / 16));
+  WriteBigEndianU16(&directory[10], (u16)(writer.tableCount * 16 - searchRange));
+  for (i32 i = 0; i < writer.tableCount; ++i)
+  {
+    TableRecord *record = &writer.records[i];
+    u8 *entry = &directory[12 + i * 16];
+    WriteBigEndianU32(&entry[0], record->tag.value);
+    WriteBigEndianU32(&entry[4], ComputeTableChecksum(MakeFontView(&writer.data[record->offset], record->length)));
+    WriteBigEndianU32(&entry[8], record->offset);
+    WriteBigEndianU32(&entry[12], record->length);
+  }
+
+  WriteBigEndianU32(&head[8], CHECKSUM_MAGIC - ChecksumRange(MakeFontView(writer.data, writer.size), 0, writer.size, 0));
+  TmpArenaPop(&scratch);
+  PROFILE_END(SubsetFont);
+
+  *subsetSize = writer.size;
+  return writer.data;
+}
@@ -0,0 +1,66 @@
+#define REPLACEMENT_CHARACTER 0xFFFD
+
+// Decodes until either the text or the codepoint buffer runs out, malformed sequences, overlongs and
+// surrogates become U+FFFD and consume a single byte. Sequences cut by the end of the text are decoded
+// the same way so callers feeding complete buffers never lose bytes.
+i32 DecodeUtf8(u8 *text, i32 length, u32 *codepoints, i32 maxCodepoints, i32 *consumed)
+{
+  i32 offset = 0;
+  i32 count = 0;
+  while (offset < length && count < maxCodepoints)
+  {
+#if SIMD_X86
+    // ASCII runs are widened 16 bytes at a time.
+    if (length - offset >= 16 && maxCodepoints - count >= 16)
+    {
+      __m128i bytes = _mm_loadu_si128((__m128i *)&text[offset]);
+      if (!_mm_movemask_epi8(bytes))
+      {
+        __m128i zero = _mm_setzero_si128();
+        __m128i low = _mm_unpacklo_epi8(bytes, zero);
+        __m128i high = _mm_unpackhi_epi8(bytes, zero);
+        _mm_storeu_si128((__m128i *)&codepoints[count + 0], _mm_unpacklo_epi16(low, zero));
+        _mm_storeu_si128((__m128i *)&codepoints[count + 4], _mm_unpackhi_epi16(low, zero));
+        _mm_storeu_si128((__m128i *)&codepoints[count + 8], _mm_unpacklo_epi16(high, zero));
+        _mm_storeu_si128((__m128i *)&codepoints[count + 12], _mm_unpackhi_epi16(high, zero));
+        offset += 16;
+        count += 16;
+        continue;
+      }
+    }
+#endif
+
+    u8 lead = text[offset];
+    if (lead < 0x80)
+    {
+      codepoints[count++] = lead;
+      offset += 1;
+      continue;
+    }
+
+    i32 sequenceLength = lead >= 0xF0 ? 4 : lead >= 0xE0 ? 3 : lead >= 0xC0 ? 2 : 0;
+    u32 minimum = sequenceLength == 4 ? 0x10000 : sequenceLength == 3 ? 0x800 : 0x80;
+    u32 codepoint = lead & (0x7F >> sequenceLength);
+    i32 valid = sequenceLength && lead < 0xF5 && offset + sequenceLength <= length;
+    for (i32 i = 1; valid && i < sequenceLength; ++i)
+    {
+      u8 continuation = text[offset + i];
+      valid = (continuation & 0xC0) == 0x80;
+      codepoint = (codepoint << 6) | (continuation & 0x3F);
+    }
+
+    if (valid && codepoint >= minimum && codepoint <= 0x10FFFF && (codepoint < 0xD800 || codepoint > 0xDFFF))
+    {
+      codepoints[count++] = codepoint;
+      offset += sequenceLength;
+    }
+    else
+    {
+      codepoints[count++] = REPLACEMENT_CHARACTER;
+      offset += 1;
+    }
+  }
+
+  *consumed = offset;
+  return count;
+}
@@ -0,0 +1,785 @@
+//SPECS: https://learn.microsoft.com/en-us/typography/opentype/spec/otvaroverview
+//SPECS: https://learn.microsoft.com/en-us/typography/opentype/spec/fvar
+//SPECS: https://learn.microsoft.com/en-us/typography/opentype/spec/avar
+//SPECS: https://learn.microsoft.com/en-us/typography/opentype/spec/gvar
+
+// Variable TrueType fonts: fvar axes and named instances, avar segment maps, and gvar deltas applied to
+// glyf outlines as they are decoded. A VariationInstance holds the normalized coordinates and the scratch
+// buffers of delta decoding, DecodeInstancedGlyphOutline (glyf.c) takes one in place of the default
+// outline. Deltas are summed over every tuple whose region contains the coordinates, with the untouched
+// points of sparse tuples inferred by IUP, so instancing a glyph costs a pass over its gvar data on top of
+// decoding it. An InstanceCache keeps whole instanced outlines for text drawn at the same coordinates.
+//
+// Phantom point deltas are decoded but not applied, advances stay the default ones. The item variation
+// store of avar 2 and CFF2 blends are not applied.
+
+#define FVAR_AXIS_RECORD_SIZE 20
+#define F2DOT14_ONE 16384
+
+typedef enum {
+  SHARED_POINT_NUMBERS = 0x8000, // In the tuple count of the glyph variation data.
+  TUPLE_COUNT_MASK = 0x0FFF,
+} GlyphVariationDataFlags;
+
+typedef enum {
+  EMBEDDED_PEAK_TUPLE = 0x8000,
+  INTERMEDIATE_REGION = 0x4000,
+  PRIVATE_POINT_NUMBERS = 0x2000,
+  TUPLE_INDEX_MASK = 0x0FFF,
+} TupleIndexFlags;
+
+typedef enum {
+  POINTS_ARE_WORDS = 0x80,
+  POINT_RUN_COUNT_MASK = 0x7F,
+  DELTAS_ARE_ZERO = 0x80,
+  DELTAS_ARE_WORDS = 0x40,
+  DELTAS_ARE_LONGS = 0xC0, // Both bits.
+  DELTA_RUN_COUNT_MASK = 0x3F,
+} PackedRunFlags;
+
+typedef struct {
+  Tag tag;
+  f32 minValue; // User coordinates, e.g. 100 to 900 for wght.
+  f32 defaultValue;
+  f32 maxValue;
+  u16 flags; // 0x0001 for axes hidden from users.
+  u16 axisNameId;
+} VariationAxis;
+
+typedef struct {
+  u16 subfamilyNameId;
+  u16 postScriptNameId; // 0xFFFF when the record has none.
+  f32 *coordinates; // axisCount user coordinates.
+} NamedInstance;
+
+// avar map of an axis, normalized F2DOT14 values sorted by fromCoordinates. Empty maps are the identity.
+typedef struct {
+  u16 count;
+  i16 *fromCoordinates;
+  i16 *toCoordinates;
+} AxisSegmentMap;
+
+typedef struct {
+  u16 axisCount;
+  VariationAxis *axes;
+  u16 instanceCount;
+  NamedInstance *instances;
+  AxisSegmentMap *segmentMaps; // axisCount maps, NULL without avar.
+} FontVariations;
+
+// Referenced from GlyphData, see glyf.c.
+struct GlyphVariations {
+  u16 axisCount;
+  u16 sharedTupleCount;
+  u16 glyphCount; // Glyphs past it have no variations.
+  u8 *sharedTuples; // sharedTupleCount peaks of axisCount big endian F2DOT14 values.
+  u32 *glyphOffsets; // glyphCount + 1 offsets into glyphVariationData.
+  FontView glyphVariationData;
+};
+
+struct VariationInstance {
+  GlyphVariations *variations;
+  u16 axisCount;
+  i32 isDefault; // Every coordinate is 0, outlines are the default ones.
+  u64 hash; // Of the coordinates, 0 for the default instance.
+  i16 *coordinates; // Normalized F2DOT14 value of each axis.
+  f32 *sharedScalars; // Scalar of each shared tuple at coordinates.
+
+  // Decoding scratch, sized for the largest glyph plus its 4 phantom points.
+  i32 pointCapacity;
+  f32 *deltaX; // Sum of the tuples.
+  f32 *deltaY;
+  f32 *tupleX; // Deltas of the tuple being decoded.
+  f32 *tupleY;
+  u8 *touched; // Points the tuple has explicit deltas for.
+  u16 *pointNumbers;
+  u16 *sharedPointNumbers;
+};
+
+i32 LoadFontVariations(Arena *arena, Font *font, FontVariations *fontVariations)
+{
+  memset(fontVariations, 0, sizeof(FontVariations));
+  FontView fvar = GetFontTable(font, FONT_TABLE_FVAR);
+  FontCursor cursor = MakeFontCursor(fvar, 0);
+  if (!CursorReserve(&cursor, 16)) return 0;
+
+  u16 majorVersion = CursorU16(&cursor);
+  CursorSkip(&cursor, 2); // minorVersion
+  u16 axesArrayOffset = CursorU16(&cursor);
+  CursorSkip(&cursor, 2); // reserved
+  u16 axisCount = CursorU16(&cursor);
+  u16 axisSize = CursorU16(&cursor);
+  u16 instanceCount = CursorU16(&cursor);
+  u16 instanceSize = CursorU16(&cursor);
+  if (majorVersion != 1 || !axisCount || axisSize < FVAR_AXIS_RECORD_SIZE || instanceSize < 4 + axisCount * 4)
+  {
+    fprintf(stderr, "Unsupported fvar table\n");
+    return 0;
+  }
+
+  cursor = MakeFontCursor(fvar, axesArrayOffset);
+  if (!CursorReserve(&cursor, (u64)axisCount * axisSize + (u64)instanceCount * instanceSize))
+  {
+    fprintf(stderr, "Truncated fvar table\n");
+    return 0;
+  }
+
+  VariationAxis *axes = (VariationAxis *)Alloc(arena, axisCount * sizeof(VariationAxis));
+  for (i32 i = 0; i < axisCount; ++i)
+  {
+    u8 *record = cursor.at;
+    VariationAxis *axis = &axes[i];
+    axis->tag.value = READ_BIG_ENDIAN_U32(record);
+    axis->minValue = (f32)(i32)READ_BIG_ENDIAN_U32(record + 4) / 65536.0f;
+    axis->defaultValue = (f32)(i32)READ_BIG_ENDIAN_U32(record + 8) / 65536.0f;
+    axis->maxValue = (f32)(i32)READ_BIG_ENDIAN_U32(record + 12) / 65536.0f;
+    axis->flags = READ_BIG_ENDIAN_U16(record + 16);
+    axis->axisNameId = READ_BIG_ENDIAN_U16(record + 18);
+
+    // Clamped into order like the spec asks of inconsistent records.
+    if (axis->defaultValue < axis->minValue) axis->minValue = axis->defaultValue;
+    if (axis->defaultValue > axis->maxValue) axis->maxValue = axis->defaultValue;
+    CursorSkip(&cursor, axisSize);
+  }
+
+  NamedInstance *instances = (NamedInstance *)Alloc(arena, instanceCount * sizeof(NamedInstance));
+  f32 *coordinates = (f32 *)Alloc(arena, (u32)instanceCount * axisCount * sizeof(f32));
+  for (i32 i = 0; i < instanceCount; ++i)
+  {
+    u8 *record = cursor.at;
+    NamedInstance *instance = &instances[i];
+    instance->subfamilyNameId = READ_BIG_ENDIAN_U16(record);
+    instance->coordinates = &coordinates[i * axisCount];
+    for (i32 axis = 0; axis < axisCount; ++axis)
+    {
+      instance->coordinates[axis] = (f32)(i32)READ_BIG_ENDIAN_U32(record + 4 + axis * 4) / 65536.0f;
+    }
+    instance->postScriptNameId = instanceSize >= 6 + axisCount * 4 ? READ_BIG_ENDIAN_U16(record + 4 + axisCount * 4) : 0xFFFF;
+    CursorSkip(&cursor, instanceSize);
+  }
+
+  fontVariations->axisCount = axisCount;
+  fontVariations->axes = axes;
+  fontVariations->instanceCount = instanceCount;
+  fontVariations->instances = instances;
+
+  // A malformed avar is ignored rather than failing the whole font, normalization is then linear.
+  FontView avar = GetFontTable(font, FONT_TABLE_AVAR);
+  cursor = MakeFontCursor(avar, 0);
+  if (!CursorReserve(&cursor, 8)) return 1;
+  u16 avarMajorVersion = CursorU16(&cursor);
+  CursorSkip(&cursor, 4); // minorVersion, reserved
+  u16 mapCount = CursorU16(&cursor);
+  if ((avarMajorVersion != 1 && avarMajorVersion != 2) || mapCount != axisCount) return 1;
+
+  AxisSegmentMap *segmentMaps = (AxisSegmentMap *)Alloc(arena, axisCount * sizeof(AxisSegmentMap));
+  for (i32 i = 0; i < axisCount; ++i)
+  {
+    if (!CursorReserve(&cursor, 2)) return 1;
+    u16 count = CursorU16(&cursor);
+    if (!CursorReserve(&cursor, (u32)count * 4)) return 1;
+    AxisSegmentMap *map = &segmentMaps[i];
+    map->count = count;
+    map->fromCoordinates = (i16 *)Alloc(arena, count * 2 * sizeof(i16));
+    map->toCoordinates = map->fromCoordinates + count;
+    for (i32 j = 0; j < count; ++j)
+    {
+      map->fromCoordinates[j] = (i16)CursorU16(&cursor);
+      map->toCoordinates[j] = (i16)CursorU16(&cursor);
+    }
+  }
+  fontVariations->segmentMaps = segmentMaps;
+  return 1;
+}
+
+// Index of the axis tagged tag (e.g. "wght"), -1 when the font has no such axis.
+i32 FindVariationAxis(FontVariations *fontVariations, char *tag)
+{
+  for (i32 i = 0; i < fontVariations->axisCount; ++i)
+  {
+    if (fontVariations->axes[i].tag.value == READ_BIG_ENDIAN_U32(tag)) return i;
+  }
+  return -1;
+}
+
+i32 MapAxisSegments(AxisSegmentMap *map, i32 value)
+{
+  if (!map->count) return value;
+  i16 *from = map->fromCoordinates;
+  i16 *to = map->toCoordinates;
+  if (value <= from[0]) return value - from[0] + to[0];
+
+  i32 k = 1;
+  while (k < map->count && from[k] < value) ++k;
+  if (k == map->count) return value - from[k - 1] + to[k - 1];
+  if (from[k] == value || from[k] == from[k - 1]) return to[k];
+
+  // Rounded half up like the F2DOT14 conversion before it.
+  i32 numerator = (value - from[k - 1]) * (to[k] - to[k - 1]);
+  i32 denominator = from[k] - from[k - 1];
+  return to[k - 1] + (i32)floorf((f32)numerator / (f32)denominator + 0.5f);
+}
+
+// User coordinates (fvar units, one per axis) to the normalized F2DOT14 coordinates gvar works with.
+void NormalizeVariationCoordinates(FontVariations *fontVariations, f32 *userCoordinates, i16 *coordinates)
+{
+  for (i32 i = 0; i < fontVariations->axisCount; ++i)
+  {
+    VariationAxis *axis = &fontVariations->axes[i];
+    f32 value = userCoordinates[i];
+    value = value < axis->minValue ? axis->minValue : value > axis->maxValue ? axis->maxValue : value;
+
+    f32 normalized = 0.0f;
+    if (value < axis->defaultValue) normalized = (value - axis->defaultValue) / (axis->defaultValue - axis->minValue);
+    else if (value > axis->defaultValue) normalized = (value - axis->defaultValue) / (axis->maxValue - axis->defaultValue);
+
+    i32 fixed = (i32)floorf(normalized * F2DOT14_ONE + 0.5f);
+    if (fontVariations->segmentMaps) fixed = MapAxisSegments(&fontVariations->segmentMaps[i], fixed);
+    coordinates[i] = (i16)(fixed < -F2DOT14_ONE ? -F2DOT14_ONE : fixed > F2DOT14_ONE ? F2DOT14_ONE : fixed);
+  }
+}
+
+GlyphVariations *LoadGlyphVariations(Arena *arena, Font *font, u16 numGlyphs)
+{
+  FontView gvar = GetFontTable(font, FONT_TABLE_GVAR);
+  FontCursor cursor = MakeFontCursor(gvar, 0);
+  if (!CursorReserve(&cursor, 20)) return NULL;
+
+  u16 majorVersion = CursorU16(&cursor);
+  CursorSkip(&cursor, 2); // minorVersion
+  u16 axisCount = CursorU16(&cursor);
+  u16 sharedTupleCount = CursorU16(&cursor);
+  u32 sharedTuplesOffset = CursorU32(&cursor);
+  u16 glyphCount = CursorU16(&cursor);
+  u16 flags = CursorU16(&cursor);
+  u32 glyphVariationDataArrayOffset = CursorU32(&cursor);
+
+  u32 offsetSize = flags & 1 ? 4 : 2;
+  FontView sharedTuples = FontSubView(gvar, sharedTuplesOffset, (u32)sharedTupleCount * axisCount * 2);
+  if (majorVersion != 1 || !axisCount || !CursorReserve(&cursor, ((u64)glyphCount + 1) * offsetSize) ||
+      (sharedTupleCount && !sharedTuples.data) || glyphVariationDataArrayOffset > gvar.length)
+  {
+    fprintf(stderr, "Unsupported or truncated gvar table\n");
+    return NULL;
+  }
+
+  GlyphVariations *variations = (GlyphVariations *)Alloc(arena, sizeof(GlyphVariations));
+  variations->axisCount = axisCount;
+  variations->sharedTupleCount = sharedTupleCount;
+  variations->glyphCount = glyphCount < numGlyphs ? glyphCount : numGlyphs;
+  variations->sharedTuples = sharedTuples.data;
+  variations->glyphVariationData = FontSubView(gvar, glyphVariationDataArrayOffset, gvar.length - glyphVariationDataArrayOffset);
+
+  // Short offsets are stored divided by 2, like loca.
+  u32 *glyphOffsets = (u32 *)AllocNoZero(arena, (variations->glyphCount + 1) * sizeof(u32));
+  for (i32 i = 0; i <= variations->glyphCount; ++i)
+  {
+    glyphOffsets[i] = offsetSize == 4 ? CursorU32(&cursor) : CursorU16(&cursor) * 2u;
+  }
+  variations->glyphOffsets = glyphOffsets;
+  return variations;
+}
+
+// Scratch and coordinates for glyphData, starting at the default instance. NULL when the font has no gvar.
+VariationInstance *CreateVariationInstance(Arena *arena, GlyphData *glyphData)
+{
+  GlyphVariations *variations = glyphData->variations;
+  if (!variations) return NULL;
+
+  // Composites have one point per component, bounded by GLYPH_VARIATION_MAX_COMPONENTS in glyf.c.
+  MaximumProfileTable *maximumProfile = glyphData->maximumProfile;
+  i32 pointCapacity = maximumProfile->maxPoints > maximumProfile->maxCompositePoints ? maximumProfile->maxPoints : maximumProfile->maxCompositePoints;
+  if (pointCapacity < GLYPH_VARIATION_MAX_COMPONENTS) pointCapacity = GLYPH_VARIATION_MAX_COMPONENTS;
+  pointCapacity += 4;
+
+  VariationInstance *instance = (VariationInstance *)Alloc(arena, sizeof(VariationInstance));
+  instance->variations = variations;
+  instance->axisCount = variations->axisCount;
+  instance->isDefault = 1;
+  instance->coordinates = (i16 *)Alloc(arena, variations->axisCount * sizeof(i16));
+  instance->sharedScalars = (f32 *)Alloc(arena, variations->sharedTupleCount * sizeof(f32) + SIMD_PADDING);
+  instance->pointCapacity = pointCapacity;
+  instance->deltaX = (f32 *)Alloc(arena, pointCapacity * sizeof(f32) + SIMD_PADDING);
+  instance->deltaY = (f32 *)Alloc(arena, pointCapacity * sizeof(f32) + SIMD_PADDING);
+  instance->tupleX = (f32 *)Alloc(arena, pointCapacity * sizeof(f32) + SIMD_PADDING);
+  instance->tupleY = (f32 *)Alloc(arena, pointCapacity * sizeof(f32) + SIMD_PADDING);
+  instance->touched = (u8 *)Alloc(arena, pointCapacity + SIMD_PADDING);
+  instance->pointNumbers = (u16 *)Alloc(arena, pointCapacity * sizeof(u16));
+  instance->sharedPointNumbers = (u16 *)Alloc(arena, pointCapacity * sizeof(u16));
+  return instance;
+}
+
+// Contribution of a tuple at coordinates. peak, start and end hold axisCount big endian F2DOT14 values,
+// start and end are NULL for tuples whose region goes from 0 to the peak.
+f32 GetTupleScalar(i16 *coordinates, i32 axisCount, u8 *peak, u8 *start, u8 *end)
+{
+  f32 scalar = 1.0f;
+  for (i32 axis = 0; axis < axisCount; ++axis)
+  {
+    i32 peakValue = READ_BIG_ENDIAN_I16(&peak[axis * 2]);
+    if (!peakValue) continue;
+
+    i32 lower = peakValue < 0 ? peakValue : 0;
+    i32 upper = peakValue > 0 ? peakValue : 0;
+    if (start)
+    {
+      // Invalid regions leave the axis out rather than the tuple.
+      lower = READ_BIG_ENDIAN_I16(&start[axis * 2]);
+      upper = READ_BIG_ENDIAN_I16(&end[axis * 2]);
+      if (lower > peakValue || peakValue > upper || (lower < 0 && upper > 0)) continue;
+    }
+
+    i32 value = coordinates[axis];
+    if (value == peakValue) continue;
+    if (value <= lower || value >= upper) return 0.0f;
+    scalar *= value < peakValue ? (f32)(value - lower) / (f32)(peakValue - lower) : (f32)(upper - value) / (f32)(upper - peakValue);
+  }
+  return scalar;
+}
+
+// Normalized coordinates, one per gvar axis, as from NormalizeVariationCoordinates.
+void SetVariationInstanceCoordinates(VariationInstance *instance, i16 *coordinates)
+{
+  GlyphVariations *variations = instance->variations;
+  memcpy(instance->coordinates, coordinates, instance->axisCount * sizeof(i16));
+
+  instance->isDefault = 1;
+  u64 hash = 0x9E3779B97F4A7C15ull;
+  for (i32 i = 0; i < instance->axisCount; ++i)
+  {
+    instance->isDefault &= coordinates[i] == 0;
+    hash = (hash ^ (u16)coordinates[i]) * 0xFF51AFD7ED558CCDull;
+    hash ^= hash >> 32;
+  }
+  instance->hash = instance->isDefault ? 0 : hash | 1;
+
+  for (i32 i = 0; i < variations->sharedTupleCount; ++i)
+  {
+    u8 *peak = &variations->sharedTuples[i * variations->axisCount * 2];
+    instance->sharedScalars[i] = GetTupleScalar(instance->coordinates, instance->axisCount, peak, NULL, NULL);
+  }
+}
+
+// User coordinates in fvar units, fontVariations must come from the same font.
+void SetVariationInstanceLocation(VariationInstance *instance, FontVariations *fontVariations, f32 *userCoordinates)
+{
+  TmpArena scratch;
+  TmpArenaPush(&scratch, GetScratchArena(NULL));
+  i32 count = fontVariations->axisCount > instance->axisCount ? fontVariations->axisCount : instance->axisCount;
+  i16 *coordinates = (i16 *)Alloc(scratch.arena, count * sizeof(i16));
+  NormalizeVariationCoordinates(fontVariations, userCoordinates, coordinates);
+  SetVariationInstanceCoordinates(instance, coordinates);
+  TmpArenaPop(&scratch);
+}
+
+i32 IsDefaultVariationInstance(VariationInstance *instance)
+{
+  return instance->isDefault;
+}
+
+// Returns the number of point numbers read into pointNumbers, 0 for all the points of the glyph, -1 when
+// the data is malformed or lists more than capacity points.
+i32 ReadPackedPointNumbers(FontCursor *cursor, u16 *pointNumbers, i32 capacity)
+{
+  if (!CursorReserve(cursor, 1)) return -1;
+  i32 count = *cursor->at++;
+  if (count & POINTS_ARE_WORDS)
+  {
+    if (!CursorReserve(cursor, 1)) return -1;
+    count = (count & POINT_RUN_COUNT_MASK) << 8 | *cursor->at++;
+  }
+  if (count > capacity) return -1;
+
+  // Each number is stored as the difference to the previous one.
+  u16 point = 0;
+  for (i32 i = 0; i < count;)
+  {
+    if (!CursorReserve(cursor, 1)) return -1;
+    u8 control = *cursor->at++;
+    i32 runLength = (control & POINT_RUN_COUNT_MASK) + 1;
+    i32 size = control & POINTS_ARE_WORDS ? 2 : 1;
+    if (i + runLength > count || !CursorReserve(cursor, (u32)runLength * size)) return -1;
+    for (i32 j = 0; j < runLength; ++j)
+    {
+      point += size == 2 ? CursorU16(cursor) : *cursor->at++;
+      pointNumbers[i++] = point;
+    }
+  }
+  return count;
+}
+
+// Reads count packed deltas, the i-th into values[pointNumbers[i]], or values[i] when pointNumbers is NULL.
+// Points past valueCount are dropped. Returns 0 when the data runs out.
+i32 ReadPackedDeltas(FontCursor *cursor, i32 count, u16 *pointNumbers, f32 *values, i32 valueCount)
+{
+  for (i32 i = 0; i < count;)
+  {
+    if (!CursorReserve(cursor, 1)) return 0;
+    u8 control = *cursor->at++;
+    i32 runLength = (control & DELTA_RUN_COUNT_MASK) + 1;
+    u32 size = (control & DELTAS_ARE_LONGS) == DELTAS_ARE_LONGS ? 4 : control & DELTAS_ARE_ZERO ? 0 : control & DELTAS_ARE_WORDS ? 2 : 1;
+    if (i + runLength > count || !CursorReserve(cursor, (u32)runLength * size)) return 0;
+    for (i32 j = 0; j < runLength; ++j, ++i)
+    {
+      f32 delta = size == 4 ? (f32)(i32)CursorU32(cursor) : size == 2 ? (f32)(i16)CursorU16(cursor) : size ? (f32)(i8)*cursor->at++ : 0.0f;
+      i32 point = pointNumbers ? pointNumbers[i] : i;
+      if (point < valueCount) values[point] = delta;
+    }
+  }
+  return 1;
+}
+
+// Infers the deltas of the untouched points of the contour from start to end (inclusive) along one axis,
+// from the touched points before and after them: interpolated between their original coordinates and
+// shifted like the nearest one past them. Contours without touched points keep zero deltas.
+void InterpolateUntouchedPoints(f32 *coordinates, f32 *deltas, u8 *touched, i32 start, i32 end)
+{
+  i32 firstTouched = start;
+  while (firstTouched <= end && !touched[firstTouched]) ++firstTouched;
+  if (firstTouched > end) return;
+
+  i32 point = firstTouched;
+  do
+  {
+    i32 next = point == end ? start : point + 1;
+    while (!touched[next]) next = next == end ? start : next + 1;
+
+    f32 x1 = coordinates[point], x2 = coordinates[next];
+    f32 d1 = deltas[point], d2 = deltas[next];
+    if (x1 > x2)
+    {
+      f32 x = x1; x1 = x2; x2 = x;
+      f32 d = d1; d1 = d2; d2 = d;
+    }
+    f32 scale = x1 < x2 ? (d2 - d1) / (x2 - x1) : 0.0f;
+    for (i32 i = point == end ? start : point + 1; i != next; i = i == end ? start : i + 1)
+    {
+      f32 x = coordinates[i];
+      if (x1 == x2) deltas[i] = d1 == d2 ? d1 : 0.0f;
+      else deltas[i] = x <= x1 ? d1 : x >= x2 ? d2 : d1 + (x - x1) * scale;
+    }
+    point = next;
+  } while (point != firstTouched);
+}
+
+// Sums the deltas of every tuple of glyphId applying at the instance into instance->deltaX and deltaY, for
+// pointCount points including the 4 phantom ones. Sparse tuples are completed by IUP over the contours of
+// the simple glyph in outline, composites pass NULL. Returns 0 when the variation data is malformed.
+i32 SumGlyphDeltas(VariationInstance *instance, u16 glyphId, i32 pointCount, GlyphOutline *outline, i32 firstPoint, i32 firstContour)
+{
+  GlyphVariations *variations = instance->variations;
+  if (pointCount > instance->pointCapacity) return 0;
+  memset(instance->deltaX, 0, pointCount * sizeof(f32));
+  memset(instance->deltaY, 0, pointCount * sizeof(f32));
+  if (glyphId >= variations->glyphCount) return 1;
+
+  u32 dataStart = variations->glyphOffsets[glyphId];
+  u32 dataEnd = variations->glyphOffsets[glyphId + 1];
+  if (dataEnd <= dataStart) return 1;
+  FontView data = FontSubView(variations->glyphVariationData, dataStart, dataEnd - dataStart);
+  if (data.length < 4) return 0;
+
+  u16 tupleVariationCount = READ_BIG_ENDIAN_U16(data.data);
+  u16 dataOffset = READ_BIG_ENDIAN_U16(data.data + 2);
+  if (dataOffset > data.length) return 0;
+  FontCursor headers = MakeFontCursor(data, 4);
+  FontCursor serialized = MakeFontCursor(data, dataOffset);
+
+  i32 sharedCount = 0;
+  if (tupleVariationCount & SHARED_POINT_NUMBERS)
+  {
+    sharedCount = ReadPackedPointNumbers(&serialized, instance->sharedPointNumbers, pointCount);
+    if (sharedCount < 0) return 0;
+  }
+
+  i32 axisCount = variations->axisCount;
+  for (i32 tuple = 0; tuple < (tupleVariationCount & TUPLE_COUNT_MASK); ++tuple)
+  {
+    if (!CursorReserve(&headers, 4)) return 0;
+    u16 variationDataSize = CursorU16(&headers);
+    u16 tupleIndex = CursorU16(&headers);
+    u32 tupleSize = axisCount * 2;
+    u32 regionSize = (tupleIndex & EMBEDDED_PEAK_TUPLE ? tupleSize : 0) + (tupleIndex & INTERMEDIATE_REGION ? 2 * tupleSize : 0);
+    if (!CursorReserve(&headers, regionSize) || !CursorReserve(&serialized, variationDataSize)) return 0;
+
+    // Shared peaks without an intermediate region have their scalar computed once per instance.
+    f32 scalar;
+    if (tupleIndex & (EMBEDDED_PEAK_TUPLE | INTERMEDIATE_REGION))
+    {
+      u8 *peak = headers.at;
+      u8 *start = tupleIndex & INTERMEDIATE_REGION ? headers.at + regionSize - 2 * tupleSize : NULL;
+      if (!(tupleIndex & EMBEDDED_PEAK_TUPLE))
+      {
+        if ((tupleIndex & TUPLE_INDEX_MASK) >= variations->sharedTupleCount) return 0;
+        peak = &variations->sharedTuples[(tupleIndex & TUPLE_INDEX_MASK) * tupleSize];
+      }
+      scalar = GetTupleScalar(instance->coordinates, axisCount, peak, start, start ? start + tupleSize : NULL);
+    }
+    else
+    {
+      if ((tupleIndex & TUPLE_INDEX_MASK) >= variations->sharedTupleCount) return 0;
+      scalar = instance->sharedScalars[tupleIndex & TUPLE_INDEX_MASK];
+    }
+    CursorSkip(&headers, regionSize);
+
+    FontCursor tupleData = { serialized.at, serialized.at + variationDataSize };
+    CursorSkip(&serialized, variationDataSize);
+    if (scalar == 0.0f) continue;
+
+    u16 *pointNumbers = instance->sharedPointNumbers;
+    i32 count = sharedCount;
+    if (tupleIndex & PRIVATE_POINT_NUMBERS)
+    {
+      pointNumbers = instance->pointNumbers;
+      count = ReadPackedPointNumbers(&tupleData, pointNumbers, pointCount);
+      if (count < 0) return 0;
+    }
+
+    f32 *tupleX = instance->tupleX;
+    f32 *tupleY = instance->tupleY;
+    if (!count)
+    {
+      if (!ReadPackedDeltas(&tupleData, pointCount, NULL, tupleX, pointCount) ||
+          !ReadPackedDeltas(&tupleData, pointCount, NULL, tupleY, pointCount)) return 0;
+    }
+    else
+    {
+      memset(tupleX, 0, pointCount * sizeof(f32));
+      memset(tupleY, 0, pointCount * sizeof(f32));
+      if (!ReadPackedDeltas(&tupleData, count, pointNumbers, tupleX, pointCount) ||
+          !ReadPackedDeltas(&tupleData, count, pointNumbers, tupleY, pointCount)) return 0;
+
+      if (outline)
+      {
+        u8 *touched = instance->touched;
+        memset(touched, 0, pointCount);
+        for (i32 i = 0; i < count; ++i)
+        {
+          if (pointNumbers[i] < pointCount) touched[pointNumbers[i]] = 1;
+        }
+
+        // Contour ends of the outline count from its first point, the ones of this glyph from firstPoint.
+        i32 contourStart = 0;
+        for (i32 contour = firstContour; contour < outline->contourCount; ++contour)
+        {
+          i32 contourEnd = outline->contourEnds[contour] - firstPoint;
+          InterpolateUntouchedPoints(&outline->x[firstPoint], tupleX, touched, contourStart, contourEnd);
+          InterpolateUntouchedPoints(&outline->y[firstPoint], tupleY, touched, contourStart, contourEnd);
+          contourStart = contourEnd + 1;
+        }
+      }
+    }
+
+    for (i32 i = 0; i < pointCount; ++i)
+    {
+      instance->deltaX[i] += scalar * tupleX[i];
+      instance->deltaY[i] += scalar * tupleY[i];
+    }
+  }
+  return 1;
+}
+
+// Moves the points AppendSimpleGlyph just added from firstPoint on.
+i32 ApplySimpleGlyphVariations(VariationInstance *instance, u16 glyphId, GlyphOutline *outline, i32 firstPoint, i32 firstContour)
+{
+  i32 pointCount = outline->pointCount - firstPoint;
+  if (!SumGlyphDeltas(instance, glyphId, pointCount + 4, outline, firstPoint, firstContour)) return 0;
+  for (i32 i = 0; i < pointCount; ++i)
+  {
+    outline->x[firstPoint + i] += instance->deltaX[i];
+    outline->y[firstPoint + i] += instance->deltaY[i];
+  }
+  return 1;
+}
+
+// Offset deltas of each component, deltaX and deltaY have room for componentCount + 4 values.
+i32 GetCompositeGlyphVariations(VariationInstance *instance, u16 glyphId, i32 componentCount, f32 *deltaX, f32 *deltaY)
+{
+  if (!SumGlyphDeltas(instance, glyphId, componentCount + 4, NULL, 0, 0)) return 0;
+  memcpy(deltaX, instance->deltaX, (componentCount + 4) * sizeof(f32));
+  memcpy(deltaY, instance->deltaY, (componentCount + 4) * sizeof(f32));
+  return 1;
+}
+
+typedef struct {
+  u64 hash; // 0 marks an empty slot.
+  GlyphData *glyphData;
+  u8 *data; // x, y, contour ends, coordinates, then point types.
+  u16 glyphId;
+  u16 axisCount; // 0 for outlines of the default instance.
+  u16 pointCount;
+  u16 contourCount;
+  i16 xMin;
+  i16 yMin;
+  i16 xMax;
+  i16 yMax;
+} InstancedOutline;
+
+typedef struct {
+  u32 entryCount;
+  InstancedOutline *entries;
+  u8 *data;
+  u32 dataUsed;
+} InstanceCacheGeneration;
+
+// Instanced outlines keyed by font, glyph and normalized coordinates, with the two generations of RunCache
+// (layout.c): hits in the previous generation move over, a full current generation drops the previous one.
+typedef struct {
+  u32 entryCapacity; // Per generation, a power of two. Tables are open addressed with linear probing.
+  u32 dataCapacity; // Per generation.
+  i32 current;
+  InstanceCacheGeneration generations[2];
+
+  u64 hits;
+  u64 misses;
+  u64 rotations;
+} InstanceCache;
+
+InstanceCache *CreateInstanceCache(Arena *arena, u32 entryCapacity, u32 dataCapacity)
+{
+  InstanceCache *cache = (InstanceCache *)Alloc(arena, sizeof(InstanceCache));
+  cache->entryCapacity = 16;
+  while (cache->entryCapacity < entryCapacity) cache->entryCapacity <<= 1;
+  cache->dataCapacity = dataCapacity;
+  for (i32 i = 0; i < 2; ++i)
+  {
+    cache->generations[i].entries = (InstancedOutline *)Alloc(arena, cache->entryCapacity * sizeof(InstancedOutline));
+    cache->generations[i].data = (u8 *)AllocNoZero(arena, dataCapacity);
+  }
+  return cache;
+}
+
+void RotateInstanceCache(InstanceCache *cache)
+{
+  cache->current ^= 1;
+  InstanceCacheGeneration *generation = &cache->generations[cache->current];
+  memset(generation->entries, 0, cache->entryCapacity * sizeof(InstancedOutline));
+  generation->entryCount = 0;
+  generation->dataUsed = 0;
+  ++cache->rotations;
+}
+
+u32 GetInstancedOutlineSize(u32 pointCount, u32 contourCount, u32 axisCount)
+{
+  return pointCount * (2 * sizeof(f32) + 1) + (contourCount + axisCount) * sizeof(u16);
+}
+
+InstancedOutline *FindInstancedOutline(InstanceCacheGeneration *generation, u32 mask, u64 hash, GlyphData *glyphData, u16 glyphId, i16 *coordinates, u16 axisCount)
+{
+  u32 slot = (u32)(hash >> 32) & mask;
+  for (InstancedOutline *entry = &generation->entries[slot]; entry->hash; slot = (slot + 1) & mask, entry = &generation->entries[slot])
+  {
+    if (entry->hash == hash && entry->glyphData == glyphData && entry->glyphId == glyphId && entry->axisCount == axisCount &&
+        (!axisCount || !memcmp(&entry->data[entry->pointCount * 2 * sizeof(f32) + entry->contourCount * sizeof(u16)], coordinates, axisCount * sizeof(i16))))
+    {
+      return entry;
+    }
+  }
+  return NULL;
+}
+
+// Takes a slot and size bytes of data in the current generation, NULL when it is full.
+InstancedOutline *AddInstancedOutline(InstanceCache *cache, u64 hash, u32 size)
+{
+  InstanceCacheGeneration *generation = &cache->generations[cache->current];
+  if (generation->entryCount + 1 > cache->entryCapacity / 4 * 3 || generation->dataUsed + size > cache->dataCapacity) return NULL;
+
+  u32 mask = cache->entryCapacity - 1;
+  u32 slot = (u32)(hash >> 32) & mask;
+  while (generation->entries[slot].hash) slot = (slot + 1) & mask;
+  InstancedOutline *entry = &generation->entries[slot];
+  entry->hash = hash;
+  entry->data = &generation->data[generation->dataUsed];
+  ++generation->entryCount;
+  generation->dataUsed += (size + 3) & ~3u;
+  return entry;
+}
+
+void CopyInstancedOutline(InstancedOutline *entry, GlyphOutline *outline)
+{
+  u8 *data = entry->data;
+  outline->pointCount = entry->pointCount;
+  outline->contourCount = entry->contourCount;
+  memcpy(outline->x, data, entry->pointCount * sizeof(f32));
+  memcpy(outline->y, data + entry->pointCount * sizeof(f32), entry->pointCount * sizeof(f32));
+  data += entry->pointCount * 2 * sizeof(f32);
+  memcpy(outline->contourEnds, data, entry->contourCount * sizeof(u16));
+  data += (entry->contourCount + entry->axisCount) * sizeof(u16);
+  memcpy(outline->onCurve, data, entry->pointCount);
+  outline->xMin = entry->xMin;
+  outline->yMin = entry->yMin;
+  outline->xMax = entry->xMax;
+  outline->yMax = entry->yMax;
+}
+
+// Same as DecodeInstancedGlyphOutline, copying the outline out of the cache when the glyph was already
+// instanced at the same coordinates. Outlines that do not fit in the cache are decoded every time.
+i32 DecodeCachedGlyphOutline(InstanceCache *cache, GlyphData *glyphData, VariationInstance *instance, u16 glyphId, GlyphOutline *outline)
+{
+  PROFILE_BEGIN(DecodeCachedGlyphOutline);
+  u16 axisCount = instance && glyphData->variations && !instance->isDefault ? instance->axisCount : 0;
+  i16 *coordinates = axisCount ? instance->coordinates : NULL;
+  u64 hash = ((axisCount ? instance->hash : 0) ^ (u64)(uintptr_t)glyphData ^ ((u64)glyphId * 0x9E3779B97F4A7C15ull)) * 0xC4CEB9FE1A85EC53ull;
+  hash = (hash ^ hash >> 29) | 1;
+
+  u32 mask = cache->entryCapacity - 1;
+  InstancedOutline *entry = FindInstancedOutline(&cache->generations[cache->current], mask, hash, glyphData, glyphId, coordinates, axisCount);
+  InstancedOutline *previous = entry ? NULL : FindInstancedOutline(&cache->generations[cache->current ^ 1], mask, hash, glyphData, glyphId, coordinates, axisCount);
+  if (entry || previous)
+  {
+    ++cache->hits;
+    if (previous)
+    {
+      // Still valid until the next rotation, moved over when the current generation has room.
+      u32 size = GetInstancedOutlineSize(previous->pointCount, previous->contourCount, axisCount);
+      entry = AddInstancedOutline(cache, hash, size);
+      if (entry)
+      {
+        u8 *data = entry->data;
+        *entry = *previous;
+        entry->data = data;
+        memcpy(entry->data, previous->data, size);
+      }
+      else entry = previous;
+    }
+    i32 fits = entry->pointCount <= outline->pointCapacity && entry->contourCount <= outline->contourCapacity;
+    if (fits) CopyInstancedOutline(entry, outline);
+    PROFILE_END(DecodeCachedGlyphOutline);
+    if (fits) return 1;
+    return DecodeInstancedGlyphOutline(glyphData, instance, glyphId, outline);
+  }
+
+  ++cache->misses;
+  i32 success = DecodeInstancedGlyphOutline(glyphData, instance, glyphId, outline);
+  u32 size = GetInstancedOutlineSize(outline->pointCount, outline->contourCount, axisCount);
+  if (success && size <= cache->dataCapacity)
+  {
+    entry = AddInstancedOutline(cache, hash, size);
+    if (!entry)
+    {
+      RotateInstanceCache(cache);
+      entry = AddInstancedOutline(cache, hash, size);
+    }
+    entry->glyphData = glyphData;
+    entry->glyphId = glyphId;
+    entry->axisCount = axisCount;
+    entry->pointCount = (u16)outline->pointCount;
+    entry->contourCount = (u16)outline->contourCount;
+    entry->xMin = outline->xMin;
+    entry->yMin = outline->yMin;
+    entry->xMax = outline->xMax;
+    entry->yMax = outline->yMax;
+
+    u8 *data = entry->data;
+    memcpy(data, outline->x, outline->pointCount * sizeof(f32));
+    memcpy(data + outline->pointCount * sizeof(f32), outline->y, outline->pointCount * sizeof(f32));
+    data += outline->pointCount * 2 * sizeof(f32);
+    memcpy(data, outline->contourEnds, outline->contourCount * sizeof(u16));
+    data += outline->contourCount * sizeof(u16);
+    if (axisCount) memcpy(data, coordinates, axisCount * sizeof(i16));
+    data += axisCount * sizeof(i16);
+    memcpy(data, outline->onCurve, outline->pointCount);
+  }
+  PROFILE_END(DecodeCachedGlyphOutline);
+  return success;
+}
@@ -0,0 +1,217 @@
+//SPECS: https://www.w3.org/TR/WOFF/
+
+// WOFF 1.0 files loaded as fonts without decoding them to an sfnt first. The directory is rebuilt as the
+// one of the sfnt the file decodes to, and each table is inflated the first time GetFontTable or
+// GetTableView asks for it, into the arena the font was loaded with: a cmap lookup never inflates glyf.
+// Tables stored uncompressed are viewed in place. DecodeWoffToSfnt still writes the whole sfnt for
+// callers that need one, e.g. to hand the font to another library.
+//
+// Tables are inflated at most once and the first access of each one writes to the font, so it must not
+// race with other threads. WOFF 2.0 is not supported.
+
+#define WOFF_HEADER_SIZE 44
+#define WOFF_TABLE_RECORD_SIZE 20
+#define WOFF_MAX_INFLATE_RATIO 1032 // DEFLATE cannot expand more, larger origLengths are rejected up front.
+
+typedef enum {
+  WOFF_TABLE_PENDING,
+  WOFF_TABLE_READY,
+  WOFF_TABLE_FAILED, // Stays an empty view, the table is treated as missing.
+} WoffTableState;
+
+typedef struct {
+  u32 offset; // In the WOFF file.
+  u32 compLength; // Equal to the length in the font directory when the table is stored uncompressed.
+  u8 state; // WoffTableState.
+  FontView table; // Set once the table is ready.
+} WoffTable;
+
+// Referenced from Font, see font.c. tables are in the order of the font directory.
+struct WoffFont {
+  Arena *arena; // Receives the inflated tables.
+  u32 sfntSize;
+  WoffTable *tables;
+  u32 inflatedTables;
+  u64 inflatedBytes;
+};
+
+typedef struct {
+  u32 offset;
+  i32 index;
+} WoffTableOrder;
+
+int CompareWoffTableOrder(const void *a, const void *b)
+{
+  WoffTableOrder *first = (WoffTableOrder *)a;
+  WoffTableOrder *second = (WoffTableOrder *)b;
+  if (first->offset != second->offset) return first->offset < second->offset ? -1 : 1;
+  return first->index - second->index;
+}
+
+// Reads the WOFF header and directory of font->view into font->directory and font->woff.
+i32 LoadWoffFromMemory(Arena *arena, Font *font)
+{
+  FontView view = font->view;
+  FontCursor cursor = MakeFontCursor(view, 0);
+  if (!CursorReserve(&cursor, WOFF_HEADER_SIZE)) return 0;
+
+  CursorSkip(&cursor, 4); // signature
+  u32 flavor = CursorU32(&cursor);
+  u32 length = CursorU32(&cursor);
+  u16 numTables = CursorU16(&cursor);
+  u16 reserved = CursorU16(&cursor);
+  CursorSkip(&cursor, WOFF_HEADER_SIZE - 16); // totalSfntSize, versions, metadata and private blocks.
+  if (length != view.length || !numTables || reserved || !CursorReserve(&cursor, (u32)numTables * WOFF_TABLE_RECORD_SIZE))
+  {
+    fprintf(stderr, "Invalid WOFF header\n");
+    return 0;
+  }
+
+  TableDirectory *directory = (TableDirectory *)Alloc(arena, sizeof(TableDirectory));
+  WoffFont *woff = (WoffFont *)Alloc(arena, sizeof(WoffFont));
+  if (!directory || !woff) return 0;
+  directory->scalableFontType = flavor;
+  directory->numTables = numTables;
+  u32 searchRange = FloorPowerOfTwo(numTables) * 16; // Wraps in the u16 fields past 4095 tables, like in any sfnt.
+  directory->searchRange = (u16)searchRange;
+  directory->entrySelector = (u16)CountTrailingZeros(searchRange / 16);
+  directory->rangeShift = (u16)(numTables * 16 - searchRange);
+  directory->tableRecords = (TableRecord *)AllocNoZero(arena, numTables * sizeof(TableRecord));
+  woff->arena = arena;
+  woff->tables = (WoffTable *)Alloc(arena, numTables * sizeof(WoffTable));
+  if (!directory->tableRecords || !woff->tables) return 0;
+
+  for (i32 i = 0; i < numTables; ++i)
+  {
+    TableRecord *record = &directory->tableRecords[i];
+    WoffTable *table = &woff->tables[i];
+    record->tag.value = CursorU32(&cursor);
+    table->offset = CursorU32(&cursor);
+    table->compLength = CursorU32(&cursor);
+    record->length = CursorU32(&cursor);
+    record->checksum = CursorU32(&cursor);
+    if (table->compLength > record->length || !FontViewContains(view, table->offset, table->compLength) ||
+        (u64)record->length > (u64)table->compLength * WOFF_MAX_INFLATE_RATIO)
+    {
+      fprintf(stderr, "Invalid WOFF table record %d\n", i);
+      return 0;
+    }
+  }
+
+  // Table data keeps the order it had in the original sfnt, laying the tables out in that order and padded
+  // to 4 bytes rebuilds the original file, which head.checksumAdjustment covers.
+  TmpArena scratch;
+  TmpArenaPush(&scratch, GetScratchArena(arena));
+  WoffTableOrder *order = (WoffTableOrder *)AllocNoZero(scratch.arena, numTables * sizeof(WoffTableOrder));
+  for (i32 i = 0; i < numTables; ++i)
+  {
+    order[i].offset = woff->tables[i].offset;
+    order[i].index = i;
+  }
+  qsort(order, numTables, sizeof(WoffTableOrder), CompareWoffTableOrder);
+
+  u64 sfntOffset = 12 + numTables * 16;
+  for (i32 i = 0; i < numTables; ++i)
+  {
+    TableRecord *record = &directory->tableRecords[order[i].index];
+    record->offset = (u32)sfntOffset;
+    sfntOffset += ((u64)record->length + 3) & ~3ull;
+  }
+  TmpArenaPop(&scratch);
+  if (sfntOffset > UINT32_MAX)
+  {
+    fprintf(stderr, "WOFF decodes to a font larger than 4GB\n");
+    return 0;
+  }
+
+  woff->sfntSize = (u32)sfntOffset;
+  font->directory = directory;
+  font->woff = woff;
+  return 1;
+}
+
+// View of the table of tableRecord, a record of font->directory, inflating it on first access. Empty when
+// the table does not decode.
+FontView GetWoffTable(Font *font, TableRecord *tableRecord)
+{
+  WoffFont *woff = font->woff;
+  WoffTable *table = &woff->tables[tableRecord - font->directory->tableRecords];
+  if (table->state != WOFF_TABLE_PENDING) return table->table;
+
+  table->state = WOFF_TABLE_FAILED;
+  u8 *compressed = font->view.data + table->offset;
+  if (table->compLength == tableRecord->length)
+  {
+    table->table = MakeFontView(compressed, tableRecord->length);
+    table->state = WOFF_TABLE_READY;
+    return table->table;
+  }
+
+  // Padded like mapped files so that SIMD loads may run past the end of the table.
+  PROFILE_BEGIN(InflateWoffTable);
+  TmpArena tmp;
+  TmpArenaPush(&tmp, woff->arena);
+  u8 *data = (u8 *)AllocNoZero(woff->arena, tableRecord->length + SIMD_PADDING);
+  if (data && InflateZlib(compressed, table->compLength, data, tableRecord->length))
+  {
+    memset(data + tableRecord->length, 0, SIMD_PADDING);
+    table->table = MakeFontView(data, tableRecord->length);
+    table->state = WOFF_TABLE_READY;
+    ++woff->inflatedTables;
+    woff->inflatedBytes += tableRecord->length;
+  }
+  else
+  {
+    TmpArenaPop(&tmp);
+    fprintf(stderr, "Failed to inflate WOFF table %d\n", (i32)(tableRecord - font->directory->tableRecords));
+  }
+  PROFILE_END(InflateWoffTable);
+  return table->table;
+}
+
+// Header and table records of the sfnt of directory, 12 + numTables * 16 bytes. Returns the size written.
+u32 WriteSfntDirectory(TableDirectory *directory, u8 *data)
+{
+  WriteBigEndianU32(data, directory->scalableFontType);
+  WriteBigEndianU16(data + 4, directory->numTables);
+  WriteBigEndianU16(data + 6, directory->searchRange);
+  WriteBigEndianU16(data + 8, directory->entrySelector);
+  WriteBigEndianU16(data + 10, directory->rangeShift);
+  for (i32 i = 0; i < directory->numTables; ++i)
+  {
+    TableRecord *record = &directory->tableRecords[i];
+    u8 *at = data + 12 + i * 16;
+    WriteBigEndianU32(at, record->tag.value);
+    WriteBigEndianU32(at + 4, record->checksum);
+    WriteBigEndianU32(at + 8, record->offset);
+    WriteBigEndianU32(at + 12, record->length);
+  }
+  return 12 + directory->numTables * 16;
+}
+
+// Decodes a whole WOFF file into the sfnt it stands for, allocated from arena. Returns NULL when the file
+// is not a valid WOFF or a table does not inflate.
+u8 *DecodeWoffToSfnt(Arena *arena, void *data, size_t size, u32 *sfntSize)
+{
+  Font font;
+  memset(&font, 0, sizeof(Font));
+  font.view = MakeFontView(data, size);
+  if (ViewU32(font.view, 0) != READ_BIG_ENDIAN_U32("wOFF") || !LoadWoffFromMemory(arena, &font)) return NULL;
+
+  TableDirectory *directory = font.directory;
+  u8 *sfnt = (u8 *)Alloc(arena, font.woff->sfntSize + SIMD_PADDING);
+  if (!sfnt) return NULL;
+  WriteSfntDirectory(directory, sfnt);
+
+  // Inflated straight into place, the padding between tables is already zero.
+  for (i32 i = 0; i < directory->numTables; ++i)
+  {
+    TableRecord *record = &directory->tableRecords[i];
+    WoffTable *table = &font.woff->tables[i];
+    u8 *source = font.view.data + table->offset;
+    if (table->compLength == record->length) memcpy(sfnt + record->offset, source, record->length);
+    else if (!InflateZlib(source, table->compLength, sfnt + record->offset, record->length)) return NULL;
+  }
+  *sfntSize = font.woff->sfntSize;
+  return sfnt;
+}